@@ -5,12 +5,15 @@
 #include <QTextStream>
 #include <QDateTime>
 #include <QMessageBox>
+#include <QFileInfo>
+#include <QCryptographicHash>
 #include <Eigen/Dense>
 
 #include "ParametersManager.h"
 #include "Parameter.h"
 #include "algorithms_definitions.h"
 #include "Algorithms.h"
+#include "CloudOptimizedGeoTiff.h"
 #include "Raster.h"
 #include "PersistenceManager.h"
 #include "persistencemanager_definitions.h"
@@ -34,6 +37,7 @@ Algorithms::Algorithms(libCRS::CRSTools *ptrCrsTools,
 {
     mPtrParametersManager=NULL;
     mIsInitialized=false;
+    mOutputProfile=REMOTESENSING_OUTPUT_PROFILE_DEFAULT;
     mPtrWidgetParent=ptrWidgetParent;
     if(mPtrWidgetParent==NULL)
     {
@@ -778,6 +782,13 @@ bool Algorithms::applyIntercalibration(QString inputFileName,
     */
     delete(ptrOutputRasterFile);
     delete(ptrInputRasterFile);
+    if(!writeOutputProfile(outputFileName,ALGORITHMS_INTC_CODE,
+                           ALGORITHMS_COG_OVERVIEW_RESAMPLING,strAuxError))
+    {
+        strError=QObject::tr("Algorithms::applyIntercalibration");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
     return(true);
 }
 
@@ -5003,6 +5014,75 @@ bool Algorithms::getAlgorithmsGuiTags(QVector<QString>& algorithmsCodes,
     return(true);
 }
 
+bool Algorithms::getMustComputeProduct(QString outputFileName,
+                                       QString algorithmCode,
+                                       QString fingerprint,
+                                       bool reprocess,
+                                       bool &mustCompute,
+                                       QString &strError)
+{
+    mustCompute=true;
+    // reprocess fuerza el calculo aunque la huella coincida
+    if(reprocess||!QFile::exists(outputFileName))
+    {
+        return(true);
+    }
+    QString strAuxError;
+    QString previousFingerprint;
+    if(!mPtrPersistenceManager->getProductFingerprint(outputFileName,
+                                                      previousFingerprint,
+                                                      strAuxError))
+    {
+        strError=QObject::tr("Algorithms::getMustComputeProduct");
+        strError+=QObject::tr("\nError recovering fingerprint for file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        return(false);
+    }
+    // Producto sin huella (calculado con una version anterior). INTC siempre se reescribia,
+    // el resto se mantiene como antes y se adopta guardando la huella actual
+    if(previousFingerprint.isEmpty())
+    {
+        if(algorithmCode.compare(ALGORITHMS_INTC_CODE,Qt::CaseInsensitive)==0)
+        {
+            return(true);
+        }
+        if(!mPtrPersistenceManager->insertProductFingerprint(outputFileName,
+                                                             algorithmCode,
+                                                             fingerprint,
+                                                             strAuxError))
+        {
+            strError=QObject::tr("Algorithms::getMustComputeProduct");
+            strError+=QObject::tr("\nError storing fingerprint for file:\n%1\nError:\n%2")
+                    .arg(outputFileName).arg(strAuxError);
+            return(false);
+        }
+        mustCompute=false;
+        return(true);
+    }
+    mustCompute=(previousFingerprint.compare(fingerprint)!=0);
+    return(true);
+}
+
+QString Algorithms::getOutputProfile(QString algorithmCode)
+{
+    // Parametro <algoritmo>_OutputProfile si esta en el fichero de parametros, si no el general
+    QString outputProfile=mOutputProfile;
+    if(mPtrParametersManager!=NULL)
+    {
+        Parameter* ptrParameter=mPtrParametersManager->getParameter(algorithmCode+ALGORITHMS_PARAMETER_OUTPUT_PROFILE_SUFFIX);
+        if(ptrParameter!=NULL)
+        {
+            QString value;
+            ptrParameter->getValue(value);
+            if(!value.isEmpty())
+            {
+                outputProfile=value;
+            }
+        }
+    }
+    return(outputProfile);
+}
+
 bool Algorithms::getParameterValue(QString algorithm,
                                    QString code,
                                    QString &value,
@@ -5030,6 +5110,67 @@ bool Algorithms::getParametersTagAndValues(QString command,
     return(mPtrParametersManager->getParametersTagAndValues(command,codes,tags,values,strError));
 }
 
+bool Algorithms::getProductFingerprint(QString algorithmCode,
+                                       QVector<QString> &parametersCommands,
+                                       QVector<QString> &inputFileNames,
+                                       QVector<QString> &values,
+                                       QString &fingerprint,
+                                       QString &strError)
+{
+    fingerprint.clear();
+    if(mPtrParametersManager==NULL)
+    {
+        strError=QObject::tr("Algorithms::getProductFingerprint, parameters is NULL");
+        return(false);
+    }
+    // Huella: algoritmo, identidad de los ficheros de entrada (ruta, tamaño y fecha de modificacion),
+    // valores de los parametros de los comandos indicados y valores adicionales
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QString(algorithmCode+"\n").toUtf8());
+    for(int nf=0;nf<inputFileNames.size();nf++)
+    {
+        QFileInfo inputFileInfo(inputFileNames.at(nf));
+        if(!inputFileInfo.exists())
+        {
+            strError=QObject::tr("Algorithms::getProductFingerprint");
+            strError+=QObject::tr("\nNot exists input file:\n%1").arg(inputFileNames.at(nf));
+            return(false);
+        }
+        QString strInputFile=inputFileInfo.absoluteFilePath();
+        strInputFile+=(";"+QString::number(inputFileInfo.size()));
+        strInputFile+=(";"+QString::number(inputFileInfo.lastModified().toMSecsSinceEpoch()));
+        hash.addData(QString(strInputFile+"\n").toUtf8());
+    }
+    for(int nc=0;nc<parametersCommands.size();nc++)
+    {
+        QVector<QString> codes,tags,parametersValues;
+        QString strAuxError;
+        // Un comando sin parametros no aporta nada a la huella
+        if(!mPtrParametersManager->getParametersTagAndValues(parametersCommands.at(nc),
+                                                             codes,tags,parametersValues,
+                                                             strAuxError))
+        {
+            continue;
+        }
+        for(int np=0;np<codes.size();np++)
+        {
+            hash.addData(QString(codes.at(np)+"="+parametersValues.at(np)+"\n").toUtf8());
+        }
+    }
+    for(int nv=0;nv<values.size();nv++)
+    {
+        hash.addData(QString(values.at(nv)+"\n").toUtf8());
+    }
+    // Solo cuenta si no es el perfil por defecto, para conservar las huellas anteriores
+    QString outputProfile=getOutputProfile(algorithmCode);
+    if(outputProfile.compare(REMOTESENSING_OUTPUT_PROFILE_DEFAULT,Qt::CaseInsensitive)!=0)
+    {
+        hash.addData(QString(ALGORITHMS_PARAMETER_OUTPUT_PROFILE_SUFFIX"="+outputProfile+"\n").toUtf8());
+    }
+    fingerprint=QString::fromLatin1(hash.result().toHex());
+    return(true);
+}
+
 bool Algorithms::initialize(QString libPath,
                             QString &strError)
 {
@@ -6926,17 +7067,63 @@ bool Algorithms::intercalibrationComputation(QVector<QString> &rasterFiles,
                                         QString auxStrError;
                                         double multValue=reflectanceMultValueByRasterFileAndByBand[rasterFile][bandId];
                                         double addValue=reflectanceAddValueByRasterFileAndByBand[rasterFile][bandId];
-                                        if(!applyIntercalibration(rasterFileName,
-                                                                  intercalibratedRasterFileName,writeImageFilesTo8Bits,
-                                                                  gain,offset,to8Bits,
-                                                                  toReflectance,multValue,addValue,
+                                        QString intcFingerprint;
+                                        QVector<QString> parametersCommands;
+                                        parametersCommands.push_back(ALGORITHMS_INTC_CODE);
+                                        QVector<QString> inputFileNames;
+                                        inputFileNames.push_back(rasterFileName);
+                                        QVector<QString> fingerprintValues;
+                                        fingerprintValues.push_back(QString::number(gain,'g',17));
+                                        fingerprintValues.push_back(QString::number(offset,'g',17));
+                                        fingerprintValues.push_back(QString::number(multValue,'g',17));
+                                        fingerprintValues.push_back(QString::number(addValue,'g',17));
+                                        fingerprintValues.push_back(writeImageFilesTo8Bits?"1":"0");
+                                        fingerprintValues.push_back(to8Bits?"1":"0");
+                                        fingerprintValues.push_back(toReflectance?"1":"0");
+                                        if(!getProductFingerprint(ALGORITHMS_INTC_CODE,
+                                                                  parametersCommands,
+                                                                  inputFileNames,
+                                                                  fingerprintValues,
+                                                                  intcFingerprint,
                                                                   auxStrError))
                                         {
                                             strError=QObject::tr("Algorithms::intercalibrationComputation");
-                                            strError+=QObject::tr("\nError applying intercalibration to file:\n%1\nError:\n%2")
-                                                    .arg(rasterFileName).arg(auxStrError);
+                                            strError+=QObject::tr("\nError computing fingerprint for file:\n%1\nError:\n%2")
+                                                    .arg(intercalibratedRasterFileName).arg(auxStrError);
+                                            return(false);
+                                        }
+                                        bool mustCompute=false;
+                                        if(!getMustComputeProduct(intercalibratedRasterFileName,ALGORITHMS_INTC_CODE,intcFingerprint,
+                                                                  reprocessFiles,mustCompute,auxStrError))
+                                        {
+                                            strError=QObject::tr("Algorithms::intercalibrationComputation");
+                                            strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
                                             return(false);
                                         }
+                                        if(mustCompute)
+                                        {
+                                            if(!applyIntercalibration(rasterFileName,
+                                                                      intercalibratedRasterFileName,writeImageFilesTo8Bits,
+                                                                      gain,offset,to8Bits,
+                                                                      toReflectance,multValue,addValue,
+                                                                      auxStrError))
+                                            {
+                                                strError=QObject::tr("Algorithms::intercalibrationComputation");
+                                                strError+=QObject::tr("\nError applying intercalibration to file:\n%1\nError:\n%2")
+                                                        .arg(rasterFileName).arg(auxStrError);
+                                                return(false);
+                                            }
+                                            if(!mPtrPersistenceManager->insertProductFingerprint(intercalibratedRasterFileName,
+                                                                                                 ALGORITHMS_INTC_CODE,
+                                                                                                 intcFingerprint,
+                                                                                                 auxStrError))
+                                            {
+                                                strError=QObject::tr("Algorithms::intercalibrationComputation");
+                                                strError+=QObject::tr("\nError storing fingerprint in database:\nIntercalibrated file:%1\nError:\n%2")
+                                                        .arg(intercalibratedRasterFileName).arg(auxStrError);
+                                                return(false);
+                                            }
+                                        }
                                     }
                                     iterWIBand++;
                                 }
@@ -7016,8 +7203,46 @@ bool Algorithms::ndviComputation(QString quadkey,
         strError+=QObject::tr("\nRaster unit conversion invalid: %1").arg(rasterUnitConversion);
         return(false);
     }
-    if(!QFile::exists(outputFileName)
-            ||reprocess)
+    QString fingerprint;
+    bool mustCompute=false;
+    // Las entradas solo se exigen si hay que recalcular: un producto existente cuyas
+    // reflectividades se han borrado se conserva
+    if(reprocess
+            ||!QFile::exists(outputFileName)
+            ||(QFile::exists(redFileName)&&QFile::exists(nirFileName)))
+    {
+        QVector<QString> parametersCommands;
+        parametersCommands.push_back(ALGORITHMS_NDVI_CODE);
+        QVector<QString> inputFileNames;
+        inputFileNames.push_back(redFileName);
+        inputFileNames.push_back(nirFileName);
+        QVector<QString> fingerprintValues;
+        QString strReflNoDataValue;
+        mPtrParametersManager->getParameter(ALGORITHMS_REFL_PARAMETER_NO_DATA_VALUE)->getValue(strReflNoDataValue);
+        fingerprintValues.push_back(computationMethod);
+        fingerprintValues.push_back(to8Bits?"1":"0");
+        fingerprintValues.push_back(rasterUnitConversion);
+        fingerprintValues.push_back(strReflNoDataValue);
+        if(!getProductFingerprint(ALGORITHMS_NDVI_CODE,
+                                  parametersCommands,
+                                  inputFileNames,
+                                  fingerprintValues,
+                                  fingerprint,
+                                  strAuxError))
+        {
+            strError=QObject::tr("Algorithms::ndviComputation");
+            strError+=QObject::tr("\nError computing fingerprint for file:\n%1\nError:\n%2")
+                    .arg(outputFileName).arg(strAuxError);
+            return(false);
+        }
+        if(!getMustComputeProduct(outputFileName,ALGORITHMS_NDVI_CODE,fingerprint,reprocess,mustCompute,strAuxError))
+        {
+            strError=QObject::tr("Algorithms::ndviComputation");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    if(mustCompute)
     {
         QString strNoDataValue;
         mPtrParametersManager->getParameter(ALGORITHMS_REFL_PARAMETER_NO_DATA_VALUE)->getValue(strNoDataValue);
@@ -7031,6 +7256,9 @@ bool Algorithms::ndviComputation(QString quadkey,
         bool buildOverviews=false;
         if(strBuildOverviews.compare("yes",Qt::CaseInsensitive)==0)
             buildOverviews=true;
+        // El perfil COG escribe las overviews junto con los datos
+        if(CloudOptimizedGeoTiff::isCogOutputProfile(getOutputProfile(ALGORITHMS_NDVI_CODE)))
+            buildOverviews=false;
         IGDAL::Raster* ptrRedRasterFile=new IGDAL::Raster(mPtrCrsTools);
         if(!ptrRedRasterFile->setFromFile(redFileName,strAuxError))
         {
@@ -7271,6 +7499,13 @@ bool Algorithms::ndviComputation(QString quadkey,
         free(nirData);
         free(pData);
         delete(ptrNdviRasterFile);
+        if(!writeOutputProfile(outputFileName,ALGORITHMS_NDVI_CODE,
+                               ALGORITHMS_COG_OVERVIEW_RESAMPLING,strAuxError))
+        {
+            strError=QObject::tr("Algorithms::ndviComputation");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
         int lodTiles=0;
         int lodGsd=0;
         if(!mPtrPersistenceManager->insertNdviTuplekeyFile(quadkey,
@@ -7287,6 +7522,16 @@ bool Algorithms::ndviComputation(QString quadkey,
                     .arg(outputFileName).arg(strAuxError);
             return(false);
         }
+        if(!mPtrPersistenceManager->insertProductFingerprint(outputFileName,
+                                                             ALGORITHMS_NDVI_CODE,
+                                                             fingerprint,
+                                                             strAuxError))
+        {
+            strError=QObject::tr("Algorithms::ndviComputation");
+            strError+=QObject::tr("\nError storing fingerprint in database:\nNdvi file:%1\nError:\n%2")
+                    .arg(outputFileName).arg(strAuxError);
+            return(false);
+        }
     }
     else if(readValues)
     {
@@ -7496,6 +7741,11 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
     bool piasBuildOverviews=false;
     if(strBuildOverviews.compare("yes",Qt::CaseInsensitive)==0)
         piasBuildOverviews=true;
+    // El perfil COG escribe las overviews junto con los datos
+    if(CloudOptimizedGeoTiff::isCogOutputProfile(getOutputProfile(ALGORITHMS_NDVI_CODE)))
+        ndviBuildOverviews=false;
+    if(CloudOptimizedGeoTiff::isCogOutputProfile(getOutputProfile(ALGORITHMS_PIAS_CODE)))
+        piasBuildOverviews=false;
     int cloudValue=strCloudValue.toInt();
     QString strNdviNoDataValue,piasImageFileExtension;
     if(piasComputationMethod.compare(ALGORITHMS_PIAS_PARAMETER_COMPUTATION_METHOD_1)!=0)
@@ -7652,8 +7902,10 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
         // si se han eliminado dira que son distintos porque se va a calcular con otros
         QString previousPiasFileName;
         int previousPiasFileId;
+        QString piasFingerprint;
         {
             QVector<QString> usedRasterFilesInQuadkey;
+            QVector<QString> usedBandsRasterFilesInQuadkey;
             for(int nrf=0;nrf<numberOfRasterFilesInQuadkey;nrf++)
             {
                 QString rasterFile=rasterFilesInQuadkey[nrf];
@@ -7702,6 +7954,8 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                     continue;
                 }
                 usedRasterFilesInQuadkey.push_back(rasterFile);
+                usedBandsRasterFilesInQuadkey.push_back(redBandRasterFile);
+                usedBandsRasterFilesInQuadkey.push_back(nirBandRasterFile);
             }
             if(usedRasterFilesInQuadkey.size()<2)
             {
@@ -7721,10 +7975,36 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                         .arg(piasFileName).arg(strAuxError);
                 return(false);
             }
+            // Los NDVI se calculan dentro, por eso entran sus parametros y los de reflectividades
+            QVector<QString> parametersCommands;
+            parametersCommands.push_back(ALGORITHMS_PIAS_CODE);
+            parametersCommands.push_back(ALGORITHMS_NDVI_CODE);
+            parametersCommands.push_back(ALGORITHMS_REFL_CODE);
+            QVector<QString> fingerprintValues;
+            fingerprintValues.push_back(quadkey);
+            if(!getProductFingerprint(ALGORITHMS_PIAS_CODE,
+                                      parametersCommands,
+                                      usedBandsRasterFilesInQuadkey,
+                                      fingerprintValues,
+                                      piasFingerprint,
+                                      strAuxError))
+            {
+                strError=QObject::tr("Algorithms::piasComputation");
+                strError+=QObject::tr("\nError computing fingerprint for quadkey: %1\nError:\n%2")
+                        .arg(quadkey).arg(strAuxError);
+                return(false);
+            }
         }
         if(!previousPiasFileName.isEmpty())
         {
-            if(!reprocessFiles)
+            bool mustCompute=false;
+            if(!getMustComputeProduct(previousPiasFileName,ALGORITHMS_PIAS_CODE,piasFingerprint,reprocessFiles,mustCompute,strAuxError))
+            {
+                strError=QObject::tr("Algorithms::piasComputation");
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
+            if(!mustCompute)
             {
                 out<<"\n"<<"    - PIAS file name .......................: Exits file, "<<previousPiasFileName<<"\n";
                 iterRasterFilesByQuadkey++;
@@ -7742,6 +8022,14 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                             .arg(previousPiasFileName).arg(strAuxError);
                     return(false);
                 }
+                if(!mPtrPersistenceManager->deleteProductFingerprint(previousPiasFileName,
+                                                                     strAuxError))
+                {
+                    strError=QObject::tr("Algorithms::piasComputation");
+                    strError+=QObject::tr("\nError deleting fingerprint in database:\nPias file:%1\nError:\n%2")
+                            .arg(previousPiasFileName).arg(strAuxError);
+                    return(false);
+                }
             }
         }
         out<<"\n"<<"    - PIAS file name .......................: "<<piasFileName<<"\n";
@@ -7841,9 +8129,7 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                 reflectanceRedBandRasterFile=redBandRasterFileInfo.absolutePath()+"/"+redBandRasterFileInfo.baseName();
                 reflectanceRedBandRasterFile+=(reflectanceSuffixFileName+"_"+reflectanceComputationMethod+"."+reflectanceImageFileExtension);
                 double sunElevation=sunElevationByRasterFile[rasterFile];
-                if(!QFile::exists(reflectanceRedBandRasterFile)
-                        ||reprocessFiles)
-//                if(!QFile::exists(reflectanceRedBandRasterFile))
+                // Se recalcula solo si no existe o si ha cambiado su huella
                 {
                     double addValue=reflectanceAddValueByRasterFileAndByBand[rasterFile][REMOTESENSING_LANDSAT8_BAND_B4_CODE];
                     double multValue=reflectanceMultValueByRasterFileAndByBand[rasterFile][REMOTESENSING_LANDSAT8_BAND_B4_CODE];
@@ -7852,6 +8138,7 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                                                sunElevation,
                                                addValue,
                                                multValue,
+                                               reprocessFiles,
                                                strAuxError))
                     {
                         strError=QObject::tr("Algorithms::piasComputation");
@@ -7863,9 +8150,6 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                 QFileInfo nirBandRasterFileInfo(nirBandRasterFile);
                 reflectanceNirBandRasterFile=nirBandRasterFileInfo.absolutePath()+"/"+nirBandRasterFileInfo.baseName();
                 reflectanceNirBandRasterFile+=(reflectanceSuffixFileName+"_"+reflectanceComputationMethod+"."+reflectanceImageFileExtension);
-                if(!QFile::exists(reflectanceNirBandRasterFile)
-                    ||reprocessFiles)
-//                if(!QFile::exists(reflectanceNirBandRasterFile))
                 {
                     double addValue=reflectanceAddValueByRasterFileAndByBand[rasterFile][REMOTESENSING_LANDSAT8_BAND_B5_CODE];
                     double multValue=reflectanceMultValueByRasterFileAndByBand[rasterFile][REMOTESENSING_LANDSAT8_BAND_B5_CODE];
@@ -7874,6 +8158,7 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                                                sunElevation,
                                                addValue,
                                                multValue,
+                                               reprocessFiles,
                                                strAuxError))
                     {
                         strError=QObject::tr("Algorithms::piasComputation");
@@ -8304,6 +8589,15 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                 CPLFree(ndviMeanData);
                 delete(ptrNdviStdRasterFile);
                 CPLFree(ndviStdData);
+                if(!writeOutputProfile(ndviMeanFileName,ALGORITHMS_NDVI_CODE,
+                                       ALGORITHMS_COG_OVERVIEW_RESAMPLING,strAuxError)
+                        ||!writeOutputProfile(ndviStdFileName,ALGORITHMS_NDVI_CODE,
+                                              ALGORITHMS_COG_OVERVIEW_RESAMPLING,strAuxError))
+                {
+                    strError=QObject::tr("Algorithms::piasComputation");
+                    strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                    return(false);
+                }
             }
         }
         if(ptrPiasRasterFile!=NULL) // si no se ha calculado no hay que hacer lo que sigue
@@ -8317,6 +8611,13 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
             }
             delete(ptrPiasRasterFile);
             CPLFree(piasData);
+            if(!writeOutputProfile(piasFileName,ALGORITHMS_PIAS_CODE,
+                                   ALGORITHMS_PIAS_COG_OVERVIEW_RESAMPLING,strAuxError))
+            {
+                strError=QObject::tr("Algorithms::piasComputation");
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
             if(ndvisByJd.size()>1)
             {
                 QMap<QString,int> jdByUsedRasterFilesInQuadkey;
@@ -8345,6 +8646,16 @@ bool Algorithms::piasComputation(QVector<QString> &rasterFiles,
                             .arg(piasFileName).arg(strAuxError);
                     return(false);
                 }
+                if(!mPtrPersistenceManager->insertProductFingerprint(piasFileName,
+                                                                     ALGORITHMS_PIAS_CODE,
+                                                                     piasFingerprint,
+                                                                     strAuxError))
+                {
+                    strError=QObject::tr("Algorithms::piasComputation");
+                    strError+=QObject::tr("\nError storing fingerprint in database:\nPias file:%1\nError:\n%2")
+                            .arg(piasFileName).arg(strAuxError);
+                    return(false);
+                }
             }
     //        break;
         }
@@ -8565,9 +8876,51 @@ bool Algorithms::reflectanceComputation(QString inputFileName,
                                         double sunElevation,
                                         double addValue,
                                         double multValue,
+                                        bool reprocess,
                                         QString &strError)
 {
     QString strAuxError;
+    // Producto existente cuya entrada se ha borrado: se conserva
+    if(!reprocess
+            &&QFile::exists(outputFileName)
+            &&!QFile::exists(inputFileName))
+    {
+        return(true);
+    }
+    QString fingerprint;
+    {
+        QVector<QString> parametersCommands;
+        parametersCommands.push_back(ALGORITHMS_REFL_CODE);
+        QVector<QString> inputFileNames;
+        inputFileNames.push_back(inputFileName);
+        QVector<QString> fingerprintValues;
+        fingerprintValues.push_back(QString::number(sunElevation,'g',17));
+        fingerprintValues.push_back(QString::number(addValue,'g',17));
+        fingerprintValues.push_back(QString::number(multValue,'g',17));
+        if(!getProductFingerprint(ALGORITHMS_REFL_CODE,
+                                  parametersCommands,
+                                  inputFileNames,
+                                  fingerprintValues,
+                                  fingerprint,
+                                  strAuxError))
+        {
+            strError=QObject::tr("Algorithms::reflectanceComputation");
+            strError+=QObject::tr("\nError computing fingerprint for file:\n%1\nError:\n%2")
+                    .arg(outputFileName).arg(strAuxError);
+            return(false);
+        }
+    }
+    bool mustCompute=false;
+    if(!getMustComputeProduct(outputFileName,ALGORITHMS_REFL_CODE,fingerprint,reprocess,mustCompute,strAuxError))
+    {
+        strError=QObject::tr("Algorithms::reflectanceComputation");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(!mustCompute)
+    {
+        return(true);
+    }
     QString strNoDataValue;
     mPtrParametersManager->getParameter(ALGORITHMS_REFL_PARAMETER_NO_DATA_VALUE)->getValue(strNoDataValue);
     double noDataValue=strNoDataValue.toDouble();
@@ -8578,6 +8931,9 @@ bool Algorithms::reflectanceComputation(QString inputFileName,
     bool buildOverviews=false;
     if(strBuildOverviews.compare("yes",Qt::CaseInsensitive)==0)
         buildOverviews=true;
+    // El perfil COG escribe las overviews junto con los datos
+    if(CloudOptimizedGeoTiff::isCogOutputProfile(getOutputProfile(ALGORITHMS_REFL_CODE)))
+        buildOverviews=false;
     IGDAL::Raster* ptrDlRasterFile=new IGDAL::Raster(mPtrCrsTools);
     if(!ptrDlRasterFile->setFromFile(inputFileName,strAuxError))
     {
@@ -8705,6 +9061,23 @@ bool Algorithms::reflectanceComputation(QString inputFileName,
         }
     }
     delete(ptrReflectanceRasterFile);
+    if(!writeOutputProfile(outputFileName,ALGORITHMS_REFL_CODE,
+                           ALGORITHMS_COG_OVERVIEW_RESAMPLING,strAuxError))
+    {
+        strError=QObject::tr("Algorithms::reflectanceComputation");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(!mPtrPersistenceManager->insertProductFingerprint(outputFileName,
+                                                         ALGORITHMS_REFL_CODE,
+                                                         fingerprint,
+                                                         strAuxError))
+    {
+        strError=QObject::tr("Algorithms::reflectanceComputation");
+        strError+=QObject::tr("\nError storing fingerprint in database:\nReflectance file:%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        return(false);
+    }
     return(true);
 }
 
@@ -9281,5 +9654,36 @@ bool Algorithms::writeCloudRemovedFile(QString inputFileName,
     */
     delete(ptrOutputRasterFile);
 //    delete(ptrInputRasterFile);
+    if(!writeOutputProfile(outputFileName,ALGORITHMS_CLOUDREMOVAL_CODE,
+                           ALGORITHMS_COG_OVERVIEW_RESAMPLING,strAuxError))
+    {
+        strError=QObject::tr("Algorithms::writeCloudRemovedFile");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    return(true);
+}
+
+bool Algorithms::writeOutputProfile(QString fileName,
+                                    QString algorithmCode,
+                                    QString overviewResampling,
+                                    QString &strError)
+{
+    if(!CloudOptimizedGeoTiff::isCogOutputProfile(getOutputProfile(algorithmCode)))
+    {
+        return(true);
+    }
+    // Los productos se crean en disco con IGDAL::Raster, que no escribe en memoria: el perfil
+    // COG cuesta una segunda escritura completa (copia temporal y renombrado)
+    QString strAuxError;
+    if(!CloudOptimizedGeoTiff::translateFile(fileName,
+                                             REMOTESENSING_COG_BLOCK_SIZE,
+                                             overviewResampling,
+                                             strAuxError))
+    {
+        strError=QObject::tr("Algorithms::writeOutputProfile");
+        strError+=QObject::tr("\nError writing COG file:\n%1\nError:\n%2").arg(fileName).arg(strAuxError);
+        return(false);
+    }
     return(true);
 }
@@ -99,6 +99,12 @@ public:
     bool getAlgorithmsGuiTags(QVector<QString> &algorithmsCodes,
                               QMap<QString,QString>& algorithmsGuiTags,
                               QString& strError);
+    bool getMustComputeProduct(QString outputFileName,
+                               QString algorithmCode,
+                               QString fingerprint,
+                               bool reprocess,
+                               bool& mustCompute,
+                               QString& strError);
     bool getParameterValue(QString algorithm,
                            QString code,
                            QString &value,
@@ -109,6 +115,12 @@ public:
                                    QVector<QString> &tags,
                                    QVector<QString> &values,
                                    QString &strError);
+    bool getProductFingerprint(QString algorithmCode,
+                               QVector<QString>& parametersCommands,
+                               QVector<QString>& inputFileNames,
+                               QVector<QString>& values,
+                               QString& fingerprint,
+                               QString& strError);
     bool initialize(QString libPath,
                     QString& strError);
     bool intercalibrationComputation(QVector<QString>& rasterFiles,
@@ -174,8 +186,10 @@ public:
                                 double sunElevation,
                                 double addValue,
                                 double multValue,
+                                bool reprocess,
                                 QString& strError);
     bool setAlgorithms(QString& strError);
+    void setOutputProfile(QString outputProfile){mOutputProfile=outputProfile;}
     bool setParametersForAlgorithm(QString command,
                                    QString &strError,
                                    QWidget *ptrWidget);
@@ -186,6 +200,11 @@ public:
                                QVector<QVector<double> >& bandData,
                                QString& strError);
 private:
+    QString getOutputProfile(QString algorithmCode);
+    bool writeOutputProfile(QString fileName,
+                            QString algorithmCode,
+                            QString overviewResampling,
+                            QString& strError);
     QString mFileName;
     QString mStrExecution;
     ProcessTools::MultiProcess *mPtrMultiProcess;
@@ -194,6 +213,7 @@ private:
     NestedGrid::NestedGridTools* mPtrNestedGridTools;
     IGDAL::libIGDALProcessMonitor* mPtrLibIGDALProcessMonitor;
     ParametersManager* mPtrParametersManager;
+    QString mOutputProfile; // perfil de los ficheros de productos
     bool mIsInitialized;
     QMap<QString,QString> mAlgorithmsGuiTagsByCode;
     QVector<QString> mAlgorithmsCodes;
@@ -4,6 +4,10 @@
 #include <QWidget>
 #include <QFile>
 #include <QDate>
+#include <QPair>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 #include "../../libs/libCRS/CRSTools.h"
 #include "../../libs/libNestedGrid/NestedGridTools.h"
@@ -16,9 +20,262 @@
 #include "../../libs/libProcessTools/ExternalProcess.h"
 
 #include "ClassificationProject.h"
+#include "ColumnarTableWriter.h"
+#include "RasterBlockCache.h"
+#include "RoiCoverageMask.h"
+#include "RoiGeometryCache.h"
+#include "StatisticsAccumulator.h"
+#include "ZonalStatisticsEngine.h"
 
 using namespace RemoteSensing;
 
+namespace{
+// NDVI de cada pixel con valor en el acumulador de un ROI, satelite y fecha
+class ClassificationNdviReducer : public ZonalStatisticsReducer
+{
+public:
+    ClassificationNdviReducer():
+        mPtrAccumulator(NULL),
+        mExistsNoDataValue(false),
+        mRasterNoDataValue(0)
+    {
+    }
+    ClassificationNdviReducer(StatisticsAccumulator* ptrAccumulator,
+                              bool existsNoDataValue,
+                              int rasterNoDataValue):
+        mPtrAccumulator(ptrAccumulator),
+        mExistsNoDataValue(existsNoDataValue),
+        mRasterNoDataValue(rasterNoDataValue)
+    {
+    }
+    bool addValue(const ZonalStatisticsRasterFile& rasterFile,
+                  double value,
+                  bool isValid,
+                  bool& finished,
+                  QString& strError)
+    {
+        Q_UNUSED(strError);
+        finished=false;
+        if(!isValid)
+        {
+            return(true);
+        }
+        int rasterValue=qRound(value*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
+        if(mExistsNoDataValue
+                &&rasterValue==mRasterNoDataValue)
+        {
+            return(true);
+        }
+        double ndvi=((double)rasterValue)/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE*rasterFile.gain+rasterFile.offset;
+        mPtrAccumulator->addValue(qRound(ndvi*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE));
+        return(true);
+    }
+private:
+    StatisticsAccumulator* mPtrAccumulator;
+    bool mExistsNoDataValue;
+    int mRasterNoDataValue;
+};
+
+// Datos de cada fichero NDVI que usan las tareas, obtenidos antes en el hilo principal
+struct ClassificationRasterFile
+{
+    QString spacecraftId;
+    double gain;
+    double offset;
+    int lodTiles;
+    int lodGsd;
+    double gsd;
+    double nwFc; // puede no coincidir con georef porque en algunos casos georef va al centro del pixel
+    double nwSc;
+    int columns;
+    int rows;
+};
+
+// Procesa un tuplekey: cada fichero NDVI se lee una vez y actualiza los acumuladores de todos
+// los ROIs que lo usan. Los acumuladores son propios de la tarea y se fusionan al terminar
+class ClassificationTuplekeyTask : public QRunnable
+{
+public:
+    ClassificationTuplekeyTask(QString tuplekey,
+                               int tuplekeyId,
+                               QMap<int,QMap<int,QVector<QString> > > fileNamesByRoiCodeByJd,
+                               QMap<QString,ClassificationRasterFile> rasterFileByFileName,
+                               QMap<int,QVector<QString> > tuplekeysByRoiCode,
+                               RoiGeometryCache* ptrRoiGeometryCache,
+                               ZonalStatisticsEngine* ptrZonalStatisticsEngine):
+        mTuplekey(tuplekey),
+        mTuplekeyId(tuplekeyId),
+        mFileNamesByRoiCodeByJd(fileNamesByRoiCodeByJd),
+        mRasterFileByFileName(rasterFileByFileName),
+        mTuplekeysByRoiCode(tuplekeysByRoiCode),
+        mPtrRoiGeometryCache(ptrRoiGeometryCache),
+        mPtrZonalStatisticsEngine(ptrZonalStatisticsEngine),
+        mSuccess(false)
+    {
+        setAutoDelete(false);
+    }
+    void run();
+    const QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > >& getAccumulators(){return(mAccumulatorByRoiCodeBySpacecraftByJd);}
+    QString getError(){return(mStrError);}
+    QString getReport(){return(mReport);}
+    bool getSuccess(){return(mSuccess);}
+private:
+    bool process(QMap<int,OGRGeometry*>& ptrGeometryByRoiCode,
+                 QString& strError);
+    QString mTuplekey;
+    int mTuplekeyId;
+    QMap<int,QMap<int,QVector<QString> > > mFileNamesByRoiCodeByJd;
+    QMap<QString,ClassificationRasterFile> mRasterFileByFileName;
+    QMap<int,QVector<QString> > mTuplekeysByRoiCode;
+    RoiGeometryCache* mPtrRoiGeometryCache;
+    ZonalStatisticsEngine* mPtrZonalStatisticsEngine;
+    QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > > mAccumulatorByRoiCodeBySpacecraftByJd;
+    QString mReport;
+    bool mSuccess;
+    QString mStrError;
+};
+
+void ClassificationTuplekeyTask::run()
+{
+    QMap<int,OGRGeometry*> ptrGeometryByRoiCode;
+    mSuccess=process(ptrGeometryByRoiCode,mStrError);
+    QMap<int,OGRGeometry*>::iterator iterGeometry=ptrGeometryByRoiCode.begin();
+    while(iterGeometry!=ptrGeometryByRoiCode.end())
+    {
+        OGRGeometryFactory::destroyGeometry(iterGeometry.value());
+        iterGeometry++;
+    }
+}
+
+bool ClassificationTuplekeyTask::process(QMap<int,OGRGeometry*>& ptrGeometryByRoiCode,
+                                         QString &strError)
+{
+    QString strAuxError;
+    QTextStream out(&mReport);
+    out<<"- Tuplekey a procesar ...............: "<<mTuplekey<<"\n";
+    // Interseccion de cada ROI con el tuplekey y pares ROI-fecha que usan cada fichero
+    QMap<int,bool> roiContainsTuplekeyByRoiCode;
+    QVector<QString> fileNames;
+    QMap<QString,QVector<QPair<int,int> > > roiCodeAndJdByFileName;
+    QMap<int,QMap<int,QVector<QString> > >::const_iterator iterRoi=mFileNamesByRoiCodeByJd.constBegin();
+    while(iterRoi!=mFileNamesByRoiCodeByJd.constEnd())
+    {
+        int roiCode=iterRoi.key();
+        out<<"  - ROI a procesar ..................: "<<QString::number(roiCode);
+        out<<" ("<<QString::number(mTuplekeysByRoiCode.value(roiCode).size())<<" tuplekeys)"<<"\n";
+        OGRGeometry* ptrRoiTuplekeyIntersectionGeometry=NULL;
+        bool roiContainsTuplekey=false;
+        if(!mPtrRoiGeometryCache->getRoiTuplekeyIntersectionGeometry(QString::number(roiCode),
+                                                                     mTuplekeyId,
+                                                                     ptrRoiTuplekeyIntersectionGeometry,
+                                                                     roiContainsTuplekey,
+                                                                     strAuxError))
+        {
+            strError=QObject::tr("Error recovering intersection for tuplekey: %1, for roi: %2\nError:\n%3")
+                    .arg(mTuplekey).arg(QString::number(roiCode)).arg(strAuxError);
+            return(false);
+        }
+        ptrGeometryByRoiCode[roiCode]=ptrRoiTuplekeyIntersectionGeometry;
+        roiContainsTuplekeyByRoiCode[roiCode]=roiContainsTuplekey;
+        QMap<int,QVector<QString> >::const_iterator iterJd=iterRoi.value().constBegin();
+        while(iterJd!=iterRoi.value().constEnd())
+        {
+            int jd=iterJd.key();
+            out<<"    - Fecha a procesar ..............: "<<QString::number(jd);
+            out<<" - "<<QDate::fromJulianDay(jd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1)<<"\n";
+            const QVector<QString>& rasterFileNames=iterJd.value();
+            for(int nrf=0;nrf<rasterFileNames.size();nrf++)
+            {
+                QString rasterFileName=rasterFileNames.at(nrf);
+                out<<"      - Fichero a procesar ..........: "<<rasterFileName<<"\n";
+                if(!roiCodeAndJdByFileName.contains(rasterFileName))
+                {
+                    fileNames.push_back(rasterFileName);
+                }
+                roiCodeAndJdByFileName[rasterFileName].push_back(qMakePair(roiCode,jd));
+            }
+            iterJd++;
+        }
+        iterRoi++;
+    }
+    out.flush();
+    // Una mascara por ROI y malla (lod de tiles y de gsd)
+    QMap<int,QMap<QString,RoiCoverageMask> > coverageMaskByGridByRoiCode;
+    for(int nf=0;nf<fileNames.size();nf++)
+    {
+        QString rasterFileName=fileNames[nf];
+        const ClassificationRasterFile rasterFile=mRasterFileByFileName.value(rasterFileName);
+        bool existsNoDataValue=false;
+        double dblRasterNoDataValue;
+        if(!mPtrZonalStatisticsEngine->getRasterBlockCache()->getNoDataValue(rasterFileName,existsNoDataValue,dblRasterNoDataValue,strAuxError))
+        {
+            strError=QObject::tr("Error opening raster file:\n%1\nError:\n%2").arg(rasterFileName).arg(strAuxError);
+            return(false);
+        }
+        int rasterNoDataValue=qRound(dblRasterNoDataValue*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
+        QString coverageMaskKey=QString::number(rasterFile.lodTiles)+"_"+QString::number(rasterFile.lodGsd);
+        const QVector<QPair<int,int> >& roiCodesAndJds=roiCodeAndJdByFileName[rasterFileName];
+        // Una zona por par ROI-fecha, sin mascara si el ROI contiene al tuplekey
+        QVector<const RoiCoverageMask*> ptrCoverageMasks;
+        QVector<ClassificationNdviReducer> reducers;
+        for(int nrj=0;nrj<roiCodesAndJds.size();nrj++)
+        {
+            int roiCode=roiCodesAndJds[nrj].first;
+            int jd=roiCodesAndJds[nrj].second;
+            const RoiCoverageMask* ptrCoverageMask=NULL;
+            if(!roiContainsTuplekeyByRoiCode[roiCode])
+            {
+                QMap<QString,RoiCoverageMask>& coverageMaskByGrid=coverageMaskByGridByRoiCode[roiCode];
+                if(!coverageMaskByGrid.contains(coverageMaskKey))
+                {
+                    RoiCoverageMask coverageMask;
+                    if(!coverageMask.setFromGeometry(ptrGeometryByRoiCode[roiCode],
+                                                     rasterFile.nwFc,
+                                                     rasterFile.nwSc,
+                                                     rasterFile.gsd,
+                                                     rasterFile.columns,
+                                                     rasterFile.rows,
+                                                     strAuxError))
+                    {
+                        strError=QObject::tr("Error getting coverage mask for tuplekey: %1, for roi: %2")
+                                .arg(mTuplekey).arg(QString::number(roiCode));
+                        strError+=QObject::tr("\nfor raster file:\n%1\nError:\n%2").arg(rasterFileName).arg(strAuxError);
+                        return(false);
+                    }
+                    coverageMaskByGrid[coverageMaskKey]=coverageMask;
+                }
+                ptrCoverageMask=&coverageMaskByGrid[coverageMaskKey];
+            }
+            ptrCoverageMasks.push_back(ptrCoverageMask);
+            reducers.push_back(ClassificationNdviReducer(&mAccumulatorByRoiCodeBySpacecraftByJd[roiCode][rasterFile.spacecraftId][jd],
+                                                         existsNoDataValue,
+                                                         rasterNoDataValue));
+        }
+        QVector<ZonalStatisticsReducer*> ptrReducers;
+        for(int nr=0;nr<reducers.size();nr++)
+        {
+            ptrReducers.push_back(&reducers[nr]);
+        }
+        ZonalStatisticsRasterFile zonalRasterFile;
+        zonalRasterFile.fileName=rasterFileName;
+        zonalRasterFile.jd=0;
+        zonalRasterFile.gain=rasterFile.gain;
+        zonalRasterFile.offset=rasterFile.offset;
+        if(!mPtrZonalStatisticsEngine->reduceZones(zonalRasterFile,
+                                                   rasterFile.columns,
+                                                   rasterFile.rows,
+                                                   ptrCoverageMasks,
+                                                   ptrReducers,
+                                                   strAuxError))
+        {
+            strError=QObject::tr("Error processing raster file:\n%1\nError:\n%2").arg(rasterFileName).arg(strAuxError);
+            return(false);
+        }
+    }
+    return(true);
+}
+}
+
 ClassificationProject::ClassificationProject(libCRS::CRSTools* ptrCrsTools,
                                              NestedGrid::NestedGridTools* ptrNestedGridTools,
                                              IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor,
@@ -39,12 +296,16 @@ ClassificationProject::ClassificationProject(libCRS::CRSTools* ptrCrsTools,
     }
     mPtrROIsShapefile=NULL;
     mPtrPersistenceManager=NULL;
+    mPtrRoiGeometryCache=NULL;
+    mPtrRasterBlockCache=NULL;
+    mPtrZonalStatisticsEngine=NULL;
     mValidFormatsForDate.append(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
     mValidFormatsForDate.append(CLASSIFICATIONPROJECT_DATE_FORMAT_2);
     mValidFormatsForDate.append(CLASSIFICATIONPROJECT_DATE_FORMAT_3);
     mValidFormatsForDate.append(CLASSIFICATIONPROJECT_DATE_FORMAT_4);
     mIsInitialized=false;
     mProcessCreateClassificationData=false;
+    mWriteTextReports=true;
 }
 
 bool ClassificationProject::createClassificationData(QString &strError)
@@ -94,6 +355,12 @@ bool ClassificationProject::createClassificationData(QString &strError)
         strError+=QObject::tr("\nError recovering ndvi data from database:\n%1").arg(strAuxError);
         return(false);
     }
+    if(!loadROIGeometries(strAuxError))
+    {
+        strError=QObject::tr("ClassificationProject::createClassificationData");
+        strError+=QObject::tr("\nError recovering ROIs geometries from database:\n%1").arg(strAuxError);
+        return(false);
+    }
 
     QVector<QString> tuplekeys;
     QMap<QString,QMap<int,QMap<int,QVector<QString> > > >::const_iterator iterTuplekeys=tuplekeyFileNamesByTuplekeyByRoiCodeByJd.begin();
@@ -103,14 +370,8 @@ bool ClassificationProject::createClassificationData(QString &strError)
         iterTuplekeys++;
     }
     QMap<int,double> minimunGsdByRoiCode;
-    QMap<QString,QVector<double> > rasterBoundingBoxByFileName; // nwFc,nwSc,seFc,seSc -> puede no coincidir con georef porque en algunos casos georef va al centro del pixel
-    QMap<QString,double> rasterGsdByFileName;
-    QMap<QString,int> rasterRowsByFileName;
-    QMap<QString,int> rasterColumnsByFileName;
+    QMap<QString,ClassificationRasterFile> rasterFileByFileName;
     QMap<int,QVector<QString> > tuplekeysByRoiCode;
-    QMap<int,QVector<bool> > tuplekeysProccesedByRoiCode;
-    QMap<QString,QString> spacecraftIdByFileName;
-    QMap<int, double> roiAreaByRoiCode;
     QMap<QString,QMap<int,QMap<int,QVector<QString> > > >::const_iterator iterTuplekeyFileNameByTuplekeyByRoiCodeByJd=tuplekeyFileNamesByTuplekeyByRoiCodeByJd.begin();
     if(mFromConsole)
     {
@@ -130,20 +391,7 @@ bool ClassificationProject::createClassificationData(QString &strError)
         while(iterTuplekeyFileNameByRoiCodeByJd!=tuplekeyFileNameByRoiCodeByJd.end())
         {
             int roiCode=iterTuplekeyFileNameByRoiCodeByJd.key();
-            if(!tuplekeysByRoiCode.contains(roiCode))
-            {
-                QVector<QString> auxVector;
-                tuplekeysByRoiCode[roiCode]=auxVector;
-                QVector<bool> auxVector2;
-                tuplekeysProccesedByRoiCode[roiCode]=auxVector2;
-            }
             tuplekeysByRoiCode[roiCode].push_back(tuplekey);
-            tuplekeysProccesedByRoiCode[roiCode].push_back(false);
-            if(mFromConsole)
-            {
-                QString msg=QObject::tr("            ... Processing ROI: %1").arg(QString::number(roiCode));
-                (*mStdOut) <<msg<< endl;
-            }
             QMap<int,QVector<QString> > tuplekeyFileNameByJd=iterTuplekeyFileNameByRoiCodeByJd.value();
             QMap<int,QVector<QString> >::const_iterator iterTuplekeyFileNameByJd=tuplekeyFileNameByJd.begin();
             while(iterTuplekeyFileNameByJd!=tuplekeyFileNameByJd.end())
@@ -154,7 +402,7 @@ bool ClassificationProject::createClassificationData(QString &strError)
                     QString rasterFileName=rasterFileNames.at(nrf);
                     int lodTiles=lodTilesByTuplekeyFileName[rasterFileName];
                     int lodGsd=lodGsdByTuplekeyFileName[rasterFileName];
-                    if(!rasterGsdByFileName.contains(rasterFileName))
+                    if(!rasterFileByFileName.contains(rasterFileName))
                     {
                         double rasterGsd;
                         if(!mPtrNestedGridTools->getLodGsd(lodGsd,rasterGsd,strAuxError))
@@ -164,7 +412,6 @@ bool ClassificationProject::createClassificationData(QString &strError)
                                     .arg(rasterFileName).arg(strAuxError);
                             return(false);
                         }
-                        rasterGsdByFileName[rasterFileName]=rasterGsd;
                         if(!minimunGsdByRoiCode.contains(roiCode))
                         {
                             minimunGsdByRoiCode[roiCode]=rasterGsd;
@@ -184,6 +431,7 @@ bool ClassificationProject::createClassificationData(QString &strError)
                                     .arg(rasterFileName).arg(strAuxError);
                             return(false);
                         }
+                        // Puede no coincidir con georef porque en algunos casos georef va al centro del pixel
                         double rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc;
                         if(!mPtrNestedGridTools->getBoundingBoxFromTile(lodTiles,tileX,tileY,crsDescription,
                                                                         rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc,
@@ -194,17 +442,6 @@ bool ClassificationProject::createClassificationData(QString &strError)
                                     .arg(rasterFileName).arg(strAuxError);
                             return(false);
                         }
-                        QVector<double> rasterBoundingBox;
-                        rasterBoundingBox.push_back(rasterNwFc);
-                        rasterBoundingBox.push_back(rasterNwSc);
-                        rasterBoundingBox.push_back(rasterSeFc);
-                        rasterBoundingBox.push_back(rasterSeSc);
-                        rasterBoundingBoxByFileName[rasterFileName]=rasterBoundingBox;
-                        int rasterColumns,rasterRows;
-                        rasterColumns=qRound((rasterSeFc-rasterNwFc)/rasterGsdByFileName[rasterFileName]);
-                        rasterRows=qRound((rasterNwSc-rasterSeSc)/rasterGsdByFileName[rasterFileName]);
-                        rasterRowsByFileName[rasterFileName]=rasterRows;
-                        rasterColumnsByFileName[rasterFileName]=rasterColumns;
                         QString spaceCraftId=CLASSIFICATIONPROJECT_L8_TAG;
                         bool validSpacecraft=false;
                         if(rasterFileName.contains(mL8SpacecraftIdentifier,Qt::CaseInsensitive))
@@ -222,7 +459,18 @@ bool ClassificationProject::createClassificationData(QString &strError)
                             strError+=QObject::tr("\nInvalid spacecraft id in raster file name:\n%1").arg(rasterFileName);
                             return(false);
                         }
-                        spacecraftIdByFileName[rasterFileName]=spaceCraftId;
+                        ClassificationRasterFile rasterFile;
+                        rasterFile.spacecraftId=spaceCraftId;
+                        rasterFile.gain=gainByTuplekeyFileName[rasterFileName];
+                        rasterFile.offset=offsetByTuplekeyFileName[rasterFileName];
+                        rasterFile.lodTiles=lodTiles;
+                        rasterFile.lodGsd=lodGsd;
+                        rasterFile.gsd=rasterGsd;
+                        rasterFile.nwFc=rasterNwFc;
+                        rasterFile.nwSc=rasterNwSc;
+                        rasterFile.columns=qRound((rasterSeFc-rasterNwFc)/rasterGsd);
+                        rasterFile.rows=qRound((rasterNwSc-rasterSeSc)/rasterGsd);
+                        rasterFileByFileName[rasterFileName]=rasterFile;
                     }
                 }
                 iterTuplekeyFileNameByJd++;
@@ -231,6 +479,18 @@ bool ClassificationProject::createClassificationData(QString &strError)
         }
         iterTuplekeyFileNameByTuplekeyByRoiCodeByJd++;
     }
+    // Las tareas no acceden a la base de datos: las geometrias de los tuplekeys se cargan antes
+    QVector<int> tuplekeyIds;
+    for(int nt=0;nt<tuplekeys.size();nt++)
+    {
+        tuplekeyIds.push_back(tuplekeyIdByTuplekeyCode[tuplekeys[nt]]);
+    }
+    if(!loadTuplekeyGeometries(tuplekeyIds,strAuxError))
+    {
+        strError=QObject::tr("ClassificationProject::createClassificationData");
+        strError+=QObject::tr("\nError recovering tuplekeys geometries from database:\n%1").arg(strAuxError);
+        return(false);
+    }
     QFile reportFile(mReportFileName);
     if (!reportFile.open(QFile::WriteOnly |QFile::Text))
     {
@@ -247,485 +507,157 @@ bool ClassificationProject::createClassificationData(QString &strError)
         QString msg=QObject::tr("    ... Processing tuplekeys");
         (*mStdOut) <<msg<< endl;
     }
-    QMap<QString,int> rasterNoDataValueByFileName;
-    QMap<int,QMap<QString,QMap<int,double> > >  meanValuesByRoiCodeBySpacecraftByJd;
-    QMap<int,QMap<QString,QMap<int,double> > >  stdValuesByRoiCodeBySpacecraftByJd;
-    QMap<int,QMap<QString,QMap<int,QVector<int> > > >  valuesByRoiCodeBySpacecraftByJd;
-    int rasterBand=0;
+    // Una tarea por tuplekey: lee cada fichero una vez para todos los ROIs que lo intersectan
+    if(mPtrRasterBlockCache==NULL)
+    {
+        mPtrRasterBlockCache=new RasterBlockCache(CLASSIFICATIONPROJECT_RASTER_BLOCK_CACHE_MAXIMUM_MB);
+    }
+    if(mPtrZonalStatisticsEngine==NULL)
+    {
+        mPtrZonalStatisticsEngine=new ZonalStatisticsEngine(mPtrRasterBlockCache);
+    }
+    mPtrRasterBlockCache->clear();
+    int numberOfThreads=CLASSIFICATIONPROJECT_NUMBER_OF_THREADS;
+    if(numberOfThreads<=0)
+    {
+        numberOfThreads=QThread::idealThreadCount();
+    }
+    numberOfThreads=qMax(1,qMin(numberOfThreads,tuplekeys.size()));
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(numberOfThreads);
+    QVector<ClassificationTuplekeyTask*> ptrTasks;
     for(int nt=0;nt<tuplekeys.size();nt++)
     {
         QString tuplekey=tuplekeys[nt];
-        if(mFromConsole)
+        ClassificationTuplekeyTask* ptrTask=new ClassificationTuplekeyTask(tuplekey,
+                                                                           tuplekeyIdByTuplekeyCode[tuplekey],
+                                                                           tuplekeyFileNamesByTuplekeyByRoiCodeByJd[tuplekey],
+                                                                           rasterFileByFileName,
+                                                                           tuplekeysByRoiCode,
+                                                                           mPtrRoiGeometryCache,
+                                                                           mPtrZonalStatisticsEngine);
+        ptrTasks.push_back(ptrTask);
+        threadPool.start(ptrTask);
+    }
+    while(!threadPool.waitForDone(100))
+    {
+        QCoreApplication::processEvents();
+    }
+    QString strTasksError;
+    QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > > accumulatorByRoiCodeBySpacecraftByJd;
+    for(int nt=0;nt<ptrTasks.size();nt++)
+    {
+        ClassificationTuplekeyTask* ptrTask=ptrTasks[nt];
+        if(!ptrTask->getSuccess())
         {
-            QString msg=QObject::tr("        ... Processing tuplekey: %1").arg(tuplekey);
-            (*mStdOut) <<msg<< endl;
+            strTasksError+=(ptrTask->getError()+"\n");
         }
-        int tuplekeyId=tuplekeyIdByTuplekeyCode[tuplekey];
-        out<<"- Tuplekey a procesar ...............: "<<tuplekey<<"\n";
-        QMap<QString,QVector<QVector<int> > > rasterValuesByFileName;
-        QMap<int,QMap<int,QVector<QString> > > tuplekeyFileNameByRoiCodeByJd=tuplekeyFileNamesByTuplekeyByRoiCodeByJd[tuplekey];
-        QMap<int,QMap<int,QVector<QString>> >::const_iterator iterRoi=tuplekeyFileNameByRoiCodeByJd.begin();
-        while(iterRoi!=tuplekeyFileNameByRoiCodeByJd.end())
+        if(strTasksError.isEmpty())
         {
-            int roiCode=iterRoi.key();
-            if(mFromConsole)
-            {
-                QString msg=QObject::tr("            ... Processing ROI: %1").arg(QString::number(roiCode));
-                (*mStdOut) <<msg<< endl;
-            }
-            out<<"  - ROI a procesar ..................: "<<QString::number(roiCode);
-            out<<" ("<<QString::number(tuplekeysByRoiCode[roiCode].size())<<" tuplekeys)"<<"\n";
-//            int roiId=roiIdByRoiCode[roiCode];
-//            double minGsd=minimunGsdByRoiCode[roiCode];
-            OGRGeometry *ptrRoiTuplekeyIntersectionGeometry;
-            bool roiContainsTuplekey=false;
-            if(!getROITuplekeyIntersectionGeomety(roiCode,
-                                                  tuplekeyId,
-                                                  ptrRoiTuplekeyIntersectionGeometry,
-                                                  roiContainsTuplekey,
-                                                  strAuxError))
-            {
-                strError=QObject::tr("ClassificationProject::createClassificationData");
-                strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
-                reportFile.close();
-                return(false);
-            }
-            double roiNwFc,roiNwSc, roiSeFc,roiSeSc;
-            OGREnvelope roiEnvelope;
-            ptrRoiTuplekeyIntersectionGeometry->getEnvelope(&roiEnvelope);
-            roiNwFc=roiEnvelope.MinX;
-            roiNwSc=roiEnvelope.MaxY;
-            roiSeFc=roiEnvelope.MaxX;
-            roiSeSc=roiEnvelope.MinY;
-            if(!roiAreaByRoiCode.contains(roiCode))
+            out<<ptrTask->getReport();
+            const QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > >& taskAccumulators=ptrTask->getAccumulators();
+            QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > >::const_iterator iterRoi=taskAccumulators.begin();
+            while(iterRoi!=taskAccumulators.end()&&strTasksError.isEmpty())
             {
-                double roiArea;
-                if(!getROIArea(roiCode,roiArea,strAuxError))
+                QMap<QString,QMap<int,StatisticsAccumulator> >::const_iterator iterSpacecraft=iterRoi.value().begin();
+                while(iterSpacecraft!=iterRoi.value().end()&&strTasksError.isEmpty())
                 {
-                    strError=QObject::tr("ClassificationProject::createClassificationData");
-                    strError+=QObject::tr("\nError recovering area for ROI: %1\nError:\n%2")
-                            .arg(QString::number(roiCode)).arg(strAuxError);
-                    reportFile.close();
-                    return(false);
-                }
-                roiAreaByRoiCode[roiCode]=roiArea;
-            }
-            QMap<int,QVector<QString> > tuplekeyFileNameByJd=iterRoi.value();
-            QMap<int,QVector<QString> >::const_iterator iterTuplekeyFileNameByJd=tuplekeyFileNameByJd.begin();
-            while(iterTuplekeyFileNameByJd!=tuplekeyFileNameByJd.end())
-            {
-                int jd=iterTuplekeyFileNameByJd.key();
-                out<<"    - Fecha a procesar ..............: "<<QString::number(jd);
-                out<<" - "<<QDate::fromJulianDay(jd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1)<<"\n";
-                QVector<QString> rasterFileNames=iterTuplekeyFileNameByJd.value();
-                for(int nrf=0;nrf<rasterFileNames.size();nrf++)
-                {
-                    QString rasterFileName=rasterFileNames.at(nrf);
-                    QString spaceCraftId=spacecraftIdByFileName[rasterFileName];
-                    out<<"      - Fichero a procesar ..........: "<<rasterFileName<<"\n";
-                    double gain=gainByTuplekeyFileName[rasterFileName];
-                    double offset=offsetByTuplekeyFileName[rasterFileName];
-                    int lodTiles=lodTilesByTuplekeyFileName[rasterFileName];
-                    int lodGsd=lodGsdByTuplekeyFileName[rasterFileName];
-                    double rasterGsd=rasterGsdByFileName[rasterFileName];
-                    double rasterNwFc=rasterBoundingBoxByFileName[rasterFileName][0];
-                    double rasterNwSc=rasterBoundingBoxByFileName[rasterFileName][1];
-                    int rasterColumns=rasterColumnsByFileName[rasterFileName];
-                    int rasterRows=rasterRowsByFileName[rasterFileName];
-                    int rasterNoDataValue;
-                    QVector<QVector<int> > rasterValues(rasterRows);
-                    if(!rasterValuesByFileName.contains(rasterFileName))
-                    {
-                        IGDAL::Raster* ptrRaster=new IGDAL::Raster(mPtrCrsTools);
-                        if(!ptrRaster->setFromFile(rasterFileName,strAuxError))
-                        {
-                            strError=QObject::tr("ClassificationProject::createClassificationData");
-                            strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
-                                    .arg(rasterFileName).arg(strAuxError);
-                            reportFile.close();
-                            return(false);
-                        }
-                        QVector<QVector<double> > dblRasterValues;
-                        if(!ptrRaster->readValues(rasterBand,
-                                                  0,0,
-                                                  rasterColumns,rasterRows,
-                                                  dblRasterValues,
-                                                  strAuxError)) // values[row][column]
-                        {
-                            strError=QObject::tr("ClassificationProject::createClassificationData");
-                            strError+=QObject::tr("\nError getting dimensions from raster file:\n%1\nError:\n%2")
-                                    .arg(rasterFileName).arg(strAuxError);
-                            delete(ptrRaster);
-                            reportFile.close();
-                            return(false);
-                        }
-                        for(int row=0;row<rasterRows;row++)
-                        {
-                            QVector<int> rowRasterValues(rasterColumns);
-                            for(int column=0;column<rasterColumns;column++)
-                            {
-                                int intValue=qRound(dblRasterValues[row][column]*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
-                                rowRasterValues[column]=intValue;
-                            }
-                            rasterValues[row]=rowRasterValues;
-                        }
-                        double dblRasterNoDataValue;
-                        if(!ptrRaster->getNoDataValue(rasterBand,
-                                                      dblRasterNoDataValue,
-                                                      strAuxError))
-                        {
-                            strError=QObject::tr("ClassificationProject::createClassificationData");
-                            strError+=QObject::tr("\nError getting no data value from raster file:\n%1\nError:\n%2")
-                                    .arg(rasterFileName).arg(strAuxError);
-                            delete(ptrRaster);
-                            reportFile.close();
-                            return(false);
-                        }
-                        delete(ptrRaster);
-                        rasterNoDataValue=qRound(dblRasterNoDataValue*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
-                        rasterValuesByFileName[rasterFileName]=rasterValues;
-                        rasterNoDataValueByFileName[rasterFileName]=rasterNoDataValue;
-                    }
-                    else
-                    {
-                        rasterValues=rasterValuesByFileName[rasterFileName];
-                        rasterNoDataValue=rasterNoDataValueByFileName[rasterFileName];
-                    }
-                    if(roiContainsTuplekey)
-                    {
-                        for(int nRow=0;nRow<rasterRows;nRow++)
-                        {
-                            for(int nColumn=0;nColumn<rasterColumns;nColumn++)
-                            {
-                                if(fabs(rasterValues[nRow][nColumn]-rasterNoDataValue)<1.0)
-                                {
-                                    continue;
-                                }
-                                double ndvi=((double)rasterValues[nRow][nColumn])/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE*gain+offset;
-                                int intNdvi=qRound(ndvi*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
-                                bool insertedValue=false;
-                                if(valuesByRoiCodeBySpacecraftByJd.contains(roiCode))
-                                {
-                                    if(valuesByRoiCodeBySpacecraftByJd[roiCode].contains(spaceCraftId))
-                                    {
-                                        if(valuesByRoiCodeBySpacecraftByJd[roiCode][spaceCraftId].contains(jd))
-                                        {
-                                            valuesByRoiCodeBySpacecraftByJd[roiCode][spaceCraftId][jd].push_back(intNdvi);
-                                            insertedValue=true;
-                                        }
-                                    }
-                                }
-                                if(!insertedValue)
-                                {
-                                    QVector<int> values;
-                                    values.push_back(intNdvi);
-                                    valuesByRoiCodeBySpacecraftByJd[roiCode][spaceCraftId][jd]=values;
-                                }
-                            }
-                        }
-                    }
-                    else
+                    QMap<int,StatisticsAccumulator>::const_iterator iterJd=iterSpacecraft.value().begin();
+                    while(iterJd!=iterSpacecraft.value().end())
                     {
-                        int rasterColumn=floor((roiNwFc-rasterNwFc)/rasterGsd);
-                        bool controlColumn=true;
-                        while(controlColumn)
+                        if(!accumulatorByRoiCodeBySpacecraftByJd[iterRoi.key()][iterSpacecraft.key()][iterJd.key()].merge(iterJd.value(),
+                                                                                                                         strAuxError))
                         {
-                            int rasterRow=floor((rasterNwSc-roiNwSc)/rasterGsd);
-                            bool controlRow=true;
-                            while(controlRow)
-                            {
-                                if(fabs(rasterValues[rasterRow][rasterColumn]-rasterNoDataValue)<1.0)
-                                {
-                                    double scSRasterPixel=rasterNwSc-(rasterRow+1)*rasterGsd;
-                                    if(scSRasterPixel<=roiSeSc)
-                                    {
-                                        controlRow=false;
-                                    }
-                                    else
-                                    {
-                                        rasterRow++;
-                                    }
-                                    continue;
-                                }
-                                bool intersects=false;
-                                if(!getIntersectsPixel(rasterNwFc,
-                                                       rasterNwSc,
-                                                       rasterGsd,
-                                                       rasterColumn,
-                                                       rasterRow,
-                                                       ptrRoiTuplekeyIntersectionGeometry,
-                                                       intersects,
-                                                       strAuxError))
-                                {
-                                    strError=QObject::tr("ClassificationProject::createClassificationData");
-                                    strError+=QObject::tr("\nError getting intersects for tuplekey: %1, for roi: %2, for date: %32")
-                                            .arg(tuplekey).arg(QString::number(roiCode)).arg(QDate::fromJulianDay(jd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1));
-                                    strError+=QObject::tr("\nfor raster file:\n%1").arg(rasterFileName);
-                                    strError+=QObject::tr("\nfor column: %1 and row: %2")
-                                            .arg(QString::number(rasterColumn)).arg(QString::number(rasterRow));
-                                    reportFile.close();
-                                    return(false);
-                                }
-                                if(intersects)
-                                {
-                                    double ndvi=((double)rasterValues[rasterRow][rasterColumn])/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE*gain+offset;
-                                    int intNdvi=qRound(ndvi*CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
-                                    bool insertedValue=false;
-                                    if(valuesByRoiCodeBySpacecraftByJd.contains(roiCode))
-                                    {
-                                        if(valuesByRoiCodeBySpacecraftByJd[roiCode].contains(spaceCraftId))
-                                        {
-                                            if(valuesByRoiCodeBySpacecraftByJd[roiCode][spaceCraftId].contains(jd))
-                                            {
-                                                valuesByRoiCodeBySpacecraftByJd[roiCode][spaceCraftId][jd].push_back(intNdvi);
-                                                insertedValue=true;
-                                            }
-                                        }
-                                    }
-                                    if(!insertedValue)
-                                    {
-                                        QVector<int> values;
-                                        values.push_back(intNdvi);
-                                        valuesByRoiCodeBySpacecraftByJd[roiCode][spaceCraftId][jd]=values;
-                                    }
-                                }
-                                double scSRasterPixel=rasterNwSc-(rasterRow+1)*rasterGsd;
-                                if(scSRasterPixel<=roiSeSc)
-                                {
-                                    controlRow=false;
-                                }
-                                else
-                                {
-                                    rasterRow++;
-                                }
-                            }
-                            double fcWRasterPixel=rasterNwFc+(rasterColumn+1)*rasterGsd;
-                            if(fcWRasterPixel>=roiSeFc)
-                            {
-                                controlColumn=false;
-                            }
-                            else
-                            {
-                                rasterColumn++;
-                            }
+                            strTasksError+=(strAuxError+"\n");
+                            break;
                         }
-                    }
-                }
-                if(tuplekeysByRoiCode[roiCode].size()==1) // lo mas frecuente
-                {
-                    QMap<QString,QMap<int,QVector<int> > > valuesBySpacecraftByJd=valuesByRoiCodeBySpacecraftByJd[roiCode];
-                    QMap<QString,QMap<int,QVector<int> > >::const_iterator iterSpacecraft=valuesBySpacecraftByJd.begin();
-                    QVector<QString> spacecraftIdValuesToRemove;
-                    while(iterSpacecraft!=valuesBySpacecraftByJd.end())
-                    {
-                        QString spacecraftId=iterSpacecraft.key();
-                        QMap<int,QVector<int> > valuesByJd=iterSpacecraft.value();
-                        QMap<int,QVector<int> >::const_iterator iterJd=valuesByJd.begin();
-                        QVector<int> values=iterJd.value();
-                        double meanValue=0.0;
-                        for(int nv=0;nv<values.size();nv++)
-                        {
-                            meanValue+=values[nv];
-                        }
-                        meanValue/=values.size();
-                        double stdValue=0.0;
-                        if(values.size()>1)
-                        {
-                            for(int nv=0;nv<values.size();nv++)
-                            {
-                                stdValue+=pow(meanValue-values[nv],2.0);
-                            }
-                            stdValue=sqrt(stdValue/(values.size()-1));
-                        }
-                        //                    QMap<int,QMap<QString,QMap<int,double> > >  meanValuesByRoiCodeBySpacecraftByJd;
-                        //                    QMap<int,QMap<QString,QMap<int,double> > >  stdValuesByRoiCodeBySpacecraftByJd;
-                        //                    QMap<int,QMap<QString,QMap<int,QVector<double> > > >  valuesByRoiCodeBySpacecraftByJd;
-                        meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][jd]=meanValue/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE;
-                        stdValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][jd]=stdValue/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE;
-                        spacecraftIdValuesToRemove.push_back(spacecraftId);
-                        iterSpacecraft++;
-                    }
-                    for(int nvtr=0;nvtr<spacecraftIdValuesToRemove.size();nvtr++)
-                    {
-                        QString spacecraftIdToRemove=spacecraftIdValuesToRemove.at(nvtr);
-                        valuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftIdToRemove].remove(jd);
-                    }
-                    for(int nvtr=0;nvtr<spacecraftIdValuesToRemove.size();nvtr++)
-                    {
-                        QString spacecraftIdToRemove=spacecraftIdValuesToRemove.at(nvtr);
-                        if(valuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftIdToRemove].size()==0)
-                        {
-                            valuesByRoiCodeBySpacecraftByJd[roiCode].remove(spacecraftIdToRemove);
-                        }
-                    }
-                    if(valuesByRoiCodeBySpacecraftByJd[roiCode].size()==0)
-                    {
-                        valuesByRoiCodeBySpacecraftByJd.remove(roiCode);
-                    }
-                }
-                iterTuplekeyFileNameByJd++;
-            }
-            OGRGeometryFactory::destroyGeometry(ptrRoiTuplekeyIntersectionGeometry);
-            int tuplekeyPositionInTuplekeysByRoiCode=tuplekeysByRoiCode[roiCode].indexOf(tuplekey);
-            tuplekeysProccesedByRoiCode[roiCode][tuplekeyPositionInTuplekeysByRoiCode]=true;
-            bool proccesedAllTuplekeysForRoiCode=true;
-            for(int nn=0;nn<tuplekeysProccesedByRoiCode[roiCode].size();nn++)
-            {
-                if(!tuplekeysProccesedByRoiCode[roiCode][nn])
-                {
-                    proccesedAllTuplekeysForRoiCode=false;
-                    break;
-                }
-            }
-            // Si se han procesado todos obtengo las estadísticas
-            if(proccesedAllTuplekeysForRoiCode)
-            {
-                QMap<QString,QMap<int,QVector<int> > > valuesBySpacecraftByJd=valuesByRoiCodeBySpacecraftByJd[roiCode];
-                QMap<QString,QMap<int,QVector<int> > >::const_iterator iterSpacecraft=valuesBySpacecraftByJd.begin();
-                while(iterSpacecraft!=valuesBySpacecraftByJd.end())
-                {
-                    QString spacecraftId=iterSpacecraft.key();
-                    QMap<int,QVector<int> > valuesByJd=iterSpacecraft.value();
-                    QMap<int,QVector<int> >::const_iterator iterJd=valuesByJd.begin();
-                    while(iterJd!=valuesByJd.end())
-                    {
-                        int jd=iterJd.key();
-                        QVector<int> values=iterJd.value();
-                        double meanValue=0.0;
-                        for(int nv=0;nv<values.size();nv++)
-                        {
-                            meanValue+=values[nv];
-                        }
-                        meanValue/=values.size();
-                        double stdValue=0.0;
-                        if(values.size()>1)
-                        {
-                            for(int nv=0;nv<values.size();nv++)
-                            {
-                                stdValue+=pow(meanValue-values[nv],2.0);
-                            }
-                        }
-                        stdValue=sqrt(stdValue/(values.size()-1));
-                        //                    QMap<int,QMap<QString,QMap<int,double> > >  meanValuesByRoiCodeBySpacecraftByJd;
-                        //                    QMap<int,QMap<QString,QMap<int,double> > >  stdValuesByRoiCodeBySpacecraftByJd;
-                        //                    QMap<int,QMap<QString,QMap<int,QVector<double> > > >  valuesByRoiCodeBySpacecraftByJd;
-                        meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][jd]=meanValue/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE;
-                        stdValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][jd]=stdValue/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE;
                         iterJd++;
                     }
                     iterSpacecraft++;
                 }
-                valuesByRoiCodeBySpacecraftByJd.remove(roiCode);
+                iterRoi++;
             }
-            iterRoi++;
         }
+        delete(ptrTask);
     }
     reportFile.close();
-    QFile reportL8File(mL8ReportFileName);
-    if (!reportL8File.open(QFile::WriteOnly |QFile::Text))
+    if(mFromConsole)
     {
-        strError=QObject::tr("ClassificationProject::createClassificationData");
-        strError+=QObject::tr("\nError opening results file: \n %1").arg(mL8ReportFileName);
-        return(false);
+        QString msg=QObject::tr("    ... Raster block cache: %1 hits, %2 misses, %3 evictions, %4 window reads")
+                .arg(QString::number(mPtrRasterBlockCache->getNumberOfHits()))
+                .arg(QString::number(mPtrRasterBlockCache->getNumberOfMisses()))
+                .arg(QString::number(mPtrRasterBlockCache->getNumberOfEvictions()))
+                .arg(QString::number(mPtrRasterBlockCache->getNumberOfWindowReads()));
+        (*mStdOut) <<msg<< endl;
     }
-    QTextStream outL8(&reportL8File);
-    QFile reportS2AFile(mS2AReportFileName);
-    if (!reportS2AFile.open(QFile::WriteOnly |QFile::Text))
+    mPtrRasterBlockCache->clear();
+    if(!strTasksError.isEmpty())
     {
         strError=QObject::tr("ClassificationProject::createClassificationData");
-        strError+=QObject::tr("\nError opening results file: \n %1").arg(mS2AReportFileName);
+        strError+=QObject::tr("\nError processing tuplekeys:\n%1").arg(strTasksError);
         return(false);
     }
-    QTextStream outS2A(&reportS2AFile);
-
-    QString strRoiIdTag=CLASSIFICATIONPROJECT_ROI_ID_PRINT_TAG;
-    QString strRoiCropTag=CLASSIFICATIONPROJECT_ROI_CROP_PRINT_TAG;
-    QString strRoiAreaTag=CLASSIFICATIONPROJECT_ROI_AREA_PRINT_TAG;
-
-    outL8<<"L8 CLASSIFICATION DATA, Time interval: ";
-    outL8<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
-    outL8<<" to ";
-    outL8<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
-    outL8<<"\n";
-    outL8<<"- Increment to ROIs ids: "<<QString::number(mROIIncrement)<<"\n";
-    outL8<<strRoiIdTag.rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
-    outL8<<strRoiCropTag.rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
-    outL8<<strRoiAreaTag.rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
-
-    outS2A<<"S2A CLASSIFICATION DATA, Time interval: ";
-    outS2A<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
-    outS2A<<" to ";
-    outS2A<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
-    outS2A<<"\n";
-    outS2A<<"- Increment to ROIs ids: "<<QString::number(mROIIncrement)<<"\n";
-    outS2A<<strRoiIdTag.rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
-    outS2A<<strRoiCropTag.rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
-    outS2A<<strRoiAreaTag.rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
-
-    for(int njd=mInitialJd;njd<=mFinalJd;njd++)
-    {
-        QString strDate=QDate::fromJulianDay(njd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
-        outL8<<strDate.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH*2);
-        outS2A<<strDate.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH*2);
-    }
-    outL8<<"\n";
-    outS2A<<"\n";
-
-    QMap<int,QMap<QString,QMap<int,double> > >::const_iterator iterROIs=meanValuesByRoiCodeBySpacecraftByJd.begin();
-    while(iterROIs!=meanValuesByRoiCodeBySpacecraftByJd.end())
+    QMap<int,QMap<QString,QMap<int,double> > >  meanValuesByRoiCodeBySpacecraftByJd;
+    QMap<int,QMap<QString,QMap<int,double> > >  stdValuesByRoiCodeBySpacecraftByJd;
+    QMap<int, double> roiAreaByRoiCode;
+    QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > >::const_iterator iterAccumulatorRoi=accumulatorByRoiCodeBySpacecraftByJd.begin();
+    while(iterAccumulatorRoi!=accumulatorByRoiCodeBySpacecraftByJd.end())
     {
-        int roiCode=iterROIs.key();
-        QMap<QString,QMap<int,double> > meanValuesBySpacecraftByJd=iterROIs.value();
-        QMap<QString,QMap<int,double> >::const_iterator iterSpacecraft=meanValuesBySpacecraftByJd.begin();
-        while(iterSpacecraft!=meanValuesBySpacecraftByJd.end())
+        int roiCode=iterAccumulatorRoi.key();
+        double roiArea;
+        if(!mPtrRoiGeometryCache->getArea(QString::number(roiCode),roiArea,strAuxError))
+        {
+            strError=QObject::tr("ClassificationProject::createClassificationData");
+            strError+=QObject::tr("\nError recovering area for ROI: %1\nError:\n%2")
+                    .arg(QString::number(roiCode)).arg(strAuxError);
+            return(false);
+        }
+        roiAreaByRoiCode[roiCode]=roiArea;
+        QMap<QString,QMap<int,StatisticsAccumulator> >::const_iterator iterSpacecraft=iterAccumulatorRoi.value().begin();
+        while(iterSpacecraft!=iterAccumulatorRoi.value().end())
         {
             QString spacecraftId=iterSpacecraft.key();
-            if(spacecraftId.compare(CLASSIFICATIONPROJECT_L8_TAG)==0)
+            QMap<int,StatisticsAccumulator>::const_iterator iterJd=iterSpacecraft.value().begin();
+            while(iterJd!=iterSpacecraft.value().end())
             {
-                outL8<<QString::number(roiCode).rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
-                outL8<<QString::number(roiCropByRoiCode[roiCode]).rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
-                outL8<<QString::number(roiAreaByRoiCode[roiCode],'f',CLASSIFICATIONPROJECT_ROI_AREA_PRECISION).rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
-            }
-            else if(spacecraftId.compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
-            {
-                outS2A<<QString::number(roiCode).rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
-                outS2A<<QString::number(roiCropByRoiCode[roiCode]).rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
-                outS2A<<QString::number(roiAreaByRoiCode[roiCode],'f',CLASSIFICATIONPROJECT_ROI_AREA_PRECISION).rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
-            }
-            for(int njd=mInitialJd;njd<=mFinalJd;njd++)
-            {
-                QString strMeanValue="NaN";
-                QString strStdValue="NaN";
-                if(meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId].contains(njd))
-                {
-                    strMeanValue=QString::number(meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][njd],'f',CLASSIFICATIONPROJECT_MEAN_VALUES_PRINT_PRECISION);
-                    strStdValue=QString::number(stdValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][njd],'f',CLASSIFICATIONPROJECT_MEAN_VALUES_PRINT_PRECISION);
-                }
-                if(spacecraftId.compare(CLASSIFICATIONPROJECT_L8_TAG)==0)
-                {
-                    outL8<<strMeanValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
-                    outL8<<strStdValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
-                }
-                else if(spacecraftId.compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
+                int jd=iterJd.key();
+                const StatisticsAccumulator& accumulator=iterJd.value();
+                if(accumulator.getCount()>0)
                 {
-                    outS2A<<strMeanValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
-                    outS2A<<strStdValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
+                    meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][jd]=accumulator.getMean()/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE;
+                    stdValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][jd]=accumulator.getStd()/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE;
                 }
-            }
-            if(spacecraftId.compare(CLASSIFICATIONPROJECT_L8_TAG)==0)
-            {
-                outL8<<"\n";
-            }
-            else if(spacecraftId.compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
-            {
-                outS2A<<"\n";
+                iterJd++;
             }
             iterSpacecraft++;
         }
-        iterROIs++;
+        iterAccumulatorRoi++;
+    }
+    if(!mBinaryReportFileName.isEmpty())
+    {
+        if(!writeBinaryReport(accumulatorByRoiCodeBySpacecraftByJd,
+                              roiCropByRoiCode,
+                              roiAreaByRoiCode,
+                              strAuxError))
+        {
+            strError=QObject::tr("ClassificationProject::createClassificationData");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    if(mWriteTextReports)
+    {
+        if(!writeTextReports(meanValuesByRoiCodeBySpacecraftByJd,
+                             stdValuesByRoiCodeBySpacecraftByJd,
+                             roiCropByRoiCode,
+                             roiAreaByRoiCode,
+                             strAuxError))
+        {
+            strError=QObject::tr("ClassificationProject::createClassificationData");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
     }
-    reportL8File.close();
-    reportS2AFile.close();
     return(true);
 }
 
@@ -1487,75 +1419,153 @@ bool ClassificationProject::setFromFile(QString &inputFileName,
                 strError=QObject::tr("ClassificationProject::setFromFile");
                 strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
                 strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-                strError+=QObject::tr("\nError removing existing L8 results file:\n%1").arg(strValue);
+                strError+=QObject::tr("\nError removing existing L8 results file:\n%1").arg(strValue);
+                fileInput.close();
+                clear();
+                return(false);
+            }
+        }
+        mS2ASpacecraftIdentifier=strValue;
+
+        // Lectura del fichero de resultados para L8
+        nline++;
+        strLine=in.readLine();
+        strLine=strLine.trimmed();
+        strList=strLine.split(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+        if(strList.size()!=2)
+        {
+            strError=QObject::tr("ClassificationProject::setFromFile");
+            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+            fileInput.close();
+            clear();
+            return(false);
+        }
+        strValue=strList.at(1).trimmed();
+        if(QFile::exists(strValue))
+        {
+            if(!QFile::remove(strValue))
+            {
+                strError=QObject::tr("ClassificationProject::setFromFile");
+                strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+                strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+                strError+=QObject::tr("\nError removing existing L8 results file:\n%1").arg(strValue);
+                fileInput.close();
+                clear();
+                return(false);
+            }
+        }
+        mL8ReportFileName=strValue;
+
+        // Lectura del fichero de resultados para S2
+        nline++;
+        strLine=in.readLine();
+        strLine=strLine.trimmed();
+        strList=strLine.split(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+        if(strList.size()!=2)
+        {
+            strError=QObject::tr("ClassificationProject::setFromFile");
+            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+            fileInput.close();
+            clear();
+            return(false);
+        }
+        strValue=strList.at(1).trimmed();
+        if(QFile::exists(strValue))
+        {
+            if(!QFile::remove(strValue))
+            {
+                strError=QObject::tr("ClassificationProject::setFromFile");
+                strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+                strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+                strError+=QObject::tr("\nError removing existing S2 results file:\n%1").arg(strValue);
+                fileInput.close();
+                clear();
+                return(false);
+            }
+        }
+        mS2AReportFileName=strValue;
+
+        // Lineas opcionales: fichero binario de resultados (vacio si no se escribe)
+        // y escritura de los ficheros de resultados de texto (0 o 1)
+        if(!in.atEnd())
+        {
+            nline++;
+            strLine=in.readLine();
+            strLine=strLine.trimmed();
+            strList=strLine.split(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+            if(strList.size()!=2)
+            {
+                strError=QObject::tr("ClassificationProject::setFromFile");
+                strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+                strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+                strError+=QObject::tr("\nThere are not two fields separated by %1").arg(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+                fileInput.close();
+                clear();
+                return(false);
+            }
+            strValue=strList.at(1).trimmed();
+            if(!strValue.isEmpty()
+                    &&QFile::exists(strValue))
+            {
+                if(!QFile::remove(strValue))
+                {
+                    strError=QObject::tr("ClassificationProject::setFromFile");
+                    strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+                    strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+                    strError+=QObject::tr("\nError removing existing binary results file:\n%1").arg(strValue);
+                    fileInput.close();
+                    clear();
+                    return(false);
+                }
+            }
+            mBinaryReportFileName=strValue;
+        }
+        if(!in.atEnd())
+        {
+            nline++;
+            strLine=in.readLine();
+            strLine=strLine.trimmed();
+            strList=strLine.split(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+            if(strList.size()!=2)
+            {
+                strError=QObject::tr("ClassificationProject::setFromFile");
+                strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+                strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+                strError+=QObject::tr("\nThere are not two fields separated by %1").arg(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
                 fileInput.close();
                 clear();
                 return(false);
             }
-        }
-        mS2ASpacecraftIdentifier=strValue;
-
-        // Lectura del fichero de resultados para L8
-        nline++;
-        strLine=in.readLine();
-        strLine=strLine.trimmed();
-        strList=strLine.split(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
-        if(strList.size()!=2)
-        {
-            strError=QObject::tr("ClassificationProject::setFromFile");
-            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
-            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
-            fileInput.close();
-            clear();
-            return(false);
-        }
-        strValue=strList.at(1).trimmed();
-        if(QFile::exists(strValue))
-        {
-            if(!QFile::remove(strValue))
+            strValue=strList.at(1).trimmed();
+            okToInt=false;
+            int intWriteTextReports=strValue.toInt(&okToInt);
+            if(!okToInt
+                    ||intWriteTextReports<0||intWriteTextReports>1)
             {
                 strError=QObject::tr("ClassificationProject::setFromFile");
                 strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
                 strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-                strError+=QObject::tr("\nError removing existing L8 results file:\n%1").arg(strValue);
+                strError+=QObject::tr("\nIn line %1 value: %2 is not 0 or 1").arg(QString::number(nline)).arg(strValue);
                 fileInput.close();
                 clear();
                 return(false);
             }
+            mWriteTextReports=(intWriteTextReports==1);
         }
-        mL8ReportFileName=strValue;
-
-        // Lectura del fichero de resultados para S2
-        nline++;
-        strLine=in.readLine();
-        strLine=strLine.trimmed();
-        strList=strLine.split(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
-        if(strList.size()!=2)
+        if(!mWriteTextReports
+                &&mBinaryReportFileName.isEmpty())
         {
             strError=QObject::tr("ClassificationProject::setFromFile");
             strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
-            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(CLASSIFICATIONPROJECT_SEPARATOR_CHARACTER);
+            strError+=QObject::tr("\nThere is not any results file to write");
             fileInput.close();
             clear();
             return(false);
         }
-        strValue=strList.at(1).trimmed();
-        if(QFile::exists(strValue))
-        {
-            if(!QFile::remove(strValue))
-            {
-                strError=QObject::tr("ClassificationProject::setFromFile");
-                strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
-                strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-                strError+=QObject::tr("\nError removing existing S2 results file:\n%1").arg(strValue);
-                fileInput.close();
-                clear();
-                return(false);
-            }
-        }
-        mS2AReportFileName=strValue;
     }
     else
     {
@@ -1783,6 +1793,21 @@ void ClassificationProject::clear()
         delete(mPtrPersistenceManager);
         mPtrPersistenceManager=NULL;
     }
+    if(mPtrRoiGeometryCache!=NULL)
+    {
+        delete(mPtrRoiGeometryCache);
+        mPtrRoiGeometryCache=NULL;
+    }
+    if(mPtrZonalStatisticsEngine!=NULL)
+    {
+        delete(mPtrZonalStatisticsEngine);
+        mPtrZonalStatisticsEngine=NULL;
+    }
+    if(mPtrRasterBlockCache!=NULL)
+    {
+        delete(mPtrRasterBlockCache);
+        mPtrRasterBlockCache=NULL;
+    }
     mInitialJd=0;
     mFinalJd=0;
     mReportFileName.clear();
@@ -1795,6 +1820,8 @@ void ClassificationProject::clear()
     mStdThreshold=CLASSIFICATIONPROJECT_NODOUBLE;
     mL8ReportFileName.clear();
     mS2AReportFileName.clear();
+    mBinaryReportFileName.clear();
+    mWriteTextReports=true;
     mProcessCreateClassificationData=false;
     mS2ASpacecraftIdentifier.clear();
     mL8SpacecraftIdentifier.clear();
@@ -1802,207 +1829,119 @@ void ClassificationProject::clear()
     //    mProjectCodes.clear();
 }
 
-bool ClassificationProject::getROITuplekeyIntersectionGeomety(int roiId,
-                                                              int tuplekeyId,
-                                                              OGRGeometry *&ptrGeometry,
-                                                              bool& roiContainsTuplekey,
-                                                              QString &strError)
+bool ClassificationProject::loadROIGeometries(QString &strError)
 {
-    ptrGeometry=NULL;
-    QString sqlSentence;
-    // Primer compruebo si la zona contiene al tuplekey
-    roiContainsTuplekey=false;
-    {
-        sqlSentence+="SELECT contains(";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_GEOMETRY;
-        sqlSentence+=",";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_THE_GEOM;
-        sqlSentence+=") FROM ";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-        sqlSentence+=",";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=" WHERE ";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_ID;
-        sqlSentence+="=";
-        sqlSentence+=QString::number(roiId);
-        sqlSentence+=" AND ";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID;
-        sqlSentence+="=";
-        sqlSentence+=QString::number(tuplekeyId);
-        QVector<QString> fieldsNamesToRetrieve;
-        QString containsFieldName="contains";
-        fieldsNamesToRetrieve.push_back(containsFieldName);
-        QVector<QMap<QString, QString> > fieldsValuesToRetrieve;
-        QString strAuxError;
-        if(!mPtrPersistenceManager->getPtrDb()->executeSqlQuery(sqlSentence,
-                                                                fieldsNamesToRetrieve,
-                                                                fieldsValuesToRetrieve,
-                                                                strAuxError))
-        {
-            strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-            strError+=QObject::tr("\nError recovering data for project id: %1 an tuplekey id: %2")
-                    .arg(QString::number(roiId)).arg(QString::number(tuplekeyId));
-            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
-            return(false);
+    if(mPtrRoiGeometryCache==NULL)
+    {
+        mPtrRoiGeometryCache=new RoiGeometryCache();
+    }
+    mPtrRoiGeometryCache->clear();
+    QString sqlSentence="SELECT ";
+    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
+    sqlSentence+=".";
+    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_ID;
+    sqlSentence+=",upper(asText(";
+    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
+    sqlSentence+=".";
+    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_GEOMETRY;
+    sqlSentence+="))";
+    sqlSentence+=" FROM ";
+    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
+    QVector<QString> fieldsNamesToRetrieve;
+    QString roiIdFieldName="id";
+    QString wktGeometryFieldName="wktGeometry";
+    fieldsNamesToRetrieve.push_back(roiIdFieldName);
+    fieldsNamesToRetrieve.push_back(wktGeometryFieldName);
+    QVector<QMap<QString, QString> > fieldsValuesToRetrieve;
+    QString strAuxError;
+    if(!mPtrPersistenceManager->getPtrDb()->executeSqlQuery(sqlSentence,
+                                                            fieldsNamesToRetrieve,
+                                                            fieldsValuesToRetrieve,
+                                                            strAuxError))
+    {
+        strError=QObject::tr("ClassificationProject::loadROIGeometries");
+        strError+=QObject::tr("\nError recovering ROIs geometries");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    for(int nr=0;nr<fieldsValuesToRetrieve.size();nr++)
+    {
+        QString roiId=fieldsValuesToRetrieve[nr][roiIdFieldName];
+        QString wktGeometry=fieldsValuesToRetrieve[nr][wktGeometryFieldName];
+        QByteArray byteArrayWktGeometry = wktGeometry.toUtf8();
+        char *charsWktGeometry = byteArrayWktGeometry.data();
+        OGRGeometry* ptrGeometry=NULL;
+        if(wktGeometry.contains("MULTIPOLYGON"))
+        {
+            ptrGeometry=OGRGeometryFactory::createGeometry(wkbMultiPolygon);
         }
-        for(int nr=0;nr<fieldsValuesToRetrieve.size();nr++)
+        else if(wktGeometry.contains("POLYGON"))
         {
-            QString strContains=fieldsValuesToRetrieve[nr][containsFieldName];
-            int intContains=strContains.toInt();
-            if(intContains==1)
-            {
-                roiContainsTuplekey=true;
-            }
+            ptrGeometry=OGRGeometryFactory::createGeometry(wkbPolygon);
         }
-    }
-    if(!roiContainsTuplekey)
-    {
-        sqlSentence="SELECT upper(asText(intersection(";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_GEOMETRY;
-        sqlSentence+=",";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_THE_GEOM;
-        sqlSentence+=")))";
-        sqlSentence+=" FROM ";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-        sqlSentence+=",";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=" WHERE ";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_ID;
-        sqlSentence+="=";
-        sqlSentence+=QString::number(roiId);
-        sqlSentence+=" AND ";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID;
-        sqlSentence+="=";
-        sqlSentence+=QString::number(tuplekeyId);
-        QVector<QString> fieldsNamesToRetrieve;
-        QString wktGeometryFieldName="wktGeometry";
-        fieldsNamesToRetrieve.push_back(wktGeometryFieldName);
-        QVector<QMap<QString, QString> > fieldsValuesToRetrieve;
-        QString strAuxError;
-        if(!mPtrPersistenceManager->getPtrDb()->executeSqlQuery(sqlSentence,
-                                                                fieldsNamesToRetrieve,
-                                                                fieldsValuesToRetrieve,
-                                                                strAuxError))
-        {
-            strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-            strError+=QObject::tr("\nError recovering data for project id: %1 an tuplekey id: %2")
-                    .arg(QString::number(roiId)).arg(QString::number(tuplekeyId));
-            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        if(ptrGeometry==NULL)
+        {
+            strError=QObject::tr("ClassificationProject::loadROIGeometries");
+            strError+=QObject::tr("\nError recovering data for ROI id: %1").arg(roiId);
+            strError+=QObject::tr("\nInvalid wkt geometry\n%1").arg(wktGeometry);
             return(false);
         }
-        for(int nr=0;nr<fieldsValuesToRetrieve.size();nr++)
+        if(OGRERR_NONE!=ptrGeometry->importFromWkt(&charsWktGeometry))
         {
-            QString wktGeometry=fieldsValuesToRetrieve[nr][wktGeometryFieldName];
-            bool validGeometry=false;
-            QByteArray byteArrayWktGeometry = wktGeometry.toUtf8();
-            char *charsWktGeometry = byteArrayWktGeometry.data();
-            if(wktGeometry.contains("POLYGON"))
-            {
-                ptrGeometry=OGRGeometryFactory::createGeometry(wkbPolygon);
-                validGeometry=true;
-            }
-            if(wktGeometry.contains("MULTIPOLYGON"))
-            {
-                ptrGeometry=OGRGeometryFactory::createGeometry(wkbMultiPolygon);
-                validGeometry=true;
-            }
-            if(!validGeometry)
-            {
-                strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-                strError+=QObject::tr("\nError recovering data for project id: %1 an tuplekey id: %2")
-                        .arg(QString::number(roiId)).arg(QString::number(tuplekeyId));
-                strError+=QObject::tr("\nInvalid wkt geometry\n%1").arg(wktGeometry);
-                return(false);
-            }
-            if(OGRERR_NONE!=ptrGeometry->importFromWkt(&charsWktGeometry))
-            {
-                strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-                strError+=QObject::tr("\nError recovering data for project id: %1 an tuplekey id: %2")
-                        .arg(QString::number(roiId)).arg(QString::number(tuplekeyId));
-                strError+=QObject::tr("\nError making geometry from WKT: %1").arg(wktGeometry);
-                return(false);
-            }
+            strError=QObject::tr("ClassificationProject::loadROIGeometries");
+            strError+=QObject::tr("\nError recovering data for ROI id: %1").arg(roiId);
+            strError+=QObject::tr("\nError making geometry from WKT: %1").arg(wktGeometry);
+            OGRGeometryFactory::destroyGeometry(ptrGeometry);
+            return(false);
+        }
+        bool success=mPtrRoiGeometryCache->insertRoi(roiId,ptrGeometry,strAuxError);
+        OGRGeometryFactory::destroyGeometry(ptrGeometry);
+        if(!success)
+        {
+            strError=QObject::tr("ClassificationProject::loadROIGeometries");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
         }
     }
-    else
+    return(true);
+}
+
+bool ClassificationProject::loadTuplekeyGeometries(QVector<int> &tuplekeyIds,
+                                                   QString &strError)
+{
+    QString strAuxError;
+    if(mPtrRoiGeometryCache==NULL)
     {
-        sqlSentence="SELECT upper(asText(";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_THE_GEOM;
-        sqlSentence+="))";
-        sqlSentence+=" FROM ";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=" WHERE ";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        sqlSentence+=".";
-        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID;
-        sqlSentence+="=";
-        sqlSentence+=QString::number(tuplekeyId);
-        QVector<QString> fieldsNamesToRetrieve;
-        QString wktGeometryFieldName="wktGeometry";
-        fieldsNamesToRetrieve.push_back(wktGeometryFieldName);
-        QVector<QMap<QString, QString> > fieldsValuesToRetrieve;
-        QString strAuxError;
-        if(!mPtrPersistenceManager->getPtrDb()->executeSqlQuery(sqlSentence,
-                                                                fieldsNamesToRetrieve,
-                                                                fieldsValuesToRetrieve,
-                                                                strAuxError))
+        strError=QObject::tr("ClassificationProject::loadTuplekeyGeometries");
+        strError+=QObject::tr("\nROIs geometries are not loaded");
+        return(false);
+    }
+    // Cada tuplekey se recupera una vez de la base de datos
+    for(int nt=0;nt<tuplekeyIds.size();nt++)
+    {
+        int tuplekeyId=tuplekeyIds[nt];
+        if(mPtrRoiGeometryCache->containsTuplekey(tuplekeyId))
+        {
+            continue;
+        }
+        OGRGeometry* ptrTuplekeyGeometry=NULL;
+        if(!mPtrPersistenceManager->getTuplekeyGeometry(tuplekeyId,
+                                                        ptrTuplekeyGeometry,
+                                                        strAuxError))
         {
-            strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
+            strError=QObject::tr("ClassificationProject::loadTuplekeyGeometries");
             strError+=QObject::tr("\nError recovering data for tuplekey id: %1")
                     .arg(QString::number(tuplekeyId));
             strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
             return(false);
         }
-        for(int nr=0;nr<fieldsValuesToRetrieve.size();nr++)
+        bool success=mPtrRoiGeometryCache->insertTuplekey(tuplekeyId,ptrTuplekeyGeometry,strAuxError);
+        OGRGeometryFactory::destroyGeometry(ptrTuplekeyGeometry);
+        if(!success)
         {
-            QString wktGeometry=fieldsValuesToRetrieve[nr][wktGeometryFieldName];
-            bool validGeometry=false;
-            QByteArray byteArrayWktGeometry = wktGeometry.toUtf8();
-            char *charsWktGeometry = byteArrayWktGeometry.data();
-            if(wktGeometry.contains("POLYGON"))
-            {
-                ptrGeometry=OGRGeometryFactory::createGeometry(wkbPolygon);
-                validGeometry=true;
-            }
-            if(wktGeometry.contains("MULTIPOLYGON"))
-            {
-                ptrGeometry=OGRGeometryFactory::createGeometry(wkbMultiPolygon);
-                validGeometry=true;
-            }
-            if(!validGeometry)
-            {
-                strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-                strError+=QObject::tr("\nError recovering data for project id: %1 an tuplekey id: %2")
-                        .arg(QString::number(roiId)).arg(QString::number(tuplekeyId));
-                strError+=QObject::tr("\nInvalid wkt geometry\n%1").arg(wktGeometry);
-                return(false);
-            }
-            if(OGRERR_NONE!=ptrGeometry->importFromWkt(&charsWktGeometry))
-            {
-                strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-                strError+=QObject::tr("\nError recovering data for project id: %1 an tuplekey id: %2")
-                        .arg(QString::number(roiId)).arg(QString::number(tuplekeyId));
-                strError+=QObject::tr("\nError making geometry from WKT: %1").arg(wktGeometry);
-                return(false);
-            }
+            strError=QObject::tr("ClassificationProject::loadTuplekeyGeometries");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
         }
     }
     return(true);
@@ -2368,136 +2307,191 @@ bool ClassificationProject::getNdviDataByTuplekeyByRoi(int initialJd,
     return(true);
 }
 
-bool ClassificationProject::getIntersectsPixel(double rasterNwFc,
-                                               double rasterNwSc,
-                                               double rasterGsd,
-                                               int col,
-                                               int row,
-                                               OGRGeometry* ptrROIGeometry,
-                                               bool &intersects,
-                                               QString &strError)
+bool ClassificationProject::writeBinaryReport(const QMap<int, QMap<QString, QMap<int, StatisticsAccumulator> > > &accumulatorByRoiCodeBySpacecraftByJd,
+                                              const QMap<int, int> &roiCropByRoiCode,
+                                              const QMap<int, double> &roiAreaByRoiCode,
+                                              QString &strError)
 {
-    double firstCoordinate=rasterNwFc+col*rasterGsd+0.5*rasterGsd;
-    double secondCoordinate=rasterNwSc-row*rasterGsd-0.5*rasterGsd;
-    QString wktPointGeometry="POINT(";
-    wktPointGeometry+=QString::number(firstCoordinate,'f',12);
-    wktPointGeometry+=" ";
-    wktPointGeometry+=QString::number(secondCoordinate,'f',12);
-    wktPointGeometry+=")";
-    QByteArray byteArrayWktGeometry = wktPointGeometry.toUtf8();
-    char *charsWktGeometry = byteArrayWktGeometry.data();
-    OGRGeometry* ptrPointGeometry;
-    ptrPointGeometry=OGRGeometryFactory::createGeometry(wkbPoint);
-    if(OGRERR_NONE!=ptrPointGeometry->importFromWkt(&charsWktGeometry))
-    {
-        strError=QObject::tr("ClassificationProject::getRoiIntersectsPixel");
-        strError+=QObject::tr("\nError making point for column: %1 and row: %2")
-                .arg(QString::number(col)).arg(QString::number(row));
+    QString strAuxError;
+    ColumnarTableWriter writer;
+    if(!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_ROI_ID,COLUMNARTABLEWRITER_TYPE_INT32,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_CROP,COLUMNARTABLEWRITER_TYPE_INT32,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_AREA,COLUMNARTABLEWRITER_TYPE_FLOAT64,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_SPACECRAFT,COLUMNARTABLEWRITER_TYPE_INT32,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_JD,COLUMNARTABLEWRITER_TYPE_INT32,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_MEAN,COLUMNARTABLEWRITER_TYPE_FLOAT64,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_STD,COLUMNARTABLEWRITER_TYPE_FLOAT64,strAuxError)
+            ||!writer.addColumn(CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_COUNT,COLUMNARTABLEWRITER_TYPE_INT64,strAuxError))
+    {
+        strError=QObject::tr("ClassificationProject::writeBinaryReport");
+        strError+=QObject::tr("\nError defining columns:\n%1").arg(strAuxError);
         return(false);
     }
-    intersects=false;
-    if(ptrROIGeometry->Contains(ptrPointGeometry))
+    if(!writer.open(mBinaryReportFileName,strAuxError,CLASSIFICATIONPROJECT_BINARY_REPORT_BATCH_SIZE))
     {
-        OGRGeometryFactory::destroyGeometry(ptrPointGeometry);
-        intersects=true;
+        strError=QObject::tr("ClassificationProject::writeBinaryReport");
+        strError+=QObject::tr("\nError opening results file:\n%1\nError:\n%2").arg(mBinaryReportFileName).arg(strAuxError);
+        return(false);
     }
-    else
+    // Una fila por ROI, satelite y fecha con valores, ordenadas por ROI, satelite y fecha
+    QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > >::const_iterator iterRoi=accumulatorByRoiCodeBySpacecraftByJd.begin();
+    while(iterRoi!=accumulatorByRoiCodeBySpacecraftByJd.end())
     {
-        double distance=ptrPointGeometry->Distance(ptrROIGeometry);
-        OGRGeometryFactory::destroyGeometry(ptrPointGeometry);
-        if(distance<=(0.5*rasterGsd*sqrt(2.0)))
-        {
-            double pixelNwFc=rasterNwFc+rasterGsd*col;
-            double pixelNwSc=rasterNwSc-rasterGsd*row;
-            double pixelSeFc=pixelNwFc+rasterGsd;
-            double pixelSeSc=pixelNwSc-rasterGsd;
-            QString pixelWktGeometry="POLYGON((";
-            pixelWktGeometry+=QString::number(pixelNwFc,'f',12);
-            pixelWktGeometry+=" ";
-            pixelWktGeometry+=QString::number(pixelNwSc,'f',12);
-            pixelWktGeometry+=",";
-            pixelWktGeometry+=QString::number(pixelSeFc,'f',12);
-            pixelWktGeometry+=" ";
-            pixelWktGeometry+=QString::number(pixelNwSc,'f',12);
-            pixelWktGeometry+=",";
-            pixelWktGeometry+=QString::number(pixelSeFc,'f',12);
-            pixelWktGeometry+=" ";
-            pixelWktGeometry+=QString::number(pixelSeSc,'f',12);
-            pixelWktGeometry+=",";
-            pixelWktGeometry+=QString::number(pixelNwFc,'f',12);
-            pixelWktGeometry+=" ";
-            pixelWktGeometry+=QString::number(pixelSeSc,'f',12);
-            pixelWktGeometry+=",";
-            pixelWktGeometry+=QString::number(pixelNwFc,'f',12);
-            pixelWktGeometry+=" ";
-            pixelWktGeometry+=QString::number(pixelNwSc,'f',12);
-            pixelWktGeometry+="))";
-            QByteArray byteArrayPixelWktGeometry = pixelWktGeometry.toUtf8();
-            char *charsPixelWktGeometry = byteArrayPixelWktGeometry.data();
-            OGRGeometry* ptrPixelGeometry;
-            ptrPixelGeometry=OGRGeometryFactory::createGeometry(wkbPolygon);
-            if(OGRERR_NONE!=ptrPixelGeometry->importFromWkt(&charsPixelWktGeometry))
+        int roiCode=iterRoi.key();
+        QMap<QString,QMap<int,StatisticsAccumulator> >::const_iterator iterSpacecraft=iterRoi.value().begin();
+        while(iterSpacecraft!=iterRoi.value().end())
+        {
+            int spacecraftCode=CLASSIFICATIONPROJECT_BINARY_REPORT_L8_CODE;
+            if(iterSpacecraft.key().compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
             {
-                strError=QObject::tr("ClassificationProject::getRoiIntersectsPixel");
-                strError+=QObject::tr("\nError making pixel for column: %1 and row: %2")
-                        .arg(QString::number(col)).arg(QString::number(row));
-                OGRGeometryFactory::destroyGeometry(ptrPixelGeometry);
-                return(false);
+                spacecraftCode=CLASSIFICATIONPROJECT_BINARY_REPORT_S2A_CODE;
             }
-            if(ptrPixelGeometry->Intersects(ptrROIGeometry))
+            QMap<int,StatisticsAccumulator>::const_iterator iterJd=iterSpacecraft.value().begin();
+            while(iterJd!=iterSpacecraft.value().end())
             {
-                intersects=true;
+                const StatisticsAccumulator& accumulator=iterJd.value();
+                if(accumulator.getCount()>0)
+                {
+                    writer.appendInt32Value(0,roiCode);
+                    writer.appendInt32Value(1,roiCropByRoiCode.value(roiCode));
+                    writer.appendDoubleValue(2,roiAreaByRoiCode.value(roiCode));
+                    writer.appendInt32Value(3,spacecraftCode);
+                    writer.appendInt32Value(4,iterJd.key());
+                    writer.appendDoubleValue(5,accumulator.getMean()/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
+                    writer.appendDoubleValue(6,accumulator.getStd()/CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE);
+                    writer.appendInt64Value(7,accumulator.getCount());
+                    if(!writer.endRow(strAuxError))
+                    {
+                        strError=QObject::tr("ClassificationProject::writeBinaryReport");
+                        strError+=QObject::tr("\nError writing results file:\n%1\nError:\n%2").arg(mBinaryReportFileName).arg(strAuxError);
+                        return(false);
+                    }
+                }
+                iterJd++;
             }
-            OGRGeometryFactory::destroyGeometry(ptrPixelGeometry);
+            iterSpacecraft++;
         }
+        iterRoi++;
+    }
+    if(!writer.close(strAuxError))
+    {
+        strError=QObject::tr("ClassificationProject::writeBinaryReport");
+        strError+=QObject::tr("\nError closing results file:\n%1\nError:\n%2").arg(mBinaryReportFileName).arg(strAuxError);
+        return(false);
     }
     return(true);
 }
 
-bool ClassificationProject::getROIArea(int roiId,
-                                       double &area,
-                                       QString &strError)
+bool ClassificationProject::writeTextReports(QMap<int, QMap<QString, QMap<int, double> > > &meanValuesByRoiCodeBySpacecraftByJd,
+                                             QMap<int, QMap<QString, QMap<int, double> > > &stdValuesByRoiCodeBySpacecraftByJd,
+                                             const QMap<int, int> &roiCropByRoiCode,
+                                             const QMap<int, double> &roiAreaByRoiCode,
+                                             QString &strError)
 {
-    QString sqlSentence;
-    sqlSentence+="SELECT Area(";
-    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-    sqlSentence+=".";
-    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_GEOMETRY;
-    sqlSentence+=") FROM ";
-    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-    sqlSentence+=" WHERE ";
-    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_NAME;
-    sqlSentence+=".";
-    sqlSentence+=CLASSIFICATIONPROJECT_ROIS_CLASSIFICATION_TABLE_FIELD_ID;
-    sqlSentence+="=";
-    sqlSentence+=QString::number(roiId);
-    QVector<QString> fieldsNamesToRetrieve;
-    QString fieldName="area";
-    fieldsNamesToRetrieve.push_back(fieldName);
-    QVector<QMap<QString, QString> > fieldsValuesToRetrieve;
-    QString strAuxError;
-    if(!mPtrPersistenceManager->getPtrDb()->executeSqlQuery(sqlSentence,
-                                                            fieldsNamesToRetrieve,
-                                                            fieldsValuesToRetrieve,
-                                                            strAuxError))
+    QFile reportL8File(mL8ReportFileName);
+    if (!reportL8File.open(QFile::WriteOnly |QFile::Text))
     {
-        strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-        strError+=QObject::tr("\nError recovering area for project id: %1").arg(QString::number(roiId));
-        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        strError=QObject::tr("ClassificationProject::writeTextReports");
+        strError+=QObject::tr("\nError opening results file: \n %1").arg(mL8ReportFileName);
         return(false);
     }
-    for(int nr=0;nr<fieldsValuesToRetrieve.size();nr++)
+    QTextStream outL8(&reportL8File);
+    QFile reportS2AFile(mS2AReportFileName);
+    if (!reportS2AFile.open(QFile::WriteOnly |QFile::Text))
+    {
+        strError=QObject::tr("ClassificationProject::writeTextReports");
+        strError+=QObject::tr("\nError opening results file: \n %1").arg(mS2AReportFileName);
+        return(false);
+    }
+    QTextStream outS2A(&reportS2AFile);
+
+    QString strRoiIdTag=CLASSIFICATIONPROJECT_ROI_ID_PRINT_TAG;
+    QString strRoiCropTag=CLASSIFICATIONPROJECT_ROI_CROP_PRINT_TAG;
+    QString strRoiAreaTag=CLASSIFICATIONPROJECT_ROI_AREA_PRINT_TAG;
+
+    outL8<<"L8 CLASSIFICATION DATA, Time interval: ";
+    outL8<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
+    outL8<<" to ";
+    outL8<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
+    outL8<<"\n";
+    outL8<<"- Increment to ROIs ids: "<<QString::number(mROIIncrement)<<"\n";
+    outL8<<strRoiIdTag.rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
+    outL8<<strRoiCropTag.rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
+    outL8<<strRoiAreaTag.rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
+
+    outS2A<<"S2A CLASSIFICATION DATA, Time interval: ";
+    outS2A<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
+    outS2A<<" to ";
+    outS2A<<QDate::fromJulianDay(mInitialJd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
+    outS2A<<"\n";
+    outS2A<<"- Increment to ROIs ids: "<<QString::number(mROIIncrement)<<"\n";
+    outS2A<<strRoiIdTag.rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
+    outS2A<<strRoiCropTag.rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
+    outS2A<<strRoiAreaTag.rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
+
+    for(int njd=mInitialJd;njd<=mFinalJd;njd++)
+    {
+        QString strDate=QDate::fromJulianDay(njd).toString(CLASSIFICATIONPROJECT_DATE_FORMAT_1);
+        outL8<<strDate.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH*2);
+        outS2A<<strDate.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH*2);
+    }
+    outL8<<"\n";
+    outS2A<<"\n";
+
+    QMap<int,QMap<QString,QMap<int,double> > >::const_iterator iterROIs=meanValuesByRoiCodeBySpacecraftByJd.begin();
+    while(iterROIs!=meanValuesByRoiCodeBySpacecraftByJd.end())
     {
-        QString strArea=fieldsValuesToRetrieve[nr][fieldName];
-        bool oktoDbl=false;
-        area=strArea.toDouble(&oktoDbl);
-        if(!oktoDbl)
+        int roiCode=iterROIs.key();
+        QMap<QString,QMap<int,double> > meanValuesBySpacecraftByJd=iterROIs.value();
+        QMap<QString,QMap<int,double> >::const_iterator iterSpacecraft=meanValuesBySpacecraftByJd.begin();
+        while(iterSpacecraft!=meanValuesBySpacecraftByJd.end())
         {
-            strError=QObject::tr("ClassificationProject::getROITuplekeyIntersectionGeomety");
-            strError+=QObject::tr("\nError recovering area for project id: %1").arg(QString::number(roiId));
-            strError+=QObject::tr("\nError:\nArea: %1 is not a dobule").arg(strArea);
-            return(false);
+            QString spacecraftId=iterSpacecraft.key();
+            if(spacecraftId.compare(CLASSIFICATIONPROJECT_L8_TAG)==0)
+            {
+                outL8<<QString::number(roiCode).rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
+                outL8<<QString::number(roiCropByRoiCode.value(roiCode)).rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
+                outL8<<QString::number(roiAreaByRoiCode.value(roiCode),'f',CLASSIFICATIONPROJECT_ROI_AREA_PRECISION).rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
+            }
+            else if(spacecraftId.compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
+            {
+                outS2A<<QString::number(roiCode).rightJustified(CLASSIFICATIONPROJECT_ROI_ID_PRINT_WIDTH);
+                outS2A<<QString::number(roiCropByRoiCode.value(roiCode)).rightJustified(CLASSIFICATIONPROJECT_ROI_CROP_PRINT_WIDTH);
+                outS2A<<QString::number(roiAreaByRoiCode.value(roiCode),'f',CLASSIFICATIONPROJECT_ROI_AREA_PRECISION).rightJustified(CLASSIFICATIONPROJECT_ROI_AREA_PRINT_WIDTH);
+            }
+            for(int njd=mInitialJd;njd<=mFinalJd;njd++)
+            {
+                QString strMeanValue="NaN";
+                QString strStdValue="NaN";
+                if(meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId].contains(njd))
+                {
+                    strMeanValue=QString::number(meanValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][njd],'f',CLASSIFICATIONPROJECT_MEAN_VALUES_PRINT_PRECISION);
+                    strStdValue=QString::number(stdValuesByRoiCodeBySpacecraftByJd[roiCode][spacecraftId][njd],'f',CLASSIFICATIONPROJECT_MEAN_VALUES_PRINT_PRECISION);
+                }
+                if(spacecraftId.compare(CLASSIFICATIONPROJECT_L8_TAG)==0)
+                {
+                    outL8<<strMeanValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
+                    outL8<<strStdValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
+                }
+                else if(spacecraftId.compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
+                {
+                    outS2A<<strMeanValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
+                    outS2A<<strStdValue.rightJustified(CLASSIFICATIONPROJECT_VALUES_PRINT_WIDTH);
+                }
+            }
+            if(spacecraftId.compare(CLASSIFICATIONPROJECT_L8_TAG)==0)
+            {
+                outL8<<"\n";
+            }
+            else if(spacecraftId.compare(CLASSIFICATIONPROJECT_S2A_TAG)==0)
+            {
+                outS2A<<"\n";
+            }
+            iterSpacecraft++;
         }
+        iterROIs++;
     }
+    reportL8File.close();
+    reportS2AFile.close();
     return(true);
 }
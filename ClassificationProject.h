@@ -57,6 +57,21 @@
 
 #define CLASSIFICATIONPROJECT_SCALE_FACTOR_TO_NDVI_INTEGER_STORAGE                  10000.0 // Para almacecenar dos decimales
 
+#define CLASSIFICATIONPROJECT_NUMBER_OF_THREADS                                     0 // 0: QThread::idealThreadCount()
+#define CLASSIFICATIONPROJECT_RASTER_BLOCK_CACHE_MAXIMUM_MB                        512
+
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_BATCH_SIZE                              65536 // filas por lote
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_ROI_ID                            "roi_id"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_CROP                              "crop"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_AREA                              "area"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_SPACECRAFT                        "spacecraft"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_JD                                "jd"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_MEAN                              "mean"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_STD                               "std"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_FIELD_COUNT                             "count"
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_L8_CODE                                 0
+#define CLASSIFICATIONPROJECT_BINARY_REPORT_S2A_CODE                                1
+
 class OGRGeometry;
 
 namespace NestedGrid{
@@ -75,6 +90,10 @@ namespace IGDAL{
 
 namespace RemoteSensing{
 class PersistenceManager;
+class RasterBlockCache;
+class RoiGeometryCache;
+class StatisticsAccumulator;
+class ZonalStatisticsEngine;
 class LIBREMOTESENSINGSHARED_EXPORT ClassificationProject : public QObject
 {
     Q_OBJECT
@@ -106,24 +125,20 @@ private:
                                     QMap<QString, QString> &rasterIdByTuplekeyFileName,
                                     int &maximumLod,
                                     QString &strError);
-    bool getIntersectsPixel(double rasterNwFc,
-                            double rasterNwSc,
-                            double rasterGsd,
-                            int col,
-                            int row,
-                            OGRGeometry* ptrROIGeometry,
-                            bool &intersects,
-                            QString &strError);
-    bool getROIArea(int roiId,
-                    double& area,
-                    QString &strError);
-    bool getROITuplekeyIntersectionGeomety(int roiId,
-                                           int tuplekeyId,
-                                           OGRGeometry *&ptrGeometry,
-                                           bool& roiContainsTuplekey,
-                                           QString &strError);
+    bool loadROIGeometries(QString &strError);
+    bool loadTuplekeyGeometries(QVector<int>& tuplekeyIds,
+                                QString &strError);
     bool removeDir(QString dirName);
     bool removeRubbish(QString &strError);
+    bool writeBinaryReport(const QMap<int,QMap<QString,QMap<int,StatisticsAccumulator> > >& accumulatorByRoiCodeBySpacecraftByJd,
+                           const QMap<int,int>& roiCropByRoiCode,
+                           const QMap<int,double>& roiAreaByRoiCode,
+                           QString& strError);
+    bool writeTextReports(QMap<int,QMap<QString,QMap<int,double> > >& meanValuesByRoiCodeBySpacecraftByJd,
+                          QMap<int,QMap<QString,QMap<int,double> > >& stdValuesByRoiCodeBySpacecraftByJd,
+                          const QMap<int,int>& roiCropByRoiCode,
+                          const QMap<int,double>& roiAreaByRoiCode,
+                          QString& strError);
     QTextStream* mStdOut;
     bool mFromConsole;
     bool mRemoveRubbish;
@@ -143,12 +158,17 @@ private:
     QString mS2ASpacecraftIdentifier;
     QString mL8ReportFileName;
     QString mS2AReportFileName;
+    QString mBinaryReportFileName; // vacio si no se escribe
+    bool mWriteTextReports;
     QString mResultsPath;
     bool mIsInitialized;
     QStringList mValidFormatsForDate;
     QWidget *mPtrParentWidget;
     libCRS::CRSTools* mPtrCrsTools;
     PersistenceManager *mPtrPersistenceManager;
+    RasterBlockCache* mPtrRasterBlockCache;
+    RoiGeometryCache* mPtrRoiGeometryCache; // geometrias de ROIs y tuplekeys durante createClassificationData
+    ZonalStatisticsEngine* mPtrZonalStatisticsEngine; // sobre mPtrRasterBlockCache
     NestedGrid::NestedGridTools* mPtrNestedGridTools;
     NestedGrid::NestedGridProject* mPtrNestedGridProject;
     IGDAL::libIGDALProcessMonitor* mPtrLibIGDALProcessMonitor;
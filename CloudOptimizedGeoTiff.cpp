@@ -0,0 +1,181 @@
+#include <QFile>
+#include <QFileInfo>
+
+#include <cpl_string.h>
+
+#include "CloudOptimizedGeoTiff.h"
+#include "remotesensing_definitions.h"
+
+using namespace RemoteSensing;
+
+bool CloudOptimizedGeoTiff::createCopy(GDALDatasetH hSrcDS,
+                                       QString outputFileName,
+                                       int blockSize,
+                                       QString overviewResampling,
+                                       QString &strError)
+{
+    GDALRasterBandH hSrcBand=GDALGetRasterBand(hSrcDS,1);
+    GDALDataType gdalDataType=GDALGetRasterDataType(hSrcBand);
+    GDALDatasetH hDstDS=NULL;
+    char** ptrOptions=NULL;
+    GDALDriverH hCogDriver=GDALGetDriverByName(REMOTESENSING_COG_DRIVER_NAME);
+    if(hCogDriver!=NULL)
+    {
+        // El driver COG calcula las overviews que falten durante la copia
+        ptrOptions=CSLSetNameValue(ptrOptions,"BLOCKSIZE",QString::number(blockSize).toLatin1().constData());
+        ptrOptions=CSLSetNameValue(ptrOptions,"COMPRESS",getCompressionMethod().toLatin1().constData());
+        ptrOptions=CSLSetNameValue(ptrOptions,"PREDICTOR","YES");
+        ptrOptions=CSLSetNameValue(ptrOptions,"RESAMPLING",overviewResampling.toLatin1().constData());
+        ptrOptions=CSLSetNameValue(ptrOptions,"BIGTIFF","IF_SAFER");
+        hDstDS=GDALCreateCopy(hCogDriver,outputFileName.toStdString().c_str(),
+                              hSrcDS,FALSE,ptrOptions,NULL,NULL);
+    }
+    else
+    {
+        // GDAL anterior a 3.1: GTiff con COPY_SRC_OVERVIEWS. Si faltan, las overviews se anaden
+        // al propio origen (externas .ovr si es un fichero de solo lectura) sin copiarlo a memoria
+        int numberOfColumns=GDALGetRasterXSize(hSrcDS);
+        int numberOfRows=GDALGetRasterYSize(hSrcDS);
+        QVector<int> overviewFactors;
+        getOverviewFactors(numberOfColumns,numberOfRows,blockSize,overviewFactors);
+        if(GDALGetOverviewCount(hSrcBand)==0
+                &&overviewFactors.size()>0)
+        {
+            if(GDALBuildOverviews(hSrcDS,overviewResampling.toLatin1().constData(),
+                                  overviewFactors.size(),overviewFactors.data(),
+                                  0,NULL,NULL,NULL)!=CE_None)
+            {
+                strError=QObject::tr("CloudOptimizedGeoTiff::createCopy");
+                strError+=QObject::tr("\nError building overviews for file:\n%1").arg(outputFileName);
+                strError+=QObject::tr("\nGDAL error:\n%1").arg(QString(CPLGetLastErrorMsg()));
+                return(false);
+            }
+        }
+        QStringList creationOptions;
+        getTiffCreationOptions(gdalDataType,blockSize,creationOptions);
+        creationOptions<<"COPY_SRC_OVERVIEWS=YES";
+        creationOptions<<"BIGTIFF=IF_SAFER";
+        for(int nco=0;nco<creationOptions.size();nco++)
+        {
+            ptrOptions=CSLAddString(ptrOptions,creationOptions[nco].toLatin1().constData());
+        }
+        hDstDS=GDALCreateCopy(GDALGetDriverByName(REMOTESENSING_REPROJECTION_OUTPUT_FORMAT),
+                              outputFileName.toStdString().c_str(),
+                              hSrcDS,FALSE,ptrOptions,NULL,NULL);
+    }
+    CSLDestroy(ptrOptions);
+    if(hDstDS==NULL)
+    {
+        strError=QObject::tr("CloudOptimizedGeoTiff::createCopy");
+        strError+=QObject::tr("\nError writing file:\n%1").arg(outputFileName);
+        strError+=QObject::tr("\nGDAL error:\n%1").arg(QString(CPLGetLastErrorMsg()));
+        return(false);
+    }
+    GDALClose(hDstDS);
+    return(true);
+}
+
+QString CloudOptimizedGeoTiff::getCompressionMethod()
+{
+    // ZSTD solo si libtiff se compilo con soporte
+    QString compressionMethod=REMOTESENSING_COG_COMPRESSION_METHOD_ALTERNATIVE;
+    GDALDriverH hDriver=GDALGetDriverByName(REMOTESENSING_REPROJECTION_OUTPUT_FORMAT);
+    if(hDriver!=NULL)
+    {
+        const char* ptrCreationOptionList=GDALGetMetadataItem(hDriver,GDAL_DMD_CREATIONOPTIONLIST,NULL);
+        if(ptrCreationOptionList!=NULL
+                &&QString(ptrCreationOptionList).contains(REMOTESENSING_COG_COMPRESSION_METHOD))
+        {
+            compressionMethod=REMOTESENSING_COG_COMPRESSION_METHOD;
+        }
+    }
+    return(compressionMethod);
+}
+
+void CloudOptimizedGeoTiff::getOverviewFactors(int numberOfColumns,
+                                               int numberOfRows,
+                                               int blockSize,
+                                               QVector<int> &overviewFactors)
+{
+    // Como el driver COG: niveles hasta que la imagen cabe en un bloque
+    overviewFactors.clear();
+    int size=qMax(numberOfColumns,numberOfRows);
+    int factor=1;
+    while(size>blockSize)
+    {
+        factor*=2;
+        size=(size+1)/2;
+        overviewFactors.push_back(factor);
+    }
+}
+
+void CloudOptimizedGeoTiff::getTiffCreationOptions(GDALDataType gdalDataType,
+                                                   int blockSize,
+                                                   QStringList &creationOptions)
+{
+    creationOptions<<"TILED=YES";
+    creationOptions<<("BLOCKXSIZE="+QString::number(blockSize));
+    creationOptions<<("BLOCKYSIZE="+QString::number(blockSize));
+    creationOptions<<("COMPRESS="+getCompressionMethod());
+    // Predictor horizontal para enteros, de coma flotante para reales
+    if(gdalDataType==GDT_Float32
+            ||gdalDataType==GDT_Float64)
+    {
+        creationOptions<<"PREDICTOR=3";
+    }
+    else
+    {
+        creationOptions<<"PREDICTOR=2";
+    }
+}
+
+bool CloudOptimizedGeoTiff::isCogOutputProfile(QString outputProfile)
+{
+    return(outputProfile.compare(REMOTESENSING_OUTPUT_PROFILE_COG,Qt::CaseInsensitive)==0);
+}
+
+bool CloudOptimizedGeoTiff::translateFile(QString fileName,
+                                          int blockSize,
+                                          QString overviewResampling,
+                                          QString &strError)
+{
+    QFileInfo fileInfo(fileName);
+    QString cogFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()
+            +REMOTESENSING_COG_TEMPORARY_FILE_SUFFIX+"."+fileInfo.suffix();
+    // Las overviews externas de una escritura anterior ya no sirven
+    QString ovrFileName=fileName+".ovr";
+    if(QFile::exists(ovrFileName))
+    {
+        QFile::remove(ovrFileName);
+    }
+    GDALDatasetH hSrcDS=GDALOpen(fileName.toStdString().c_str(),GA_ReadOnly);
+    if(hSrcDS==NULL)
+    {
+        strError=QObject::tr("CloudOptimizedGeoTiff::translateFile");
+        strError+=QObject::tr("\nError opening file:\n%1").arg(fileName);
+        return(false);
+    }
+    QString strAuxError;
+    bool success=createCopy(hSrcDS,cogFileName,blockSize,overviewResampling,strAuxError);
+    GDALClose(hSrcDS);
+    // Ni las que crea la copia sin driver COG, ya incluidas en el fichero COG
+    if(QFile::exists(ovrFileName))
+    {
+        QFile::remove(ovrFileName);
+    }
+    if(!success)
+    {
+        QFile::remove(cogFileName);
+        strError=QObject::tr("CloudOptimizedGeoTiff::translateFile");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(!QFile::remove(fileName)
+            ||!QFile::rename(cogFileName,fileName))
+    {
+        strError=QObject::tr("CloudOptimizedGeoTiff::translateFile");
+        strError+=QObject::tr("\nError replacing file:\n%1").arg(fileName);
+        return(false);
+    }
+    return(true);
+}
@@ -0,0 +1,38 @@
+#ifndef CLOUDOPTIMIZEDGEOTIFF_H
+#define CLOUDOPTIMIZEDGEOTIFF_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <gdal.h>
+
+#include "libremotesensing_global.h"
+
+namespace RemoteSensing{
+// Perfil de salida COG: teselado interno, compresion ZSTD (o DEFLATE) con predictor
+// y overviews escritas en la misma copia que los datos
+class LIBREMOTESENSINGSHARED_EXPORT CloudOptimizedGeoTiff
+{
+public:
+    static bool createCopy(GDALDatasetH hSrcDS,
+                           QString outputFileName,
+                           int blockSize,
+                           QString overviewResampling,
+                           QString& strError);
+    static QString getCompressionMethod();
+    static void getOverviewFactors(int numberOfColumns,
+                                   int numberOfRows,
+                                   int blockSize,
+                                   QVector<int>& overviewFactors);
+    static void getTiffCreationOptions(GDALDataType gdalDataType,
+                                       int blockSize,
+                                       QStringList& creationOptions);
+    static bool isCogOutputProfile(QString outputProfile);
+    static bool translateFile(QString fileName,
+                              int blockSize,
+                              QString overviewResampling,
+                              QString& strError);
+};
+}
+#endif // CLOUDOPTIMIZEDGEOTIFF_H
@@ -0,0 +1,272 @@
+#include <QObject>
+#include <QtEndian>
+
+#include <string.h>
+
+#include "ColumnarTableWriter.h"
+
+using namespace RemoteSensing;
+
+namespace{
+void appendUInt32(QByteArray& bytes,
+                  quint32 value)
+{
+    quint32 littleEndianValue=qToLittleEndian(value);
+    bytes.append((const char*)&littleEndianValue,sizeof(quint32));
+}
+
+void appendUInt64(QByteArray& bytes,
+                  quint64 value)
+{
+    quint64 littleEndianValue=qToLittleEndian(value);
+    bytes.append((const char*)&littleEndianValue,sizeof(quint64));
+}
+
+void appendPadding(QByteArray& bytes)
+{
+    while(bytes.size()%COLUMNARTABLEWRITER_ALIGNMENT!=0)
+    {
+        bytes.append('\0');
+    }
+}
+
+int getTypeSize(int type)
+{
+    if(type==COLUMNARTABLEWRITER_TYPE_INT32)
+    {
+        return(4);
+    }
+    return(8);
+}
+}
+
+ColumnarTableWriter::ColumnarTableWriter()
+{
+    mBatchSize=COLUMNARTABLEWRITER_DEFAULT_BATCH_SIZE;
+    mNumberOfRowsInBatch=0;
+    mNumberOfRows=0;
+}
+
+ColumnarTableWriter::~ColumnarTableWriter()
+{
+    clear();
+}
+
+bool ColumnarTableWriter::addColumn(QString name,
+                                    int type,
+                                    QString &strError)
+{
+    if(mFile.isOpen())
+    {
+        strError=QObject::tr("ColumnarTableWriter::addColumn");
+        strError+=QObject::tr("\nColumns must be added before opening the file");
+        return(false);
+    }
+    if(type!=COLUMNARTABLEWRITER_TYPE_INT32
+            &&type!=COLUMNARTABLEWRITER_TYPE_INT64
+            &&type!=COLUMNARTABLEWRITER_TYPE_FLOAT64)
+    {
+        strError=QObject::tr("ColumnarTableWriter::addColumn");
+        strError+=QObject::tr("\nInvalid type: %1 for column: %2").arg(QString::number(type)).arg(name);
+        return(false);
+    }
+    if(name.isEmpty()
+            ||name.toLatin1().size()>=COLUMNARTABLEWRITER_COLUMN_NAME_SIZE
+            ||mColumnNames.contains(name))
+    {
+        strError=QObject::tr("ColumnarTableWriter::addColumn");
+        strError+=QObject::tr("\nInvalid or repeated column name: %1").arg(name);
+        return(false);
+    }
+    mColumnNames.push_back(name);
+    mColumnTypes.push_back(type);
+    mColumnValues.push_back(QByteArray());
+    return(true);
+}
+
+void ColumnarTableWriter::appendDoubleValue(int column,
+                                            double value)
+{
+    quint64 bits;
+    memcpy(&bits,&value,sizeof(double));
+    appendUInt64(mColumnValues[column],bits);
+}
+
+void ColumnarTableWriter::appendInt32Value(int column,
+                                           qint32 value)
+{
+    appendUInt32(mColumnValues[column],(quint32)value);
+}
+
+void ColumnarTableWriter::appendInt64Value(int column,
+                                           qint64 value)
+{
+    appendUInt64(mColumnValues[column],(quint64)value);
+}
+
+void ColumnarTableWriter::clear()
+{
+    if(mFile.isOpen())
+    {
+        mFile.close();
+    }
+    mFileName.clear();
+    mBatchSize=COLUMNARTABLEWRITER_DEFAULT_BATCH_SIZE;
+    mNumberOfRowsInBatch=0;
+    mNumberOfRows=0;
+    mColumnNames.clear();
+    mColumnTypes.clear();
+    mColumnValues.clear();
+    mBatchOffsets.clear();
+}
+
+bool ColumnarTableWriter::close(QString &strError)
+{
+    if(!mFile.isOpen())
+    {
+        strError=QObject::tr("ColumnarTableWriter::close");
+        strError+=QObject::tr("\nFile is not open");
+        return(false);
+    }
+    QString strAuxError;
+    if(mNumberOfRowsInBatch>0)
+    {
+        if(!writeBatch(strAuxError))
+        {
+            strError=QObject::tr("ColumnarTableWriter::close");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    QByteArray footer;
+    for(int nb=0;nb<mBatchOffsets.size();nb++)
+    {
+        appendUInt64(footer,mBatchOffsets[nb]);
+    }
+    appendUInt64(footer,(quint64)mBatchOffsets.size());
+    appendUInt64(footer,(quint64)mNumberOfRows);
+    footer.append(COLUMNARTABLEWRITER_FOOTER_MAGIC);
+    if(!writeBytes(footer,strAuxError))
+    {
+        strError=QObject::tr("ColumnarTableWriter::close");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    mFile.close();
+    return(true);
+}
+
+bool ColumnarTableWriter::endRow(QString &strError)
+{
+    mNumberOfRowsInBatch++;
+    mNumberOfRows++;
+    for(int nc=0;nc<mColumnValues.size();nc++)
+    {
+        if(mColumnValues[nc].size()!=mNumberOfRowsInBatch*getTypeSize(mColumnTypes[nc]))
+        {
+            strError=QObject::tr("ColumnarTableWriter::endRow");
+            strError+=QObject::tr("\nColumn: %1 has not one value in row: %2")
+                    .arg(mColumnNames[nc]).arg(QString::number(mNumberOfRows));
+            return(false);
+        }
+    }
+    if(mNumberOfRowsInBatch<mBatchSize)
+    {
+        return(true);
+    }
+    QString strAuxError;
+    if(!writeBatch(strAuxError))
+    {
+        strError=QObject::tr("ColumnarTableWriter::endRow");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    return(true);
+}
+
+bool ColumnarTableWriter::open(QString fileName,
+                               QString &strError,
+                               int batchSize)
+{
+    if(mFile.isOpen())
+    {
+        strError=QObject::tr("ColumnarTableWriter::open");
+        strError+=QObject::tr("\nFile is already open: %1").arg(mFileName);
+        return(false);
+    }
+    if(mColumnNames.isEmpty()||batchSize<1)
+    {
+        strError=QObject::tr("ColumnarTableWriter::open");
+        strError+=QObject::tr("\nThere are no columns or batch size is not valid");
+        return(false);
+    }
+    mFile.setFileName(fileName);
+    if(!mFile.open(QFile::WriteOnly|QFile::Truncate))
+    {
+        strError=QObject::tr("ColumnarTableWriter::open");
+        strError+=QObject::tr("\nError opening file:\n%1").arg(fileName);
+        return(false);
+    }
+    mFileName=fileName;
+    mBatchSize=batchSize;
+    mNumberOfRowsInBatch=0;
+    mNumberOfRows=0;
+    mBatchOffsets.clear();
+    QByteArray header;
+    header.append(COLUMNARTABLEWRITER_FILE_MAGIC);
+    appendUInt32(header,COLUMNARTABLEWRITER_VERSION);
+    appendUInt32(header,(quint32)mColumnNames.size());
+    for(int nc=0;nc<mColumnNames.size();nc++)
+    {
+        QByteArray name=mColumnNames[nc].toLatin1();
+        name.append(QByteArray(COLUMNARTABLEWRITER_COLUMN_NAME_SIZE-name.size(),'\0'));
+        header.append(name);
+        appendUInt32(header,(quint32)mColumnTypes[nc]);
+        appendUInt32(header,0);
+    }
+    QString strAuxError;
+    if(!writeBytes(header,strAuxError))
+    {
+        strError=QObject::tr("ColumnarTableWriter::open");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        mFile.close();
+        return(false);
+    }
+    return(true);
+}
+
+bool ColumnarTableWriter::writeBatch(QString &strError)
+{
+    mBatchOffsets.push_back((quint64)mFile.pos());
+    QByteArray batchHeader;
+    batchHeader.append(COLUMNARTABLEWRITER_BATCH_MAGIC);
+    appendUInt32(batchHeader,(quint32)mNumberOfRowsInBatch);
+    appendUInt32(batchHeader,0);
+    if(!writeBytes(batchHeader,strError))
+    {
+        return(false);
+    }
+    for(int nc=0;nc<mColumnValues.size();nc++)
+    {
+        appendPadding(mColumnValues[nc]);
+        if(!writeBytes(mColumnValues[nc],strError))
+        {
+            return(false);
+        }
+        mColumnValues[nc].clear();
+    }
+    mNumberOfRowsInBatch=0;
+    return(true);
+}
+
+bool ColumnarTableWriter::writeBytes(const QByteArray &bytes,
+                                     QString &strError)
+{
+    if(mFile.write(bytes)!=bytes.size())
+    {
+        strError=QObject::tr("ColumnarTableWriter::writeBytes");
+        strError+=QObject::tr("\nError writing file:\n%1\nError:\n%2").arg(mFileName).arg(mFile.errorString());
+        return(false);
+    }
+    return(true);
+}
@@ -0,0 +1,68 @@
+#ifndef COLUMNARTABLEWRITER_H
+#define COLUMNARTABLEWRITER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+#define COLUMNARTABLEWRITER_FILE_MAGIC                      "RSCOLTB1"
+#define COLUMNARTABLEWRITER_BATCH_MAGIC                     "RSBATCH1"
+#define COLUMNARTABLEWRITER_FOOTER_MAGIC                    "RSCOLEND"
+#define COLUMNARTABLEWRITER_VERSION                         1
+#define COLUMNARTABLEWRITER_COLUMN_NAME_SIZE                32 // bytes ASCII, rellenos con ceros
+#define COLUMNARTABLEWRITER_ALIGNMENT                       8
+#define COLUMNARTABLEWRITER_DEFAULT_BATCH_SIZE              65536 // filas
+
+#define COLUMNARTABLEWRITER_TYPE_INT32                      1
+#define COLUMNARTABLEWRITER_TYPE_INT64                      2
+#define COLUMNARTABLEWRITER_TYPE_FLOAT64                    3
+
+namespace RemoteSensing{
+// Tabla binaria por columnas, little-endian, escrita por lotes sin guardar la tabla en memoria.
+// Todos los bloques estan alineados a 8 bytes, para poder leerla con el fichero mapeado:
+//  - Cabecera: magic "RSCOLTB1", uint32 version, uint32 numero de columnas y, por columna,
+//    nombre (32 bytes) y uint32 tipo, uint32 reservado
+//  - Lotes: magic "RSBATCH1", uint32 numero de filas, uint32 reservado y los valores de cada
+//    columna seguidos, en el orden de la cabecera, cada columna rellena hasta multiplo de 8
+//  - Pie: uint64 posicion de cada lote, uint64 numero de lotes, uint64 numero de filas y
+//    magic "RSCOLEND". Un lector empieza por los ultimos 24 bytes
+class LIBREMOTESENSINGSHARED_EXPORT ColumnarTableWriter
+{
+public:
+    ColumnarTableWriter();
+    ~ColumnarTableWriter();
+    bool addColumn(QString name,
+                   int type,
+                   QString& strError);
+    void appendDoubleValue(int column,
+                           double value);
+    void appendInt32Value(int column,
+                          qint32 value);
+    void appendInt64Value(int column,
+                          qint64 value);
+    void clear();
+    bool close(QString& strError);
+    bool endRow(QString& strError);
+    qint64 getNumberOfRows(){return(mNumberOfRows);}
+    bool open(QString fileName,
+              QString& strError,
+              int batchSize=COLUMNARTABLEWRITER_DEFAULT_BATCH_SIZE);
+private:
+    bool writeBatch(QString& strError);
+    bool writeBytes(const QByteArray& bytes,
+                    QString& strError);
+    QFile mFile;
+    QString mFileName;
+    int mBatchSize;
+    int mNumberOfRowsInBatch;
+    qint64 mNumberOfRows;
+    QVector<QString> mColumnNames;
+    QVector<int> mColumnTypes;
+    QVector<QByteArray> mColumnValues; // lote en curso
+    QVector<quint64> mBatchOffsets;
+};
+}
+#endif // COLUMNARTABLEWRITER_H
@@ -0,0 +1,82 @@
+#include "DailyValueSeries.h"
+
+using namespace RemoteSensing;
+
+DailyValueSeries::DailyValueSeries()
+{
+    clear();
+}
+
+void DailyValueSeries::clear()
+{
+    mFirstJd=0;
+    mValues.clear();
+    mExists.clear();
+    mPrefixSums.clear();
+    mIndexWeightedPrefixSums.clear();
+    mPrefixCounts.clear();
+}
+
+bool DailyValueSeries::containsAll(int firstJd,
+                                   int lastJd) const
+{
+    if(firstJd>lastJd)
+    {
+        return(true);
+    }
+    int firstPosition=firstJd-mFirstJd;
+    int endPosition=lastJd-mFirstJd+1;
+    if(firstPosition<0||endPosition>mValues.size())
+    {
+        return(false);
+    }
+    return(mPrefixCounts[endPosition]-mPrefixCounts[firstPosition]==endPosition-firstPosition);
+}
+
+double DailyValueSeries::getLinearWeightedSum(int firstJd,
+                                              int lastJd,
+                                              double weight,
+                                              double slope,
+                                              int referenceJd) const
+{
+    if(firstJd>lastJd)
+    {
+        return(0.0);
+    }
+    int firstPosition=firstJd-mFirstJd;
+    int endPosition=lastJd-mFirstJd+1;
+    double sum=mPrefixSums[endPosition]-mPrefixSums[firstPosition];
+    double indexWeightedSum=mIndexWeightedPrefixSums[endPosition]-mIndexWeightedPrefixSums[firstPosition];
+    // jd-referenceJd=k+(mFirstJd-referenceJd) con k la posicion en la serie
+    return(weight*sum+slope*(indexWeightedSum+(mFirstJd-referenceJd)*sum));
+}
+
+void DailyValueSeries::setValues(const QMap<int, double> &valueByJd)
+{
+    clear();
+    if(valueByJd.isEmpty())
+    {
+        return;
+    }
+    mFirstJd=valueByJd.firstKey();
+    int numberOfDays=valueByJd.lastKey()-mFirstJd+1;
+    mValues.fill(0.0,numberOfDays);
+    mExists.fill(0,numberOfDays);
+    QMap<int,double>::const_iterator iterValue=valueByJd.begin();
+    while(iterValue!=valueByJd.end())
+    {
+        int position=iterValue.key()-mFirstJd;
+        mValues[position]=iterValue.value();
+        mExists[position]=1;
+        iterValue++;
+    }
+    mPrefixSums.fill(0.0,numberOfDays+1);
+    mIndexWeightedPrefixSums.fill(0.0,numberOfDays+1);
+    mPrefixCounts.fill(0,numberOfDays+1);
+    for(int position=0;position<numberOfDays;position++)
+    {
+        mPrefixSums[position+1]=mPrefixSums[position]+mValues[position];
+        mIndexWeightedPrefixSums[position+1]=mIndexWeightedPrefixSums[position]+position*mValues[position];
+        mPrefixCounts[position+1]=mPrefixCounts[position]+mExists[position];
+    }
+}
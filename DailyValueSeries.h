@@ -0,0 +1,45 @@
+#ifndef DAILYVALUESERIES_H
+#define DAILYVALUESERIES_H
+
+#include <QMap>
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+namespace RemoteSensing{
+// Serie diaria densa indexada por jd-firstJd, con sumas acumuladas de los valores, de los
+// valores por el indice y del numero de dias con valor, para obtener en tiempo constante
+// sumas de intervalos y sumas ponderadas con pesos lineales en el dia
+class LIBREMOTESENSINGSHARED_EXPORT DailyValueSeries
+{
+public:
+    DailyValueSeries();
+    void clear();
+    bool contains(int jd) const
+    {
+        int position=jd-mFirstJd;
+        return(position>=0&&position<mExists.size()&&mExists[position]!=0);
+    }
+    bool containsAll(int firstJd,
+                     int lastJd) const; // true si firstJd>lastJd
+    int getFirstJd() const {return(mFirstJd);}
+    // Suma de (weight+slope*(jd-referenceJd))*valor(jd) para jd en [firstJd,lastJd],
+    // que deben tener valor (containsAll)
+    double getLinearWeightedSum(int firstJd,
+                                int lastJd,
+                                double weight,
+                                double slope,
+                                int referenceJd) const;
+    double getValue(int jd) const {return(mValues[jd-mFirstJd]);}
+    bool isEmpty() const {return(mValues.isEmpty());}
+    void setValues(const QMap<int,double>& valueByJd);
+private:
+    int mFirstJd;
+    QVector<double> mValues;
+    QVector<char> mExists;
+    QVector<double> mPrefixSums; // mPrefixSums[i]: suma de mValues[0..i-1]
+    QVector<double> mIndexWeightedPrefixSums; // suma de k*mValues[k] para k<i
+    QVector<int> mPrefixCounts; // dias con valor antes de i
+};
+}
+#endif // DAILYVALUESERIES_H
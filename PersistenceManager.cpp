@@ -2,9 +2,12 @@
 #include <QDir>
 #include <QDate>
 #include <QDateTime>
+#include <QUuid>
+#include <QCoreApplication>
 
 #include "Algorithms.h"
 #include "PersistenceManager.h"
+#include "SceneLandsat8.h"
 #include "NestedGridTools.h"
 #include "CRSTools.h"
 #include "remotesensing_definitions.h"
@@ -32,6 +35,179 @@ PersistenceManager::PersistenceManager(QObject *parent) :
     mFinalDateByZone.clear();
     mOutputSridByZone.clear();
     mIdByZone.clear();
+    mPtrJobHeartbeatTimer=NULL;
+    mCurrentJobId=-1;
+    mCurrentJobLeaseSeconds=PERSISTENCEMANAGER_JOBS_LEASE_SECONDS;
+    mCurrentJobLeaseLost=false;
+}
+
+bool PersistenceManager::claimAlgorithmJob(QString workerId,
+                                           int leaseSeconds,
+                                           int maxAttempts,
+                                           bool &claimed,
+                                           QMap<QString, QString> &jobValues,
+                                           QString &strError)
+{
+    claimed=false;
+    jobValues.clear();
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::claimAlgorithmJob");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString jobsTableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+    QString fieldId=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID;
+    QString fieldStatus=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS;
+    QString fieldWorkerId=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_WORKER_ID;
+    QString fieldLeaseToken=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN;
+    QString fieldLeaseExpiration=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_EXPIRATION;
+    QString fieldAttempts=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS;
+    QString fieldError=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ERROR;
+    QString statusPending=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_PENDING;
+    QString statusRunning=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_RUNNING;
+    QString statusFailed=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_FAILED;
+    QString strNow="CAST(strftime('%s','now') AS INTEGER)";
+    QString leaseToken=QUuid::createUuid().toString();
+    QString strAuxError;
+    QVector<QString> sqlSentences;
+    // Los trabajos de procesos caidos (concesion vencida) vuelven a la cola
+    {
+        QString sqlSentence="UPDATE "+jobsTableName+" SET ";
+        sqlSentence+=(fieldStatus+"=CASE WHEN "+fieldAttempts+">="+QString::number(maxAttempts));
+        sqlSentence+=(" THEN '"+statusFailed+"' ELSE '"+statusPending+"' END");
+        sqlSentence+=(","+fieldError+"=CASE WHEN "+fieldAttempts+">="+QString::number(maxAttempts));
+        sqlSentence+=(" THEN 'Lease expired' ELSE "+fieldError+" END");
+        sqlSentence+=(","+fieldWorkerId+"=NULL,"+fieldLeaseToken+"=NULL,"+fieldLeaseExpiration+"=NULL");
+        sqlSentence+=(" WHERE "+fieldStatus+"='"+statusRunning+"'");
+        sqlSentence+=(" AND "+fieldLeaseExpiration+"<"+strNow);
+        sqlSentences.push_back(sqlSentence);
+    }
+    // Reclamo atomico: una unica sentencia UPDATE toma el bloqueo de escritura de SQLite
+    {
+        QString sqlSentence="UPDATE "+jobsTableName+" SET ";
+        sqlSentence+=(fieldStatus+"='"+statusRunning+"'");
+        sqlSentence+=(","+fieldWorkerId+"='"+QString(workerId).replace("'","''")+"'");
+        sqlSentence+=(","+fieldLeaseToken+"='"+leaseToken+"'");
+        sqlSentence+=(","+fieldLeaseExpiration+"="+strNow+"+"+QString::number(leaseSeconds));
+        sqlSentence+=(","+fieldAttempts+"="+fieldAttempts+"+1");
+        sqlSentence+=(" WHERE "+fieldId+"=(SELECT "+fieldId+" FROM "+jobsTableName);
+        sqlSentence+=(" WHERE "+fieldStatus+"='"+statusPending+"' ORDER BY "+fieldId+" LIMIT 1)");
+        sqlSentences.push_back(sqlSentence);
+    }
+    for(int ns=0;ns<sqlSentences.size();ns++)
+    {
+        QString sqlSentence=sqlSentences.at(ns);
+        QVector<QString> fieldsNamesToRetrieve;
+        QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+        if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                    fieldsNamesToRetrieve,
+                                    fieldsValuesToRetrieve,
+                                    strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::claimAlgorithmJob");
+            strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    QVector<QString> fieldsNamesToRetrieve;
+    fieldsNamesToRetrieve.push_back(fieldId);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_BAND_ID);
+    fieldsNamesToRetrieve.push_back(fieldAttempts);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MERGE_FILES);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROCESS_FILES);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROJECT_FILES);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MAIN_SCENE_JD);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_IMAGE_ID);
+    fieldsNamesToRetrieve.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_RASTER_ID);
+    QString sqlSentence="SELECT ";
+    for(int nf=0;nf<fieldsNamesToRetrieve.size();nf++)
+    {
+        if(nf>0)
+        {
+            sqlSentence+=",";
+        }
+        sqlSentence+=fieldsNamesToRetrieve.at(nf);
+    }
+    sqlSentence+=(" FROM "+jobsTableName);
+    sqlSentence+=(" WHERE "+fieldLeaseToken+"='"+leaseToken+"'");
+    sqlSentence+=(" AND "+fieldStatus+"='"+statusRunning+"'");
+    QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+    if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                fieldsNamesToRetrieve,
+                                fieldsValuesToRetrieve,
+                                strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::claimAlgorithmJob");
+        strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(fieldsValuesToRetrieve.size()==0)
+    {
+        return(true);
+    }
+    jobValues=fieldsValuesToRetrieve[0];
+    jobValues[fieldLeaseToken]=leaseToken;
+    claimed=true;
+    return(true);
+}
+
+bool PersistenceManager::completeAlgorithmJob(int jobId,
+                                              QString leaseToken,
+                                              bool success,
+                                              QString jobError,
+                                              int maxAttempts,
+                                              QString &strError)
+{
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::completeAlgorithmJob");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString fieldStatus=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS;
+    QString fieldAttempts=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS;
+    QString fieldError=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ERROR;
+    QString fieldLeaseToken=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN;
+    QString sqlSentence="UPDATE ";
+    sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+    sqlSentence+=" SET ";
+    if(success)
+    {
+        sqlSentence+=(fieldStatus+"='"+PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_DONE+"'");
+        sqlSentence+=(","+fieldError+"=NULL");
+    }
+    else
+    {
+        // Si quedan intentos vuelve a la cola
+        sqlSentence+=(fieldStatus+"=CASE WHEN "+fieldAttempts+">="+QString::number(maxAttempts));
+        sqlSentence+=(" THEN '"+QString(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_FAILED)+"'");
+        sqlSentence+=(" ELSE '"+QString(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_PENDING)+"' END");
+        sqlSentence+=(","+fieldError+"='"+QString(jobError).replace("'","''")+"'");
+    }
+    sqlSentence+=(","+fieldLeaseToken+"=NULL");
+    sqlSentence+=(","+QString(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_EXPIRATION)+"=NULL");
+    sqlSentence+=(" WHERE "+QString(PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID)+"="+QString::number(jobId));
+    sqlSentence+=(" AND "+fieldLeaseToken+"='"+leaseToken+"'");
+    QString strAuxError;
+    QVector<QString> fieldsNamesToRetrieve;
+    QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+    if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                fieldsNamesToRetrieve,
+                                fieldsValuesToRetrieve,
+                                strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::completeAlgorithmJob");
+        strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    return(true);
 }
 
 bool PersistenceManager::createDatabase(QString templateDb,
@@ -141,6 +317,283 @@ bool PersistenceManager::createDatabase(QString templateDb,
             return(false);
         }
     }
+    if(!createAuxiliaryTables(strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::createDatabase");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    return(true);
+}
+
+bool PersistenceManager::createAuxiliaryTables(QString &strError)
+{
+    // Tablas que no estan en la base de datos plantilla, se crean si no existen
+    // para que las bases de datos anteriores sigan siendo validas
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::createAuxiliaryTables");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QVector<QString> sqlSentences;
+    // Table: products_fingerprints
+    {
+        QString sqlSentence="CREATE TABLE IF NOT EXISTS ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_TABLE_NAME;
+        sqlSentence+=" (";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ID;
+        sqlSentence+=" INTEGER PRIMARY KEY AUTOINCREMENT, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME;
+        sqlSentence+=" TEXT NOT NULL UNIQUE, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ALGORITHM_CODE;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FINGERPRINT;
+        sqlSentence+=" TEXT NOT NULL);";
+        sqlSentences.push_back(sqlSentence);
+    }
+    // Table: ingestion_fingerprints
+    {
+        QString sqlSentence="CREATE TABLE IF NOT EXISTS ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TABLE_NAME;
+        sqlSentence+=" (";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_ID;
+        sqlSentence+=" INTEGER PRIMARY KEY AUTOINCREMENT, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_FINGERPRINT;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_TUPLEKEYS_FILES;
+        sqlSentence+=" TEXT NOT NULL DEFAULT '', ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_EMPTY_TUPLEKEYS_FILES;
+        sqlSentence+=" TEXT NOT NULL DEFAULT '', UNIQUE(";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID;
+        sqlSentence+=",";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID;
+        sqlSentence+="));";
+        sqlSentences.push_back(sqlSentence);
+    }
+    // Table: algorithm_jobs
+    {
+        QString sqlSentence="CREATE TABLE IF NOT EXISTS ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+        sqlSentence+=" (";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID;
+        sqlSentence+=" INTEGER PRIMARY KEY AUTOINCREMENT, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY;
+        sqlSentence+=" TEXT NOT NULL DEFAULT '', ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_BAND_ID;
+        sqlSentence+=" TEXT NOT NULL DEFAULT '', ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS;
+        sqlSentence+=" TEXT NOT NULL, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_WORKER_ID;
+        sqlSentence+=" TEXT, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN;
+        sqlSentence+=" TEXT, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_EXPIRATION;
+        sqlSentence+=" INTEGER, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS;
+        sqlSentence+=" INTEGER NOT NULL DEFAULT 0, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MERGE_FILES;
+        sqlSentence+=" INTEGER, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROCESS_FILES;
+        sqlSentence+=" INTEGER, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROJECT_FILES;
+        sqlSentence+=" INTEGER, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MAIN_SCENE_JD;
+        sqlSentence+=" INTEGER, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_IMAGE_ID;
+        sqlSentence+=" INTEGER, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_RASTER_ID;
+        sqlSentence+=" TEXT, ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ERROR;
+        sqlSentence+=" TEXT, UNIQUE(";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE;
+        sqlSentence+=",";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE;
+        sqlSentence+=",";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY;
+        sqlSentence+=",";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_BAND_ID;
+        sqlSentence+="));";
+        sqlSentences.push_back(sqlSentence);
+        sqlSentence="CREATE INDEX IF NOT EXISTS ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+        sqlSentence+="_status_idx ON ";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+        sqlSentence+=" (";
+        sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS;
+        sqlSentence+=");";
+        sqlSentences.push_back(sqlSentence);
+    }
+    QString strAuxError;
+    for(int ns=0;ns<sqlSentences.size();ns++)
+    {
+        QString sqlSentence=sqlSentences.at(ns);
+        QVector<QString> fieldsNamesToRetrieve;
+        QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+        if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                    fieldsNamesToRetrieve,
+                                    fieldsValuesToRetrieve,
+                                    strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::createAuxiliaryTables");
+            strError+=QObject::tr("\nIn sql:\n%1\nError:\n%2").arg(sqlSentence).arg(strAuxError);
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool PersistenceManager::enqueueAlgorithmJobs(QString algorithmCode,
+                                              QString zoneCode,
+                                              bool mergeFiles,
+                                              bool reprocessFiles,
+                                              bool reprojectFiles,
+                                              int mainScenceJd,
+                                              int intercalibrationReferenceImageId,
+                                              QString intercalibrationReferenceImageRasterId,
+                                              int &numberOfJobs,
+                                              QString &strError)
+{
+    numberOfJobs=0;
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::enqueueAlgorithmJobs");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString strAuxError;
+    if(!loadZone(zoneCode,strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::enqueueAlgorithmJobs");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    // PIAS y CLOUDREMOVAL se procesan tuplekey a tuplekey.
+    // INTC ajusta la intercalibracion con todos los tuplekeys de la zona: un unico trabajo
+    // Ningun algoritmo separa aun las bandas (CLOUDREMOVAL combina bandas), band_id vacio
+    QVector<QString> tuplekeys;
+    if(algorithmCode.compare(ALGORITHMS_PIAS_CODE,Qt::CaseInsensitive)==0
+            ||algorithmCode.compare(ALGORITHMS_CLOUDREMOVAL_CODE,Qt::CaseInsensitive)==0)
+    {
+        QString tuplekeys_raster_files_table_name=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_RASTER_FILES_TABLE_NAME;
+        QString tuplekeys_table_name=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
+        QString projects_table_name=PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_TABLE_NAME;
+        QString sqlSentence="SELECT DISTINCT ";
+        sqlSentence+=(tuplekeys_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_TUPLEKEY);
+        sqlSentence+=(" FROM "+tuplekeys_raster_files_table_name+","+tuplekeys_table_name+","+projects_table_name);
+        sqlSentence+=(" WHERE "+tuplekeys_raster_files_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_RASTER_FILES_FIELD_TUPLEKEY_ID);
+        sqlSentence+=("="+tuplekeys_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID);
+        sqlSentence+=(" AND intersects("+tuplekeys_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_THE_GEOM);
+        sqlSentence+=(","+projects_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_THE_GEOM+")");
+        sqlSentence+=(" AND "+projects_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_ID+"="+QString::number(mIdByZone[zoneCode]));
+        QVector<QString> fieldsNamesToRetrieve;
+        fieldsNamesToRetrieve.push_back(tuplekeys_table_name+"."+PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_TUPLEKEY);
+        QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+        if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                    fieldsNamesToRetrieve,
+                                    fieldsValuesToRetrieve,
+                                    strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::enqueueAlgorithmJobs");
+            strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        for(int nr=0;nr<fieldsValuesToRetrieve.size();nr++)
+        {
+            tuplekeys.push_back(fieldsValuesToRetrieve[nr][fieldsNamesToRetrieve[0]]);
+        }
+    }
+    else if(algorithmCode.compare(ALGORITHMS_INTC_CODE,Qt::CaseInsensitive)==0)
+    {
+        tuplekeys.push_back("");
+    }
+    else
+    {
+        strError=QObject::tr("PersistenceManager::enqueueAlgorithmJobs");
+        strError+=QObject::tr("\nInvalid algorithm code for jobs queue: %1").arg(algorithmCode);
+        return(false);
+    }
+    QString jobsTableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+    QString fieldAlgorithmCode=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE;
+    QString fieldZoneCode=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE;
+    QString fieldTuplekey=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY;
+    QString fieldBandId=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_BAND_ID;
+    QString fieldStatus=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS;
+    QString fieldAttempts=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS;
+    QString fieldMergeFiles=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MERGE_FILES;
+    QString fieldReprocessFiles=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROCESS_FILES;
+    QString fieldReprojectFiles=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROJECT_FILES;
+    QString fieldMainSceneJd=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MAIN_SCENE_JD;
+    QString fieldIntcReferenceImageId=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_IMAGE_ID;
+    QString fieldIntcReferenceRasterId=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_RASTER_ID;
+    QString fieldError=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ERROR;
+    QString statusPending=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_PENDING;
+    QString statusRunning=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_RUNNING;
+    QString strZoneCode=QString(zoneCode).replace("'","''");
+    QString strIntcReferenceRasterId=QString(intercalibrationReferenceImageRasterId).replace("'","''");
+    QString strOptions=(QString::number(mergeFiles?1:0)+","+QString::number(reprocessFiles?1:0));
+    strOptions+=(","+QString::number(reprojectFiles?1:0)+","+QString::number(mainScenceJd));
+    strOptions+=(","+QString::number(intercalibrationReferenceImageId)+",'"+strIntcReferenceRasterId+"'");
+    QString bandId=""; // todas las bandas
+    for(int nt=0;nt<tuplekeys.size();nt++)
+    {
+        QString tuplekey=tuplekeys.at(nt);
+        QVector<QString> sqlSentences;
+        // Alta si no existe (clave unica por algoritmo, zona, tuplekey y banda)
+        {
+            QString sqlSentence="INSERT OR IGNORE INTO "+jobsTableName+" (";
+            sqlSentence+=(fieldAlgorithmCode+","+fieldZoneCode+","+fieldTuplekey+","+fieldBandId);
+            sqlSentence+=(","+fieldStatus+","+fieldAttempts);
+            sqlSentence+=(","+fieldMergeFiles+","+fieldReprocessFiles+","+fieldReprojectFiles);
+            sqlSentence+=(","+fieldMainSceneJd+","+fieldIntcReferenceImageId+","+fieldIntcReferenceRasterId+")");
+            sqlSentence+=(" VALUES ('"+algorithmCode+"','"+strZoneCode+"','"+tuplekey+"','"+bandId+"'");
+            sqlSentence+=(",'"+statusPending+"',0,"+strOptions+")");
+            sqlSentences.push_back(sqlSentence);
+        }
+        // Si ya existia y no esta en ejecucion se vuelve a encolar con las opciones actuales
+        {
+            QString sqlSentence="UPDATE "+jobsTableName+" SET ";
+            sqlSentence+=(fieldStatus+"='"+statusPending+"',"+fieldAttempts+"=0,"+fieldError+"=NULL");
+            sqlSentence+=(","+fieldMergeFiles+"="+QString::number(mergeFiles?1:0));
+            sqlSentence+=(","+fieldReprocessFiles+"="+QString::number(reprocessFiles?1:0));
+            sqlSentence+=(","+fieldReprojectFiles+"="+QString::number(reprojectFiles?1:0));
+            sqlSentence+=(","+fieldMainSceneJd+"="+QString::number(mainScenceJd));
+            sqlSentence+=(","+fieldIntcReferenceImageId+"="+QString::number(intercalibrationReferenceImageId));
+            sqlSentence+=(","+fieldIntcReferenceRasterId+"='"+strIntcReferenceRasterId+"'");
+            sqlSentence+=(" WHERE "+fieldAlgorithmCode+"='"+algorithmCode+"'");
+            sqlSentence+=(" AND "+fieldZoneCode+"='"+strZoneCode+"'");
+            sqlSentence+=(" AND "+fieldTuplekey+"='"+tuplekey+"'");
+            sqlSentence+=(" AND "+fieldBandId+"='"+bandId+"'");
+            sqlSentence+=(" AND "+fieldStatus+"<>'"+statusRunning+"'");
+            sqlSentences.push_back(sqlSentence);
+        }
+        for(int ns=0;ns<sqlSentences.size();ns++)
+        {
+            QString sqlSentence=sqlSentences.at(ns);
+            QVector<QString> fieldsNamesToRetrieve;
+            QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+            if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                        fieldsNamesToRetrieve,
+                                        fieldsValuesToRetrieve,
+                                        strAuxError))
+            {
+                strError=QObject::tr("PersistenceManager::enqueueAlgorithmJobs");
+                strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
+        }
+        numberOfJobs++;
+    }
     return(true);
 }
 
@@ -762,6 +1215,104 @@ bool PersistenceManager::getIsDatabaseDefined()
     return(success);
 }
 
+bool PersistenceManager::getIngestionFingerprint(QString sceneId,
+                                                 QString bandId,
+                                                 QString &fingerprint,
+                                                 QVector<QString> &tuplekeysFileNames,
+                                                 QVector<QString> &emptyTuplekeysFileNames,
+                                                 QString &strError)
+{
+    fingerprint.clear();
+    tuplekeysFileNames.clear();
+    emptyTuplekeysFileNames.clear();
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::getIngestionFingerprint");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString strAuxError;
+    QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TABLE_NAME;
+    QVector<QString> fieldsNames;
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_FINGERPRINT);
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_TUPLEKEYS_FILES);
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_EMPTY_TUPLEKEYS_FILES);
+    QVector<QVector<QString> > fieldsValues;
+    QVector<QString> whereFieldsNames;
+    whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID);
+    whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID);
+    QVector<QString> whereFieldsValues;
+    whereFieldsValues.push_back(sceneId);
+    whereFieldsValues.push_back(bandId);
+    QVector<QString> whereFieldsTypes;
+    whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID_FIELD_TYPE);
+    whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID_FIELD_TYPE);
+    if(!mPtrDb->select(tableName,fieldsNames,fieldsValues,
+                       whereFieldsNames,whereFieldsValues,whereFieldsTypes,
+                       strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::getIngestionFingerprint");
+        strError+=QObject::tr("\nError recovering fingerprint for scene: %1 and band: %2").arg(sceneId).arg(bandId);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(fieldsValues.size()>0)
+    {
+        fingerprint=fieldsValues[0][0];
+        QStringList strTuplekeysFileNames=fieldsValues[0][1].split(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TUPLEKEYS_FILES_SEPARATOR,
+                                                                   QString::SkipEmptyParts);
+        for(int nf=0;nf<strTuplekeysFileNames.size();nf++)
+        {
+            tuplekeysFileNames.push_back(strTuplekeysFileNames.at(nf));
+        }
+        QStringList strEmptyTuplekeysFileNames=fieldsValues[0][2].split(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TUPLEKEYS_FILES_SEPARATOR,
+                                                                        QString::SkipEmptyParts);
+        for(int nf=0;nf<strEmptyTuplekeysFileNames.size();nf++)
+        {
+            emptyTuplekeysFileNames.push_back(strEmptyTuplekeysFileNames.at(nf));
+        }
+    }
+    return(true);
+}
+
+bool PersistenceManager::getProductFingerprint(QString fileName,
+                                               QString &fingerprint,
+                                               QString &strError)
+{
+    fingerprint.clear();
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::getProductFingerprint");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString strAuxError;
+    QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_TABLE_NAME;
+    QVector<QString> fieldsNames;
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FINGERPRINT);
+    QVector<QVector<QString> > fieldsValues;
+    QVector<QString> whereFieldsNames;
+    whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME);
+    QVector<QString> whereFieldsValues;
+    whereFieldsValues.push_back(fileName);
+    QVector<QString> whereFieldsTypes;
+    whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME_FIELD_TYPE);
+    if(!mPtrDb->select(tableName,fieldsNames,fieldsValues,
+                       whereFieldsNames,whereFieldsValues,whereFieldsTypes,
+                       strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::getProductFingerprint");
+        strError+=QObject::tr("\nError recovering fingerprint for file:\n%1").arg(fileName);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(fieldsValues.size()>0)
+    {
+        fingerprint=fieldsValues[0][0];
+    }
+    return(true);
+}
+
 bool PersistenceManager::getProjectCodes(QVector<QString> &projectCodes,
                                          QString &strError)
 {
@@ -1107,6 +1658,79 @@ bool PersistenceManager::getProjectTuplekeyIntersectionGeomety(int roiId,
     return(true);
 }
 
+bool PersistenceManager::getTuplekeyGeometry(int tuplekeyId,
+                                             OGRGeometry *&ptrGeometry,
+                                             QString &strError)
+{
+    ptrGeometry=NULL;
+    QString sqlSentence="SELECT upper(asText(";
+    sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
+    sqlSentence+=".";
+    sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_THE_GEOM;
+    sqlSentence+="))";
+    sqlSentence+=" FROM ";
+    sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
+    sqlSentence+=" WHERE ";
+    sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
+    sqlSentence+=".";
+    sqlSentence+=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID;
+    sqlSentence+="=";
+    sqlSentence+=QString::number(tuplekeyId);
+    QVector<QString> fieldsNamesToRetrieve;
+    QString wktGeometryFieldName="wktGeometry";
+    fieldsNamesToRetrieve.push_back(wktGeometryFieldName);
+    QVector<QMap<QString, QString> > fieldsValuesToRetrieve;
+    QString strAuxError;
+    if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                fieldsNamesToRetrieve,
+                                fieldsValuesToRetrieve,
+                                strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::getTuplekeyGeometry");
+        strError+=QObject::tr("\nError recovering data for tuplekey id: %1")
+                .arg(QString::number(tuplekeyId));
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(fieldsValuesToRetrieve.size()!=1)
+    {
+        strError=QObject::tr("PersistenceManager::getTuplekeyGeometry");
+        strError+=QObject::tr("\nNot exists tuplekey id: %1")
+                .arg(QString::number(tuplekeyId));
+        return(false);
+    }
+    QString wktGeometry=fieldsValuesToRetrieve[0][wktGeometryFieldName];
+    QByteArray byteArrayWktGeometry = wktGeometry.toUtf8();
+    char *charsWktGeometry = byteArrayWktGeometry.data();
+    if(!wktGeometry.contains("POLYGON"))
+    {
+        strError=QObject::tr("PersistenceManager::getTuplekeyGeometry");
+        strError+=QObject::tr("\nError recovering data for tuplekey id: %1")
+                .arg(QString::number(tuplekeyId));
+        strError+=QObject::tr("\nInvalid wkt geometry\n%1").arg(wktGeometry);
+        return(false);
+    }
+    if(wktGeometry.contains("MULTIPOLYGON"))
+    {
+        ptrGeometry=OGRGeometryFactory::createGeometry(wkbMultiPolygon);
+    }
+    else
+    {
+        ptrGeometry=OGRGeometryFactory::createGeometry(wkbPolygon);
+    }
+    if(OGRERR_NONE!=ptrGeometry->importFromWkt(&charsWktGeometry))
+    {
+        strError=QObject::tr("PersistenceManager::getTuplekeyGeometry");
+        strError+=QObject::tr("\nError recovering data for tuplekey id: %1")
+                .arg(QString::number(tuplekeyId));
+        strError+=QObject::tr("\nError making geometry from WKT: %1").arg(wktGeometry);
+        OGRGeometryFactory::destroyGeometry(ptrGeometry);
+        ptrGeometry=NULL;
+        return(false);
+    }
+    return(true);
+}
+
 bool PersistenceManager::getProjects(QMap<int,int>& initialDateByProjectId,
                                      QMap<int,int>& finalDateByProjectId,
                                      QMap<QString,int>& idByProjectCode,
@@ -1220,6 +1844,70 @@ bool PersistenceManager::getProjects(QMap<int,int>& initialDateByProjectId,
     return(true);
 }
 
+bool PersistenceManager::heartbeatAlgorithmJob(int jobId,
+                                               QString leaseToken,
+                                               int leaseSeconds,
+                                               bool &leaseLost,
+                                               QString &strError)
+{
+    leaseLost=false;
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::heartbeatAlgorithmJob");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString jobsTableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME;
+    QString fieldId=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID;
+    QString fieldStatus=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS;
+    QString fieldLeaseToken=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN;
+    QString fieldLeaseExpiration=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_EXPIRATION;
+    QString statusRunning=PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_RUNNING;
+    QString strWhere=" WHERE "+fieldId+"="+QString::number(jobId);
+    strWhere+=(" AND "+fieldLeaseToken+"='"+leaseToken+"'");
+    strWhere+=(" AND "+fieldStatus+"='"+statusRunning+"'");
+    QString strAuxError;
+    {
+        QString sqlSentence="UPDATE "+jobsTableName+" SET ";
+        sqlSentence+=(fieldLeaseExpiration+"=CAST(strftime('%s','now') AS INTEGER)+"+QString::number(leaseSeconds));
+        sqlSentence+=strWhere;
+        QVector<QString> fieldsNamesToRetrieve;
+        QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+        if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                    fieldsNamesToRetrieve,
+                                    fieldsValuesToRetrieve,
+                                    strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::heartbeatAlgorithmJob");
+            strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    // Si la concesion vencio y otro proceso la ha reclamado el token ya no coincide
+    {
+        QString sqlSentence="SELECT "+fieldId+" FROM "+jobsTableName+strWhere;
+        QVector<QString> fieldsNamesToRetrieve;
+        fieldsNamesToRetrieve.push_back(fieldId);
+        QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+        if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                    fieldsNamesToRetrieve,
+                                    fieldsValuesToRetrieve,
+                                    strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::heartbeatAlgorithmJob");
+            strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        if(fieldsValuesToRetrieve.size()==0)
+        {
+            leaseLost=true;
+        }
+    }
+    return(true);
+}
+
 bool PersistenceManager::initializeAlgorithms(libCRS::CRSTools* ptrCrsTools,
                                               NestedGrid::NestedGridTools* ptrNestedGridTools,
                                               IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor,
@@ -1405,12 +2093,49 @@ bool PersistenceManager::insertIntercalibration(QString sceneId,
     return(true);
 }
 
+bool PersistenceManager::insertLandsat8Scene(QString sceneId,
+                                             int jd,
+                                             QString metadataFileName,
+                                             QString &strError)
+{
+    Landsat8Metadata metadata;
+    QString strAuxError;
+    if(!SceneLandsat8::getMetadata(metadataFileName,metadata,strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::insertLandsat8Scene");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    return(insertLandsat8Scene(sceneId,jd,metadataFileName,metadata,strError));
+}
+
 bool PersistenceManager::insertLandsat8Scene(QString sceneId,
                                              int jd,
                                              QString metadataFileName,
                                              QVector<QString> metadataTags,
                                              QVector<QString> metadataValues,
                                              QString &strError)
+{
+    Landsat8Metadata metadata;
+    for(int nt=0;nt<metadataTags.size()&&nt<metadataValues.size();nt++)
+    {
+        QString strAuxError;
+        if(!metadata.setValue(metadataTags[nt],metadataValues[nt],strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::insertLandsat8Scene");
+            strError+=QObject::tr("\nFor Landsat8 scene: %1").arg(sceneId);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    return(insertLandsat8Scene(sceneId,jd,metadataFileName,metadata,strError));
+}
+
+bool PersistenceManager::insertLandsat8Scene(QString sceneId,
+                                             int jd,
+                                             QString metadataFileName,
+                                             Landsat8Metadata &metadata,
+                                             QString &strError)
 {
     // Table: raster_files
     {
@@ -1676,35 +2401,18 @@ bool PersistenceManager::insertLandsat8Scene(QString sceneId,
 
         tagsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_LANDSAT8_METADATA_FIELD_REF_ADD_B9);
         tagsPrecisions.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_LANDSAT8_METADATA_FIELD_REF_ADD_B9_FIELD_PRECISION);
-        tagsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_LANDSAT8_METADATA_FIELD_REF_ADD_B9_FIELD_TYPE);
-
-        for(int nt=0;nt<tagsNames.size();nt++)
-        {
-            QString tagName=tagsNames[nt];
-            int tagPrecision=tagsPrecisions[nt];
-            QString tagType=tagsTypes[nt];
-            int pos=metadataTags.indexOf(tagName);
-            if(pos==-1)
-            {
-                pos=metadataTags.indexOf(tagName.toLower());
-                if(pos==-1)
-                {
-                    pos=metadataTags.indexOf(tagName.toUpper());
-                }
-            }
-            if(pos==-1)
-            {
-                strError=QObject::tr("PersistenceManager::insertLandsat8Scene");
-                strError+=QObject::tr("\nFor Landsat8 scene: %1 not exists tag: %2").arg(sceneId).arg(tagName);
-                return(false);
-            }
+        tagsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_LANDSAT8_METADATA_FIELD_REF_ADD_B9_FIELD_TYPE);
+
+        for(int nt=0;nt<tagsNames.size();nt++)
+        {
+            QString tagName=tagsNames[nt];
+            int tagPrecision=tagsPrecisions[nt];
+            QString tagType=tagsTypes[nt];
             double dblValue=0.0;
-            bool okToDobule=false;
-            dblValue=metadataValues.at(pos).toDouble(&okToDobule);
-            if(!okToDobule)
+            if(!metadata.getValue(tagName,dblValue,strAuxError))
             {
                 strError=QObject::tr("PersistenceManager::insertLandsat8Scene");
-                strError+=QObject::tr("\nFor Landsat8 scene: %1 for tag: %2 value is not a double: %3").arg(sceneId).arg(tagName).arg(metadataValues.at(pos));
+                strError+=QObject::tr("\nFor Landsat8 scene: %1 not exists tag: %2").arg(sceneId).arg(tagName);
                 return(false);
             }
             fieldsNames.push_back(tagName);
@@ -2217,6 +2925,34 @@ bool PersistenceManager::insertOrthoimage(QString orthoimageId,
     return(true);
 }
 
+bool PersistenceManager::deleteProductFingerprint(QString fileName,
+                                                  QString &strError)
+{
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::deleteProductFingerprint");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString strAuxError;
+    QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_TABLE_NAME;
+    QVector<QString> whereFieldsNames;
+    whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME);
+    QVector<QString> whereFieldsValues;
+    whereFieldsValues.push_back(fileName);
+    QVector<QString> whereFieldsTypes;
+    whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME_FIELD_TYPE);
+    if(!mPtrDb->deleteRegisters(tableName,whereFieldsNames,whereFieldsValues,whereFieldsTypes,strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::deleteProductFingerprint");
+        strError+=QObject::tr("\nError deleting fingerprint of file: %1\n in table: %2")
+                .arg(fileName).arg(tableName);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    return(true);
+}
+
 bool PersistenceManager::deletePiasFile(int piasFileId,
                                         QString &strError)
 {
@@ -2897,134 +3633,352 @@ bool PersistenceManager::insertPiasTuplekeyFile(QString tuplekey,
         fieldsValues.push_back(QString::number(piaValue));
         fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_PIA_VALUE_FIELD_TYPE);
 
-        // foreign_key quadkey_id
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID);
-        fieldsValues.push_back(tuplekey);
-        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID_FIELD_TYPE);
-        foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
-        foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID;
-        foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID_FIELD_TYPE;
-        foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_TUPLEKEY;
-        foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_TUPLEKEY_FIELD_TYPE;
+        // foreign_key quadkey_id
+        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID);
+        fieldsValues.push_back(tuplekey);
+        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID_FIELD_TYPE);
+        foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_TABLE_NAME;
+        foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID;
+        foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID_FIELD_TYPE;
+        foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_TUPLEKEY;
+        foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_TUPLEKEY_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_TUPLEKEY_FIELD_TYPE;
+
+        // foreign_key cm_id
+        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID);
+        fieldsValues.push_back(computationMethod);
+        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID_FIELD_TYPE);
+        foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS;
+        foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_ID;
+        foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_ID_FIELD_TYPE;
+        foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_TYPE;
+        foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_TYPE_FIELD_TYPE;
+
+        if(!mPtrDb->insertRegister(tableName,fieldsNames,fieldsValues,fieldsTypes,
+                                   foreignTablesByFieldName,foreignFieldsNamesByFieldName,
+                                   foreignFieldsTypesByFieldName,foreignFieldsMatchingsNamesByFieldName,
+                                   foreignFieldsMatchingsTypesByFieldName,
+                                   strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    int piasFileId=-1;
+    {
+        QString auxTableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES;
+        QVector<QString> auxFieldsNames;
+        auxFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID);
+        QVector<QVector<QString> > auxFieldsValues;
+        QVector<QString> auxWhereFieldsNames;
+        auxWhereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_FILE_NAME);
+        QVector<QString> auxWhereFieldsValues;
+        auxWhereFieldsValues.push_back(piasFileName);
+        QVector<QString> auxWhereFieldsTypes;
+        auxWhereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_FILE_NAME_FIELD_TYPE);
+        if(!mPtrDb->select(auxTableName,auxFieldsNames,auxFieldsValues,
+                           auxWhereFieldsNames,auxWhereFieldsValues,auxWhereFieldsTypes,
+                           strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
+            strError+=QObject::tr("\nError recovering pias file id for pias file name:\n%1").arg(piasFileName);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        bool validResult=true;
+        if(auxFieldsValues.size()!=1)
+        {
+            validResult=false;
+        }
+        if(validResult)
+        {
+            if(auxFieldsValues[0].size()!=1)
+            {
+                validResult=false;
+            }
+        }
+        if(!validResult)
+        {
+            strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
+            strError+=QObject::tr("\nError recovering pias file id for pias file name:\n%1").arg(piasFileName);
+            strError+=QObject::tr("\nInvalid result");
+            return(false);
+        }
+        piasFileId=auxFieldsValues[0][0].toInt();
+    }
+    if(piasFileId==-1)
+    {
+        strError=QObject::tr("PersistenceManager::insertPiasTuplekeyFile");
+        strError+=QObject::tr("\nError recovering stored pias file in database:\nPias file:%1\nError:\n%2")
+                .arg(piasFileName).arg(strAuxError);
+        return(false);
+    }
+    // inserto los raster_files_by_pias_file
+    {
+        QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES;
+        for(int nrf=0;nrf<rasterFiles.size();nrf++)
+        {
+            QVector<QString> fieldsNames;
+            QVector<QString> fieldsValues;
+            QVector<QString> fieldsTypes;
+            QMap<QString,QString> foreignTablesByFieldName;
+            QMap<QString,QString> foreignFieldsNamesByFieldName;
+            QMap<QString,QString> foreignFieldsTypesByFieldName;
+            QMap<QString,QString> foreignFieldsMatchingsNamesByFieldName;
+            QMap<QString,QString> foreignFieldsMatchingsTypesByFieldName;
+
+            QString rasterFile=rasterFiles.at(nrf);
+            int rasterFileId=rasterFileIdByRasterFile[rasterFile];
+
+            // foreign_key quadkey_id
+            fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID);
+            fieldsValues.push_back(QString::number(rasterFileId));
+            fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID_FIELD_TYPE);
+            foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_TABLE_NAME;
+            foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_FIELD_ID;
+            foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID_FIELD_TYPE;
+            foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_FIELD_ID;
+            foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID_FIELD_TYPE;
+
+            // foreign_key pias_file_id
+            fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID);
+            fieldsValues.push_back(QString::number(piasFileId));
+            fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID_FIELD_TYPE);
+            foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES;
+            foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID;
+            foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID_FIELD_TYPE;
+            foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID;
+            foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID_FIELD_TYPE;
+
+            if(!mPtrDb->insertRegister(tableName,fieldsNames,fieldsValues,fieldsTypes,
+                                       foreignTablesByFieldName,foreignFieldsNamesByFieldName,
+                                       foreignFieldsTypesByFieldName,foreignFieldsMatchingsNamesByFieldName,
+                                       foreignFieldsMatchingsTypesByFieldName,
+                                       strAuxError))
+            {
+                strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
+        }
+    }
+    return(true);
+}
+
+bool PersistenceManager::insertIngestionFingerprint(QString sceneId,
+                                                    QString bandId,
+                                                    QString fingerprint,
+                                                    QVector<QString> &tuplekeysFileNames,
+                                                    QVector<QString> &emptyTuplekeysFileNames,
+                                                    QString &strError)
+{
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::insertIngestionFingerprint");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TABLE_NAME;
+    bool existsRegister=false;
+    QString strAuxError;
+    QVector<QString> auxFieldsNames;
+    QVector<QString> auxFieldsValues;
+    auxFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID);
+    auxFieldsValues.push_back(sceneId);
+    auxFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID);
+    auxFieldsValues.push_back(bandId);
+    if(!mPtrDb->getExistsRegister(tableName,auxFieldsNames,auxFieldsValues,existsRegister,strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::insertIngestionFingerprint");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    QString strTuplekeysFileNames;
+    for(int nf=0;nf<tuplekeysFileNames.size();nf++)
+    {
+        if(nf>0)
+        {
+            strTuplekeysFileNames+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TUPLEKEYS_FILES_SEPARATOR;
+        }
+        strTuplekeysFileNames+=tuplekeysFileNames.at(nf);
+    }
+    QString strEmptyTuplekeysFileNames;
+    for(int nf=0;nf<emptyTuplekeysFileNames.size();nf++)
+    {
+        if(nf>0)
+        {
+            strEmptyTuplekeysFileNames+=PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TUPLEKEYS_FILES_SEPARATOR;
+        }
+        strEmptyTuplekeysFileNames+=emptyTuplekeysFileNames.at(nf);
+    }
+    QVector<QString> fieldsNames;
+    QVector<QString> fieldsValues;
+    QVector<QString> fieldsTypes;
+    QMap<QString,QString> foreignTablesByFieldName;
+    QMap<QString,QString> foreignFieldsNamesByFieldName;
+    QMap<QString,QString> foreignFieldsTypesByFieldName;
+    QMap<QString,QString> foreignFieldsMatchingsNamesByFieldName;
+    QMap<QString,QString> foreignFieldsMatchingsTypesByFieldName;
+
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_FINGERPRINT);
+    fieldsValues.push_back(fingerprint);
+    fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_FINGERPRINT_FIELD_TYPE);
+
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_TUPLEKEYS_FILES);
+    fieldsValues.push_back(strTuplekeysFileNames);
+    fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_TUPLEKEYS_FILES_FIELD_TYPE);
+
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_EMPTY_TUPLEKEYS_FILES);
+    fieldsValues.push_back(strEmptyTuplekeysFileNames);
+    fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_EMPTY_TUPLEKEYS_FILES_FIELD_TYPE);
+
+    if(!existsRegister)
+    {
+        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID);
+        fieldsValues.push_back(sceneId);
+        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID_FIELD_TYPE);
+        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID);
+        fieldsValues.push_back(bandId);
+        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID_FIELD_TYPE);
+        if(!mPtrDb->insertRegister(tableName,fieldsNames,fieldsValues,fieldsTypes,
+                                   foreignTablesByFieldName,foreignFieldsNamesByFieldName,
+                                   foreignFieldsTypesByFieldName,foreignFieldsMatchingsNamesByFieldName,
+                                   foreignFieldsMatchingsTypesByFieldName,
+                                   strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::insertIngestionFingerprint");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    else
+    {
+        QVector<QString> whereFieldsNames;
+        whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID);
+        whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID);
+        QVector<QString> whereFieldsValues;
+        whereFieldsValues.push_back(sceneId);
+        whereFieldsValues.push_back(bandId);
+        QVector<QString> whereFieldsTypes;
+        whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID_FIELD_TYPE);
+        whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID_FIELD_TYPE);
+        QMap<QString,QString> whereForeignTablesByFieldName;
+        QMap<QString,QString> whereForeignFieldsNamesByFieldName;
+        QMap<QString,QString> whereForeignFieldsTypesByFieldName;
+        QMap<QString,QString> whereForeignFieldsMatchingsNamesByFieldName;
+        QMap<QString,QString> whereForeignFieldsMatchingsTypesByFieldName;
+        if(!mPtrDb->updateRegister(tableName,
+                                   fieldsNames,fieldsValues,fieldsTypes,
+                                   foreignTablesByFieldName,
+                                   foreignFieldsNamesByFieldName,
+                                   foreignFieldsTypesByFieldName,
+                                   foreignFieldsMatchingsNamesByFieldName,
+                                   foreignFieldsMatchingsTypesByFieldName,
+                                   whereFieldsNames,whereFieldsValues,whereFieldsTypes,
+                                   whereForeignTablesByFieldName,
+                                   whereForeignFieldsNamesByFieldName,
+                                   whereForeignFieldsTypesByFieldName,
+                                   whereForeignFieldsMatchingsNamesByFieldName,
+                                   whereForeignFieldsMatchingsTypesByFieldName,
+                                   strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::insertIngestionFingerprint");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool PersistenceManager::insertProductFingerprint(QString fileName,
+                                                  QString algorithmCode,
+                                                  QString fingerprint,
+                                                  QString &strError)
+{
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::insertProductFingerprint");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_TABLE_NAME;
+    bool existsRegister=false;
+    QString strAuxError;
+    QVector<QString> auxFieldsNames;
+    QVector<QString> auxFieldsValues;
+    auxFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME);
+    auxFieldsValues.push_back(fileName);
+    if(!mPtrDb->getExistsRegister(tableName,auxFieldsNames,auxFieldsValues,existsRegister,strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::insertProductFingerprint");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    QVector<QString> fieldsNames;
+    QVector<QString> fieldsValues;
+    QVector<QString> fieldsTypes;
+    QMap<QString,QString> foreignTablesByFieldName;
+    QMap<QString,QString> foreignFieldsNamesByFieldName;
+    QMap<QString,QString> foreignFieldsTypesByFieldName;
+    QMap<QString,QString> foreignFieldsMatchingsNamesByFieldName;
+    QMap<QString,QString> foreignFieldsMatchingsTypesByFieldName;
+
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ALGORITHM_CODE);
+    fieldsValues.push_back(algorithmCode);
+    fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ALGORITHM_CODE_FIELD_TYPE);
 
-        // foreign_key cm_id
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID);
-        fieldsValues.push_back(computationMethod);
-        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID_FIELD_TYPE);
-        foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS;
-        foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_ID;
-        foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_ID_FIELD_TYPE;
-        foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_TYPE;
-        foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_COMPUTATION_METHOD_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_COMPUTATION_METHODS_FIELD_TYPE_FIELD_TYPE;
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FINGERPRINT);
+    fieldsValues.push_back(fingerprint);
+    fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FINGERPRINT_FIELD_TYPE);
 
+    if(!existsRegister)
+    {
+        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME);
+        fieldsValues.push_back(fileName);
+        fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME_FIELD_TYPE);
         if(!mPtrDb->insertRegister(tableName,fieldsNames,fieldsValues,fieldsTypes,
                                    foreignTablesByFieldName,foreignFieldsNamesByFieldName,
                                    foreignFieldsTypesByFieldName,foreignFieldsMatchingsNamesByFieldName,
                                    foreignFieldsMatchingsTypesByFieldName,
                                    strAuxError))
         {
-            strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
+            strError=QObject::tr("PersistenceManager::insertProductFingerprint");
             strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
             return(false);
         }
     }
-    int piasFileId=-1;
+    else
     {
-        QString auxTableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES;
-        QVector<QString> auxFieldsNames;
-        auxFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID);
-        QVector<QVector<QString> > auxFieldsValues;
-        QVector<QString> auxWhereFieldsNames;
-        auxWhereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_FILE_NAME);
-        QVector<QString> auxWhereFieldsValues;
-        auxWhereFieldsValues.push_back(piasFileName);
-        QVector<QString> auxWhereFieldsTypes;
-        auxWhereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_FILE_NAME_FIELD_TYPE);
-        if(!mPtrDb->select(auxTableName,auxFieldsNames,auxFieldsValues,
-                           auxWhereFieldsNames,auxWhereFieldsValues,auxWhereFieldsTypes,
-                           strAuxError))
+        QVector<QString> whereFieldsNames;
+        whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME);
+        QVector<QString> whereFieldsValues;
+        whereFieldsValues.push_back(fileName);
+        QVector<QString> whereFieldsTypes;
+        whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME_FIELD_TYPE);
+        QMap<QString,QString> whereForeignTablesByFieldName;
+        QMap<QString,QString> whereForeignFieldsNamesByFieldName;
+        QMap<QString,QString> whereForeignFieldsTypesByFieldName;
+        QMap<QString,QString> whereForeignFieldsMatchingsNamesByFieldName;
+        QMap<QString,QString> whereForeignFieldsMatchingsTypesByFieldName;
+        if(!mPtrDb->updateRegister(tableName,
+                                   fieldsNames,fieldsValues,fieldsTypes,
+                                   foreignTablesByFieldName,
+                                   foreignFieldsNamesByFieldName,
+                                   foreignFieldsTypesByFieldName,
+                                   foreignFieldsMatchingsNamesByFieldName,
+                                   foreignFieldsMatchingsTypesByFieldName,
+                                   whereFieldsNames,whereFieldsValues,whereFieldsTypes,
+                                   whereForeignTablesByFieldName,
+                                   whereForeignFieldsNamesByFieldName,
+                                   whereForeignFieldsTypesByFieldName,
+                                   whereForeignFieldsMatchingsNamesByFieldName,
+                                   whereForeignFieldsMatchingsTypesByFieldName,
+                                   strAuxError))
         {
-            strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
-            strError+=QObject::tr("\nError recovering pias file id for pias file name:\n%1").arg(piasFileName);
+            strError=QObject::tr("PersistenceManager::insertProductFingerprint");
             strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
             return(false);
         }
-        bool validResult=true;
-        if(auxFieldsValues.size()!=1)
-        {
-            validResult=false;
-        }
-        if(validResult)
-        {
-            if(auxFieldsValues[0].size()!=1)
-            {
-                validResult=false;
-            }
-        }
-        if(!validResult)
-        {
-            strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
-            strError+=QObject::tr("\nError recovering pias file id for pias file name:\n%1").arg(piasFileName);
-            strError+=QObject::tr("\nInvalid result");
-            return(false);
-        }
-        piasFileId=auxFieldsValues[0][0].toInt();
-    }
-    if(piasFileId==-1)
-    {
-        strError=QObject::tr("PersistenceManager::insertPiasTuplekeyFile");
-        strError+=QObject::tr("\nError recovering stored pias file in database:\nPias file:%1\nError:\n%2")
-                .arg(piasFileName).arg(strAuxError);
-        return(false);
-    }
-    // inserto los raster_files_by_pias_file
-    {
-        QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES;
-        for(int nrf=0;nrf<rasterFiles.size();nrf++)
-        {
-            QVector<QString> fieldsNames;
-            QVector<QString> fieldsValues;
-            QVector<QString> fieldsTypes;
-            QMap<QString,QString> foreignTablesByFieldName;
-            QMap<QString,QString> foreignFieldsNamesByFieldName;
-            QMap<QString,QString> foreignFieldsTypesByFieldName;
-            QMap<QString,QString> foreignFieldsMatchingsNamesByFieldName;
-            QMap<QString,QString> foreignFieldsMatchingsTypesByFieldName;
-
-            QString rasterFile=rasterFiles.at(nrf);
-            int rasterFileId=rasterFileIdByRasterFile[rasterFile];
-
-            // foreign_key quadkey_id
-            fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID);
-            fieldsValues.push_back(QString::number(rasterFileId));
-            fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID_FIELD_TYPE);
-            foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_TABLE_NAME;
-            foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_FIELD_ID;
-            foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID_FIELD_TYPE;
-            foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_FIELD_ID;
-            foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_RASTER_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_TUPLEKEYS_FIELD_ID_FIELD_TYPE;
-
-            // foreign_key pias_file_id
-            fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID);
-            fieldsValues.push_back(QString::number(piasFileId));
-            fieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID_FIELD_TYPE);
-            foreignTablesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES;
-            foreignFieldsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID;
-            foreignFieldsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID_FIELD_TYPE;
-            foreignFieldsMatchingsNamesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID;
-            foreignFieldsMatchingsTypesByFieldName[PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_FILES_BY_PIAS_FILES_FIELD_PIAS_FILE_ID]=PERSISTENCEMANAGER_SPATIALITE_TABLE_PIAS_FILES_FIELD_ID_FIELD_TYPE;
-
-            if(!mPtrDb->insertRegister(tableName,fieldsNames,fieldsValues,fieldsTypes,
-                                       foreignTablesByFieldName,foreignFieldsNamesByFieldName,
-                                       foreignFieldsTypesByFieldName,foreignFieldsMatchingsNamesByFieldName,
-                                       foreignFieldsMatchingsTypesByFieldName,
-                                       strAuxError))
-            {
-                strError=QObject::tr("PersistenceManager::insertPiasQuadkeyFile");
-                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
-                return(false);
-            }
-        }
     }
     return(true);
 }
@@ -3468,6 +4422,53 @@ bool PersistenceManager::insertRSProduct(QString rsProductId,
     return(true);
 }
 
+bool PersistenceManager::loadZone(QString zoneCode,
+                                  QString &strError)
+{
+    if(mZonesCodes.contains(zoneCode))
+    {
+        return(true);
+    }
+    QString strAuxError;
+    //select id,results_path,initial_date,final_date,output_srid from projects where code="zone1"
+    QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_TABLE_NAME;
+    QVector<QString> fieldsNames;
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_ID);
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_RESULTS_PATH);
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_INITIAL_DATE);
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_FINAL_DATE);
+    fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_OUTPUT_SRID);
+    QVector<QVector<QString> > fieldsValues;
+    QVector<QString> whereFieldsNames;
+    whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_CODE);
+    QVector<QString> whereFieldsValues;
+    whereFieldsValues.push_back(zoneCode);
+    QVector<QString> whereFieldsTypes;
+    whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_CODE_FIELD_TYPE);
+    if(!mPtrDb->select(tableName,fieldsNames,fieldsValues,
+                       whereFieldsNames,whereFieldsValues,whereFieldsTypes,
+                       strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::loadZone");
+        strError+=QObject::tr("\nError recovering zone information:\n%1").arg(zoneCode);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(fieldsValues.size()==0)
+    {
+        strError=QObject::tr("PersistenceManager::loadZone");
+        strError+=QObject::tr("\nNot exists zone:\n%1").arg(zoneCode);
+        return(false);
+    }
+    mZonesCodes.push_back(zoneCode);
+    mIdByZone[zoneCode]=fieldsValues[0][0].toInt();
+    mResultsPathByZone[zoneCode]=fieldsValues[0][1];
+    mInitialDateByZone[zoneCode]=fieldsValues[0][2].toInt();
+    mFinalDateByZone[zoneCode]=fieldsValues[0][3].toInt();
+    mOutputSridByZone[zoneCode]=fieldsValues[0][4].toInt();
+    return(true);
+}
+
 bool PersistenceManager::openDatabase(QString fileName,
                                       QString &strError)
 {
@@ -3528,6 +4529,12 @@ bool PersistenceManager::openDatabase(QString fileName,
         strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
         return(false);
     }
+    if(!createAuxiliaryTables(strAuxError))
+    {
+        strError=QObject::tr("PersistenceManager::openDatabase");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
     return(true);
 }
 
@@ -3539,7 +4546,9 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
                                           int mainScenceJd,
                                           int intercalibrationReferenceImageId,
                                           QString intercalibrationReferenceImageRasterId,
-                                          QString &strError)
+                                          QString &strError,
+                                          QVector<QString> tuplekeysToProcess,
+                                          QString resultsFileNameSuffix)
 {
     if(mPtrDb==NULL)
     {
@@ -3554,38 +4563,11 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
         return(false);
     }
     QString strAuxError;
-    if(!mZonesCodes.contains(zoneCode))
+    if(!loadZone(zoneCode,strAuxError))
     {
-        //select id,results_path,initial_date,final_date,output_srid from projects where code="zone1"
-        QString tableName=PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_TABLE_NAME;
-        QVector<QString> fieldsNames;
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_ID);
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_RESULTS_PATH);
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_INITIAL_DATE);
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_FINAL_DATE);
-        fieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_OUTPUT_SRID);
-        QVector<QVector<QString> > fieldsValues;
-        QVector<QString> whereFieldsNames;
-        whereFieldsNames.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_CODE);
-        QVector<QString> whereFieldsValues;
-        whereFieldsValues.push_back(zoneCode);
-        QVector<QString> whereFieldsTypes;
-        whereFieldsTypes.push_back(PERSISTENCEMANAGER_SPATIALITE_TABLE_PROJECTS_FIELD_CODE_FIELD_TYPE);
-        if(!mPtrDb->select(tableName,fieldsNames,fieldsValues,
-                           whereFieldsNames,whereFieldsValues,whereFieldsTypes,
-                           strAuxError))
-        {
-            strError=QObject::tr("PersistenceManager::processAlgorithm");
-            strError+=QObject::tr("\nError recovering zone information:\n%1").arg(zoneCode);
-            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
-            return(false);
-        }
-        mZonesCodes.push_back(zoneCode);
-        mIdByZone[zoneCode]=fieldsValues[0][0].toInt();
-        mResultsPathByZone[zoneCode]=fieldsValues[0][1];
-        mInitialDateByZone[zoneCode]=fieldsValues[0][2].toInt();
-        mFinalDateByZone[zoneCode]=fieldsValues[0][3].toInt();
-        mOutputSridByZone[zoneCode]=fieldsValues[0][4].toInt();
+        strError=QObject::tr("PersistenceManager::processAlgorithm");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
     }
     QString landsat8IdDb=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_TYPES_LANDSAT8;
     QString sentinel2IdDb=PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_TYPES_SENTINEL2;
@@ -3776,6 +4758,13 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
                 QString rasterType=fieldsValuesToRetrieve[nr][fieldsNamesToRetrieve[3]];
                 QString bandId=fieldsValuesToRetrieve[nr][fieldsNamesToRetrieve[4]];
                 QString quadkey=fieldsValuesToRetrieve[nr][fieldsNamesToRetrieve[5]];
+                // INTC necesita todos los tuplekeys de la zona para el ajuste
+                if(tuplekeysToProcess.size()>0
+                        &&algorithmCode.compare(ALGORITHMS_INTC_CODE,Qt::CaseInsensitive)!=0
+                        &&tuplekeysToProcess.indexOf(quadkey)==-1)
+                {
+                    continue;
+                }
                 if(rasterType.compare(PERSISTENCEMANAGER_SPATIALITE_TABLE_RASTER_TYPES_LANDSAT8)==0
                         &&bandsInAlgorithmBySpaceCraft[REMOTESENSING_LANDSAT8_USGS_SPACECRAFT_ID].indexOf(bandId)==-1)
                 {
@@ -4054,7 +5043,7 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
         QString strDate=QDateTime::currentDateTime().toString(ALGORITHMS_DATE_TIME_FILE_NAME_STRING_FORMAT);
         QString algorithmResultsFileName=mResultsPathByZone[zoneCode]+"/"+zoneCode;
 //        algorithmResultsFileName+="_"+algorithmCode+"_"+strDate+"."+algorithmResultsFileExtension;
-        algorithmResultsFileName+="_"+algorithmCode+"."+algorithmResultsFileExtension;
+        algorithmResultsFileName+="_"+algorithmCode+resultsFileNameSuffix+"."+algorithmResultsFileExtension;
         QFile file(algorithmResultsFileName);
         if (!file.open(QFile::WriteOnly |QFile::Text))
         {
@@ -4199,7 +5188,7 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
         QString algorithmResultsFileExtension=ALGORITHMS_RESULTS_FILE_EXTENSION;
         QString strDate=QDateTime::currentDateTime().toString(ALGORITHMS_DATE_TIME_FILE_NAME_STRING_FORMAT);
         QString algorithmResultsFileName=mResultsPathByZone[zoneCode]+"/"+zoneCode;
-        algorithmResultsFileName+="_"+algorithmCode+"_"+strDate+"."+algorithmResultsFileExtension;
+        algorithmResultsFileName+="_"+algorithmCode+"_"+strDate+resultsFileNameSuffix+"."+algorithmResultsFileExtension;
         QFile file(algorithmResultsFileName);
         if (!file.open(QFile::WriteOnly |QFile::Text))
         {
@@ -4264,7 +5253,7 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
         QString algorithmResultsFileExtension=ALGORITHMS_RESULTS_FILE_EXTENSION;
         QString strDate=QDateTime::currentDateTime().toString(ALGORITHMS_DATE_TIME_FILE_NAME_STRING_FORMAT);
         QString algorithmResultsFileName=mResultsPathByZone[zoneCode]+"/"+zoneCode;
-        algorithmResultsFileName+="_"+algorithmCode+"_"+strDate+"."+algorithmResultsFileExtension;
+        algorithmResultsFileName+="_"+algorithmCode+"_"+strDate+resultsFileNameSuffix+"."+algorithmResultsFileExtension;
         QFile file(algorithmResultsFileName);
         if (!file.open(QFile::WriteOnly |QFile::Text))
         {
@@ -4303,6 +5292,128 @@ bool PersistenceManager::processAlgorithm(QString algorithmCode,
     return(true);
 }
 
+bool PersistenceManager::processAlgorithmJobs(QString workerId,
+                                              int &processedJobs,
+                                              int &failedJobs,
+                                              QString &strError,
+                                              int leaseSeconds,
+                                              int maxAttempts)
+{
+    processedJobs=0;
+    failedJobs=0;
+    if(mPtrDb==NULL)
+    {
+        strError=QObject::tr("PersistenceManager::processAlgorithmJobs");
+        strError+=QObject::tr("\nPointer to database is null");
+        return(false);
+    }
+    if(workerId.isEmpty())
+    {
+        workerId=QString::number(QCoreApplication::applicationPid())+"_"+QUuid::createUuid().toString();
+    }
+    QString strAuxError;
+    // Varios procesos comparten la base de datos: esperar al bloqueo en lugar de fallar
+    {
+        QString sqlSentence="PRAGMA busy_timeout="+QString::number(PERSISTENCEMANAGER_JOBS_BUSY_TIMEOUT_MILLISECONDS);
+        QVector<QString> fieldsNamesToRetrieve;
+        QVector<QMap<QString,QString> > fieldsValuesToRetrieve;
+        if(!mPtrDb->executeSqlQuery(sqlSentence,
+                                    fieldsNamesToRetrieve,
+                                    fieldsValuesToRetrieve,
+                                    strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::processAlgorithmJobs");
+            strError+=QObject::tr("\nError executing sql sentence:\n%1").arg(sqlSentence);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    // El latido se emite desde el bucle de eventos, que los algoritmos atienden con processEvents
+    if(mPtrJobHeartbeatTimer==NULL)
+    {
+        mPtrJobHeartbeatTimer=new QTimer(this);
+        QObject::connect(mPtrJobHeartbeatTimer, SIGNAL(timeout()),this,SLOT(onAlgorithmJobHeartbeat()));
+    }
+    int heartbeatMilliseconds=leaseSeconds*1000/3;
+    if(heartbeatMilliseconds<1000)
+    {
+        heartbeatMilliseconds=1000;
+    }
+    while(true)
+    {
+        bool claimed=false;
+        QMap<QString,QString> jobValues;
+        if(!claimAlgorithmJob(workerId,leaseSeconds,maxAttempts,claimed,jobValues,strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::processAlgorithmJobs");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        if(!claimed)
+        {
+            break;
+        }
+        int jobId=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID].toInt();
+        QString leaseToken=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN];
+        QString algorithmCode=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE];
+        QString zoneCode=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE];
+        QString tuplekey=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY];
+        bool mergeFiles=(jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MERGE_FILES].toInt()==1);
+        bool reprocessFiles=(jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROCESS_FILES].toInt()==1);
+        bool reprojectFiles=(jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROJECT_FILES].toInt()==1);
+        int mainScenceJd=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MAIN_SCENE_JD].toInt();
+        int intercalibrationReferenceImageId=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_IMAGE_ID].toInt();
+        QString intercalibrationReferenceImageRasterId=jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_RASTER_ID];
+        QVector<QString> tuplekeysToProcess;
+        // Cada ejecucion de un trabajo escribe su propio fichero de resultados: los trabajos
+        // de una zona corren a la vez en varios procesos
+        QString resultsFileNameSuffix="_"+QString(PERSISTENCEMANAGER_JOBS_RESULTS_FILE_TAG);
+        resultsFileNameSuffix+=QString::number(jobId);
+        resultsFileNameSuffix+="_"+jobValues[PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS];
+        if(!tuplekey.isEmpty())
+        {
+            tuplekeysToProcess.push_back(tuplekey);
+            resultsFileNameSuffix+="_"+tuplekey;
+        }
+        mCurrentJobId=jobId;
+        mCurrentJobLeaseToken=leaseToken;
+        mCurrentJobLeaseSeconds=leaseSeconds;
+        mCurrentJobLeaseLost=false;
+        mPtrJobHeartbeatTimer->start(heartbeatMilliseconds);
+        QString strJobError;
+        bool success=processAlgorithm(algorithmCode,
+                                      zoneCode,
+                                      mergeFiles,
+                                      reprocessFiles,
+                                      reprojectFiles,
+                                      mainScenceJd,
+                                      intercalibrationReferenceImageId,
+                                      intercalibrationReferenceImageRasterId,
+                                      strJobError,
+                                      tuplekeysToProcess,
+                                      resultsFileNameSuffix);
+        mPtrJobHeartbeatTimer->stop();
+        mCurrentJobId=-1;
+        mCurrentJobLeaseToken.clear();
+        if(mCurrentJobLeaseLost) // otro proceso lo ha recuperado, el resultado es suyo
+        {
+            continue;
+        }
+        if(!completeAlgorithmJob(jobId,leaseToken,success,strJobError,maxAttempts,strAuxError))
+        {
+            strError=QObject::tr("PersistenceManager::processAlgorithmJobs");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        processedJobs++;
+        if(!success)
+        {
+            failedJobs++;
+        }
+    }
+    return(true);
+}
+
 bool PersistenceManager::updateDatabase(QString sqlFileName,
                                         QString &strError)
 {
@@ -4322,3 +5433,24 @@ bool PersistenceManager::updateDatabase(QString sqlFileName,
     }
     return(true);
 }
+
+void PersistenceManager::onAlgorithmJobHeartbeat()
+{
+    if(mCurrentJobId<0)
+    {
+        return;
+    }
+    bool leaseLost=false;
+    QString strAuxError;
+    if(!heartbeatAlgorithmJob(mCurrentJobId,mCurrentJobLeaseToken,mCurrentJobLeaseSeconds,
+                              leaseLost,strAuxError))
+    {
+        // Se reintenta en el siguiente latido, la concesion aun no ha vencido
+        return;
+    }
+    if(leaseLost)
+    {
+        mCurrentJobLeaseLost=true;
+        mPtrJobHeartbeatTimer->stop();
+    }
+}
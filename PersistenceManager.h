@@ -4,12 +4,18 @@
 #define PERSISTENCEMANAGER_CRS_PRECISION                -1 // cuando sea -1 lo calculo
 #define PERSISTENCEMANAGER_CRS_PROJECTED_PRECISION      3 // cuando sea -1 lo calculo
 
+#define PERSISTENCEMANAGER_JOBS_LEASE_SECONDS               600
+#define PERSISTENCEMANAGER_JOBS_MAX_ATTEMPTS                3
+#define PERSISTENCEMANAGER_JOBS_BUSY_TIMEOUT_MILLISECONDS   30000
+#define PERSISTENCEMANAGER_JOBS_RESULTS_FILE_TAG            "JOB"
+
 //#include "spatialite.h"
 #include "../libIGDAL/SpatiaLite.h"
 #include "persistencemanager_definitions.h"
 
 #include <QObject>
 #include <QMap>
+#include <QTimer>
 
 #include "libremotesensing_global.h"
 
@@ -28,11 +34,24 @@ namespace NestedGrid{
 
 namespace RemoteSensing{
 class Algorithms;
+struct Landsat8Metadata;
 class LIBREMOTESENSINGSHARED_EXPORT PersistenceManager : public QObject
 {
     Q_OBJECT
 public:
     explicit PersistenceManager(QObject *parent = 0);
+    bool claimAlgorithmJob(QString workerId,
+                           int leaseSeconds,
+                           int maxAttempts,
+                           bool& claimed,
+                           QMap<QString,QString>& jobValues,
+                           QString& strError);
+    bool completeAlgorithmJob(int jobId,
+                              QString leaseToken,
+                              bool success,
+                              QString jobError,
+                              int maxAttempts,
+                              QString& strError);
     bool createDatabase(QString templateDb,
                         QString fileName,
                         QString proj4Text,
@@ -41,6 +60,16 @@ public:
                         int& srid,
                         QString& strError,
                         QString sqlCreateFileName="");
+    bool enqueueAlgorithmJobs(QString algorithmCode,
+                              QString zoneCode,
+                              bool mergeFiles,
+                              bool reprocessFiles,
+                              bool reprojectFiles,
+                              int mainScenceJd,
+                              int intercalibrationReferenceImageId,
+                              QString intercalibrationReferenceImageRasterId,
+                              int& numberOfJobs,
+                              QString& strError);
     bool executeSql(QString sqlSentence,
                     QVector<QString> fieldsNamesToRetrieve,
                     QVector<QMap<QString,QString> > &fieldsValuesToRetrieve,
@@ -71,6 +100,15 @@ public:
                      int& srid,
                      QString& strError);
     bool getIsDatabaseDefined();
+    bool getIngestionFingerprint(QString sceneId,
+                                 QString bandId,
+                                 QString& fingerprint,
+                                 QVector<QString>& tuplekeysFileNames, // esperados
+                                 QVector<QString>& emptyTuplekeysFileNames, // esperados sin pixeles validos, no creados
+                                 QString& strError);
+    bool getProductFingerprint(QString fileName,
+                               QString& fingerprint,
+                               QString& strError);
     bool getProjects(QMap<int,int>& initialDateByProjectId,
                      QMap<int,int>& finalDateByProjectId,
                      QMap<QString,int>& idByProjectCode,
@@ -92,9 +130,17 @@ public:
                                                int tuplekeyId,
                                                OGRGeometry*& ptrGeometry,
                                                QString& strError);
+    bool getTuplekeyGeometry(int tuplekeyId,
+                             OGRGeometry*& ptrGeometry,
+                             QString& strError);
     QString getCrsDescription(){return(mCrsDescription);};
     QString getGeographicCrsBaseProj4Text(){return(mGeographicCrsBaseProj4Text);};
     QString getNestedGridLocalParameters(){return(mNestedGridLocalParameters);};
+    bool heartbeatAlgorithmJob(int jobId,
+                               QString leaseToken,
+                               int leaseSeconds,
+                               bool& leaseLost,
+                               QString& strError);
     bool initializeAlgorithms(libCRS::CRSTools* ptrCrsTools,
                               NestedGrid::NestedGridTools* ptrNestedGridTools,
                               IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor,
@@ -109,12 +155,21 @@ public:
                                 bool toReflectance,
                                 bool interpolated,
                                 QString& strError);
+    bool insertLandsat8Scene(QString sceneId,
+                             int jd,
+                             QString metadataFileName,
+                             QString& strError);
     bool insertLandsat8Scene(QString sceneId,
                              int jd,
                              QString metadataFileName,
                              QVector<QString> metadataTags,
                              QVector<QString> metadataValues,
                              QString& strError);
+    bool insertLandsat8Scene(QString sceneId,
+                             int jd,
+                             QString metadataFileName,
+                             Landsat8Metadata& metadata,
+                             QString& strError);
     bool insertNdviTuplekeyFile(QString tuplekey,
                                 QString rasterFile,
                                 QString computationMethod,
@@ -126,6 +181,8 @@ public:
     bool insertOrthoimage(QString orthoimageId,
                           int jd,
                           QString& strError);
+    bool deleteProductFingerprint(QString fileName,
+                                  QString& strError);
     bool deletePiasFile(int piasFileId,
                         QString& strError);
     bool getExistsPiasTuplekeyFile(QString tuplekey,
@@ -143,6 +200,16 @@ public:
                                 QString piasFileName,
                                 bool reprocessFiles,
                                 QString& strError);
+    bool insertIngestionFingerprint(QString sceneId,
+                                    QString bandId,
+                                    QString fingerprint,
+                                    QVector<QString>& tuplekeysFileNames,
+                                    QVector<QString>& emptyTuplekeysFileNames,
+                                    QString& strError);
+    bool insertProductFingerprint(QString fileName,
+                                  QString algorithmCode,
+                                  QString fingerprint,
+                                  QString& strError);
     bool insertProject(QString code,
                        QString resultsPath,
                        int initialJd,
@@ -183,16 +250,30 @@ public:
                           int mainScenceJd,
                           int intercalibrationReferenceImageId,
                           QString intercalibrationReferenceImageRasterId,
-                          QString& strError);
+                          QString& strError,
+                          QVector<QString> tuplekeysToProcess=QVector<QString>(), // vacio: todos
+                          QString resultsFileNameSuffix=QString()); // trabajos: fichero de resultados propio
+    bool processAlgorithmJobs(QString workerId,
+                              int& processedJobs,
+                              int& failedJobs,
+                              QString& strError,
+                              int leaseSeconds=PERSISTENCEMANAGER_JOBS_LEASE_SECONDS,
+                              int maxAttempts=PERSISTENCEMANAGER_JOBS_MAX_ATTEMPTS);
     bool updateDatabase(QString sqlFileName,
                         QString& strError);
 private:
+    bool createAuxiliaryTables(QString& strError);
+    bool loadZone(QString zoneCode,
+                  QString& strError);
 
 signals:
     void operationFinished();
 
 public slots:
 
+private slots:
+    void onAlgorithmJobHeartbeat();
+
 private:
     IGDAL::SpatiaLite* mPtrDb;
     int mSRID;
@@ -211,6 +292,11 @@ private:
     QMap<QString,int> mOutputSridByZone;
     QMap<QString,double> mRUCGains;
     QMap<QString,double> mRUCOffsets;
+    QTimer* mPtrJobHeartbeatTimer;
+    int mCurrentJobId;
+    QString mCurrentJobLeaseToken;
+    int mCurrentJobLeaseSeconds;
+    bool mCurrentJobLeaseLost;
 };
 }
 #endif // PERSISTENCEMANAGER_H
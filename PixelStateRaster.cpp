@@ -0,0 +1,281 @@
+#include <QFile>
+#include <QObject>
+
+#include <gdal.h>
+#include <cpl_string.h>
+#include <math.h>
+
+#include "PixelStateRaster.h"
+#include "remotesensing_definitions.h"
+
+using namespace RemoteSensing;
+
+PixelStateRaster::PixelStateRaster()
+{
+    mPtrDataset=NULL;
+    clear();
+}
+
+PixelStateRaster::~PixelStateRaster()
+{
+    clear();
+}
+
+void PixelStateRaster::clear()
+{
+    if(mPtrDataset!=NULL)
+    {
+        GDALClose(mPtrDataset);
+        mPtrDataset=NULL;
+        if(mIsCreated)
+        {
+            QFile::remove(mFileName+PIXELSTATERASTER_TEMPORARY_FILE_SUFFIX);
+        }
+    }
+    mFileName.clear();
+    mIsCreated=false;
+    mNumberOfBands=0;
+    mColumns=0;
+    mRows=0;
+    mGeoTransform.clear();
+    mMetadata.clear();
+}
+
+bool PixelStateRaster::close(QString &strError)
+{
+    if(mPtrDataset==NULL)
+    {
+        strError=QObject::tr("PixelStateRaster::close");
+        strError+=QObject::tr("\nFile is not open");
+        return(false);
+    }
+    if(!mIsCreated)
+    {
+        clear();
+        return(true);
+    }
+    QMap<QString,QString>::const_iterator iterMetadata=mMetadata.begin();
+    while(iterMetadata!=mMetadata.end())
+    {
+        GDALSetMetadataItem(mPtrDataset,
+                            iterMetadata.key().toStdString().c_str(),
+                            iterMetadata.value().toStdString().c_str(),
+                            NULL);
+        iterMetadata++;
+    }
+    GDALClose(mPtrDataset);
+    mPtrDataset=NULL;
+    QString fileName=mFileName;
+    QString temporalFileName=mFileName+PIXELSTATERASTER_TEMPORARY_FILE_SUFFIX;
+    clear();
+    if(QFile::exists(fileName)
+            &&!QFile::remove(fileName))
+    {
+        strError=QObject::tr("PixelStateRaster::close");
+        strError+=QObject::tr("\nError removing previous file:\n%1").arg(fileName);
+        QFile::remove(temporalFileName);
+        return(false);
+    }
+    if(!QFile::rename(temporalFileName,fileName))
+    {
+        strError=QObject::tr("PixelStateRaster::close");
+        strError+=QObject::tr("\nError renaming file:\n%1\nto:\n%2").arg(temporalFileName).arg(fileName);
+        return(false);
+    }
+    return(true);
+}
+
+bool PixelStateRaster::create(QString fileName,
+                              int numberOfBands,
+                              int columns,
+                              int rows,
+                              const QVector<double> &geoTransform,
+                              QString &strError)
+{
+    clear();
+    GDALDriverH hDriver=GDALGetDriverByName(REMOTESENSING_REPROJECTION_OUTPUT_FORMAT);
+    if(hDriver==NULL
+            ||numberOfBands<1
+            ||geoTransform.size()!=6)
+    {
+        strError=QObject::tr("PixelStateRaster::create");
+        strError+=QObject::tr("\nInvalid driver or state definition for file:\n%1").arg(fileName);
+        return(false);
+    }
+    QString temporalFileName=fileName+PIXELSTATERASTER_TEMPORARY_FILE_SUFFIX;
+    char** ptrOptions=NULL;
+    ptrOptions=CSLSetNameValue(ptrOptions,"TILED","YES");
+    ptrOptions=CSLSetNameValue(ptrOptions,"COMPRESS",REMOTESENSING_COG_COMPRESSION_METHOD_ALTERNATIVE);
+    ptrOptions=CSLSetNameValue(ptrOptions,"PREDICTOR","3");
+    ptrOptions=CSLSetNameValue(ptrOptions,"BIGTIFF","IF_SAFER");
+    mPtrDataset=GDALCreate(hDriver,temporalFileName.toStdString().c_str(),
+                           columns,rows,numberOfBands,GDT_Float64,ptrOptions);
+    CSLDestroy(ptrOptions);
+    if(mPtrDataset==NULL)
+    {
+        strError=QObject::tr("PixelStateRaster::create");
+        strError+=QObject::tr("\nError creating file:\n%1\nGDAL error:\n%2")
+                .arg(temporalFileName).arg(QString(CPLGetLastErrorMsg()));
+        return(false);
+    }
+    double auxGeoTransform[6];
+    for(int i=0;i<6;i++)
+    {
+        auxGeoTransform[i]=geoTransform[i];
+    }
+    GDALSetGeoTransform(mPtrDataset,auxGeoTransform);
+    mFileName=fileName;
+    mIsCreated=true;
+    mNumberOfBands=numberOfBands;
+    mColumns=columns;
+    mRows=rows;
+    mGeoTransform=geoTransform;
+    return(true);
+}
+
+bool PixelStateRaster::getMetadataValue(QString key,
+                                        QString &value) const
+{
+    if(!mMetadata.contains(key))
+    {
+        return(false);
+    }
+    value=mMetadata[key];
+    return(true);
+}
+
+bool PixelStateRaster::isCompatible(int numberOfBands,
+                                    int columns,
+                                    int rows,
+                                    const QVector<double> &geoTransform) const
+{
+    if(numberOfBands!=mNumberOfBands
+            ||columns!=mColumns
+            ||rows!=mRows
+            ||geoTransform.size()!=mGeoTransform.size())
+    {
+        return(false);
+    }
+    for(int i=0;i<geoTransform.size();i++)
+    {
+        if(fabs(geoTransform[i]-mGeoTransform[i])>PIXELSTATERASTER_GEOTRANSFORM_TOLERANCE)
+        {
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool PixelStateRaster::open(QString fileName,
+                            QString &strError)
+{
+    clear();
+    if(!QFile::exists(fileName))
+    {
+        strError=QObject::tr("PixelStateRaster::open");
+        strError+=QObject::tr("\nNot exists file:\n%1").arg(fileName);
+        return(false);
+    }
+    mPtrDataset=GDALOpen(fileName.toStdString().c_str(),GA_ReadOnly);
+    if(mPtrDataset==NULL)
+    {
+        strError=QObject::tr("PixelStateRaster::open");
+        strError+=QObject::tr("\nError opening file:\n%1").arg(fileName);
+        return(false);
+    }
+    double geoTransform[6];
+    if(GDALGetGeoTransform(mPtrDataset,geoTransform)!=CE_None)
+    {
+        strError=QObject::tr("PixelStateRaster::open");
+        strError+=QObject::tr("\nError getting geotransform from file:\n%1").arg(fileName);
+        clear();
+        return(false);
+    }
+    for(int i=0;i<6;i++)
+    {
+        mGeoTransform.push_back(geoTransform[i]);
+    }
+    mFileName=fileName;
+    mNumberOfBands=GDALGetRasterCount(mPtrDataset);
+    mColumns=GDALGetRasterXSize(mPtrDataset);
+    mRows=GDALGetRasterYSize(mPtrDataset);
+    char** ptrMetadata=GDALGetMetadata(mPtrDataset,NULL);
+    for(int i=0;ptrMetadata!=NULL&&ptrMetadata[i]!=NULL;i++)
+    {
+        QString item=QString(ptrMetadata[i]);
+        int position=item.indexOf("=");
+        if(position>0)
+        {
+            mMetadata[item.left(position)]=item.mid(position+1);
+        }
+    }
+    return(true);
+}
+
+bool PixelStateRaster::readWindow(PixelStateWindow &window,
+                                  QString &strError)
+{
+    if(mPtrDataset==NULL
+            ||window.numberOfBands>mNumberOfBands
+            ||window.firstColumn<0||window.firstRow<0
+            ||window.firstColumn+window.columns>mColumns
+            ||window.firstRow+window.rows>mRows)
+    {
+        strError=QObject::tr("PixelStateRaster::readWindow");
+        strError+=QObject::tr("\nFile is not open or invalid window for file:\n%1").arg(mFileName);
+        return(false);
+    }
+    window.values.resize(window.numberOfBands*window.columns*window.rows);
+    for(int nb=0;nb<window.numberOfBands;nb++)
+    {
+        CPLErr eErr=GDALRasterIO(GDALGetRasterBand(mPtrDataset,nb+1),GF_Read,
+                                 window.firstColumn,window.firstRow,window.columns,window.rows,
+                                 window.values.data()+qint64(nb)*window.rows*window.columns,
+                                 window.columns,window.rows,GDT_Float64,0,0);
+        if(eErr!=CE_None)
+        {
+            strError=QObject::tr("PixelStateRaster::readWindow");
+            strError+=QObject::tr("\nError reading band: %1 from file:\n%2\nGDAL error:\n%3")
+                    .arg(QString::number(nb+1)).arg(mFileName).arg(QString(CPLGetLastErrorMsg()));
+            return(false);
+        }
+    }
+    return(true);
+}
+
+void PixelStateRaster::setMetadataValue(QString key,
+                                        QString value)
+{
+    mMetadata[key]=value;
+}
+
+bool PixelStateRaster::writeWindow(const PixelStateWindow &window,
+                                   QString &strError)
+{
+    if(mPtrDataset==NULL
+            ||!mIsCreated
+            ||window.numberOfBands!=mNumberOfBands
+            ||window.firstColumn<0||window.firstRow<0
+            ||window.firstColumn+window.columns>mColumns
+            ||window.firstRow+window.rows>mRows)
+    {
+        strError=QObject::tr("PixelStateRaster::writeWindow");
+        strError+=QObject::tr("\nFile is not created or invalid window for file:\n%1").arg(mFileName);
+        return(false);
+    }
+    for(int nb=0;nb<window.numberOfBands;nb++)
+    {
+        CPLErr eErr=GDALRasterIO(GDALGetRasterBand(mPtrDataset,nb+1),GF_Write,
+                                 window.firstColumn,window.firstRow,window.columns,window.rows,
+                                 (void*)(window.values.constData()+qint64(nb)*window.rows*window.columns),
+                                 window.columns,window.rows,GDT_Float64,0,0);
+        if(eErr!=CE_None)
+        {
+            strError=QObject::tr("PixelStateRaster::writeWindow");
+            strError+=QObject::tr("\nError writting band: %1 to file:\n%2\nGDAL error:\n%3")
+                    .arg(QString::number(nb+1)).arg(mFileName).arg(QString(CPLGetLastErrorMsg()));
+            return(false);
+        }
+    }
+    return(true);
+}
@@ -0,0 +1,100 @@
+#ifndef PIXELSTATERASTER_H
+#define PIXELSTATERASTER_H
+
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+#include <gdal.h>
+
+#include "libremotesensing_global.h"
+
+#define PIXELSTATERASTER_GEOTRANSFORM_TOLERANCE                 0.001
+#define PIXELSTATERASTER_TEMPORARY_FILE_SUFFIX                  ".tmp"
+
+namespace RemoteSensing{
+// Ventana del estado, en coordenadas del raster
+struct PixelStateWindow
+{
+    int numberOfBands;
+    int firstColumn;
+    int firstRow;
+    int columns;
+    int rows;
+    QVector<double> values; // values[(band*rows+row)*columns+column], relativo a la ventana
+    double getValue(int band,
+                    int column,
+                    int row) const
+    {
+        return(values[(qint64(band)*rows+row-firstRow)*columns+column-firstColumn]);
+    }
+    void setValue(int band,
+                  int column,
+                  int row,
+                  double value)
+    {
+        values[(qint64(band)*rows+row-firstRow)*columns+column-firstColumn]=value;
+    }
+    void setWindow(int windowNumberOfBands,
+                   int windowFirstColumn,
+                   int windowFirstRow,
+                   int windowColumns,
+                   int windowRows,
+                   double initialValue)
+    {
+        numberOfBands=windowNumberOfBands;
+        firstColumn=windowFirstColumn;
+        firstRow=windowFirstRow;
+        columns=windowColumns;
+        rows=windowRows;
+        values.fill(initialValue,numberOfBands*columns*rows);
+    }
+};
+
+// Estado por pixel de un proceso acumulativo, para continuarlo en ejecuciones posteriores.
+// Se guarda como GeoTIFF Float64 con una banda por variable de estado, alineado con la malla
+// de la salida, y parametros del proceso (fechas, coeficientes, ...) como metadatos. Se lee y
+// escribe por ventanas. Un fichero creado se escribe en un temporal que sustituye al fichero
+// al cerrarlo, por lo que se puede leer el estado anterior mientras se escribe el nuevo
+class LIBREMOTESENSINGSHARED_EXPORT PixelStateRaster
+{
+public:
+    PixelStateRaster();
+    ~PixelStateRaster();
+    void clear(); // descarta el temporal si no se ha cerrado
+    bool close(QString& strError);
+    bool create(QString fileName,
+                int numberOfBands,
+                int columns,
+                int rows,
+                const QVector<double>& geoTransform, // de GDAL
+                QString& strError);
+    bool getMetadataValue(QString key,
+                          QString& value) const;
+    int getNumberOfBands() const {return(mNumberOfBands);}
+    int getNumberOfColumns() const {return(mColumns);}
+    int getNumberOfRows() const {return(mRows);}
+    bool isCompatible(int numberOfBands,
+                      int columns,
+                      int rows,
+                      const QVector<double>& geoTransform) const;
+    bool open(QString fileName,
+              QString& strError);
+    bool readWindow(PixelStateWindow& window,
+                    QString& strError);
+    void setMetadataValue(QString key,
+                          QString value);
+    bool writeWindow(const PixelStateWindow& window,
+                     QString& strError);
+private:
+    QString mFileName;
+    GDALDatasetH mPtrDataset;
+    bool mIsCreated;
+    int mNumberOfBands;
+    int mColumns;
+    int mRows;
+    QVector<double> mGeoTransform;
+    QMap<QString,QString> mMetadata;
+};
+}
+#endif // PIXELSTATERASTER_H
@@ -0,0 +1,518 @@
+#include <QObject>
+
+#include <gdal.h>
+
+#include "RasterBlockCache.h"
+
+using namespace RemoteSensing;
+
+RasterBlockCache::RasterBlockCache(int maximumMegabytes,
+                                   int blockSize)
+{
+    mMaximumBytes=((qint64)qMax(1,maximumMegabytes))*1024*1024;
+    mBlockSize=qMax(1,blockSize);
+    mUsedBytes=0;
+    mUseCounter=0;
+    mNumberOfHits=0;
+    mNumberOfMisses=0;
+    mNumberOfEvictions=0;
+    mNumberOfWindowReads=0;
+    mNumberOfFreeDatasets=0;
+}
+
+RasterBlockCache::~RasterBlockCache()
+{
+    clear();
+}
+
+void RasterBlockCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    // Los bloques fijados pasan a tratarse como ventanas: siguen contando en el limite y se
+    // liberan en unpinBlock al soltarlos
+    QMap<quint64,RasterBlock*>::iterator iterBlock=mPtrBlockByLastUse.begin();
+    while(iterBlock!=mPtrBlockByLastUse.end())
+    {
+        RasterBlock* ptrBlock=iterBlock.value();
+        if(ptrBlock->pinCount>0)
+        {
+            ptrBlock->blockIndex=RASTERBLOCKCACHE_WINDOW_BLOCK_INDEX;
+        }
+        else
+        {
+            mUsedBytes-=((qint64)ptrBlock->values.size())*sizeof(double);
+            delete(ptrBlock);
+        }
+        iterBlock++;
+    }
+    mPtrBlockByLastUse.clear();
+    mPtrBlockByIndexByFileName.clear();
+    mFileByFileName.clear();
+    closeDatasets();
+    mUseCounter=0;
+    mNumberOfHits=0;
+    mNumberOfMisses=0;
+    mNumberOfEvictions=0;
+    mNumberOfWindowReads=0;
+}
+
+bool RasterBlockCache::acquireDataset(QString fileName,
+                                      GDALDatasetH &hDS,
+                                      QString &strError)
+{
+    // Un dataset de GDAL solo lo usa un hilo a la vez
+    hDS=NULL;
+    {
+        QMutexLocker locker(&mMutex);
+        QMap<QString,QVector<GDALDatasetH> >::iterator iterFile=mFreeDatasetsByFileName.find(fileName);
+        if(iterFile!=mFreeDatasetsByFileName.end()
+                &&!iterFile.value().isEmpty())
+        {
+            hDS=iterFile.value().last();
+            iterFile.value().pop_back();
+            mNumberOfFreeDatasets--;
+            return(true);
+        }
+    }
+    hDS=GDALOpen(fileName.toStdString().c_str(),GA_ReadOnly);
+    if(hDS==NULL)
+    {
+        strError=QObject::tr("RasterBlockCache::acquireDataset");
+        strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
+                .arg(fileName).arg(QString(CPLGetLastErrorMsg()));
+        return(false);
+    }
+    return(true);
+}
+
+void RasterBlockCache::closeDatasets()
+{
+    // Con el mutex bloqueado
+    QMap<QString,QVector<GDALDatasetH> >::iterator iterFile=mFreeDatasetsByFileName.begin();
+    while(iterFile!=mFreeDatasetsByFileName.end())
+    {
+        for(int nd=0;nd<iterFile.value().size();nd++)
+        {
+            GDALClose(iterFile.value()[nd]);
+        }
+        iterFile++;
+    }
+    mFreeDatasetsByFileName.clear();
+    mNumberOfFreeDatasets=0;
+}
+
+bool RasterBlockCache::getGeoTransform(QString fileName,
+                                       QVector<double> &geoTransform,
+                                       QString &strError)
+{
+    RasterBlockCacheFile file;
+    QString strAuxError;
+    if(!getFile(fileName,file,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::getGeoTransform");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(file.geoTransform.isEmpty())
+    {
+        strError=QObject::tr("RasterBlockCache::getGeoTransform");
+        strError+=QObject::tr("\nThere is no georeference in raster file:\n%1").arg(fileName);
+        return(false);
+    }
+    geoTransform=file.geoTransform;
+    return(true);
+}
+
+bool RasterBlockCache::getNoDataValue(QString fileName,
+                                      bool &existsNoDataValue,
+                                      double &noDataValue,
+                                      QString &strError)
+{
+    RasterBlockCacheFile file;
+    QString strAuxError;
+    if(!getFile(fileName,file,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::getNoDataValue");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    existsNoDataValue=file.existsNoDataValue;
+    noDataValue=file.noDataValue;
+    return(true);
+}
+
+qint64 RasterBlockCache::getNumberOfEvictions()
+{
+    QMutexLocker locker(&mMutex);
+    return(mNumberOfEvictions);
+}
+
+qint64 RasterBlockCache::getNumberOfHits()
+{
+    QMutexLocker locker(&mMutex);
+    return(mNumberOfHits);
+}
+
+qint64 RasterBlockCache::getNumberOfMisses()
+{
+    QMutexLocker locker(&mMutex);
+    return(mNumberOfMisses);
+}
+
+qint64 RasterBlockCache::getNumberOfWindowReads()
+{
+    QMutexLocker locker(&mMutex);
+    return(mNumberOfWindowReads);
+}
+
+bool RasterBlockCache::getSize(QString fileName,
+                               int &columns,
+                               int &rows,
+                               QString &strError)
+{
+    RasterBlockCacheFile file;
+    QString strAuxError;
+    if(!getFile(fileName,file,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::getSize");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    columns=file.columns;
+    rows=file.rows;
+    return(true);
+}
+
+qint64 RasterBlockCache::getUsedBytes()
+{
+    QMutexLocker locker(&mMutex);
+    return(mUsedBytes);
+}
+
+bool RasterBlockCache::getValue(QString fileName,
+                                int column,
+                                int row,
+                                double &value,
+                                QString &strError)
+{
+    if(column<0||row<0)
+    {
+        strError=QObject::tr("RasterBlockCache::getValue");
+        strError+=QObject::tr("\nPixel [%1,%2] out of raster file:\n%3")
+                .arg(QString::number(column)).arg(QString::number(row)).arg(fileName);
+        return(false);
+    }
+    const RasterBlock* ptrBlock=NULL;
+    QString strAuxError;
+    if(!pinBlock(fileName,column/mBlockSize,row/mBlockSize,ptrBlock,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::getValue");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    int blockColumn=column-ptrBlock->firstColumn;
+    int blockRow=row-ptrBlock->firstRow;
+    bool success=(blockColumn<ptrBlock->columns&&blockRow<ptrBlock->rows);
+    if(success)
+    {
+        value=ptrBlock->values[blockRow*ptrBlock->columns+blockColumn];
+    }
+    unpinBlock(ptrBlock);
+    if(!success)
+    {
+        strError=QObject::tr("RasterBlockCache::getValue");
+        strError+=QObject::tr("\nPixel [%1,%2] out of raster file:\n%3")
+                .arg(QString::number(column)).arg(QString::number(row)).arg(fileName);
+        return(false);
+    }
+    return(true);
+}
+
+bool RasterBlockCache::pinBlock(QString fileName,
+                                int blockColumn,
+                                int blockRow,
+                                const RasterBlock *&ptrBlock,
+                                QString &strError)
+{
+    ptrBlock=NULL;
+    RasterBlockCacheFile file;
+    QString strAuxError;
+    if(!getFile(fileName,file,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::pinBlock");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    int numberOfBlockColumns=(file.columns+mBlockSize-1)/mBlockSize;
+    int numberOfBlockRows=(file.rows+mBlockSize-1)/mBlockSize;
+    if(blockColumn<0||blockColumn>=numberOfBlockColumns
+            ||blockRow<0||blockRow>=numberOfBlockRows)
+    {
+        strError=QObject::tr("RasterBlockCache::pinBlock");
+        strError+=QObject::tr("\nBlock [%1,%2] out of raster file:\n%3")
+                .arg(QString::number(blockColumn)).arg(QString::number(blockRow)).arg(fileName);
+        return(false);
+    }
+    int blockIndex=blockRow*numberOfBlockColumns+blockColumn;
+    {
+        QMutexLocker locker(&mMutex);
+        RasterBlock* ptrCachedBlock=mPtrBlockByIndexByFileName.value(fileName).value(blockIndex,NULL);
+        if(ptrCachedBlock!=NULL)
+        {
+            mNumberOfHits++;
+            ptrCachedBlock->pinCount++;
+            touchBlock(ptrCachedBlock);
+            ptrBlock=ptrCachedBlock;
+            return(true);
+        }
+        mNumberOfMisses++;
+    }
+    // La lectura se hace sin bloquear la cache
+    RasterBlock* ptrNewBlock=new RasterBlock();
+    ptrNewBlock->fileName=fileName;
+    ptrNewBlock->blockIndex=blockIndex;
+    ptrNewBlock->firstColumn=blockColumn*mBlockSize;
+    ptrNewBlock->firstRow=blockRow*mBlockSize;
+    ptrNewBlock->columns=qMin(mBlockSize,file.columns-ptrNewBlock->firstColumn);
+    ptrNewBlock->rows=qMin(mBlockSize,file.rows-ptrNewBlock->firstRow);
+    ptrNewBlock->pinCount=0;
+    ptrNewBlock->lastUse=0;
+    if(!readBlock(ptrNewBlock,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::pinBlock");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        delete(ptrNewBlock);
+        return(false);
+    }
+    QMutexLocker locker(&mMutex);
+    QMap<int,RasterBlock*>& ptrBlockByIndex=mPtrBlockByIndexByFileName[fileName];
+    if(ptrBlockByIndex.contains(blockIndex)) // otro hilo lo ha leido a la vez
+    {
+        delete(ptrNewBlock);
+        ptrNewBlock=ptrBlockByIndex[blockIndex];
+    }
+    else
+    {
+        ptrBlockByIndex[blockIndex]=ptrNewBlock;
+        mUsedBytes+=((qint64)ptrNewBlock->values.size())*sizeof(double);
+    }
+    ptrNewBlock->pinCount++;
+    touchBlock(ptrNewBlock);
+    evictBlocks();
+    ptrBlock=ptrNewBlock;
+    return(true);
+}
+
+bool RasterBlockCache::pinWindow(QString fileName,
+                                 int firstColumn,
+                                 int firstRow,
+                                 int columns,
+                                 int rows,
+                                 const RasterBlock *&ptrBlock,
+                                 QString &strError)
+{
+    ptrBlock=NULL;
+    RasterBlockCacheFile file;
+    QString strAuxError;
+    if(!getFile(fileName,file,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::pinWindow");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(firstColumn<0||firstRow<0||columns<1||rows<1
+            ||firstColumn+columns>file.columns
+            ||firstRow+rows>file.rows)
+    {
+        strError=QObject::tr("RasterBlockCache::pinWindow");
+        strError+=QObject::tr("\nWindow [%1,%2] x [%3,%4] out of raster file:\n%5")
+                .arg(QString::number(firstColumn)).arg(QString::number(firstRow))
+                .arg(QString::number(columns)).arg(QString::number(rows)).arg(fileName);
+        return(false);
+    }
+    RasterBlock* ptrWindow=new RasterBlock();
+    ptrWindow->fileName=fileName;
+    ptrWindow->blockIndex=RASTERBLOCKCACHE_WINDOW_BLOCK_INDEX;
+    ptrWindow->firstColumn=firstColumn;
+    ptrWindow->firstRow=firstRow;
+    ptrWindow->columns=columns;
+    ptrWindow->rows=rows;
+    ptrWindow->pinCount=1;
+    ptrWindow->lastUse=0;
+    if(!readBlock(ptrWindow,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::pinWindow");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        delete(ptrWindow);
+        return(false);
+    }
+    // No se comparte: solo cuenta en el limite y desplaza bloques hasta que se suelta
+    QMutexLocker locker(&mMutex);
+    mNumberOfWindowReads++;
+    mUsedBytes+=((qint64)ptrWindow->values.size())*sizeof(double);
+    evictBlocks();
+    ptrBlock=ptrWindow;
+    return(true);
+}
+
+void RasterBlockCache::unpinBlock(const RasterBlock *ptrBlock)
+{
+    if(ptrBlock==NULL)
+    {
+        return;
+    }
+    QMutexLocker locker(&mMutex);
+    RasterBlock* ptrCachedBlock=const_cast<RasterBlock*>(ptrBlock);
+    if(ptrCachedBlock->pinCount>0)
+    {
+        ptrCachedBlock->pinCount--;
+    }
+    if(ptrCachedBlock->blockIndex==RASTERBLOCKCACHE_WINDOW_BLOCK_INDEX)
+    {
+        if(ptrCachedBlock->pinCount==0)
+        {
+            mUsedBytes-=((qint64)ptrCachedBlock->values.size())*sizeof(double);
+            delete(ptrCachedBlock);
+        }
+        return;
+    }
+    if(mUsedBytes>mMaximumBytes)
+    {
+        evictBlocks();
+    }
+}
+
+void RasterBlockCache::evictBlocks()
+{
+    // Con el mutex bloqueado. Se expulsan los menos usados recientemente que no esten fijados
+    QMap<quint64,RasterBlock*>::iterator iterBlock=mPtrBlockByLastUse.begin();
+    while(mUsedBytes>mMaximumBytes
+          &&iterBlock!=mPtrBlockByLastUse.end())
+    {
+        RasterBlock* ptrBlock=iterBlock.value();
+        if(ptrBlock->pinCount>0)
+        {
+            iterBlock++;
+            continue;
+        }
+        iterBlock=mPtrBlockByLastUse.erase(iterBlock);
+        QMap<QString,QMap<int,RasterBlock*> >::iterator iterFile=mPtrBlockByIndexByFileName.find(ptrBlock->fileName);
+        if(iterFile!=mPtrBlockByIndexByFileName.end())
+        {
+            iterFile.value().remove(ptrBlock->blockIndex);
+            if(iterFile.value().isEmpty())
+            {
+                mPtrBlockByIndexByFileName.erase(iterFile);
+            }
+        }
+        mUsedBytes-=((qint64)ptrBlock->values.size())*sizeof(double);
+        mNumberOfEvictions++;
+        delete(ptrBlock);
+    }
+}
+
+bool RasterBlockCache::getFile(QString fileName,
+                               RasterBlockCacheFile &file,
+                               QString &strError)
+{
+    {
+        QMutexLocker locker(&mMutex);
+        if(mFileByFileName.contains(fileName))
+        {
+            file=mFileByFileName[fileName];
+            return(true);
+        }
+    }
+    GDALDatasetH hDS=NULL;
+    QString strAuxError;
+    if(!acquireDataset(fileName,hDS,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::getFile");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    GDALRasterBandH hBand=GDALGetRasterBand(hDS,1);
+    if(hBand==NULL)
+    {
+        strError=QObject::tr("RasterBlockCache::getFile");
+        strError+=QObject::tr("\nThere are no bands in raster file:\n%1").arg(fileName);
+        GDALClose(hDS);
+        return(false);
+    }
+    int successNoDataValue=0;
+    file.columns=GDALGetRasterXSize(hDS);
+    file.rows=GDALGetRasterYSize(hDS);
+    file.noDataValue=GDALGetRasterNoDataValue(hBand,&successNoDataValue);
+    file.existsNoDataValue=(successNoDataValue!=0);
+    double geoTransform[6];
+    file.geoTransform.clear();
+    if(GDALGetGeoTransform(hDS,geoTransform)==CE_None)
+    {
+        for(int ngt=0;ngt<6;ngt++)
+        {
+            file.geoTransform.push_back(geoTransform[ngt]);
+        }
+    }
+    releaseDataset(fileName,hDS);
+    QMutexLocker locker(&mMutex);
+    mFileByFileName[fileName]=file;
+    return(true);
+}
+
+bool RasterBlockCache::readBlock(RasterBlock *ptrBlock,
+                                 QString &strError)
+{
+    GDALDatasetH hDS=NULL;
+    QString strAuxError;
+    if(!acquireDataset(ptrBlock->fileName,hDS,strAuxError))
+    {
+        strError=QObject::tr("RasterBlockCache::readBlock");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    ptrBlock->values.resize(ptrBlock->columns*ptrBlock->rows);
+    CPLErr eErr=GDALRasterIO(GDALGetRasterBand(hDS,1),GF_Read,
+                             ptrBlock->firstColumn,ptrBlock->firstRow,
+                             ptrBlock->columns,ptrBlock->rows,
+                             ptrBlock->values.data(),
+                             ptrBlock->columns,ptrBlock->rows,
+                             GDT_Float64,0,0);
+    if(eErr!=CE_None)
+    {
+        strError=QObject::tr("RasterBlockCache::readBlock");
+        strError+=QObject::tr("\nError reading block from raster file:\n%1\nError:\n%2")
+                .arg(ptrBlock->fileName).arg(QString(CPLGetLastErrorMsg()));
+        GDALClose(hDS);
+        return(false);
+    }
+    releaseDataset(ptrBlock->fileName,hDS);
+    return(true);
+}
+
+void RasterBlockCache::releaseDataset(QString fileName,
+                                      GDALDatasetH hDS)
+{
+    // Por encima del maximo de libres el dataset se cierra
+    {
+        QMutexLocker locker(&mMutex);
+        if(mNumberOfFreeDatasets<RASTERBLOCKCACHE_MAXIMUM_OPEN_DATASETS)
+        {
+            mFreeDatasetsByFileName[fileName].push_back(hDS);
+            mNumberOfFreeDatasets++;
+            return;
+        }
+    }
+    GDALClose(hDS);
+}
+
+void RasterBlockCache::touchBlock(RasterBlock *ptrBlock)
+{
+    // Con el mutex bloqueado
+    if(ptrBlock->lastUse>0)
+    {
+        mPtrBlockByLastUse.remove(ptrBlock->lastUse);
+    }
+    mUseCounter++;
+    ptrBlock->lastUse=mUseCounter;
+    mPtrBlockByLastUse[mUseCounter]=ptrBlock;
+}
@@ -0,0 +1,123 @@
+#ifndef RASTERBLOCKCACHE_H
+#define RASTERBLOCKCACHE_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+#include <gdal.h>
+
+#include "libremotesensing_global.h"
+
+#define RASTERBLOCKCACHE_DEFAULT_MAXIMUM_MB                  512
+#define RASTERBLOCKCACHE_DEFAULT_BLOCK_SIZE                  256 // pixeles de lado
+#define RASTERBLOCKCACHE_WINDOW_BLOCK_INDEX                  -1 // ventanas leidas con pinWindow y bloques descartados fijados
+#define RASTERBLOCKCACHE_MAXIMUM_OPEN_DATASETS               256 // datasets libres que se mantienen abiertos
+
+namespace RemoteSensing{
+// Bloque cuadrado de la banda 1 de un fichero, ya decodificado. Los bloques del borde
+// derecho e inferior pueden ser menores que el tamano de bloque
+struct RasterBlock
+{
+    QString fileName;
+    int blockIndex;
+    int firstColumn;
+    int firstRow;
+    int columns;
+    int rows;
+    QVector<double> values; // values[row*columns+column], relativo al bloque
+    int pinCount;
+    quint64 lastUse;
+};
+
+struct RasterBlockCacheFile
+{
+    int columns;
+    int rows;
+    bool existsNoDataValue;
+    double noDataValue;
+    QVector<double> geoTransform; // de GDAL, esquina noroeste del primer pixel
+};
+
+// Cache LRU de bloques de raster limitada en bytes y compartida entre hilos. Un bloque fijado
+// (pinBlock) no se expulsa hasta que se libera (unpinBlock), por lo que el limite solo se supera
+// mientras todos los bloques en memoria esten fijados. Los datasets de GDAL se mantienen abiertos
+// durante la vida de la cache, con una lista de libres por fichero: cada lectura toma uno que no
+// usa otro hilo o abre otro. Una ventana arbitraria (pinWindow) se lee de una vez, cuenta en el
+// limite mientras esta fijada y se libera al soltarla. clear() no libera los bloques fijados, que
+// se liberan al soltarlos
+class LIBREMOTESENSINGSHARED_EXPORT RasterBlockCache
+{
+public:
+    RasterBlockCache(int maximumMegabytes=RASTERBLOCKCACHE_DEFAULT_MAXIMUM_MB,
+                     int blockSize=RASTERBLOCKCACHE_DEFAULT_BLOCK_SIZE);
+    ~RasterBlockCache();
+    void clear();
+    int getBlockSize(){return(mBlockSize);}
+    bool getGeoTransform(QString fileName,
+                         QVector<double>& geoTransform,
+                         QString& strError);
+    qint64 getMaximumBytes(){return(mMaximumBytes);}
+    bool getNoDataValue(QString fileName,
+                        bool& existsNoDataValue,
+                        double& noDataValue,
+                        QString& strError);
+    qint64 getNumberOfEvictions();
+    qint64 getNumberOfHits();
+    qint64 getNumberOfMisses();
+    qint64 getNumberOfWindowReads();
+    bool getSize(QString fileName,
+                 int& columns,
+                 int& rows,
+                 QString& strError);
+    qint64 getUsedBytes();
+    bool getValue(QString fileName,
+                  int column,
+                  int row,
+                  double& value,
+                  QString& strError);
+    bool pinBlock(QString fileName,
+                  int blockColumn,
+                  int blockRow,
+                  const RasterBlock*& ptrBlock,
+                  QString& strError);
+    bool pinWindow(QString fileName,
+                   int firstColumn,
+                   int firstRow,
+                   int columns,
+                   int rows,
+                   const RasterBlock*& ptrBlock,
+                   QString& strError);
+    void unpinBlock(const RasterBlock* ptrBlock);
+private:
+    bool acquireDataset(QString fileName,
+                        GDALDatasetH& hDS,
+                        QString& strError);
+    void closeDatasets();
+    void evictBlocks();
+    bool getFile(QString fileName,
+                 RasterBlockCacheFile& file,
+                 QString& strError);
+    bool readBlock(RasterBlock* ptrBlock,
+                   QString& strError);
+    void releaseDataset(QString fileName,
+                        GDALDatasetH hDS);
+    void touchBlock(RasterBlock* ptrBlock);
+    qint64 mMaximumBytes;
+    int mBlockSize;
+    qint64 mUsedBytes;
+    quint64 mUseCounter;
+    qint64 mNumberOfHits;
+    qint64 mNumberOfMisses;
+    qint64 mNumberOfEvictions;
+    qint64 mNumberOfWindowReads;
+    QMap<QString,RasterBlockCacheFile> mFileByFileName;
+    QMap<QString,QMap<int,RasterBlock*> > mPtrBlockByIndexByFileName;
+    QMap<quint64,RasterBlock*> mPtrBlockByLastUse; // orden LRU
+    QMap<QString,QVector<GDALDatasetH> > mFreeDatasetsByFileName; // abiertos y sin usar
+    int mNumberOfFreeDatasets;
+    QMutex mMutex;
+};
+}
+#endif // RASTERBLOCKCACHE_H
@@ -0,0 +1,205 @@
+#include <QObject>
+
+#include <math.h>
+
+#include "ResamplingIndexMap.h"
+
+using namespace RemoteSensing;
+
+ResamplingIndexMap::ResamplingIndexMap()
+{
+    clear();
+}
+
+bool ResamplingIndexMap::build(const QVector<double> &inputGeoTransform,
+                               int inputColumns,
+                               int inputRows,
+                               double outputNwFc,
+                               double outputNwSc,
+                               double outputGsd,
+                               const QVector<int> &pixelColumns,
+                               const QVector<int> &pixelRows,
+                               int resamplingMethod,
+                               QString &strError)
+{
+    clear();
+    if(!isValidMethod(resamplingMethod))
+    {
+        strError=QObject::tr("ResamplingIndexMap::build");
+        strError+=QObject::tr("\nInvalid resampling method: %1").arg(QString::number(resamplingMethod));
+        return(false);
+    }
+    if(inputGeoTransform.size()!=6
+            ||inputGeoTransform[1]==0.0
+            ||inputGeoTransform[5]==0.0
+            ||pixelColumns.size()!=pixelRows.size())
+    {
+        strError=QObject::tr("ResamplingIndexMap::build");
+        strError+=QObject::tr("\nInvalid geotransform or pixels");
+        return(false);
+    }
+    mResamplingMethod=resamplingMethod;
+    mNumberOfTaps=1;
+    if(resamplingMethod==RESAMPLINGINDEXMAP_METHOD_BILINEAR)
+    {
+        mNumberOfTaps=4;
+    }
+    mNumberOfPixels=pixelColumns.size();
+    // Tomas en coordenadas del raster de entrada
+    QVector<int> tapColumns(mNumberOfPixels*mNumberOfTaps,-1);
+    QVector<int> tapRows(mNumberOfPixels*mNumberOfTaps,-1);
+    mWeights.fill(0.0,mNumberOfPixels*mNumberOfTaps);
+    int firstColumn=inputColumns;
+    int firstRow=inputRows;
+    int endColumn=0;
+    int endRow=0;
+    for(int np=0;np<mNumberOfPixels;np++)
+    {
+        double centerPixelFc=outputNwFc+pixelColumns[np]*outputGsd+0.5*outputGsd;
+        double centerPixelSc=outputNwSc-pixelRows[np]*outputGsd-0.5*outputGsd;
+        // Posicion continua en el raster de entrada, en pixeles desde la esquina noroeste
+        double x=(centerPixelFc-inputGeoTransform[0])/inputGeoTransform[1];
+        double y=(centerPixelSc-inputGeoTransform[3])/inputGeoTransform[5];
+        int column=floor(x);
+        int row=floor(y);
+        if(column<0||row<0||column>=inputColumns||row>=inputRows)
+        {
+            strError=QObject::tr("ResamplingIndexMap::build");
+            strError+=QObject::tr("\nPixel [%1,%2] out of input raster")
+                    .arg(QString::number(pixelColumns[np])).arg(QString::number(pixelRows[np]));
+            clear();
+            return(false);
+        }
+        if(mResamplingMethod==RESAMPLINGINDEXMAP_METHOD_NEAREST)
+        {
+            tapColumns[np]=column;
+            tapRows[np]=row;
+            mWeights[np]=1.0;
+        }
+        else
+        {
+            // Centros de los cuatro pixeles mas proximos
+            x-=0.5;
+            y-=0.5;
+            column=floor(x);
+            row=floor(y);
+            double dx=x-column;
+            double dy=y-row;
+            for(int nt=0;nt<4;nt++)
+            {
+                int tapColumn=column+nt%2;
+                int tapRow=row+nt/2;
+                if(tapColumn<0||tapRow<0||tapColumn>=inputColumns||tapRow>=inputRows)
+                {
+                    continue;
+                }
+                tapColumns[np*4+nt]=tapColumn;
+                tapRows[np*4+nt]=tapRow;
+                mWeights[np*4+nt]=(nt%2==0?1.0-dx:dx)*(nt/2==0?1.0-dy:dy);
+            }
+        }
+        for(int nt=0;nt<mNumberOfTaps;nt++)
+        {
+            int position=np*mNumberOfTaps+nt;
+            if(tapColumns[position]<0)
+            {
+                continue;
+            }
+            firstColumn=qMin(firstColumn,tapColumns[position]);
+            firstRow=qMin(firstRow,tapRows[position]);
+            endColumn=qMax(endColumn,tapColumns[position]+1);
+            endRow=qMax(endRow,tapRows[position]+1);
+        }
+    }
+    if(mNumberOfPixels==0)
+    {
+        return(true);
+    }
+    mFirstColumn=firstColumn;
+    mFirstRow=firstRow;
+    mColumns=endColumn-firstColumn;
+    mRows=endRow-firstRow;
+    mIndexes.fill(-1,mNumberOfPixels*mNumberOfTaps);
+    for(int position=0;position<mIndexes.size();position++)
+    {
+        if(tapColumns[position]>=0)
+        {
+            mIndexes[position]=(tapRows[position]-mFirstRow)*mColumns+tapColumns[position]-mFirstColumn;
+        }
+    }
+    return(true);
+}
+
+void ResamplingIndexMap::clear()
+{
+    mResamplingMethod=RESAMPLINGINDEXMAP_METHOD_NEAREST;
+    mNumberOfTaps=1;
+    mNumberOfPixels=0;
+    mFirstColumn=0;
+    mFirstRow=0;
+    mColumns=0;
+    mRows=0;
+    mIndexes.clear();
+    mWeights.clear();
+}
+
+double ResamplingIndexMap::gather(const double *ptrWindowValues,
+                                  int pixel,
+                                  bool existsNoDataValue,
+                                  double noDataValue,
+                                  bool &isValid) const
+{
+    isValid=false;
+    if(mNumberOfTaps==1)
+    {
+        int index=mIndexes[pixel];
+        if(index<0)
+        {
+            return(noDataValue);
+        }
+        double value=ptrWindowValues[index];
+        isValid=(!existsNoDataValue||value!=noDataValue);
+        return(value);
+    }
+    double value=0.0;
+    double weight=0.0;
+    for(int nt=0;nt<mNumberOfTaps;nt++)
+    {
+        int index=mIndexes[pixel*mNumberOfTaps+nt];
+        if(index<0)
+        {
+            continue;
+        }
+        double tapValue=ptrWindowValues[index];
+        if(existsNoDataValue&&tapValue==noDataValue)
+        {
+            continue;
+        }
+        value+=mWeights[pixel*mNumberOfTaps+nt]*tapValue;
+        weight+=mWeights[pixel*mNumberOfTaps+nt];
+    }
+    if(weight<=0.0)
+    {
+        return(noDataValue);
+    }
+    isValid=true;
+    return(value/weight);
+}
+
+QString ResamplingIndexMap::getGridKey(const QVector<double> &inputGeoTransform,
+                                       int inputColumns,
+                                       int inputRows)
+{
+    QString gridKey=QString::number(inputColumns)+"_"+QString::number(inputRows);
+    for(int i=0;i<inputGeoTransform.size();i++)
+    {
+        gridKey+=("_"+QString::number(inputGeoTransform[i],'g',17));
+    }
+    return(gridKey);
+}
+
+bool ResamplingIndexMap::isValidMethod(int resamplingMethod)
+{
+    return(resamplingMethod==RESAMPLINGINDEXMAP_METHOD_NEAREST
+           ||resamplingMethod==RESAMPLINGINDEXMAP_METHOD_BILINEAR);
+}
@@ -0,0 +1,61 @@
+#ifndef RESAMPLINGINDEXMAP_H
+#define RESAMPLINGINDEXMAP_H
+
+#include <QString>
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+#define RESAMPLINGINDEXMAP_METHOD_NEAREST                       0
+#define RESAMPLINGINDEXMAP_METHOD_BILINEAR                      1
+
+namespace RemoteSensing{
+// Mapa de indices y pesos de un conjunto de pixeles de una malla de salida sobre la malla de
+// un raster de entrada, para el vecino mas proximo (una toma) o bilineal (cuatro tomas). Se
+// calcula una vez por malla de entrada y se aplica a la ventana del raster que cubre todas las
+// tomas (getFirstColumn, ...), de cualquier fecha con la misma malla, sin importar si la malla
+// de entrada es mas fina o mas gruesa que la de salida
+class LIBREMOTESENSINGSHARED_EXPORT ResamplingIndexMap
+{
+public:
+    ResamplingIndexMap();
+    bool build(const QVector<double>& inputGeoTransform, // de GDAL
+               int inputColumns,
+               int inputRows,
+               double outputNwFc,
+               double outputNwSc,
+               double outputGsd,
+               const QVector<int>& pixelColumns,
+               const QVector<int>& pixelRows,
+               int resamplingMethod,
+               QString& strError);
+    void clear();
+    // Valor remuestreado del pixel, ignorando las tomas con noDataValue o fuera del raster.
+    // isValid=false, y valor sin significado, si ninguna toma es valida
+    double gather(const double* ptrWindowValues,
+                  int pixel,
+                  bool existsNoDataValue,
+                  double noDataValue,
+                  bool& isValid) const;
+    int getColumns() const {return(mColumns);}
+    int getFirstColumn() const {return(mFirstColumn);}
+    int getFirstRow() const {return(mFirstRow);}
+    static QString getGridKey(const QVector<double>& inputGeoTransform,
+                              int inputColumns,
+                              int inputRows);
+    int getNumberOfPixels() const {return(mNumberOfPixels);}
+    int getRows() const {return(mRows);}
+    static bool isValidMethod(int resamplingMethod);
+private:
+    int mResamplingMethod;
+    int mNumberOfTaps;
+    int mNumberOfPixels;
+    int mFirstColumn; // ventana del raster de entrada
+    int mFirstRow;
+    int mColumns;
+    int mRows;
+    QVector<int> mIndexes; // mIndexes[pixel*taps+tap], relativo a la ventana, -1 fuera del raster
+    QVector<float> mWeights;
+};
+}
+#endif // RESAMPLINGINDEXMAP_H
@@ -0,0 +1,295 @@
+#include <QObject>
+
+#include <math.h>
+
+#include <ogr_geometry.h>
+
+#include "RoiCoverageMask.h"
+
+using namespace RemoteSensing;
+
+RoiCoverageMask::RoiCoverageMask()
+{
+    clear();
+}
+
+void RoiCoverageMask::clear()
+{
+    mNwFc=0.0;
+    mNwSc=0.0;
+    mGsd=0.0;
+    mFirstColumn=0;
+    mFirstRow=0;
+    mNumberOfColumns=0;
+    mNumberOfRows=0;
+    mCoverages.clear();
+    mAccumulatedCoverages.clear();
+}
+
+int RoiCoverageMask::getCoverageType(int column,
+                                     int row) const
+{
+    double coverage=getCoverage(column,row);
+    if(coverage<=ROICOVERAGEMASK_TOLERANCE)
+    {
+        return(ROICOVERAGEMASK_NONE);
+    }
+    if(coverage>=(1.0-ROICOVERAGEMASK_TOLERANCE))
+    {
+        return(ROICOVERAGEMASK_FULL);
+    }
+    return(ROICOVERAGEMASK_PARTIAL);
+}
+
+double RoiCoverageMask::getCoverage(int column,
+                                    int row) const
+{
+    int maskColumn=column-mFirstColumn;
+    int maskRow=row-mFirstRow;
+    if(maskColumn<0||maskColumn>=mNumberOfColumns
+            ||maskRow<0||maskRow>=mNumberOfRows)
+    {
+        return(0.0);
+    }
+    return(mCoverages[maskRow*mNumberOfColumns+maskColumn]);
+}
+
+bool RoiCoverageMask::setFromGeometry(OGRGeometry *ptrGeometry,
+                                      double rasterNwFc,
+                                      double rasterNwSc,
+                                      double rasterGsd,
+                                      int rasterColumns,
+                                      int rasterRows,
+                                      QString &strError)
+{
+    clear();
+    if(ptrGeometry==NULL)
+    {
+        strError=QObject::tr("RoiCoverageMask::setFromGeometry");
+        strError+=QObject::tr("\nNull geometry");
+        return(false);
+    }
+    if(rasterGsd<=0.0)
+    {
+        strError=QObject::tr("RoiCoverageMask::setFromGeometry");
+        strError+=QObject::tr("\nInvalid gsd: %1").arg(QString::number(rasterGsd));
+        return(false);
+    }
+    if(ptrGeometry->IsEmpty())
+    {
+        return(true);
+    }
+    // Ventana de la envolvente ajustada a la malla y recortada al raster
+    OGREnvelope envelope;
+    ptrGeometry->getEnvelope(&envelope);
+    int firstColumn=qMax(0,(int)floor((envelope.MinX-rasterNwFc)/rasterGsd));
+    int lastColumn=qMin(rasterColumns-1,(int)ceil((envelope.MaxX-rasterNwFc)/rasterGsd)-1);
+    int firstRow=qMax(0,(int)floor((rasterNwSc-envelope.MaxY)/rasterGsd));
+    int lastRow=qMin(rasterRows-1,(int)ceil((rasterNwSc-envelope.MinY)/rasterGsd)-1);
+    if(lastColumn<firstColumn||lastRow<firstRow)
+    {
+        return(true);
+    }
+    mGsd=rasterGsd;
+    mFirstColumn=firstColumn;
+    mFirstRow=firstRow;
+    mNumberOfColumns=lastColumn-firstColumn+1;
+    mNumberOfRows=lastRow-firstRow+1;
+    mNwFc=rasterNwFc+mFirstColumn*rasterGsd;
+    mNwSc=rasterNwSc-mFirstRow*rasterGsd;
+    mCoverages.fill(0.0,mNumberOfRows*mNumberOfColumns);
+    mAccumulatedCoverages.fill(0.0,mNumberOfRows*(mNumberOfColumns+1));
+    QString strAuxError;
+    if(!addGeometry(ptrGeometry,strAuxError))
+    {
+        strError=QObject::tr("RoiCoverageMask::setFromGeometry");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        clear();
+        return(false);
+    }
+    // Cada pixel recibe lo que los lados a su derecha barren en su fila
+    for(int row=0;row<mNumberOfRows;row++)
+    {
+        double* ptrCoverages=mCoverages.data()+row*mNumberOfColumns;
+        const double* ptrAccumulatedCoverages=mAccumulatedCoverages.constData()+row*(mNumberOfColumns+1);
+        double accumulatedCoverage=ptrAccumulatedCoverages[mNumberOfColumns];
+        for(int column=mNumberOfColumns-1;column>=0;column--)
+        {
+            double coverage=ptrCoverages[column]+accumulatedCoverage;
+            ptrCoverages[column]=qMin(1.0,qMax(0.0,coverage));
+            accumulatedCoverage+=ptrAccumulatedCoverages[column];
+        }
+    }
+    mAccumulatedCoverages.clear();
+    return(true);
+}
+
+bool RoiCoverageMask::addGeometry(OGRGeometry *ptrGeometry,
+                                  QString &strError)
+{
+    OGRwkbGeometryType geometryType=wkbFlatten(ptrGeometry->getGeometryType());
+    if(geometryType==wkbPolygon)
+    {
+        OGRPolygon* ptrPolygon=(OGRPolygon*)ptrGeometry;
+        if(ptrPolygon->getExteriorRing()==NULL)
+        {
+            return(true);
+        }
+        addRing(ptrPolygon->getExteriorRing(),false);
+        for(int nir=0;nir<ptrPolygon->getNumInteriorRings();nir++)
+        {
+            addRing(ptrPolygon->getInteriorRing(nir),true);
+        }
+        return(true);
+    }
+    if(geometryType==wkbMultiPolygon
+            ||geometryType==wkbGeometryCollection)
+    {
+        OGRGeometryCollection* ptrCollection=(OGRGeometryCollection*)ptrGeometry;
+        for(int ng=0;ng<ptrCollection->getNumGeometries();ng++)
+        {
+            OGRGeometry* ptrPart=ptrCollection->getGeometryRef(ng);
+            OGRwkbGeometryType partType=wkbFlatten(ptrPart->getGeometryType());
+            // La interseccion de dos poligonos puede devolver lineas o puntos de contacto sin area
+            if(partType!=wkbPolygon
+                    &&partType!=wkbMultiPolygon
+                    &&partType!=wkbGeometryCollection)
+            {
+                continue;
+            }
+            if(!addGeometry(ptrPart,strError))
+            {
+                return(false);
+            }
+        }
+        return(true);
+    }
+    strError=QObject::tr("RoiCoverageMask::addGeometry");
+    strError+=QObject::tr("\nInvalid geometry type: %1").arg(QString(OGRGeometryTypeToName(geometryType)));
+    return(false);
+}
+
+void RoiCoverageMask::addRing(OGRLinearRing *ptrRing,
+                              bool isInteriorRing)
+{
+    int numberOfPoints=ptrRing->getNumPoints();
+    if(numberOfPoints<3)
+    {
+        return;
+    }
+    // Coordenadas en pixeles respecto a la esquina de la ventana: u hacia el este, v hacia el sur
+    QVector<double> us(numberOfPoints);
+    QVector<double> vs(numberOfPoints);
+    double signedArea=0.0;
+    for(int np=0;np<numberOfPoints;np++)
+    {
+        us[np]=(ptrRing->getX(np)-mNwFc)/mGsd;
+        vs[np]=(mNwSc-ptrRing->getY(np))/mGsd;
+    }
+    for(int np=0;np<numberOfPoints;np++)
+    {
+        int nextPoint=(np+1)%numberOfPoints;
+        signedArea+=us[np]*vs[nextPoint]-us[nextPoint]*vs[np];
+    }
+    if(fabs(signedArea)<=ROICOVERAGEMASK_TOLERANCE)
+    {
+        return;
+    }
+    // Exterior suma e interiores restan, sea cual sea la orientacion de los anillos
+    double sign=(signedArea>0.0)?1.0:-1.0;
+    if(isInteriorRing)
+    {
+        sign=-sign;
+    }
+    for(int np=0;np<numberOfPoints;np++)
+    {
+        int nextPoint=(np+1)%numberOfPoints;
+        addSegment(us[np],vs[np],us[nextPoint],vs[nextPoint],sign);
+    }
+}
+
+void RoiCoverageMask::addSegment(double u0,
+                                 double v0,
+                                 double u1,
+                                 double v1,
+                                 double sign)
+{
+    // area(P ∩ pixel) = integral de contorno de (min(u,c+1)-min(u,c)) dv, recortada a la franja de la fila
+    if(v0==v1)
+    {
+        return;
+    }
+    double minV=qMin(v0,v1);
+    double maxV=qMax(v0,v1);
+    int firstRow=qMax(0,(int)floor(minV));
+    int lastRow=qMin(mNumberOfRows-1,(int)ceil(maxV)-1);
+    for(int row=firstRow;row<=lastRow;row++)
+    {
+        double* ptrCoverages=mCoverages.data()+row*mNumberOfColumns;
+        double* ptrAccumulatedCoverages=mAccumulatedCoverages.data()+row*(mNumberOfColumns+1);
+        // Recorte del lado a la franja [row,row+1]
+        double startT=(qMax((double)row,minV)-v0)/(v1-v0);
+        double endT=(qMin((double)(row+1),maxV)-v0)/(v1-v0);
+        if(startT>endT)
+        {
+            double auxT=startT;
+            startT=endT;
+            endT=auxT;
+        }
+        double startU=u0+startT*(u1-u0);
+        double startV=v0+startT*(v1-v0);
+        double endU=u0+endT*(u1-u0);
+        double endV=v0+endT*(v1-v0);
+        if(startV==endV)
+        {
+            continue;
+        }
+        // Tramos entre los bordes de columna que cruza el lado
+        QVector<double> breakUs;
+        breakUs.push_back(startU);
+        double minU=qMin(startU,endU);
+        double maxU=qMax(startU,endU);
+        int firstBorder=qMax(0,(int)floor(minU)+1);
+        int lastBorder=qMin(mNumberOfColumns,(int)ceil(maxU)-1);
+        if(startU<endU)
+        {
+            for(int border=firstBorder;border<=lastBorder;border++)
+            {
+                breakUs.push_back((double)border);
+            }
+        }
+        else
+        {
+            for(int border=lastBorder;border>=firstBorder;border--)
+            {
+                breakUs.push_back((double)border);
+            }
+        }
+        breakUs.push_back(endU);
+        double pieceStartU=startU;
+        double pieceStartV=startV;
+        for(int nb=1;nb<breakUs.size();nb++)
+        {
+            double pieceEndU=breakUs[nb];
+            double pieceEndV=endV;
+            if(nb<breakUs.size()-1)
+            {
+                pieceEndV=startV+(pieceEndU-startU)/(endU-startU)*(endV-startV);
+            }
+            double pieceDv=sign*(pieceEndV-pieceStartV);
+            double middleU=0.5*(pieceStartU+pieceEndU);
+            int column=(int)floor(middleU);
+            if(column>=mNumberOfColumns)
+            {
+                ptrAccumulatedCoverages[mNumberOfColumns]+=pieceDv;
+            }
+            else if(column>=0)
+            {
+                ptrCoverages[column]+=(middleU-column)*pieceDv;
+                ptrAccumulatedCoverages[column]+=pieceDv;
+            }
+            pieceStartU=pieceEndU;
+            pieceStartV=pieceEndV;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef ROICOVERAGEMASK_H
+#define ROICOVERAGEMASK_H
+
+#include <QString>
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+#define ROICOVERAGEMASK_NONE                        0
+#define ROICOVERAGEMASK_PARTIAL                     1
+#define ROICOVERAGEMASK_FULL                        2
+#define ROICOVERAGEMASK_TOLERANCE                   1.0e-9 // en fraccion de pixel
+
+class OGRGeometry;
+class OGRLinearRing;
+
+namespace RemoteSensing{
+// Mascara de cobertura exacta de un poligono sobre una malla raster (nwFc,nwSc,gsd):
+// se recorre cada fila como una franja y la fraccion de area de cada pixel se
+// integra analiticamente sobre los lados del poligono (teorema de Green), sin
+// construir geometrias por pixel. Solo se almacena la ventana de la envolvente.
+class LIBREMOTESENSINGSHARED_EXPORT RoiCoverageMask
+{
+public:
+    RoiCoverageMask();
+    void clear();
+    int getCoverageType(int column,
+                        int row) const;
+    double getCoverage(int column,
+                       int row) const;
+    int getFirstColumn() const {return(mFirstColumn);}
+    int getFirstRow() const {return(mFirstRow);}
+    int getNumberOfColumns() const {return(mNumberOfColumns);}
+    int getNumberOfRows() const {return(mNumberOfRows);}
+    bool isCovered(int column,
+                   int row) const {return(getCoverageType(column,row)!=ROICOVERAGEMASK_NONE);}
+    bool isEmpty() const {return(mNumberOfColumns==0||mNumberOfRows==0);}
+    bool setFromGeometry(OGRGeometry* ptrGeometry,
+                         double rasterNwFc,
+                         double rasterNwSc,
+                         double rasterGsd,
+                         int rasterColumns,
+                         int rasterRows,
+                         QString& strError);
+private:
+    bool addGeometry(OGRGeometry* ptrGeometry,
+                     QString& strError);
+    void addRing(OGRLinearRing* ptrRing,
+                 bool isInteriorRing);
+    void addSegment(double u0,
+                    double v0,
+                    double u1,
+                    double v1,
+                    double sign);
+    double mNwFc; // esquina noroeste de la ventana
+    double mNwSc;
+    double mGsd;
+    int mFirstColumn;
+    int mFirstRow;
+    int mNumberOfColumns;
+    int mNumberOfRows;
+    QVector<double> mCoverages; // mCoverages[row*mNumberOfColumns+column], relativos a la ventana
+    QVector<double> mAccumulatedCoverages; // aportes a los pixeles a la izquierda, (mNumberOfColumns+1) por fila
+};
+}
+#endif // ROICOVERAGEMASK_H
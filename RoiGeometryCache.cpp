@@ -0,0 +1,327 @@
+#include <QMutexLocker>
+#include <QObject>
+
+#include "RoiGeometryCache.h"
+
+using namespace RemoteSensing;
+
+RoiGeometryCache::RoiGeometryCache()
+{
+
+}
+
+RoiGeometryCache::~RoiGeometryCache()
+{
+    clear();
+}
+
+void RoiGeometryCache::clear()
+{
+    QMutexLocker locker(&mMutex);
+    QMap<QString,OGRPreparedGeometry*>::iterator iterPreparedGeometry=mPtrPreparedGeometryByRoiCode.begin();
+    while(iterPreparedGeometry!=mPtrPreparedGeometryByRoiCode.end())
+    {
+        if(iterPreparedGeometry.value()!=NULL)
+        {
+            OGRDestroyPreparedGeometry(iterPreparedGeometry.value());
+        }
+        iterPreparedGeometry++;
+    }
+    mPtrPreparedGeometryByRoiCode.clear();
+    QMap<QString,OGRGeometry*>::iterator iterRoi=mPtrGeometryByRoiCode.begin();
+    while(iterRoi!=mPtrGeometryByRoiCode.end())
+    {
+        OGRGeometryFactory::destroyGeometry(iterRoi.value());
+        iterRoi++;
+    }
+    mPtrGeometryByRoiCode.clear();
+    QMap<int,OGRGeometry*>::iterator iterTuplekey=mPtrGeometryByTuplekeyId.begin();
+    while(iterTuplekey!=mPtrGeometryByTuplekeyId.end())
+    {
+        OGRGeometryFactory::destroyGeometry(iterTuplekey.value());
+        iterTuplekey++;
+    }
+    mPtrGeometryByTuplekeyId.clear();
+    mAreaByRoiCode.clear();
+    mEnvelopeByRoiCode.clear();
+    mEnvelopeByTuplekeyId.clear();
+    mIntersectsByGeometryKeyByRoiCode.clear();
+    mIntersectsByTuplekeyIdByRoiCode.clear();
+    mContainsByTuplekeyIdByRoiCode.clear();
+}
+
+bool RoiGeometryCache::containsRoi(QString roiCode)
+{
+    QMutexLocker locker(&mMutex);
+    return(mPtrGeometryByRoiCode.contains(roiCode));
+}
+
+bool RoiGeometryCache::containsTuplekey(int tuplekeyId)
+{
+    QMutexLocker locker(&mMutex);
+    return(mPtrGeometryByTuplekeyId.contains(tuplekeyId));
+}
+
+bool RoiGeometryCache::getEnvelope(QString roiCode,
+                                   OGREnvelope &envelope,
+                                   QString &strError)
+{
+    QMutexLocker locker(&mMutex);
+    if(!mEnvelopeByRoiCode.contains(roiCode))
+    {
+        strError=QObject::tr("RoiGeometryCache::getEnvelope");
+        strError+=QObject::tr("\nNot exists ROI: %1").arg(roiCode);
+        return(false);
+    }
+    envelope=mEnvelopeByRoiCode[roiCode];
+    return(true);
+}
+
+bool RoiGeometryCache::getArea(QString roiCode,
+                               double &area,
+                               QString &strError)
+{
+    QMutexLocker locker(&mMutex);
+    if(!mAreaByRoiCode.contains(roiCode))
+    {
+        strError=QObject::tr("RoiGeometryCache::getArea");
+        strError+=QObject::tr("\nNot exists ROI: %1").arg(roiCode);
+        return(false);
+    }
+    area=mAreaByRoiCode[roiCode];
+    return(true);
+}
+
+bool RoiGeometryCache::getIntersects(QString roiCode,
+                                     QString geometryKey,
+                                     OGRGeometry *ptrGeometry,
+                                     bool &intersects,
+                                     QString &strError)
+{
+    QMutexLocker locker(&mMutex);
+    intersects=false;
+    if(!mPtrGeometryByRoiCode.contains(roiCode))
+    {
+        strError=QObject::tr("RoiGeometryCache::getIntersects");
+        strError+=QObject::tr("\nNot exists ROI: %1").arg(roiCode);
+        return(false);
+    }
+    if(mIntersectsByGeometryKeyByRoiCode[roiCode].contains(geometryKey))
+    {
+        intersects=mIntersectsByGeometryKeyByRoiCode[roiCode][geometryKey];
+        return(true);
+    }
+    OGREnvelope envelope;
+    ptrGeometry->getEnvelope(&envelope);
+    if(mEnvelopeByRoiCode[roiCode].Intersects(envelope))
+    {
+        OGRPreparedGeometry* ptrPreparedGeometry=mPtrPreparedGeometryByRoiCode[roiCode];
+        if(ptrPreparedGeometry!=NULL)
+        {
+            intersects=OGRPreparedGeometryIntersects(ptrPreparedGeometry,ptrGeometry);
+        }
+        else
+        {
+            intersects=mPtrGeometryByRoiCode[roiCode]->Intersects(ptrGeometry);
+        }
+    }
+    mIntersectsByGeometryKeyByRoiCode[roiCode][geometryKey]=intersects;
+    return(true);
+}
+
+bool RoiGeometryCache::getRoiTuplekeyIntersectionGeometry(QString roiCode,
+                                                          int tuplekeyId,
+                                                          OGRGeometry *&ptrGeometry,
+                                                          bool &roiContainsTuplekey,
+                                                          QString &strError)
+{
+    ptrGeometry=NULL;
+    roiContainsTuplekey=false;
+    QMutexLocker locker(&mMutex);
+    QString strAuxError;
+    bool intersects=false;
+    if(!getRoiTuplekeyRelation(roiCode,tuplekeyId,intersects,roiContainsTuplekey,strAuxError))
+    {
+        strError=QObject::tr("RoiGeometryCache::getRoiTuplekeyIntersectionGeometry");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    OGRGeometry* ptrTuplekeyGeometry=mPtrGeometryByTuplekeyId[tuplekeyId];
+    if(roiContainsTuplekey)
+    {
+        ptrGeometry=ptrTuplekeyGeometry->clone();
+        return(true);
+    }
+    if(!intersects)
+    {
+        ptrGeometry=OGRGeometryFactory::createGeometry(wkbPolygon);
+        return(true);
+    }
+    // Las copias solo se liberan en clear(): la interseccion se calcula sin bloquear a otros hilos
+    OGRGeometry* ptrRoiGeometry=mPtrGeometryByRoiCode[roiCode];
+    locker.unlock();
+    OGRGeometry* ptrIntersection=ptrRoiGeometry->Intersection(ptrTuplekeyGeometry);
+    if(ptrIntersection==NULL)
+    {
+        strError=QObject::tr("RoiGeometryCache::getRoiTuplekeyIntersectionGeometry");
+        strError+=QObject::tr("\nError intersecting ROI: %1 and tuplekey id: %2")
+                .arg(roiCode).arg(QString::number(tuplekeyId));
+        return(false);
+    }
+    // Se descartan lineas y puntos de contacto
+    OGRwkbGeometryType intersectionType=wkbFlatten(ptrIntersection->getGeometryType());
+    if(intersectionType==wkbPolygon
+            ||intersectionType==wkbMultiPolygon)
+    {
+        ptrGeometry=ptrIntersection;
+        return(true);
+    }
+    OGRMultiPolygon* ptrMultiPolygon=(OGRMultiPolygon*)OGRGeometryFactory::createGeometry(wkbMultiPolygon);
+    if(intersectionType==wkbGeometryCollection)
+    {
+        OGRGeometryCollection* ptrCollection=(OGRGeometryCollection*)ptrIntersection;
+        for(int ng=0;ng<ptrCollection->getNumGeometries();ng++)
+        {
+            OGRGeometry* ptrPart=ptrCollection->getGeometryRef(ng);
+            OGRwkbGeometryType partType=wkbFlatten(ptrPart->getGeometryType());
+            if(partType==wkbPolygon)
+            {
+                ptrMultiPolygon->addGeometry(ptrPart);
+            }
+            else if(partType==wkbMultiPolygon)
+            {
+                OGRMultiPolygon* ptrPartMultiPolygon=(OGRMultiPolygon*)ptrPart;
+                for(int np=0;np<ptrPartMultiPolygon->getNumGeometries();np++)
+                {
+                    ptrMultiPolygon->addGeometry(ptrPartMultiPolygon->getGeometryRef(np));
+                }
+            }
+        }
+    }
+    OGRGeometryFactory::destroyGeometry(ptrIntersection);
+    ptrGeometry=ptrMultiPolygon;
+    return(true);
+}
+
+bool RoiGeometryCache::insertRoi(QString roiCode,
+                                 OGRGeometry *ptrGeometry,
+                                 QString &strError)
+{
+    if(ptrGeometry==NULL)
+    {
+        strError=QObject::tr("RoiGeometryCache::insertRoi");
+        strError+=QObject::tr("\nNull geometry for ROI: %1").arg(roiCode);
+        return(false);
+    }
+    QMutexLocker locker(&mMutex);
+    if(mPtrGeometryByRoiCode.contains(roiCode))
+    {
+        strError=QObject::tr("RoiGeometryCache::insertRoi");
+        strError+=QObject::tr("\nExists ROI: %1").arg(roiCode);
+        return(false);
+    }
+    OGRGeometry* ptrRoiGeometry=ptrGeometry->clone();
+    OGREnvelope envelope;
+    ptrRoiGeometry->getEnvelope(&envelope);
+    double area=0.0;
+    OGRwkbGeometryType geometryType=wkbFlatten(ptrRoiGeometry->getGeometryType());
+    if(geometryType==wkbPolygon)
+    {
+        area=((OGRPolygon*)ptrRoiGeometry)->get_Area();
+    }
+    else if(geometryType==wkbMultiPolygon
+            ||geometryType==wkbGeometryCollection)
+    {
+        area=((OGRGeometryCollection*)ptrRoiGeometry)->get_Area();
+    }
+    OGRPreparedGeometry* ptrPreparedGeometry=NULL;
+    if(OGRHasPreparedGeometrySupport())
+    {
+        ptrPreparedGeometry=OGRCreatePreparedGeometry(ptrRoiGeometry);
+    }
+    mPtrGeometryByRoiCode[roiCode]=ptrRoiGeometry;
+    mEnvelopeByRoiCode[roiCode]=envelope;
+    mAreaByRoiCode[roiCode]=area;
+    mPtrPreparedGeometryByRoiCode[roiCode]=ptrPreparedGeometry;
+    return(true);
+}
+
+bool RoiGeometryCache::insertTuplekey(int tuplekeyId,
+                                      OGRGeometry *ptrGeometry,
+                                      QString &strError)
+{
+    if(ptrGeometry==NULL)
+    {
+        strError=QObject::tr("RoiGeometryCache::insertTuplekey");
+        strError+=QObject::tr("\nNull geometry for tuplekey id: %1").arg(QString::number(tuplekeyId));
+        return(false);
+    }
+    QMutexLocker locker(&mMutex);
+    if(mPtrGeometryByTuplekeyId.contains(tuplekeyId))
+    {
+        return(true);
+    }
+    OGRGeometry* ptrTuplekeyGeometry=ptrGeometry->clone();
+    OGREnvelope envelope;
+    ptrTuplekeyGeometry->getEnvelope(&envelope);
+    mPtrGeometryByTuplekeyId[tuplekeyId]=ptrTuplekeyGeometry;
+    mEnvelopeByTuplekeyId[tuplekeyId]=envelope;
+    return(true);
+}
+
+bool RoiGeometryCache::getRoiTuplekeyRelation(QString roiCode,
+                                              int tuplekeyId,
+                                              bool &intersects,
+                                              bool &contains,
+                                              QString &strError)
+{
+    // Se llama con el mutex bloqueado
+    intersects=false;
+    contains=false;
+    if(!mPtrGeometryByRoiCode.contains(roiCode))
+    {
+        strError=QObject::tr("RoiGeometryCache::getRoiTuplekeyRelation");
+        strError+=QObject::tr("\nNot exists ROI: %1").arg(roiCode);
+        return(false);
+    }
+    if(!mPtrGeometryByTuplekeyId.contains(tuplekeyId))
+    {
+        strError=QObject::tr("RoiGeometryCache::getRoiTuplekeyRelation");
+        strError+=QObject::tr("\nNot exists tuplekey id: %1").arg(QString::number(tuplekeyId));
+        return(false);
+    }
+    if(mIntersectsByTuplekeyIdByRoiCode[roiCode].contains(tuplekeyId))
+    {
+        intersects=mIntersectsByTuplekeyIdByRoiCode[roiCode][tuplekeyId];
+        contains=mContainsByTuplekeyIdByRoiCode[roiCode][tuplekeyId];
+        return(true);
+    }
+    const OGREnvelope& roiEnvelope=mEnvelopeByRoiCode[roiCode];
+    const OGREnvelope& tuplekeyEnvelope=mEnvelopeByTuplekeyId[tuplekeyId];
+    if(roiEnvelope.Intersects(tuplekeyEnvelope))
+    {
+        OGRGeometry* ptrTuplekeyGeometry=mPtrGeometryByTuplekeyId[tuplekeyId];
+        OGRPreparedGeometry* ptrPreparedGeometry=mPtrPreparedGeometryByRoiCode[roiCode];
+        if(ptrPreparedGeometry!=NULL)
+        {
+            intersects=OGRPreparedGeometryIntersects(ptrPreparedGeometry,ptrTuplekeyGeometry);
+            // Si la envolvente del ROI no contiene la del tuplekey, el ROI no puede contenerlo
+            if(intersects&&roiEnvelope.Contains(tuplekeyEnvelope))
+            {
+                contains=OGRPreparedGeometryContains(ptrPreparedGeometry,ptrTuplekeyGeometry);
+            }
+        }
+        else
+        {
+            OGRGeometry* ptrRoiGeometry=mPtrGeometryByRoiCode[roiCode];
+            intersects=ptrRoiGeometry->Intersects(ptrTuplekeyGeometry);
+            if(intersects&&roiEnvelope.Contains(tuplekeyEnvelope))
+            {
+                contains=ptrRoiGeometry->Contains(ptrTuplekeyGeometry);
+            }
+        }
+    }
+    mIntersectsByTuplekeyIdByRoiCode[roiCode][tuplekeyId]=intersects;
+    mContainsByTuplekeyIdByRoiCode[roiCode][tuplekeyId]=contains;
+    return(true);
+}
@@ -0,0 +1,65 @@
+#ifndef ROIGEOMETRYCACHE_H
+#define ROIGEOMETRYCACHE_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+#include <ogr_geometry.h>
+
+#include "libremotesensing_global.h"
+
+namespace RemoteSensing{
+// Geometrias de los ROIs para toda una ejecucion: copia de cada ROI con su envolvente
+// y area, su geometria preparada de GEOS, geometrias de los tuplekeys y resultados de los
+// contrastes ROI-tuplekey ya calculados. Las consultas estan protegidas por un mutex
+// porque las geometrias preparadas no admiten uso concurrente.
+class LIBREMOTESENSINGSHARED_EXPORT RoiGeometryCache
+{
+public:
+    RoiGeometryCache();
+    ~RoiGeometryCache();
+    void clear();
+    bool containsRoi(QString roiCode);
+    bool containsTuplekey(int tuplekeyId);
+    bool getArea(QString roiCode,
+                 double& area,
+                 QString& strError);
+    bool getEnvelope(QString roiCode,
+                     OGREnvelope& envelope,
+                     QString& strError);
+    bool getIntersects(QString roiCode,
+                       QString geometryKey,
+                       OGRGeometry* ptrGeometry,
+                       bool& intersects,
+                       QString& strError);
+    bool getRoiTuplekeyIntersectionGeometry(QString roiCode,
+                                            int tuplekeyId,
+                                            OGRGeometry*& ptrGeometry,
+                                            bool& roiContainsTuplekey,
+                                            QString& strError);
+    bool insertRoi(QString roiCode,
+                   OGRGeometry* ptrGeometry,
+                   QString& strError);
+    bool insertTuplekey(int tuplekeyId,
+                        OGRGeometry* ptrGeometry,
+                        QString& strError);
+private:
+    bool getRoiTuplekeyRelation(QString roiCode,
+                                int tuplekeyId,
+                                bool& intersects,
+                                bool& contains,
+                                QString& strError);
+    QMap<QString,OGRGeometry*> mPtrGeometryByRoiCode; // copias propias
+    QMap<QString,double> mAreaByRoiCode;
+    QMap<QString,OGREnvelope> mEnvelopeByRoiCode;
+    QMap<QString,OGRPreparedGeometry*> mPtrPreparedGeometryByRoiCode;
+    QMap<int,OGRGeometry*> mPtrGeometryByTuplekeyId; // copias propias
+    QMap<int,OGREnvelope> mEnvelopeByTuplekeyId;
+    QMap<QString,QMap<QString,bool> > mIntersectsByGeometryKeyByRoiCode;
+    QMap<QString,QMap<int,bool> > mIntersectsByTuplekeyIdByRoiCode;
+    QMap<QString,QMap<int,bool> > mContainsByTuplekeyIdByRoiCode;
+    QMutex mMutex;
+};
+}
+#endif // ROIGEOMETRYCACHE_H
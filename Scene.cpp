@@ -1,16 +1,773 @@
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <gdalwarper.h>
+#include <ogr_spatialref.h>
+#include <cpl_string.h>
+
+#include <math.h>
+
+#include <algorithm>
+
 #include "Scene.h"
+#include "StrRTree.h"
+#include "CloudOptimizedGeoTiff.h"
+#include "Raster.h"
+#include "NestedGridTools.h"
 #include "NestedGridProject.h"
 #include "remotesensing_definitions.h"
 
 using namespace RemoteSensing;
 
+namespace{
+// Limites de concurrencia de la ingestion por lotes: calculo (warp, remuestreo) y escritura/lectura a disco
+struct ConcurrencyLimits
+{
+    QSemaphore* ptrCpuSemaphore;
+    QSemaphore* ptrIoSemaphore;
+};
+
+class ConcurrencyPermit
+{
+public:
+    ConcurrencyPermit(QSemaphore* ptrSemaphore):
+        mPtrSemaphore(ptrSemaphore)
+    {
+        if(mPtrSemaphore!=NULL)
+        {
+            mPtrSemaphore->acquire();
+        }
+    }
+    ~ConcurrencyPermit()
+    {
+        release();
+    }
+    void release()
+    {
+        if(mPtrSemaphore!=NULL)
+        {
+            mPtrSemaphore->release();
+            mPtrSemaphore=NULL;
+        }
+    }
+private:
+    QSemaphore* mPtrSemaphore;
+};
+
+// Libera el estado compartido mientras se hace trabajo que solo usa GDAL
+class SharedStateUnlocker
+{
+public:
+    SharedStateUnlocker(QMutex* ptrMutex):
+        mPtrMutex(ptrMutex)
+    {
+        if(mPtrMutex!=NULL)
+        {
+            mPtrMutex->unlock();
+        }
+    }
+    ~SharedStateUnlocker()
+    {
+        if(mPtrMutex!=NULL)
+        {
+            mPtrMutex->lock();
+        }
+    }
+private:
+    QMutex* mPtrMutex;
+};
+
+// Mismos nombres que aceptan gdalwarp, gdal_translate y gdaladdo -r
+bool getResampleAlgorithms(QString resamplingMethod,
+                           GDALResampleAlg& resampleAlg,
+                           GDALRIOResampleAlg& rioResampleAlg)
+{
+    QString strResamplingMethod=resamplingMethod.toLower();
+    if(strResamplingMethod.compare("near")==0
+            ||strResamplingMethod.compare("nearest")==0)
+    {
+        resampleAlg=GRA_NearestNeighbour;
+        rioResampleAlg=GRIORA_NearestNeighbour;
+    }
+    else if(strResamplingMethod.compare("bilinear")==0)
+    {
+        resampleAlg=GRA_Bilinear;
+        rioResampleAlg=GRIORA_Bilinear;
+    }
+    else if(strResamplingMethod.compare("cubic")==0)
+    {
+        resampleAlg=GRA_Cubic;
+        rioResampleAlg=GRIORA_Cubic;
+    }
+    else if(strResamplingMethod.compare("cubicspline")==0)
+    {
+        resampleAlg=GRA_CubicSpline;
+        rioResampleAlg=GRIORA_CubicSpline;
+    }
+    else if(strResamplingMethod.compare("lanczos")==0)
+    {
+        resampleAlg=GRA_Lanczos;
+        rioResampleAlg=GRIORA_Lanczos;
+    }
+    else if(strResamplingMethod.compare("average")==0)
+    {
+        resampleAlg=GRA_Average;
+        rioResampleAlg=GRIORA_Average;
+    }
+    else if(strResamplingMethod.compare("mode")==0)
+    {
+        resampleAlg=GRA_Mode;
+        rioResampleAlg=GRIORA_Mode;
+    }
+    else
+    {
+        return(false);
+    }
+    return(true);
+}
+
+int getNumberOfThreads(int numberOfThreads)
+{
+    if(numberOfThreads<=0)
+    {
+        numberOfThreads=QThread::idealThreadCount();
+    }
+    if(numberOfThreads<1)
+    {
+        numberOfThreads=1;
+    }
+    return(numberOfThreads);
+}
+
+// Reproyeccion de un fichero con la API de GDALWarp, equivalente a:
+// gdalwarp -s_srs -t_srs -r -srcnodata -dstnodata -of GTiff
+class ReprojectionTask : public QRunnable
+{
+public:
+    ReprojectionTask(QString inputFileName,
+                     QString outputFileName,
+                     QString inputWktCrs,
+                     QString outputWktCrs,
+                     GDALResampleAlg resampleAlg,
+                     double noDataValue,
+                     double warpMemoryLimit,
+                     int numberOfWarpThreads,
+                     QVector<double> outputEnvelope,
+                     ConcurrencyLimits concurrencyLimits):
+        mInputFileName(inputFileName),
+        mOutputFileName(outputFileName),
+        mInputWktCrs(inputWktCrs),
+        mOutputWktCrs(outputWktCrs),
+        mResampleAlg(resampleAlg),
+        mNoDataValue(noDataValue),
+        mWarpMemoryLimit(warpMemoryLimit),
+        mNumberOfWarpThreads(numberOfWarpThreads),
+        mOutputEnvelope(outputEnvelope),
+        mConcurrencyLimits(concurrencyLimits),
+        mSuccess(false)
+    {
+        setAutoDelete(false);
+    }
+    void run();
+    bool getSuccess(){return(mSuccess);}
+    QString getError(){return(mStrError);}
+private:
+    QString mInputFileName;
+    QString mOutputFileName;
+    QString mInputWktCrs;
+    QString mOutputWktCrs;
+    GDALResampleAlg mResampleAlg;
+    double mNoDataValue;
+    double mWarpMemoryLimit;
+    int mNumberOfWarpThreads;
+    QVector<double> mOutputEnvelope; // minX,minY,maxX,maxY; vacio: toda la extension
+    ConcurrencyLimits mConcurrencyLimits;
+    bool mSuccess;
+    QString mStrError;
+};
+
+void ReprojectionTask::run()
+{
+    ConcurrencyPermit cpuPermit(mConcurrencyLimits.ptrCpuSemaphore);
+    GDALDatasetH hSrcDS=GDALOpen(mInputFileName.toStdString().c_str(),GA_ReadOnly);
+    if(hSrcDS==NULL)
+    {
+        mStrError=QObject::tr("Error opening file:\n%1").arg(mInputFileName);
+        return;
+    }
+    QByteArray inputWkt=mInputWktCrs.toLatin1();
+    QByteArray outputWkt=mOutputWktCrs.toLatin1();
+    void* ptrTransformArg=GDALCreateGenImgProjTransformer(hSrcDS,inputWkt.constData(),
+                                                          NULL,outputWkt.constData(),
+                                                          FALSE,0.0,1);
+    if(ptrTransformArg==NULL)
+    {
+        mStrError=QObject::tr("Error creating transformer for file:\n%1").arg(mInputFileName);
+        GDALClose(hSrcDS);
+        return;
+    }
+    double geoTransform[6];
+    int numberOfColumns=0;
+    int numberOfRows=0;
+    CPLErr eErr=GDALSuggestedWarpOutput(hSrcDS,GDALGenImgProjTransform,ptrTransformArg,
+                                        geoTransform,&numberOfColumns,&numberOfRows);
+    GDALDestroyGenImgProjTransformer(ptrTransformArg);
+    if(eErr!=CE_None)
+    {
+        mStrError=QObject::tr("Error computing output extent for file:\n%1").arg(mInputFileName);
+        GDALClose(hSrcDS);
+        return;
+    }
+    if(mOutputEnvelope.size()==4)
+    {
+        // Recorte a la huella de la escena, en la misma malla de pixeles
+        int firstColumn=qMax(0,(int)floor((mOutputEnvelope[0]-geoTransform[0])/geoTransform[1]));
+        int endColumn=qMin(numberOfColumns,(int)ceil((mOutputEnvelope[2]-geoTransform[0])/geoTransform[1]));
+        int firstRow=qMax(0,(int)floor((mOutputEnvelope[3]-geoTransform[3])/geoTransform[5]));
+        int endRow=qMin(numberOfRows,(int)ceil((mOutputEnvelope[1]-geoTransform[3])/geoTransform[5]));
+        if(endColumn>firstColumn&&endRow>firstRow)
+        {
+            geoTransform[0]+=firstColumn*geoTransform[1];
+            geoTransform[3]+=firstRow*geoTransform[5];
+            numberOfColumns=endColumn-firstColumn;
+            numberOfRows=endRow-firstRow;
+        }
+    }
+    int numberOfBands=GDALGetRasterCount(hSrcDS);
+    GDALDataType gdalDataType=GDALGetRasterDataType(GDALGetRasterBand(hSrcDS,1));
+    GDALDriverH hDriver=GDALGetDriverByName(REMOTESENSING_REPROJECTION_OUTPUT_FORMAT);
+    GDALDatasetH hDstDS=GDALCreate(hDriver,mOutputFileName.toStdString().c_str(),
+                                   numberOfColumns,numberOfRows,numberOfBands,
+                                   gdalDataType,NULL);
+    if(hDstDS==NULL)
+    {
+        mStrError=QObject::tr("Error creating file:\n%1").arg(mOutputFileName);
+        GDALClose(hSrcDS);
+        return;
+    }
+    GDALSetProjection(hDstDS,outputWkt.constData());
+    GDALSetGeoTransform(hDstDS,geoTransform);
+    GDALWarpOptions* ptrWarpOptions=GDALCreateWarpOptions();
+    ptrWarpOptions->hSrcDS=hSrcDS;
+    ptrWarpOptions->hDstDS=hDstDS;
+    ptrWarpOptions->eResampleAlg=mResampleAlg;
+    ptrWarpOptions->dfWarpMemoryLimit=mWarpMemoryLimit;
+    ptrWarpOptions->nBandCount=numberOfBands;
+    ptrWarpOptions->panSrcBands=(int*)CPLMalloc(sizeof(int)*numberOfBands);
+    ptrWarpOptions->panDstBands=(int*)CPLMalloc(sizeof(int)*numberOfBands);
+    ptrWarpOptions->padfSrcNoDataReal=(double*)CPLMalloc(sizeof(double)*numberOfBands);
+    ptrWarpOptions->padfSrcNoDataImag=(double*)CPLCalloc(numberOfBands,sizeof(double));
+    ptrWarpOptions->padfDstNoDataReal=(double*)CPLMalloc(sizeof(double)*numberOfBands);
+    ptrWarpOptions->padfDstNoDataImag=(double*)CPLCalloc(numberOfBands,sizeof(double));
+    for(int nb=0;nb<numberOfBands;nb++)
+    {
+        ptrWarpOptions->panSrcBands[nb]=nb+1;
+        ptrWarpOptions->panDstBands[nb]=nb+1;
+        ptrWarpOptions->padfSrcNoDataReal[nb]=mNoDataValue;
+        ptrWarpOptions->padfDstNoDataReal[nb]=mNoDataValue;
+        GDALSetRasterNoDataValue(GDALGetRasterBand(hDstDS,nb+1),mNoDataValue);
+    }
+    ptrWarpOptions->papszWarpOptions=CSLSetNameValue(ptrWarpOptions->papszWarpOptions,
+                                                     "INIT_DEST","NO_DATA");
+    ptrWarpOptions->papszWarpOptions=CSLSetNameValue(ptrWarpOptions->papszWarpOptions,
+                                                     "NUM_THREADS",
+                                                     QString::number(mNumberOfWarpThreads).toLatin1().constData());
+    ptrWarpOptions->pTransformerArg=GDALCreateGenImgProjTransformer(hSrcDS,inputWkt.constData(),
+                                                                    hDstDS,outputWkt.constData(),
+                                                                    FALSE,0.0,1);
+    ptrWarpOptions->pfnTransformer=GDALGenImgProjTransform;
+    GDALWarpOperation warpOperation;
+    eErr=warpOperation.Initialize(ptrWarpOptions);
+    if(eErr==CE_None)
+    {
+        eErr=warpOperation.ChunkAndWarpMulti(0,0,numberOfColumns,numberOfRows);
+    }
+    if(eErr!=CE_None)
+    {
+        mStrError=QObject::tr("Error warping file:\n%1\nGDAL error:\n%2")
+                .arg(mInputFileName).arg(QString(CPLGetLastErrorMsg()));
+    }
+    else
+    {
+        mSuccess=true;
+    }
+    GDALDestroyGenImgProjTransformer(ptrWarpOptions->pTransformerArg);
+    GDALDestroyWarpOptions(ptrWarpOptions);
+    GDALClose(hDstDS);
+    GDALClose(hSrcDS);
+}
+
+// VRT de reproyeccion: los pixeles se reproyectan al leerlos, no se escribe el fichero reproyectado
+bool createWarpedVrt(QString inputFileName,
+                     QString outputFileName,
+                     QString inputWktCrs,
+                     QString outputWktCrs,
+                     GDALResampleAlg resampleAlg,
+                     double noDataValue,
+                     double warpMemoryLimit,
+                     int numberOfWarpThreads,
+                     QString& strError)
+{
+    GDALDatasetH hSrcDS=GDALOpen(inputFileName.toStdString().c_str(),GA_ReadOnly);
+    if(hSrcDS==NULL)
+    {
+        strError=QObject::tr("Error opening file:\n%1").arg(inputFileName);
+        return(false);
+    }
+    int numberOfBands=GDALGetRasterCount(hSrcDS);
+    GDALWarpOptions* ptrWarpOptions=GDALCreateWarpOptions();
+    ptrWarpOptions->dfWarpMemoryLimit=warpMemoryLimit;
+    ptrWarpOptions->nBandCount=numberOfBands;
+    ptrWarpOptions->panSrcBands=(int*)CPLMalloc(sizeof(int)*numberOfBands);
+    ptrWarpOptions->panDstBands=(int*)CPLMalloc(sizeof(int)*numberOfBands);
+    ptrWarpOptions->padfSrcNoDataReal=(double*)CPLMalloc(sizeof(double)*numberOfBands);
+    ptrWarpOptions->padfSrcNoDataImag=(double*)CPLCalloc(numberOfBands,sizeof(double));
+    ptrWarpOptions->padfDstNoDataReal=(double*)CPLMalloc(sizeof(double)*numberOfBands);
+    ptrWarpOptions->padfDstNoDataImag=(double*)CPLCalloc(numberOfBands,sizeof(double));
+    for(int nb=0;nb<numberOfBands;nb++)
+    {
+        ptrWarpOptions->panSrcBands[nb]=nb+1;
+        ptrWarpOptions->panDstBands[nb]=nb+1;
+        ptrWarpOptions->padfSrcNoDataReal[nb]=noDataValue;
+        ptrWarpOptions->padfDstNoDataReal[nb]=noDataValue;
+    }
+    ptrWarpOptions->papszWarpOptions=CSLSetNameValue(ptrWarpOptions->papszWarpOptions,
+                                                     "INIT_DEST","NO_DATA");
+    ptrWarpOptions->papszWarpOptions=CSLSetNameValue(ptrWarpOptions->papszWarpOptions,
+                                                     "NUM_THREADS",
+                                                     QString::number(numberOfWarpThreads).toLatin1().constData());
+    QByteArray inputWkt=inputWktCrs.toLatin1();
+    QByteArray outputWkt=outputWktCrs.toLatin1();
+    GDALDatasetH hWarpedDS=GDALAutoCreateWarpedVRT(hSrcDS,inputWkt.constData(),outputWkt.constData(),
+                                                   resampleAlg,0.0,ptrWarpOptions);
+    GDALDestroyWarpOptions(ptrWarpOptions);
+    if(hWarpedDS==NULL)
+    {
+        strError=QObject::tr("Error creating warped VRT for file:\n%1\nGDAL error:\n%2")
+                .arg(inputFileName).arg(QString(CPLGetLastErrorMsg()));
+        GDALClose(hSrcDS);
+        return(false);
+    }
+    for(int nb=0;nb<numberOfBands;nb++)
+    {
+        GDALSetRasterNoDataValue(GDALGetRasterBand(hWarpedDS,nb+1),noDataValue);
+    }
+    GDALDatasetH hVrtDS=GDALCreateCopy(GDALGetDriverByName("VRT"),outputFileName.toStdString().c_str(),
+                                       hWarpedDS,FALSE,NULL,NULL,NULL);
+    bool success=(hVrtDS!=NULL);
+    if(!success)
+    {
+        strError=QObject::tr("Error writing warped VRT file:\n%1\nGDAL error:\n%2")
+                .arg(outputFileName).arg(QString(CPLGetLastErrorMsg()));
+    }
+    else
+    {
+        GDALClose(hVrtDS);
+    }
+    GDALClose(hWarpedDS);
+    GDALClose(hSrcDS);
+    return(success);
+}
+
+// Ventana de un tuplekey sobre el fichero de entrada, en pixeles del fichero de entrada
+// El fichero de salida solo se crea cuando aparece el primer pixel valido
+struct TileWindow
+{
+    QString fileName;
+    GDALDatasetH hDS;
+    double geoTransform[6];
+    qint64 numberOfValidPixels;
+    int size;
+    double sourceX;
+    double sourceY;
+    double sourceColumnsByPixel;
+    double sourceRowsByPixel;
+    int sourceMargin;
+    int firstDataRow;
+    int endDataRow;
+    int firstDataColumn;
+    int endDataColumn;
+    int nextRow;
+};
+
+// Calcula y escribe las filas [firstRow,endRow) de un tuplekey a partir de la franja leida
+class TileRowsTask : public QRunnable
+{
+public:
+    TileRowsTask(TileWindow* ptrTileWindow,
+                 GDALDriverH hDriver,
+                 char** ptrCreationOptions,
+                 QByteArray projection,
+                 int firstRow,
+                 int endRow,
+                 GByte* ptrStripData,
+                 int stripFirstRow,
+                 int stripColumns,
+                 int stripRows,
+                 GDALDataType gdalDataType,
+                 GDALRIOResampleAlg rioResampleAlg,
+                 double noDataValue,
+                 ConcurrencyLimits concurrencyLimits):
+        mPtrTileWindow(ptrTileWindow),
+        mHDriver(hDriver),
+        mPtrCreationOptions(ptrCreationOptions),
+        mProjection(projection),
+        mFirstRow(firstRow),
+        mEndRow(endRow),
+        mPtrStripData(ptrStripData),
+        mStripFirstRow(stripFirstRow),
+        mStripColumns(stripColumns),
+        mStripRows(stripRows),
+        mGdalDataType(gdalDataType),
+        mRioResampleAlg(rioResampleAlg),
+        mNoDataValue(noDataValue),
+        mConcurrencyLimits(concurrencyLimits),
+        mSuccess(false)
+    {
+        setAutoDelete(false);
+    }
+    void run();
+    bool getSuccess(){return(mSuccess);}
+    QString getError(){return(mStrError);}
+private:
+    bool createDataset();
+    TileWindow* mPtrTileWindow;
+    GDALDriverH mHDriver;
+    char** mPtrCreationOptions;
+    QByteArray mProjection;
+    int mFirstRow;
+    int mEndRow;
+    GByte* mPtrStripData;
+    int mStripFirstRow;
+    int mStripColumns;
+    int mStripRows;
+    GDALDataType mGdalDataType;
+    GDALRIOResampleAlg mRioResampleAlg;
+    double mNoDataValue;
+    ConcurrencyLimits mConcurrencyLimits;
+    bool mSuccess;
+    QString mStrError;
+};
+
+void TileRowsTask::run()
+{
+    ConcurrencyPermit cpuPermit(mConcurrencyLimits.ptrCpuSemaphore);
+    int bytesByPixel=GDALGetDataTypeSize(mGdalDataType)/8;
+    int size=mPtrTileWindow->size;
+    int numberOfRows=mEndRow-mFirstRow;
+    QVector<GByte> buffer(size*numberOfRows*bytesByPixel);
+    GDALCopyWords(&mNoDataValue,GDT_Float64,0,
+                  buffer.data(),mGdalDataType,bytesByPixel,
+                  size*numberOfRows);
+    QVector<GByte> noDataPixel(bytesByPixel);
+    GDALCopyWords(&mNoDataValue,GDT_Float64,0,
+                  noDataPixel.data(),mGdalDataType,bytesByPixel,1);
+    int firstDataRow=qMax(mFirstRow,mPtrTileWindow->firstDataRow);
+    int endDataRow=qMin(mEndRow,mPtrTileWindow->endDataRow);
+    int firstDataColumn=mPtrTileWindow->firstDataColumn;
+    int endDataColumn=mPtrTileWindow->endDataColumn;
+    if(endDataRow>firstDataRow&&endDataColumn>firstDataColumn)
+    {
+        // Un dataset MEM por tarea sobre la memoria compartida de la franja, solo lectura
+        char strPointer[64];
+        memset(strPointer,0,sizeof(strPointer));
+        CPLPrintPointer(strPointer,mPtrStripData,sizeof(strPointer));
+        QString memDatasetName=QString("MEM:::DATAPOINTER=%1,PIXELS=%2,LINES=%3,BANDS=1,DATATYPE=%4")
+                .arg(QString(strPointer)).arg(mStripColumns).arg(mStripRows)
+                .arg(QString(GDALGetDataTypeName(mGdalDataType)));
+        GDALDatasetH hStripDS=GDALOpen(memDatasetName.toLatin1().constData(),GA_ReadOnly);
+        if(hStripDS==NULL)
+        {
+            mStrError=QObject::tr("Error opening memory dataset for strip");
+            return;
+        }
+        // Sin valor nulo en la banda el remuestreo mezcla los nulos con los pixeles validos del
+        // borde. Si no se puede establecer se usa el vecino mas proximo
+        GDALRIOResampleAlg rioResampleAlg=mRioResampleAlg;
+        if(GDALSetRasterNoDataValue(GDALGetRasterBand(hStripDS,1),mNoDataValue)!=CE_None)
+        {
+            rioResampleAlg=GRIORA_NearestNeighbour;
+        }
+        GDALRasterIOExtraArg extraArg;
+        INIT_RASTERIO_EXTRA_ARG(extraArg);
+        extraArg.eResampleAlg=rioResampleAlg;
+        extraArg.bFloatingPointWindowValidity=TRUE;
+        extraArg.dfXOff=mPtrTileWindow->sourceX+firstDataColumn*mPtrTileWindow->sourceColumnsByPixel;
+        extraArg.dfYOff=mPtrTileWindow->sourceY+firstDataRow*mPtrTileWindow->sourceRowsByPixel-mStripFirstRow;
+        extraArg.dfXSize=(endDataColumn-firstDataColumn)*mPtrTileWindow->sourceColumnsByPixel;
+        extraArg.dfYSize=(endDataRow-firstDataRow)*mPtrTileWindow->sourceRowsByPixel;
+        int xOff=qMax(0,(int)floor(extraArg.dfXOff));
+        int yOff=qMax(0,(int)floor(extraArg.dfYOff));
+        int xEnd=qMin(mStripColumns,(int)ceil(extraArg.dfXOff+extraArg.dfXSize));
+        int yEnd=qMin(mStripRows,(int)ceil(extraArg.dfYOff+extraArg.dfYSize));
+        GByte* ptrData=buffer.data()+((firstDataRow-mFirstRow)*size+firstDataColumn)*bytesByPixel;
+        CPLErr eErr=GDALRasterIOEx(GDALGetRasterBand(hStripDS,1),GF_Read,
+                                   xOff,yOff,xEnd-xOff,yEnd-yOff,
+                                   ptrData,endDataColumn-firstDataColumn,endDataRow-firstDataRow,
+                                   mGdalDataType,bytesByPixel,size*bytesByPixel,
+                                   &extraArg);
+        GDALClose(hStripDS);
+        if(eErr!=CE_None)
+        {
+            mStrError=QObject::tr("Error resampling strip\nGDAL error:\n%1").arg(QString(CPLGetLastErrorMsg()));
+            return;
+        }
+        // Conteo barato de pixeles validos sobre lo ya calculado
+        for(int nr=firstDataRow;nr<endDataRow;nr++)
+        {
+            GByte* ptrPixel=buffer.data()+((nr-mFirstRow)*size+firstDataColumn)*bytesByPixel;
+            for(int nc=firstDataColumn;nc<endDataColumn;nc++)
+            {
+                if(memcmp(ptrPixel,noDataPixel.data(),bytesByPixel)!=0)
+                {
+                    mPtrTileWindow->numberOfValidPixels++;
+                }
+                ptrPixel+=bytesByPixel;
+            }
+        }
+    }
+    cpuPermit.release();
+    if(mPtrTileWindow->hDS==NULL)
+    {
+        if(mPtrTileWindow->numberOfValidPixels==0)
+        {
+            // Filas sin datos: no se escriben hasta saber que el tuplekey no esta vacio
+            mSuccess=true;
+            return;
+        }
+    }
+    ConcurrencyPermit ioPermit(mConcurrencyLimits.ptrIoSemaphore);
+    if(mPtrTileWindow->hDS==NULL)
+    {
+        if(!createDataset())
+        {
+            return;
+        }
+    }
+    if(GDALRasterIO(GDALGetRasterBand(mPtrTileWindow->hDS,1),GF_Write,
+                    0,mFirstRow,size,numberOfRows,
+                    buffer.data(),size,numberOfRows,mGdalDataType,0,0)!=CE_None)
+    {
+        mStrError=QObject::tr("Error writing rows\nGDAL error:\n%1").arg(QString(CPLGetLastErrorMsg()));
+        return;
+    }
+    mSuccess=true;
+}
+
+bool TileRowsTask::createDataset()
+{
+    int size=mPtrTileWindow->size;
+    mPtrTileWindow->hDS=GDALCreate(mHDriver,mPtrTileWindow->fileName.toStdString().c_str(),
+                                   size,size,1,mGdalDataType,mPtrCreationOptions);
+    if(mPtrTileWindow->hDS==NULL)
+    {
+        mStrError=QObject::tr("Error creating file:\n%1").arg(mPtrTileWindow->fileName);
+        return(false);
+    }
+    GDALSetGeoTransform(mPtrTileWindow->hDS,mPtrTileWindow->geoTransform);
+    GDALSetProjection(mPtrTileWindow->hDS,mProjection.constData());
+    GDALRasterBandH hBand=GDALGetRasterBand(mPtrTileWindow->hDS,1);
+    GDALSetRasterNoDataValue(hBand,mNoDataValue);
+    // Las filas anteriores no se escribieron porque no tenian datos
+    int bytesByPixel=GDALGetDataTypeSize(mGdalDataType)/8;
+    QVector<GByte> noDataRow(size*bytesByPixel);
+    GDALCopyWords(&mNoDataValue,GDT_Float64,0,
+                  noDataRow.data(),mGdalDataType,bytesByPixel,size);
+    for(int nr=0;nr<mFirstRow;nr++)
+    {
+        if(GDALRasterIO(hBand,GF_Write,0,nr,size,1,
+                        noDataRow.data(),size,1,mGdalDataType,0,0)!=CE_None)
+        {
+            mStrError=QObject::tr("Error writing rows\nGDAL error:\n%1").arg(QString(CPLGetLastErrorMsg()));
+            return(false);
+        }
+    }
+    return(true);
+}
+
+// Overviews (equivalente a gdaladdo) y cierre de un tuplekey
+class TileCloseTask : public QRunnable
+{
+public:
+    TileCloseTask(QString fileName,
+                  GDALDatasetH hDS,
+                  QVector<int> overviewFactors,
+                  QString overviewResampling,
+                  bool cogOutput,
+                  ConcurrencyLimits concurrencyLimits):
+        mFileName(fileName),
+        mHDS(hDS),
+        mOverviewFactors(overviewFactors),
+        mOverviewResampling(overviewResampling),
+        mCogOutput(cogOutput),
+        mConcurrencyLimits(concurrencyLimits),
+        mSuccess(false)
+    {
+        setAutoDelete(false);
+    }
+    void run();
+    bool getSuccess(){return(mSuccess);}
+    QString getError(){return(mStrError);}
+    QString getFileName(){return(mFileName);}
+private:
+    QString mFileName;
+    GDALDatasetH mHDS;
+    QVector<int> mOverviewFactors;
+    QString mOverviewResampling;
+    bool mCogOutput; // mHDS en memoria, se copia a COG con sus overviews en una sola escritura
+    ConcurrencyLimits mConcurrencyLimits;
+    bool mSuccess;
+    QString mStrError;
+};
+
+void TileCloseTask::run()
+{
+    ConcurrencyPermit ioPermit(mConcurrencyLimits.ptrIoSemaphore);
+    if(mOverviewFactors.size()>0)
+    {
+        if(GDALBuildOverviews(mHDS,mOverviewResampling.toLatin1().constData(),
+                              mOverviewFactors.size(),mOverviewFactors.data(),
+                              0,NULL,NULL,NULL)!=CE_None)
+        {
+            mStrError=QObject::tr("Error building overviews\nGDAL error:\n%1").arg(QString(CPLGetLastErrorMsg()));
+            GDALClose(mHDS);
+            return;
+        }
+    }
+    if(mCogOutput)
+    {
+        QString strAuxError;
+        if(!CloudOptimizedGeoTiff::createCopy(mHDS,mFileName,REMOTESENSING_COG_TUPLEKEY_BLOCK_SIZE,
+                                              mOverviewResampling,strAuxError))
+        {
+            mStrError=strAuxError;
+            GDALClose(mHDS);
+            return;
+        }
+    }
+    GDALClose(mHDS);
+    mSuccess=true;
+}
+}
+
 Scene::Scene(QString id,
              libCRS::CRSTools *ptrCrsTools):
     mPtrCrsTools(ptrCrsTools),
     mId(id)
 {
     mPtrNestedGridProject=NULL;
+    mPtrCpuSemaphore=NULL;
+    mPtrIoSemaphore=NULL;
+    mPtrSharedStateMutex=NULL;
+    mPtrFootprintGeometry=NULL;
     mStdOut = new QTextStream(stdout);
+    mReprojectInProcess=REMOTESENSING_REPROJECTION_IN_PROCESS;
+    mReprojectToWarpedVrt=REMOTESENSING_REPROJECTION_WARPED_VRT;
+    mReprojectionNumberOfThreads=REMOTESENSING_REPROJECTION_NUMBER_OF_THREADS;
+    mReprojectionWarpMemoryLimitMb=REMOTESENSING_REPROJECTION_WARP_MEMORY_LIMIT_MB;
+    mOutputProfile=REMOTESENSING_OUTPUT_PROFILE_DEFAULT;
+}
+
+bool Scene::getBandFingerprint(QString bandId,
+                               NestedGrid::NestedGridProject *ptrNestedGridProject,
+                               QString &fingerprint,
+                               QString &strError)
+{
+    fingerprint.clear();
+    if(!mPtrRasterBands.contains(bandId))
+    {
+        strError=QObject::tr("Scene::getBandFingerprint");
+        strError+=QObject::tr("\nThere are not band id: %1 in scene: %2").arg(bandId).arg(mId);
+        return(false);
+    }
+    QString bandFileName=mPtrRasterBands[bandId]->getFileName();
+    // Las bandas dentro de un zip se identifican por el fichero zip
+    QString sourceFileName=bandFileName;
+    if(sourceFileName.startsWith(REMOTESENSING_VSIZIP_PREFIX))
+    {
+        sourceFileName=sourceFileName.mid(QString(REMOTESENSING_VSIZIP_PREFIX).size());
+        int zipPosition=sourceFileName.indexOf(".zip/",0,Qt::CaseInsensitive);
+        if(zipPosition!=-1)
+        {
+            sourceFileName=sourceFileName.left(zipPosition+4);
+        }
+    }
+    QFileInfo sourceFileInfo(sourceFileName);
+    QFile sourceFile(sourceFileName);
+    if(!sourceFileInfo.exists()
+            ||!sourceFile.open(QIODevice::ReadOnly))
+    {
+        strError=QObject::tr("Scene::getBandFingerprint");
+        strError+=QObject::tr("\nError opening file:\n%1").arg(sourceFileName);
+        return(false);
+    }
+    // Huella: identidad del fichero fuente (tamaño, fecha y primer y ultimo mega)
+    // y parametros de NestedGrid que determinan los tuplekeys generados
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    qint64 fileSize=sourceFileInfo.size();
+    hash.addData(QString(bandFileName+"\n").toUtf8());
+    hash.addData(QString(QString::number(fileSize)+"\n").toUtf8());
+    hash.addData(QString(QString::number(sourceFileInfo.lastModified().toMSecsSinceEpoch())+"\n").toUtf8());
+    qint64 chunkSize=qMin((qint64)REMOTESENSING_INGESTION_FINGERPRINT_CHUNK_SIZE,fileSize);
+    hash.addData(sourceFile.read(chunkSize));
+    if(fileSize>chunkSize)
+    {
+        sourceFile.seek(fileSize-chunkSize);
+        hash.addData(sourceFile.read(chunkSize));
+    }
+    sourceFile.close();
+    int lodStorage,lodSpatialResolution;
+    if(mSceneType==Landsat8)
+    {
+        lodStorage=ptrNestedGridProject->getLandsat8LODStorage(bandId);
+        lodSpatialResolution=ptrNestedGridProject->getLandsat8LODSpatialResolution(bandId);
+    }
+    else
+    {
+        lodStorage=ptrNestedGridProject->getSentinel2LODStorage(bandId);
+        lodSpatialResolution=ptrNestedGridProject->getSentinel2LODSpatialResolution(bandId);
+    }
+    QStringList values;
+    values<<ptrNestedGridProject->getNestedGridTools()->getCrsDescription();
+    values<<QString::number(lodStorage);
+    values<<QString::number(lodSpatialResolution);
+    values<<ptrNestedGridProject->getResamplingMethod();
+    values<<ptrNestedGridProject->getCompressMethod();
+    values<<QString::number(ptrNestedGridProject->getCreateTiledRaster()?1:0);
+    values<<ptrNestedGridProject->getStoragePath();
+    values<<mOutputProfile;
+    for(int nv=0;nv<values.size();nv++)
+    {
+        hash.addData(QString(values.at(nv)+"\n").toUtf8());
+    }
+    fingerprint=QString::fromLatin1(hash.result().toHex());
+    return(true);
+}
+
+QString Scene::getReprojectedFileName(QString fileName,
+                                      QString fileExtension)
+{
+    QFileInfo fileInfo(fileName);
+    if(mReprojectInProcess&&mReprojectToWarpedVrt)
+    {
+        fileExtension=REMOTESENSING_REPROJECTION_WARPED_VRT_FILE_EXTENSION;
+    }
+    QString reprojectionPath=mReprojectionPath;
+    if(reprojectionPath.isEmpty())
+    {
+        reprojectionPath=fileInfo.absolutePath();
+    }
+    QString reprojectedFileName=reprojectionPath+"/"+fileInfo.completeBaseName()+"_rpy."+fileExtension;
+    return(reprojectedFileName);
 }
 
 QString Scene::getType()
@@ -43,8 +800,605 @@ bool Scene::isSentinel2()
     return(isSentinel2);
 }
 
+bool Scene::reprojectRasterFiles(QVector<QString> &inputFileNames,
+                                 QVector<QString> &outputFileNames,
+                                 QString inputProj4Crs,
+                                 QString outputProj4Crs,
+                                 QString resamplingMethod,
+                                 double noDataValue,
+                                 QString &strError)
+{
+    if(inputFileNames.size()!=outputFileNames.size())
+    {
+        strError=QObject::tr("Scene::reprojectRasterFiles");
+        strError+=QObject::tr("\nDifferent number of input and output files");
+        return(false);
+    }
+    if(inputFileNames.size()==0)
+    {
+        return(true);
+    }
+    SharedStateUnlocker sharedStateUnlocker(mPtrSharedStateMutex);
+    ConcurrencyLimits concurrencyLimits;
+    concurrencyLimits.ptrCpuSemaphore=mPtrCpuSemaphore;
+    concurrencyLimits.ptrIoSemaphore=mPtrIoSemaphore;
+    QVector<QString> proj4Crss;
+    proj4Crss.push_back(inputProj4Crs);
+    proj4Crss.push_back(outputProj4Crs);
+    QVector<QString> wktCrss;
+    for(int nc=0;nc<proj4Crss.size();nc++)
+    {
+        OGRSpatialReference spatialReference;
+        if(spatialReference.SetFromUserInput(proj4Crss[nc].toLatin1().constData())!=OGRERR_NONE)
+        {
+            strError=QObject::tr("Scene::reprojectRasterFiles");
+            strError+=QObject::tr("\nInvalid CRS:\n%1").arg(proj4Crss[nc]);
+            return(false);
+        }
+        char* ptrWkt=NULL;
+        spatialReference.exportToWkt(&ptrWkt);
+        wktCrss.push_back(QString(ptrWkt));
+        CPLFree(ptrWkt);
+    }
+    GDALResampleAlg resampleAlg=GRA_NearestNeighbour;
+    GDALRIOResampleAlg rioResampleAlg=GRIORA_NearestNeighbour;
+    if(!getResampleAlgorithms(resamplingMethod,resampleAlg,rioResampleAlg))
+    {
+        strError=QObject::tr("Scene::reprojectRasterFiles");
+        strError+=QObject::tr("\nInvalid resampling method: %1").arg(resamplingMethod);
+        return(false);
+    }
+    for(int nf=0;nf<outputFileNames.size();nf++)
+    {
+        if(QFile::exists(outputFileNames[nf]))
+        {
+            if(!QFile::remove(outputFileNames[nf]))
+            {
+                strError=QObject::tr("Scene::reprojectRasterFiles");
+                strError+=QObject::tr("\nError deleting existing file:\n%1").arg(outputFileNames[nf]);
+                return(false);
+            }
+        }
+    }
+    if(mReprojectToWarpedVrt)
+    {
+        // Los VRT se leen despues banda a banda: cada uno dispone de todo el limite de memoria y de todos los hilos.
+        // En la ingestion por lotes cada lectura ocupa un solo permiso de calculo, y un solo hilo
+        int numberOfThreads=getNumberOfThreads(mReprojectionNumberOfThreads);
+        if(mPtrCpuSemaphore!=NULL)
+        {
+            numberOfThreads=1;
+        }
+        double warpMemoryLimit=mReprojectionWarpMemoryLimitMb*1024.0*1024.0;
+        for(int nf=0;nf<inputFileNames.size();nf++)
+        {
+            QString strAuxError;
+            if(!createWarpedVrt(inputFileNames[nf],
+                                outputFileNames[nf],
+                                wktCrss[0],
+                                wktCrss[1],
+                                resampleAlg,
+                                noDataValue,
+                                warpMemoryLimit,
+                                numberOfThreads,
+                                strAuxError))
+            {
+                strError=QObject::tr("Scene::reprojectRasterFiles");
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
+        }
+        return(true);
+    }
+    QVector<double> outputEnvelope;
+    if(mPtrFootprintGeometry!=NULL)
+    {
+        OGREnvelope footprintEnvelope;
+        mPtrFootprintGeometry->getEnvelope(&footprintEnvelope);
+        outputEnvelope.push_back(footprintEnvelope.MinX);
+        outputEnvelope.push_back(footprintEnvelope.MinY);
+        outputEnvelope.push_back(footprintEnvelope.MaxX);
+        outputEnvelope.push_back(footprintEnvelope.MaxY);
+    }
+    // Las bandas se reparten entre los hilos del pool y cada warp usa los hilos sobrantes.
+    // El limite de memoria se reparte entre los warps simultaneos
+    int numberOfThreads=getNumberOfThreads(mReprojectionNumberOfThreads);
+    int numberOfPoolThreads=qMin(numberOfThreads,inputFileNames.size());
+    int numberOfWarpThreads=qMax(1,numberOfThreads/numberOfPoolThreads);
+    // En la ingestion por lotes cada warp ocupa un solo permiso de calculo, y un solo hilo
+    if(mPtrCpuSemaphore!=NULL)
+    {
+        numberOfWarpThreads=1;
+    }
+    double warpMemoryLimit=mReprojectionWarpMemoryLimitMb*1024.0*1024.0/numberOfPoolThreads;
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(numberOfPoolThreads);
+    QVector<ReprojectionTask*> ptrTasks;
+    for(int nf=0;nf<inputFileNames.size();nf++)
+    {
+        ReprojectionTask* ptrTask=new ReprojectionTask(inputFileNames[nf],
+                                                       outputFileNames[nf],
+                                                       wktCrss[0],
+                                                       wktCrss[1],
+                                                       resampleAlg,
+                                                       noDataValue,
+                                                       warpMemoryLimit,
+                                                       numberOfWarpThreads,
+                                                       outputEnvelope,
+                                                       concurrencyLimits);
+        ptrTasks.push_back(ptrTask);
+        threadPool.start(ptrTask);
+    }
+    while(!threadPool.waitForDone(100))
+    {
+        QCoreApplication::processEvents();
+    }
+    QString strTasksError;
+    for(int nt=0;nt<ptrTasks.size();nt++)
+    {
+        if(!ptrTasks[nt]->getSuccess())
+        {
+            strTasksError+=(ptrTasks[nt]->getError()+"\n");
+        }
+        delete(ptrTasks[nt]);
+    }
+    if(!strTasksError.isEmpty())
+    {
+        strError=QObject::tr("Scene::reprojectRasterFiles");
+        strError+=QObject::tr("\nError:\n%1").arg(strTasksError);
+        return(false);
+    }
+    return(true);
+}
+
+void Scene::setConcurrencyLimits(QSemaphore *ptrCpuSemaphore,
+                                 QSemaphore *ptrIoSemaphore,
+                                 QMutex *ptrSharedStateMutex)
+{
+    mPtrCpuSemaphore=ptrCpuSemaphore;
+    mPtrIoSemaphore=ptrIoSemaphore;
+    mPtrSharedStateMutex=ptrSharedStateMutex;
+}
+
+bool Scene::setFootprint(OGRGeometry *ptrGeometry,
+                         int epsgCode,
+                         double buffer,
+                         QString outputProj4Crs,
+                         QString &strError)
+{
+    if(mPtrFootprintGeometry!=NULL)
+    {
+        OGRGeometryFactory::destroyGeometry(mPtrFootprintGeometry);
+        mPtrFootprintGeometry=NULL;
+    }
+    OGRSpatialReference footprintCrs;
+    if(footprintCrs.importFromEPSG(epsgCode)!=OGRERR_NONE)
+    {
+        strError=QObject::tr("Scene::setFootprint");
+        strError+=QObject::tr("\nInvalid EPSG code: %1").arg(QString::number(epsgCode));
+        return(false);
+    }
+    OGRSpatialReference outputCrs;
+    if(outputCrs.SetFromUserInput(outputProj4Crs.toLatin1().constData())!=OGRERR_NONE)
+    {
+        strError=QObject::tr("Scene::setFootprint");
+        strError+=QObject::tr("\nInvalid CRS:\n%1").arg(outputProj4Crs);
+        return(false);
+    }
+#if GDAL_VERSION_NUM >= 3000000
+    footprintCrs.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    outputCrs.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+    OGRCoordinateTransformation* ptrCoordinateTransformation=OGRCreateCoordinateTransformation(&footprintCrs,&outputCrs);
+    if(ptrCoordinateTransformation==NULL)
+    {
+        strError=QObject::tr("Scene::setFootprint");
+        strError+=QObject::tr("\nError creating transformation from EPSG: %1 to CRS:\n%2")
+                .arg(QString::number(epsgCode)).arg(outputProj4Crs);
+        return(false);
+    }
+    // La escena real puede desplazarse respecto a la huella nominal
+    OGRGeometry* ptrFootprintGeometry=NULL;
+    if(buffer>0.0)
+    {
+        ptrFootprintGeometry=ptrGeometry->Buffer(buffer);
+    }
+    else
+    {
+        ptrFootprintGeometry=ptrGeometry->clone();
+    }
+    if(ptrFootprintGeometry==NULL
+            ||ptrFootprintGeometry->transform(ptrCoordinateTransformation)!=OGRERR_NONE)
+    {
+        strError=QObject::tr("Scene::setFootprint");
+        strError+=QObject::tr("\nError transforming footprint to CRS:\n%1").arg(outputProj4Crs);
+        if(ptrFootprintGeometry!=NULL)
+        {
+            OGRGeometryFactory::destroyGeometry(ptrFootprintGeometry);
+        }
+        OCTDestroyCoordinateTransformation((OGRCoordinateTransformationH)ptrCoordinateTransformation);
+        return(false);
+    }
+    OCTDestroyCoordinateTransformation((OGRCoordinateTransformationH)ptrCoordinateTransformation);
+    mPtrFootprintGeometry=ptrFootprintGeometry;
+    return(true);
+}
+
+void Scene::selectFootprintTuplekeys(QVector<QString> &tuplekeys,
+                                     QVector<int> &tilesX,
+                                     QVector<int> &tilesY,
+                                     QVector<QVector<double> > &boundingBoxes)
+{
+    if(mPtrFootprintGeometry==NULL||tuplekeys.isEmpty())
+    {
+        return;
+    }
+    // Preseleccion por rectangulos en el R-tree y comprobacion exacta contra la huella
+    StrRTree tuplekeysIndex;
+    for(int nt=0;nt<tuplekeys.size();nt++)
+    {
+        double ulx=boundingBoxes[nt][0];
+        double uly=boundingBoxes[nt][1];
+        double lrx=boundingBoxes[nt][2];
+        double lry=boundingBoxes[nt][3];
+        tuplekeysIndex.insert(nt,qMin(ulx,lrx),qMin(uly,lry),qMax(ulx,lrx),qMax(uly,lry));
+    }
+    tuplekeysIndex.build();
+    OGREnvelope footprintEnvelope;
+    mPtrFootprintGeometry->getEnvelope(&footprintEnvelope);
+    QVector<int> candidates;
+    tuplekeysIndex.query(footprintEnvelope.MinX,footprintEnvelope.MinY,
+                         footprintEnvelope.MaxX,footprintEnvelope.MaxY,
+                         candidates);
+    std::sort(candidates.begin(),candidates.end());
+    QVector<QString> selectedTuplekeys;
+    QVector<int> selectedTilesX;
+    QVector<int> selectedTilesY;
+    QVector<QVector<double> > selectedBoundingBoxes;
+    for(int nc=0;nc<candidates.size();nc++)
+    {
+        int nt=candidates[nc];
+        double ulx=boundingBoxes[nt][0];
+        double uly=boundingBoxes[nt][1];
+        double lrx=boundingBoxes[nt][2];
+        double lry=boundingBoxes[nt][3];
+        OGRLinearRing ring;
+        ring.addPoint(ulx,uly);
+        ring.addPoint(lrx,uly);
+        ring.addPoint(lrx,lry);
+        ring.addPoint(ulx,lry);
+        ring.closeRings();
+        OGRPolygon tuplekeyPolygon;
+        tuplekeyPolygon.addRing(&ring);
+        if(!mPtrFootprintGeometry->Intersects(&tuplekeyPolygon))
+        {
+            continue;
+        }
+        selectedTuplekeys.push_back(tuplekeys[nt]);
+        selectedTilesX.push_back(tilesX[nt]);
+        selectedTilesY.push_back(tilesY[nt]);
+        selectedBoundingBoxes.push_back(boundingBoxes[nt]);
+    }
+    tuplekeys=selectedTuplekeys;
+    tilesX=selectedTilesX;
+    tilesY=selectedTilesY;
+    boundingBoxes=selectedBoundingBoxes;
+}
+
+bool Scene::getIngestedTuplekeysFileNames(QString bandId,
+                                          QVector<QString> &expectedTuplekeysFileNames,
+                                          QVector<QString> &emptyTuplekeysFileNames)
+{
+    // Falso si la banda no ha terminado de teselarse en el proceso
+    expectedTuplekeysFileNames.clear();
+    emptyTuplekeysFileNames.clear();
+    if(!mExpectedTuplekeysFileNamesByBand.contains(bandId))
+    {
+        return(false);
+    }
+    expectedTuplekeysFileNames=mExpectedTuplekeysFileNamesByBand[bandId];
+    emptyTuplekeysFileNames=mEmptyTuplekeysFileNamesByBand.value(bandId);
+    return(true);
+}
+
+void Scene::setOutputProfile(QString outputProfile)
+{
+    mOutputProfile=outputProfile;
+}
+
+void Scene::setTuplekeysFileNames(QString bandId,
+                                  QVector<QString> &tuplekeysFileNames)
+{
+    // Tuplekeys de una banda que no se vuelve a ingestar
+    QVector<QString> tuplekeys;
+    for(int nf=0;nf<tuplekeysFileNames.size();nf++)
+    {
+        QFileInfo fileInfo(tuplekeysFileNames[nf]);
+        tuplekeys.push_back(fileInfo.dir().dirName());
+    }
+    mTuplekeysByBand[bandId]=tuplekeys;
+    mTuplekeysFileNamesByBand[bandId]=tuplekeysFileNames;
+}
+
+void Scene::setReprojectionParameters(bool inProcess,
+                                      bool warpedVrt,
+                                      int numberOfThreads,
+                                      double warpMemoryLimitMb)
+{
+    mReprojectInProcess=inProcess;
+    mReprojectToWarpedVrt=warpedVrt;
+    mReprojectionNumberOfThreads=numberOfThreads;
+    mReprojectionWarpMemoryLimitMb=warpMemoryLimitMb;
+}
+
+bool Scene::tileRasterFile(QString inputFileName,
+                           QVector<QString> &outputFileNames,
+                           QVector<QVector<double> > &boundingBoxes,
+                           int outputSize,
+                           QString resamplingMethod,
+                           double noDataValue,
+                           QStringList &creationOptions,
+                           QVector<int> &overviewFactors,
+                           QVector<bool> &emptyTiles,
+                           QString &strError)
+{
+    emptyTiles.fill(true,outputFileNames.size());
+    if(outputFileNames.size()!=boundingBoxes.size())
+    {
+        strError=QObject::tr("Scene::tileRasterFile");
+        strError+=QObject::tr("\nDifferent number of output files and bounding boxes");
+        return(false);
+    }
+    if(outputFileNames.size()==0)
+    {
+        return(true);
+    }
+    SharedStateUnlocker sharedStateUnlocker(mPtrSharedStateMutex);
+    ConcurrencyLimits concurrencyLimits;
+    concurrencyLimits.ptrCpuSemaphore=mPtrCpuSemaphore;
+    concurrencyLimits.ptrIoSemaphore=mPtrIoSemaphore;
+    GDALResampleAlg resampleAlg=GRA_NearestNeighbour;
+    GDALRIOResampleAlg rioResampleAlg=GRIORA_NearestNeighbour;
+    if(!getResampleAlgorithms(resamplingMethod,resampleAlg,rioResampleAlg))
+    {
+        strError=QObject::tr("Scene::tileRasterFile");
+        strError+=QObject::tr("\nInvalid resampling method: %1").arg(resamplingMethod);
+        return(false);
+    }
+    QString overviewResampling=resamplingMethod.toUpper();
+    if(resampleAlg==GRA_NearestNeighbour)
+    {
+        overviewResampling="NEAREST";
+    }
+    GDALDatasetH hSrcDS=GDALOpen(inputFileName.toStdString().c_str(),GA_ReadOnly);
+    if(hSrcDS==NULL)
+    {
+        strError=QObject::tr("Scene::tileRasterFile");
+        strError+=QObject::tr("\nError opening file:\n%1").arg(inputFileName);
+        return(false);
+    }
+    double geoTransform[6];
+    GDALGetGeoTransform(hSrcDS,geoTransform);
+    int numberOfColumns=GDALGetRasterXSize(hSrcDS);
+    int numberOfRows=GDALGetRasterYSize(hSrcDS);
+    GDALRasterBandH hSrcBand=GDALGetRasterBand(hSrcDS,1);
+    GDALDataType gdalDataType=GDALGetRasterDataType(hSrcBand);
+    int bytesByPixel=GDALGetDataTypeSize(gdalDataType)/8;
+    QString projection=QString(GDALGetProjectionRef(hSrcDS));
+    char** ptrCreationOptions=NULL;
+    GDALDriverH hDriver=NULL;
+    // Perfil COG: cada tuplekey se calcula en memoria y se escribe una vez con sus overviews
+    bool cogOutput=CloudOptimizedGeoTiff::isCogOutputProfile(mOutputProfile);
+    if(cogOutput)
+    {
+        hDriver=GDALGetDriverByName("MEM");
+    }
+    else
+    {
+        for(int nco=0;nco<creationOptions.size();nco++)
+        {
+            ptrCreationOptions=CSLAddString(ptrCreationOptions,creationOptions[nco].toLatin1().constData());
+        }
+        hDriver=GDALGetDriverByName(REMOTESENSING_REPROJECTION_OUTPUT_FORMAT);
+    }
+    // Mismas ventanas que gdal_translate -projwin -outsize
+    QVector<TileWindow> tileWindows;
+    int overlapRows=0;
+    for(int nt=0;nt<outputFileNames.size();nt++)
+    {
+        double ulx=boundingBoxes[nt][0];
+        double uly=boundingBoxes[nt][1];
+        double lrx=boundingBoxes[nt][2];
+        double lry=boundingBoxes[nt][3];
+        TileWindow tileWindow;
+        tileWindow.size=outputSize;
+        tileWindow.sourceX=(ulx-geoTransform[0])/geoTransform[1];
+        tileWindow.sourceY=(uly-geoTransform[3])/geoTransform[5];
+        tileWindow.sourceColumnsByPixel=(lrx-ulx)/geoTransform[1]/outputSize;
+        tileWindow.sourceRowsByPixel=(lry-uly)/geoTransform[5]/outputSize;
+        tileWindow.sourceMargin=(int)ceil(3.0*qMax(1.0,tileWindow.sourceRowsByPixel))+1;
+        tileWindow.firstDataRow=qBound(0,(int)ceil(-tileWindow.sourceY/tileWindow.sourceRowsByPixel-1.0e-6),outputSize);
+        tileWindow.endDataRow=qBound(tileWindow.firstDataRow,
+                                     (int)floor((numberOfRows-tileWindow.sourceY)/tileWindow.sourceRowsByPixel+1.0e-6),
+                                     outputSize);
+        tileWindow.firstDataColumn=qBound(0,(int)ceil(-tileWindow.sourceX/tileWindow.sourceColumnsByPixel-1.0e-6),outputSize);
+        tileWindow.endDataColumn=qBound(tileWindow.firstDataColumn,
+                                        (int)floor((numberOfColumns-tileWindow.sourceX)/tileWindow.sourceColumnsByPixel+1.0e-6),
+                                        outputSize);
+        // Sin interseccion entre la ventana del tuplekey y la extension del fichero: nunca se crea
+        if(tileWindow.endDataColumn==tileWindow.firstDataColumn)
+        {
+            tileWindow.endDataRow=tileWindow.firstDataRow;
+        }
+        tileWindow.nextRow=0;
+        int rowsByPixel=(int)ceil(tileWindow.sourceRowsByPixel)+2*tileWindow.sourceMargin+1;
+        if(rowsByPixel>overlapRows)
+        {
+            overlapRows=rowsByPixel;
+        }
+        tileWindow.fileName=outputFileNames[nt];
+        tileWindow.hDS=NULL;
+        tileWindow.numberOfValidPixels=0;
+        tileWindow.geoTransform[0]=ulx;
+        tileWindow.geoTransform[1]=(lrx-ulx)/outputSize;
+        tileWindow.geoTransform[2]=0.0;
+        tileWindow.geoTransform[3]=uly;
+        tileWindow.geoTransform[4]=0.0;
+        tileWindow.geoTransform[5]=(lry-uly)/outputSize;
+        tileWindows.push_back(tileWindow);
+    }
+    QByteArray strProjection=projection.toLatin1();
+    // El fichero de entrada se lee una sola vez por franjas de filas. Cada franja se solapa con
+    // la anterior lo necesario para que cada fila de salida, con el nucleo de remuestreo, caiga entera en una
+    int stripNumberOfRows=qMax(REMOTESENSING_TILING_STRIP_NUMBER_OF_ROWS,2*overlapRows);
+    QVector<GByte> stripBuffer(numberOfColumns*(stripNumberOfRows+overlapRows)*bytesByPixel);
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(getNumberOfThreads(mReprojectionNumberOfThreads));
+    QString strTasksError;
+    for(int stripStartRow=0;stripStartRow<numberOfRows&&strTasksError.isEmpty();stripStartRow+=stripNumberOfRows)
+    {
+        int stripFirstRow=qMax(0,stripStartRow-overlapRows);
+        int stripEndRow=qMin(numberOfRows,stripStartRow+stripNumberOfRows);
+        int stripRows=stripEndRow-stripFirstRow;
+        // Solo se leen las columnas que necesitan los tuplekeys pendientes
+        bool readStrip=false;
+        int stripFirstColumn=numberOfColumns;
+        int stripEndColumn=0;
+        for(int nt=0;nt<tileWindows.size();nt++)
+        {
+            const TileWindow& tileWindow=tileWindows[nt];
+            if(tileWindow.nextRow<tileWindow.endDataRow)
+            {
+                readStrip=true;
+                int firstColumn=(int)floor(tileWindow.sourceX+tileWindow.firstDataColumn*tileWindow.sourceColumnsByPixel)-tileWindow.sourceMargin;
+                int endColumn=(int)ceil(tileWindow.sourceX+tileWindow.endDataColumn*tileWindow.sourceColumnsByPixel)+tileWindow.sourceMargin;
+                stripFirstColumn=qMin(stripFirstColumn,qMax(0,firstColumn));
+                stripEndColumn=qMax(stripEndColumn,qMin(numberOfColumns,endColumn));
+            }
+        }
+        if(readStrip&&stripEndColumn>stripFirstColumn)
+        {
+            // Leer de un VRT con warp es calculo, leer de un GeoTIFF es disco
+            ConcurrencyPermit readPermit(mReprojectInProcess&&mReprojectToWarpedVrt
+                                         ?concurrencyLimits.ptrCpuSemaphore
+                                         :concurrencyLimits.ptrIoSemaphore);
+            if(GDALRasterIO(hSrcBand,GF_Read,stripFirstColumn,stripFirstRow,stripEndColumn-stripFirstColumn,stripRows,
+                            stripBuffer.data()+stripFirstColumn*bytesByPixel,stripEndColumn-stripFirstColumn,stripRows,
+                            gdalDataType,bytesByPixel,numberOfColumns*bytesByPixel)!=CE_None)
+            {
+                strTasksError=QObject::tr("Error reading rows from %1 to %2\nGDAL error:\n%3")
+                        .arg(stripFirstRow).arg(stripEndRow).arg(QString(CPLGetLastErrorMsg()));
+                break;
+            }
+        }
+        QVector<TileRowsTask*> ptrTasks;
+        for(int nt=0;nt<tileWindows.size();nt++)
+        {
+            TileWindow& tileWindow=tileWindows[nt];
+            int endRow=tileWindow.nextRow;
+            while(endRow<tileWindow.size)
+            {
+                if(endRow>=tileWindow.firstDataRow&&endRow<tileWindow.endDataRow)
+                {
+                    double rowFirstSourceRow=tileWindow.sourceY+endRow*tileWindow.sourceRowsByPixel;
+                    int firstSourceRow=qMax(0,(int)floor(rowFirstSourceRow)-tileWindow.sourceMargin);
+                    int endSourceRow=qMin(numberOfRows,(int)ceil(rowFirstSourceRow+tileWindow.sourceRowsByPixel)+tileWindow.sourceMargin);
+                    if(firstSourceRow<stripFirstRow||endSourceRow>stripEndRow)
+                    {
+                        break;
+                    }
+                }
+                endRow++;
+            }
+            if(tileWindow.hDS==NULL
+                    &&(endRow<=tileWindow.firstDataRow||tileWindow.nextRow>=tileWindow.endDataRow))
+            {
+                // Filas sin datos de un tuplekey aun no creado
+                tileWindow.nextRow=endRow;
+            }
+            if(endRow>tileWindow.nextRow)
+            {
+                TileRowsTask* ptrTask=new TileRowsTask(&tileWindow,hDriver,ptrCreationOptions,strProjection,
+                                                       tileWindow.nextRow,endRow,
+                                                       stripBuffer.data(),stripFirstRow,
+                                                       numberOfColumns,stripRows,
+                                                       gdalDataType,rioResampleAlg,noDataValue,
+                                                       concurrencyLimits);
+                ptrTasks.push_back(ptrTask);
+                threadPool.start(ptrTask);
+                tileWindow.nextRow=endRow;
+            }
+        }
+        while(!threadPool.waitForDone(100))
+        {
+            QCoreApplication::processEvents();
+        }
+        for(int nt=0;nt<ptrTasks.size();nt++)
+        {
+            if(!ptrTasks[nt]->getSuccess())
+            {
+                strTasksError+=(ptrTasks[nt]->getError()+"\n");
+            }
+            delete(ptrTasks[nt]);
+        }
+    }
+    GDALClose(hSrcDS);
+    CSLDestroy(ptrCreationOptions);
+    for(int nt=0;nt<tileWindows.size()&&strTasksError.isEmpty();nt++)
+    {
+        if(tileWindows[nt].nextRow<tileWindows[nt].size)
+        {
+            strTasksError=QObject::tr("Rows not written in file:\n%1").arg(outputFileNames[nt]);
+        }
+    }
+    QVector<TileCloseTask*> ptrCloseTasks;
+    for(int nt=0;nt<tileWindows.size();nt++)
+    {
+        if(tileWindows[nt].hDS==NULL)
+        {
+            continue;
+        }
+        emptyTiles[nt]=false;
+        QVector<int> tileOverviewFactors;
+        if(strTasksError.isEmpty())
+        {
+            tileOverviewFactors=overviewFactors;
+        }
+        TileCloseTask* ptrTask=new TileCloseTask(tileWindows[nt].fileName,tileWindows[nt].hDS,
+                                                 tileOverviewFactors,overviewResampling,
+                                                 cogOutput&&strTasksError.isEmpty(),
+                                                 concurrencyLimits);
+        ptrCloseTasks.push_back(ptrTask);
+        threadPool.start(ptrTask);
+    }
+    while(!threadPool.waitForDone(100))
+    {
+        QCoreApplication::processEvents();
+    }
+    for(int nt=0;nt<ptrCloseTasks.size();nt++)
+    {
+        if(!ptrCloseTasks[nt]->getSuccess())
+        {
+            strTasksError+=(QObject::tr("File:\n%1\n").arg(ptrCloseTasks[nt]->getFileName())+ptrCloseTasks[nt]->getError()+"\n");
+        }
+        delete(ptrCloseTasks[nt]);
+    }
+    if(!strTasksError.isEmpty())
+    {
+        strError=QObject::tr("Scene::tileRasterFile");
+        strError+=QObject::tr("\nFor file:\n%1").arg(inputFileName);
+        strError+=QObject::tr("\nError:\n%1").arg(strTasksError);
+        return(false);
+    }
+    return(true);
+}
+
 Scene::~Scene()
 {
+    if(mPtrFootprintGeometry!=NULL)
+    {
+        OGRGeometryFactory::destroyGeometry(mPtrFootprintGeometry);
+    }
     QMap<QString,IGDAL::Raster*>::iterator iterPtrRasterBands=mPtrRasterBands.begin();
     while(iterPtrRasterBands!=mPtrRasterBands.end())
     {
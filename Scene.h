@@ -6,12 +6,16 @@
 #include <QMap>
 #include <QObject>
 #include <QTextStream>
+#include <QStringList>
 
 #include "libremotesensing_global.h"
 
 #include <gdal_priv.h>
 #include <ogrsf_frmts.h>
 
+class QMutex;
+class QSemaphore;
+
 namespace ProcessTools{
     class MultiProcess;
 }
@@ -36,12 +40,57 @@ class LIBREMOTESENSINGSHARED_EXPORT Scene : public QObject
 public:
     explicit Scene(QString id,
                    libCRS::CRSTools* ptrCrsTools);
+    bool getBandFingerprint(QString bandId,
+                            NestedGrid::NestedGridProject* ptrNestedGridProject,
+                            QString& fingerprint,
+                            QString& strError);
+    bool getIngestedTuplekeysFileNames(QString bandId,
+                                       QVector<QString>& expectedTuplekeysFileNames,
+                                       QVector<QString>& emptyTuplekeysFileNames);
     void getQuadkeys(QMap<QString,QVector<QString> >& quadkeysByBand){quadkeysByBand=mTuplekeysByBand;}
     QString getType();
     bool isLandsat8();
     bool isSentinel2();
+    void setConcurrencyLimits(QSemaphore* ptrCpuSemaphore,
+                              QSemaphore* ptrIoSemaphore,
+                              QMutex* ptrSharedStateMutex);
+    void setOutputProfile(QString outputProfile);
+    void setReprojectionParameters(bool inProcess,
+                                   bool warpedVrt,
+                                   int numberOfThreads,
+                                   double warpMemoryLimitMb);
+    void setTuplekeysFileNames(QString bandId,
+                               QVector<QString>& tuplekeysFileNames);
     ~Scene();
 protected:
+    QString getReprojectedFileName(QString fileName,
+                                   QString fileExtension);
+    void selectFootprintTuplekeys(QVector<QString>& tuplekeys,
+                                  QVector<int>& tilesX,
+                                  QVector<int>& tilesY,
+                                  QVector<QVector<double> >& boundingBoxes);
+    bool setFootprint(OGRGeometry* ptrGeometry,
+                      int epsgCode,
+                      double buffer,
+                      QString outputProj4Crs,
+                      QString& strError);
+    bool reprojectRasterFiles(QVector<QString>& inputFileNames,
+                              QVector<QString>& outputFileNames,
+                              QString inputProj4Crs,
+                              QString outputProj4Crs,
+                              QString resamplingMethod,
+                              double noDataValue,
+                              QString& strError);
+    bool tileRasterFile(QString inputFileName,
+                        QVector<QString>& outputFileNames,
+                        QVector<QVector<double> >& boundingBoxes,
+                        int outputSize,
+                        QString resamplingMethod,
+                        double noDataValue,
+                        QStringList& creationOptions,
+                        QVector<int>& overviewFactors,
+                        QVector<bool>& emptyTiles,
+                        QString& strError);
     QTextStream* mStdOut;
     QString mId;
     libCRS::CRSTools* mPtrCrsTools;
@@ -51,7 +100,20 @@ protected:
     QMap<QString,IGDAL::Raster*> mPtrRasterBands;
     ProcessTools::MultiProcess* mPtrMultiProcess;
     QMap<QString,QVector<QString> > mTuplekeysByBand;
+    QMap<QString,QVector<QString> > mTuplekeysFileNamesByBand;
+    QMap<QString,QVector<QString> > mExpectedTuplekeysFileNamesByBand; // solo bandas teseladas sin error
+    QMap<QString,QVector<QString> > mEmptyTuplekeysFileNamesByBand; // esperados sin pixeles validos
     SceneType mSceneType;
+    bool mReprojectInProcess;
+    bool mReprojectToWarpedVrt;
+    int mReprojectionNumberOfThreads;
+    double mReprojectionWarpMemoryLimitMb;
+    QString mReprojectionPath; // vacio: junto a cada banda
+    QString mOutputProfile; // perfil de los ficheros de tuplekeys
+    QSemaphore* mPtrCpuSemaphore; // NULL: sin limite
+    QSemaphore* mPtrIoSemaphore; // NULL: sin limite
+    QMutex* mPtrSharedStateMutex; // protege NestedGridProject y CRSTools en ingestion por lotes
+    OGRGeometry* mPtrFootprintGeometry; // en el CRS de NestedGrid, NULL: sin huella
 };
 }
 #endif // SCENE_H
@@ -1,12 +1,18 @@
 #include <ogr_geos.h>
 #include <ogr_geometry.h>
 
+#include <cctype>
+#include <cstring>
+
 #include <QDir>
 #include <QFile>
 #include <QTextStream>
 #include <QDate>
 #include <QTime>
 #include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QtCore>
 
 //#include "../../libs/libPW/libPW.h"
@@ -24,6 +30,320 @@
 
 using namespace RemoteSensing;
 
+namespace{
+// Cache de metadatos por fichero MTL, compartida por escenas y persistencia
+QMutex metadataCacheMutex;
+QMap<QString,Landsat8Metadata> metadataCache;
+
+QString removeQuotes(QString value)
+{
+    if(value.contains("\""))
+    {
+        value=value.remove("\"");
+    }
+    return(value);
+}
+
+// Lectura en una sola pasada del MTL proyectado en memoria
+bool parseMetadataFile(QString fileName,
+                       Landsat8Metadata& metadata,
+                       QString& strError)
+{
+    QFile fileInput(fileName);
+    if(!fileInput.open(QIODevice::ReadOnly))
+    {
+        strError=QObject::tr("Error opening file: \n%1").arg(fileName);
+        return(false);
+    }
+    qint64 fileSize=fileInput.size();
+    QByteArray fileData;
+    const char* ptrBegin=NULL;
+    uchar* ptrMap=NULL;
+    if(fileSize>0)
+    {
+        ptrMap=fileInput.map(0,fileSize);
+    }
+    if(ptrMap!=NULL)
+    {
+        ptrBegin=(const char*)ptrMap;
+    }
+    else
+    {
+        fileData=fileInput.readAll();
+        ptrBegin=fileData.constData();
+        fileSize=fileData.size();
+    }
+    const char* ptrEnd=ptrBegin+fileSize;
+    QByteArray fileContent;
+    fileContent.reserve(fileSize);
+    QString tagGroup;
+    QMap<QString,QString> metadataGroup;
+    int nline=0;
+    const char* ptrLine=ptrBegin;
+    while(ptrLine<ptrEnd)
+    {
+        nline++;
+        const char* ptrLineEnd=(const char*)memchr(ptrLine,'\n',ptrEnd-ptrLine);
+        if(ptrLineEnd==NULL)
+        {
+            ptrLineEnd=ptrEnd;
+        }
+        const char* ptrFirst=ptrLine;
+        const char* ptrLast=ptrLineEnd;
+        ptrLine=ptrLineEnd+1;
+        while(ptrFirst<ptrLast&&isspace((unsigned char)*ptrFirst))
+        {
+            ptrFirst++;
+        }
+        while(ptrLast>ptrFirst&&isspace((unsigned char)*(ptrLast-1)))
+        {
+            ptrLast--;
+        }
+        if(ptrFirst==ptrLast)
+        {
+            continue;
+        }
+        fileContent.append(ptrFirst,ptrLast-ptrFirst);
+        fileContent.append('\n');
+        const char* ptrSeparator=(const char*)memchr(ptrFirst,REMOTESENSING_LANDSAT8_USGS_METADATA_STRING_SEPARATOR[0],ptrLast-ptrFirst);
+        if(ptrSeparator==NULL)
+        {
+            if(qstrnicmp(ptrFirst,REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_END,ptrLast-ptrFirst)==0
+                    &&(ptrLast-ptrFirst)==(int)qstrlen(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_END)) // línea final
+            {
+                continue;
+            }
+            strError=QObject::tr("Error reading file: %1").arg(fileName);
+            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(REMOTESENSING_LANDSAT8_USGS_METADATA_STRING_SEPARATOR);
+            return(false);
+        }
+        QString strTag=QString::fromLatin1(ptrFirst,ptrSeparator-ptrFirst).trimmed();
+        QString strValue=QString::fromLatin1(ptrSeparator+1,ptrLast-ptrSeparator-1).trimmed();
+        if(strTag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_BEGIN_GROUP,Qt::CaseInsensitive)==0)
+        {
+            tagGroup=strValue;
+            metadataGroup.clear();
+            continue;
+        }
+        else if(strTag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_END_GROUP,Qt::CaseInsensitive)==0)
+        {
+            metadata.valuesByTagByGroup[tagGroup]=metadataGroup;
+            continue;
+        }
+        metadataGroup[strTag]=strValue;
+        QString strAuxError;
+        if(!metadata.setValue(strTag,strValue,strAuxError))
+        {
+            strError=QObject::tr("Error reading file: %1").arg(fileName);
+            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    if(ptrMap!=NULL)
+    {
+        fileInput.unmap(ptrMap);
+    }
+    fileInput.close();
+    metadata.fileContent=QString::fromLatin1(fileContent);
+
+    QString productMetadataGroup=REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA;
+    if(!metadata.valuesByTagByGroup.contains(productMetadataGroup))
+    {
+        strError=QObject::tr("Metadata group not found: %1").arg(productMetadataGroup);
+        return(false);
+    }
+    QMap<QString,QString>& productMetadata=metadata.valuesByTagByGroup[productMetadataGroup];
+    QVector<QString> requiredTags;
+    requiredTags.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH);
+    requiredTags.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_ROW);
+    requiredTags.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_DATE_ACQUIRED);
+    requiredTags.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_CENTER_TIME);
+    for(int nt=0;nt<requiredTags.size();nt++)
+    {
+        if(!productMetadata.contains(requiredTags[nt]))
+        {
+            strError=QObject::tr("Tag: %1 not found in metadata group: %2")
+                    .arg(requiredTags[nt]).arg(productMetadataGroup);
+            return(false);
+        }
+    }
+    bool okToInt=false;
+    QString strPath=removeQuotes(productMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH]);
+    metadata.path=strPath.toInt(&okToInt);
+    if(!okToInt)
+    {
+        strError=QObject::tr("Tag: %1 in metadata group: %2 is not an integer: %3")
+                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH)
+                .arg(productMetadataGroup).arg(strPath);
+        return(false);
+    }
+    QString strRow=removeQuotes(productMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_ROW]);
+    metadata.row=strRow.toInt(&okToInt);
+    if(!okToInt)
+    {
+        strError=QObject::tr("Tag: %1 in metadata group: %2 is not an integer: %3")
+                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_ROW)
+                .arg(productMetadataGroup).arg(strRow);
+        return(false);
+    }
+    QString strDate=removeQuotes(productMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_DATE_ACQUIRED]);
+    QDate date=QDate::fromString(strDate,"yyyy-MM-dd");
+    if(!date.isValid())
+    {
+        strError=QObject::tr("Tag: %1 in metadata group: %2 is not a valid date: %3")
+                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_DATE_ACQUIRED)
+                .arg(productMetadataGroup).arg(strDate);
+        return(false);
+    }
+    QString strTime=productMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_CENTER_TIME];
+    if(strTime.contains(".")) // desprecio la parte decimal de segundo porque no se el número de decimales y hay un carácter z final
+    {
+        strTime=strTime.split(".").at(0);
+    }
+    strTime=removeQuotes(strTime);
+    QTime time=QTime::fromString(strTime,"hh:mm:ss");
+    if(!time.isValid())
+    {
+        strError=QObject::tr("Tag: %1 in metadata group: %2 is not a valid time: %3")
+                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_CENTER_TIME)
+                .arg(productMetadataGroup).arg(strTime);
+        return(false);
+    }
+    metadata.dateTime=QDateTime(date,time);
+    return(true);
+}
+}
+
+Landsat8Metadata::Landsat8Metadata()
+{
+    fileSize=0;
+    path=-1;
+    row=-1;
+    sunAzimuth=0.0;
+    sunElevation=0.0;
+    earthSunDistance=0.0;
+    hasSunAzimuth=false;
+    hasSunElevation=false;
+    hasEarthSunDistance=false;
+    for(int nb=0;nb<=REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE;nb++)
+    {
+        reflectanceMult[nb]=0.0;
+        reflectanceAdd[nb]=0.0;
+        radianceMult[nb]=0.0;
+        radianceAdd[nb]=0.0;
+        hasReflectanceMult[nb]=false;
+        hasReflectanceAdd[nb]=false;
+        hasRadianceMult[nb]=false;
+        hasRadianceAdd[nb]=false;
+    }
+}
+
+bool Landsat8Metadata::getValue(QString tag,
+                                double &value,
+                                QString &strError)
+{
+    double* ptrValue=NULL;
+    bool* ptrHasValue=NULL;
+    if(!getValuePointers(tag,ptrValue,ptrHasValue,strError))
+    {
+        return(false);
+    }
+    if(ptrValue==NULL||!(*ptrHasValue))
+    {
+        strError=QObject::tr("Landsat8Metadata::getValue");
+        strError+=QObject::tr("\nNot exists tag: %1").arg(tag);
+        return(false);
+    }
+    value=*ptrValue;
+    return(true);
+}
+
+bool Landsat8Metadata::getValuePointers(QString tag,
+                                        double *&ptrValue,
+                                        bool *&ptrHasValue,
+                                        QString &strError)
+{
+    // Solo se tipan los valores radiometricos, el resto queda en valuesByTagByGroup
+    ptrValue=NULL;
+    ptrHasValue=NULL;
+    tag=tag.toUpper();
+    if(tag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_SUN_AZIMUTH)==0)
+    {
+        ptrValue=&sunAzimuth;
+        ptrHasValue=&hasSunAzimuth;
+        return(true);
+    }
+    if(tag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_SUN_ELEVATION)==0)
+    {
+        ptrValue=&sunElevation;
+        ptrHasValue=&hasSunElevation;
+        return(true);
+    }
+    if(tag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_EARTH_SUN_DISTANCE)==0)
+    {
+        ptrValue=&earthSunDistance;
+        ptrHasValue=&hasEarthSunDistance;
+        return(true);
+    }
+    QVector<QString> bandPrefixes;
+    bandPrefixes.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_REFLECTANCE_MULT_BAND_PREFIX);
+    bandPrefixes.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_REFLECTANCE_ADD_BAND_PREFIX);
+    bandPrefixes.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_RADIANCE_MULT_BAND_PREFIX);
+    bandPrefixes.push_back(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_RADIANCE_ADD_BAND_PREFIX);
+    double* ptrBandValues[4]={reflectanceMult,reflectanceAdd,radianceMult,radianceAdd};
+    bool* ptrBandHasValues[4]={hasReflectanceMult,hasReflectanceAdd,hasRadianceMult,hasRadianceAdd};
+    for(int np=0;np<bandPrefixes.size();np++)
+    {
+        if(!tag.startsWith(bandPrefixes[np]))
+        {
+            continue;
+        }
+        bool okToInt=false;
+        int numberOfBand=tag.mid(bandPrefixes[np].size()).toInt(&okToInt);
+        if(!okToInt
+                ||numberOfBand<REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MINVALUE
+                ||numberOfBand>REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE)
+        {
+            strError=QObject::tr("Landsat8Metadata::getValuePointers");
+            strError+=QObject::tr("\nInvalid band number in tag: %1").arg(tag);
+            return(false);
+        }
+        ptrValue=&ptrBandValues[np][numberOfBand];
+        ptrHasValue=&ptrBandHasValues[np][numberOfBand];
+        return(true);
+    }
+    return(true);
+}
+
+bool Landsat8Metadata::setValue(QString tag,
+                                QString value,
+                                QString &strError)
+{
+    double* ptrValue=NULL;
+    bool* ptrHasValue=NULL;
+    if(!getValuePointers(tag,ptrValue,ptrHasValue,strError))
+    {
+        return(false);
+    }
+    if(ptrValue==NULL)
+    {
+        return(true);
+    }
+    bool okToDouble=false;
+    double dblValue=removeQuotes(value).toDouble(&okToDouble);
+    if(!okToDouble)
+    {
+        strError=QObject::tr("Landsat8Metadata::setValue");
+        strError+=QObject::tr("\nFor tag: %1 value is not a double: %2").arg(tag).arg(value);
+        return(false);
+    }
+    *ptrValue=dblValue;
+    *ptrHasValue=true;
+    return(true);
+}
+
 SceneLandsat8::SceneLandsat8(QString id,
                              libCRS::CRSTools *ptrCrsTools):
     Scene(id,
@@ -277,190 +597,17 @@ bool SceneLandsat8::setFromUsgsFormat(QString& scenePath,
 bool SceneLandsat8::setMetadataFromUsgsFormat(QString &inputFileName,
                                               QString &strError)
 {
-    mUsgsMetadata.clear();
-    if(!QFile::exists(inputFileName))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nNot exists input file:\n%1").arg(inputFileName);
-        return(false);
-    }
-    QFile fileInput(inputFileName);
-    if (!fileInput.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nError opening file: \n%1").arg(inputFileName);
-        return(false);
-    }
-    QTextStream in(&fileInput);
-
-    int intValue,nline=0;
-    double dblValue;
-    bool okToInt,okToDouble;
-    QString strLine,strValue,strTag;
-    QStringList strList;
-    QStringList strAuxList;
-    QDir currentDir=QDir::current();
-
-    // Se ignora la cabecera
-//    nline++;
-//    strLine=in.readLine();
-    QString tagGroup;
-    QMap<QString,QString> metadataGroup;
-    while(!in.atEnd())
-    {
-        nline++;
-        strLine=in.readLine();
-        strLine=strLine.trimmed();
-        mMetadataFileContent+=strLine;
-        mMetadataFileContent+="\n";
-        if(strLine.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_END,Qt::CaseInsensitive)==0) // línea final
-            continue;
-        strList=strLine.split(REMOTESENSING_LANDSAT8_USGS_METADATA_STRING_SEPARATOR);
-        if(strList.size()!=2)
-        {
-            strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
-            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(REMOTESENSING_LANDSAT8_USGS_METADATA_STRING_SEPARATOR);
-            fileInput.close();
-            mUsgsMetadata.clear();
-            return(false);
-        }
-        strTag=strList.at(0).trimmed();
-        if(strTag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_BEGIN_GROUP,Qt::CaseInsensitive)==0)
-        {
-            tagGroup=strList.at(1).trimmed();
-            // Comparar con los valores admitidos ... por hacer
-            metadataGroup.clear();
-            continue;
-        }
-        else if(strTag.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_END_GROUP,Qt::CaseInsensitive)==0)
-        {
-            mUsgsMetadata[tagGroup]=metadataGroup;
-        }
-        else
-        {
-            strValue=strList.at(1).trimmed();
-            metadataGroup[strTag]=strValue;
-        }
-    }
-    fileInput.close();
-    if(!mUsgsMetadata.contains(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nMetadata group not found: %1").arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    if(!mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA].contains(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 not found in metadata group: %2")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    QString strPath=mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA][REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH];
-    if(strPath.contains("\"")) // desprecio la parte decimal de segundo porque no se el número de decimales y hay un carácter z final
-    {
-        strPath=strPath.remove("\"");
-    }
-    int path=strPath.toInt(&okToInt);
-    if(!okToInt)
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 in metadata group: %2 is not an integer: %3")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA)
-                .arg(strPath);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    if(!mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA].contains(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_ROW))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 not found in metadata group: %2")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    QString strRow=mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA][REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_ROW];
-    if(strRow.contains("\"")) // desprecio la parte decimal de segundo porque no se el número de decimales y hay un carácter z final
-    {
-        strRow=strRow.remove("\"");
-    }
-    int row=strRow.toInt(&okToInt);
-    if(!okToInt)
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 in metadata group: %2 is not an integer: %3")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_ROW)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA)
-                .arg(strRow);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    if(!mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA].contains(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_DATE_ACQUIRED))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 not found in metadata group: %2")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    QString strDate=mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA][REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_DATE_ACQUIRED];
-    if(strDate.contains("\"")) // desprecio la parte decimal de segundo porque no se el número de decimales y hay un carácter z final
-    {
-        strDate=strDate.remove("\"");
-    }
-    QDate date=QDate::fromString(strDate,"yyyy-MM-dd");
-    if(!date.isValid())
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 in metadata group: %2 is not a valid date: %3")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_DATE_ACQUIRED)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA)
-                .arg(strDate);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    if(!mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA].contains(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_CENTER_TIME))
-    {
-        strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 not found in metadata group: %2")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_WRS_PATH)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA);
-        mUsgsMetadata.clear();
-        return(false);
-    }
-    QString strTime=mUsgsMetadata[REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA][REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_CENTER_TIME];
-    if(strTime.contains(".")) // desprecio la parte decimal de segundo porque no se el número de decimales y hay un carácter z final
-    {
-        QStringList strTimeList=strTime.split(".");
-        strTime=strTimeList.at(0);
-    }
-    if(strTime.contains("\"")) // desprecio la parte decimal de segundo porque no se el número de decimales y hay un carácter z final
-    {
-        strTime=strTime.remove("\"");
-    }
-    QTime time=QTime::fromString(strTime,"hh:mm:ss");
-    if(!time.isValid())
+    QString strAuxError;
+    if(!getMetadata(inputFileName,mMetadata,strAuxError))
     {
         strError=QObject::tr("SceneLandsat8::setMetadataFromUsgsFormat");
-        strError+=QObject::tr("\nTag: %1 in metadata group: %2 is not a valid time: %3")
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA_CENTER_TIME)
-                .arg(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_GROUP_PRODUCT_METADATA)
-                .arg(strDate);
-        mUsgsMetadata.clear();
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        mMetadata=Landsat8Metadata();
         return(false);
     }
-    mDateTime=QDateTime(date,time);
-    mPath=path;
-    mRow=row;
-
+    mDateTime=mMetadata.dateTime;
+    mPath=mMetadata.path;
+    mRow=mMetadata.row;
     return(true);
 }
 
@@ -503,8 +650,23 @@ bool SceneLandsat8::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGri
 
     QString strAuxError;
     NestedGrid::NestedGridTools* ptrNestedGridTools=mPtrNestedGridProject->getNestedGridTools();
+    // La huella limita la reproyeccion y los tuplekeys a recortar
+    if(!setFootprint(landsat8PathRowGeometries[mPath][mRow],
+                     landSat8PathRowCrsEpsgCode,
+                     REMOTESENSING_LANDSAT8_FOOTPRINT_BUFFER,
+                     ptrNestedGridTools->getCrsDescription(),
+                     strAuxError))
+    {
+        strError=QObject::tr("SceneLandsat8::createNestedGrid");
+        strError+=QObject::tr("\nError setting footprint for path: %1 and row: %2")
+                .arg(QString::number(mPath)).arg(QString::number(mRow));
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
     IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor=ptrNestedGridTools->getIGDALProcessMonitor();
     QString resamplingMethod=ptrNestedGridProject->getResamplingMethod();
+    QVector<QString> reprojectionInputFileNames;
+    QVector<QString> reprojectionOutputFileNames;
     for(int i=0;i<landsat8BandsToUse.size();i++)
     {
 //        QString bandId=QString::number(landsat8BandsToUse.at(i));
@@ -537,7 +699,7 @@ bool SceneLandsat8::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGri
                 QStringList arguments;
                 QString outputFileName;
                 QFileInfo fileInfo(fileName);
-                outputFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()+"_rpy."+fileInfo.suffix();
+                outputFileName=getReprojectedFileName(fileName,fileInfo.suffix());
                 if(QFile::exists(outputFileName))
                 {
                     QFlags<QFile::Permission> permissionsImage=QFile::permissions(outputFileName);
@@ -557,6 +719,12 @@ bool SceneLandsat8::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGri
                         return(false);
                     }
                 }
+                if(mReprojectInProcess)
+                {
+                    reprojectionInputFileNames.push_back(fileName);
+                    reprojectionOutputFileNames.push_back(outputFileName);
+                    continue;
+                }
                 bool forceReprojection=true;
                 if(!ptrLibIGDALProcessMonitor->rasterReprojectionGetProcessDefinition(fileName,
                                                                                       inputProj4Crs,
@@ -596,6 +764,31 @@ bool SceneLandsat8::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGri
 //            }
 //        }
     }
+    if(reprojectionInputFileNames.size()>0)
+    {
+        if(!reprojectRasterFiles(reprojectionInputFileNames,
+                                 reprojectionOutputFileNames,
+                                 mCrsDescription,
+                                 ptrNestedGridTools->getCrsDescription(),
+                                 resamplingMethod,
+                                 REMOTESENSING_LANDSAT8_NULL_VALUE,
+                                 strAuxError))
+        {
+            strError=QObject::tr("SceneLandsat8::createNestedGrid");
+            strError+=QObject::tr("\nError reprojecting bands:\nError: %1").arg(strAuxError);
+            return(false);
+        }
+        // Igual que al terminar cada proceso gdalwarp, pero un fallo se devuelve como error
+        for(int nf=0;nf<reprojectionInputFileNames.size();nf++)
+        {
+            if(!processReprojectionOutput(strAuxError))
+            {
+                strError=QObject::tr("SceneLandsat8::createNestedGrid");
+                strError+=QObject::tr("\nError tiling bands:\nError: %1").arg(strAuxError);
+                return(false);
+            }
+        }
+    }
     return(true);
 }
 
@@ -635,84 +828,97 @@ bool SceneLandsat8::getBandIdFromFileName(QString fileName,
     return(true);
 }
 
+bool SceneLandsat8::getMetadata(QString metadataFileName,
+                                Landsat8Metadata &metadata,
+                                QString &strError)
+{
+    QFileInfo fileInfo(metadataFileName);
+    if(!fileInfo.exists())
+    {
+        strError=QObject::tr("SceneLandsat8::getMetadata");
+        strError+=QObject::tr("\nNot exists input file:\n%1").arg(metadataFileName);
+        return(false);
+    }
+    QString fileName=fileInfo.absoluteFilePath();
+    QDateTime fileLastModified=fileInfo.lastModified();
+    qint64 fileSize=fileInfo.size();
+    {
+        QMutexLocker locker(&metadataCacheMutex);
+        if(metadataCache.contains(fileName))
+        {
+            const Landsat8Metadata& cachedMetadata=metadataCache[fileName];
+            if(cachedMetadata.fileSize==fileSize
+                    &&cachedMetadata.fileLastModified==fileLastModified)
+            {
+                metadata=cachedMetadata;
+                return(true);
+            }
+        }
+    }
+    Landsat8Metadata parsedMetadata;
+    parsedMetadata.fileName=fileName;
+    parsedMetadata.fileSize=fileSize;
+    parsedMetadata.fileLastModified=fileLastModified;
+    QString strAuxError;
+    if(!parseMetadataFile(fileName,parsedMetadata,strAuxError))
+    {
+        strError=QObject::tr("SceneLandsat8::getMetadata");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    {
+        QMutexLocker locker(&metadataCacheMutex);
+        metadataCache[fileName]=parsedMetadata;
+    }
+    metadata=parsedMetadata;
+    return(true);
+}
+
 bool SceneLandsat8::getMetadataValues(QString inputFileName,
                                       QVector<QString> metadataTags,
                                       QVector<QString> &metadataValues,
                                       QString &strError)
 {
     metadataValues.clear();
-    if(!QFile::exists(inputFileName))
+    Landsat8Metadata metadata;
+    QString strAuxError;
+    if(!getMetadata(inputFileName,metadata,strAuxError))
     {
         strError=QObject::tr("SceneLandsat8::getMetadataValues");
         strError+=QObject::tr("\nFor metadata file name: %1").arg(inputFileName);
-        strError+=QObject::tr("\nnot exists metadata file:\n%1").arg(inputFileName);
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
         return(false);
     }
-    QFile fileInput(inputFileName);
-    if (!fileInput.open(QIODevice::ReadOnly | QIODevice::Text))
-    {
-        strError=QObject::tr("SceneLandsat8::getMetadataValues");
-        strError+=QObject::tr("\nError opening file: \n%1").arg(inputFileName);
-        return(false);
-    }
-    QTextStream in(&fileInput);
-
-    int nline=0;
-    QString strLine,strTag;
-    QStringList strList;
-//    int intValue;
-//    double dblValue;
-//    bool okToInt,okToDouble;
-//    QStringList strAuxList;
-//    QDir currentDir=QDir::current();
-
-    // Se ignora la cabecera
-//    nline++;
-//    strLine=in.readLine();
-    QString tagGroup;
-    QMap<QString,QString> metadataValueByTag;
-    while(!in.atEnd())
-    {
-        nline++;
-        strLine=in.readLine();
-        strLine=strLine.trimmed();
-        if(strLine.compare(REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_END,Qt::CaseInsensitive)==0) // línea final
-            continue;
-        strList=strLine.split(REMOTESENSING_LANDSAT8_USGS_METADATA_STRING_SEPARATOR);
-        if(strList.size()!=2)
-        {
-            strError=QObject::tr("SceneLandsat8::getMetadataValues");
-            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
-            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
-            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(REMOTESENSING_LANDSAT8_USGS_METADATA_STRING_SEPARATOR);
-            fileInput.close();
-            return(false);
-        }
-        strTag=strList.at(0).trimmed();
-        if(metadataTags.contains(strTag)
-                ||metadataTags.contains(strTag.toLower())
-                ||metadataTags.contains(strTag.toUpper()))
-        {
-            metadataValueByTag[strTag]=strList.at(1).trimmed();
-        }
-    }
-    fileInput.close();
     for(int i=0;i<metadataTags.size();i++)
     {
         QString metadataTag=metadataTags[i];
-        if(metadataValueByTag.contains(metadataTag)
-                ||metadataTags.contains(metadataTag.toLower())
-                ||metadataTags.contains(metadataTag.toUpper()))
+        bool findTag=false;
+        QMap<QString,QMap<QString,QString> >::const_iterator iterGroup=metadata.valuesByTagByGroup.begin();
+        while(iterGroup!=metadata.valuesByTagByGroup.end())
         {
-            metadataValues.push_back(metadataValueByTag[metadataTag]);
+            QMap<QString,QString>::const_iterator iterTag=iterGroup.value().begin();
+            while(iterTag!=iterGroup.value().end())
+            {
+                if(iterTag.key().compare(metadataTag,Qt::CaseInsensitive)==0)
+                {
+                    metadataValues.push_back(iterTag.value());
+                    findTag=true;
+                    break;
+                }
+                iterTag++;
+            }
+            if(findTag)
+            {
+                break;
+            }
+            iterGroup++;
         }
-        else
+        if(!findTag)
         {
-            strError=QObject::tr("SceneLandsat"
-                                 "8::getMetadataValues");
+            strError=QObject::tr("SceneLandsat8::getMetadataValues");
             strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
             strError+=QObject::tr("\nTag %1 not found").arg(metadataTag);
-            fileInput.close();
+            metadataValues.clear();
             return(false);
         }
     }
@@ -722,7 +928,38 @@ bool SceneLandsat8::getMetadataValues(QString inputFileName,
 bool SceneLandsat8::getPersistenceData(QMap<QString, QString> &persistenceData,
                                        QString &strError)
 {
-    persistenceData[REMOTESENSING_LANDSAT8_USGS_METADATA_FILE_PERSISTENCE_TAG]=mMetadataFileContent;
+    persistenceData[REMOTESENSING_LANDSAT8_USGS_METADATA_FILE_PERSISTENCE_TAG]=mMetadata.fileContent;
+    return(true);
+}
+
+bool SceneLandsat8::insertTuplekeyFile(QString fileName,
+                                       QString &strError)
+{
+    QFileInfo fileInfo(fileName);
+    QString completeBaseName=fileInfo.completeBaseName();
+    if(!mBandCodeByBandUsgsFormatFileCompleteBaseName.contains(completeBaseName))
+    {
+        strError=QObject::tr("SceneLandsat8::insertTuplekeyFile");
+        strError+=QObject::tr("\nNot exists band for tuplekey file:\n%1").arg(fileName);
+        return(false);
+    }
+//        int numberOfBand=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
+    QString bandId=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
+    QDir fileDir=fileInfo.dir();
+    QString quadkey=fileDir.dirName();
+    if(!mTuplekeysByBand.contains(bandId))
+    {
+        QVector<QString> quadkeys;
+        mTuplekeysByBand[bandId]=quadkeys;
+    }
+//        if(!mQuadkeysByBand.contains(numberOfBand))
+//        {
+//            QVector<QString> quadkeys;
+//            mQuadkeysByBand[numberOfBand]=quadkeys;
+//        }
+//        mQuadkeysByBand[numberOfBand].push_back(quadkey);
+    mTuplekeysByBand[bandId].push_back(quadkey);
+    mTuplekeysFileNamesByBand[bandId].push_back(fileName);
     return(true);
 }
 
@@ -782,47 +1019,44 @@ void SceneLandsat8::onTuplekeySecondProcessFinished()
         QFileInfo fileInfo(fileName);
         mPtrNestedGridProject->addPathToRemoveIfEmpty(fileInfo.absolutePath());
     }
-    else
+    else if(!insertTuplekeyFile(fileName,strError))
     {
-        QFileInfo fileInfo(fileName);
-        QString completeBaseName=fileInfo.completeBaseName();
-//        int numberOfBand=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
-        QString bandId=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
-        QDir fileDir=fileInfo.dir();
-        QString quadkey=fileDir.dirName();
-        if(!mTuplekeysByBand.contains(bandId))
-        {
-            QVector<QString> quadkeys;
-            mTuplekeysByBand[bandId]=quadkeys;
-        }
-//        if(!mQuadkeysByBand.contains(numberOfBand))
-//        {
-//            QVector<QString> quadkeys;
-//            mQuadkeysByBand[numberOfBand]=quadkeys;
-//        }
-//        mQuadkeysByBand[numberOfBand].push_back(quadkey);
-        mTuplekeysByBand[bandId].push_back(quadkey);
+        (*mStdOut)<<strError<<"\n";
+        (*mStdOut).flush();
+        QCoreApplication::exit();
     }
     ptrRaster->closeDataset();
     mTuplekeysOutputFileNames.remove(0);
 }
 
 void SceneLandsat8::onReprojectionProcessFinished()
+{
+    QString strError;
+    if(!processReprojectionOutput(strError))
+    {
+        (*mStdOut)<<strError<<"\n";
+        (*mStdOut).flush();
+        QCoreApplication::exit();
+    }
+}
+
+bool SceneLandsat8::processReprojectionOutput(QString &strError)
 {
     QString fileName=mReprojectionProcessesOutputFileNames[0];
     QFileInfo fileInfo(fileName);
     QString completeBaseName=fileInfo.completeBaseName();
     QString bandId=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
+    mExpectedTuplekeysFileNamesByBand.remove(bandId);
+    mEmptyTuplekeysFileNamesByBand.remove(bandId);
 //    int numberOfBand=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
     QString outputFileName;
-    outputFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()+"_rpy."+fileInfo.suffix();
+    outputFileName=getReprojectedFileName(fileName,fileInfo.suffix());
     if(!QFile::exists(outputFileName))
     {
-        QString msg=QObject::tr("SceneLandsat8::onReprojectionProcessFinished\nOutput file not exists:\n%1")
+        strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+        strError+=QObject::tr("\nOutput file not exists:\n%1")
                 .arg(outputFileName);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        return(false);
     }
     QDir tmpDir(fileInfo.absolutePath());
     QStringList filters;
@@ -834,17 +1068,16 @@ void SceneLandsat8::onReprojectionProcessFinished()
         QString fileName=fileInfoList[i].absoluteFilePath();
         mPtrNestedGridProject->addFileToRemove(fileName);
     }
-    QString strError;
+    QString strAuxError;
     IGDAL::Raster* ptrReprojectedRasterBand=new IGDAL::Raster(mPtrCrsTools);
     if(!ptrReprojectedRasterBand->setFromFile(outputFileName,
-                                              strError))
+                                              strAuxError))
     {
-        QString msg=QObject::tr("SceneLandsat8::onReprojectionProcessFinished");
-        msg+=QObject::tr("\nError openning reprojected raster file:\n%1\nError:\n%2")
-                .arg(outputFileName).arg(strError);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+        strError+=QObject::tr("\nError openning reprojected raster file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        delete(ptrReprojectedRasterBand);
+        return(false);
     }
     NestedGrid::NestedGridTools* ptrNestedGridTools=mPtrNestedGridProject->getNestedGridTools();
     QString reprojectedProj4Crs=ptrNestedGridTools->getCrsDescription();
@@ -853,16 +1086,16 @@ void SceneLandsat8::onReprojectionProcessFinished()
                                                  nwSc,
                                                  seFc,
                                                  seSc,
-                                                 strError))
+                                                 strAuxError))
     {
-        QString msg=QObject::tr("SceneLandsat8::onReprojectionProcessFinished");
-        msg+=QObject::tr("\nError recovering bounding box from reprojected raster file:\n%1\nError:\n%2")
-                .arg(outputFileName).arg(strError);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+        strError+=QObject::tr("\nError recovering bounding box from reprojected raster file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        delete(ptrReprojectedRasterBand);
+        return(false);
     }
     ptrReprojectedRasterBand->closeDataset();
+    delete(ptrReprojectedRasterBand);
     int lodStorage=mPtrNestedGridProject->getLandsat8LODStorage(bandId);
     int lodSpatialResolution=mPtrNestedGridProject->getLandsat8LODSpatialResolution(bandId);
 //    int lodStorage=mPtrNestedGridProject->getLandsatLODStorage(numberOfBand);
@@ -880,15 +1113,14 @@ void SceneLandsat8::onReprojectionProcessFinished()
     QVector<QVector<double> > boundingBoxes;
     if(!ptrNestedGridTools->getTiles(lodStorage,reprojectedProj4Crs,nwFc,nwSc,seFc,seSc,
                                      tuplekeys,tilesX,tilesY,boundingBoxes,
-                                     strError))
+                                     strAuxError))
     {
-        QString msg=QObject::tr("SceneLandsat8::onReprojectionProcessFinished");
-        msg+=QObject::tr("\nError recovering tiles for reprojected raster file:\n%1\nError:\n%2")
-                .arg(outputFileName).arg(strError);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+        strError+=QObject::tr("\nError recovering tiles for reprojected raster file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        return(false);
     }
+    selectFootprintTuplekeys(tuplekeys,tilesX,tilesY,boundingBoxes);
     QDir auxDir=QDir::currentPath();
 //    IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor=ptrNestedGridTools->getIGDALProcessMonitor();
     QString resamplingMethod=mPtrNestedGridProject->getResamplingMethod();
@@ -899,6 +1131,9 @@ void SceneLandsat8::onReprojectionProcessFinished()
     }
     QString strCompressionArgument="COMPRESS="+compressionMethod;
     bool createTiledRaster=mPtrNestedGridProject->getCreateTiledRaster();
+    QVector<QString> tilesOutputFileNames;
+    QVector<QString> emptyTilesOutputFileNames;
+    QVector<QVector<double> > tilesBoundingBoxes;
     for(int nTile=0;nTile<tuplekeys.size();nTile++)
     {
         QString tuplekey=tuplekeys.at(nTile);
@@ -913,11 +1148,9 @@ void SceneLandsat8::onReprojectionProcessFinished()
         {
             if(!auxDir.mkpath(tuplekeyPath))
             {
-                QString msg=QObject::tr("SceneLandsat8::onReprojectionProcessFinished");
-                msg+=QObject::tr("\nError making tuplekey path:\n%1").arg(tuplekeyPath);
-                (*mStdOut)<<msg<<"\n";
-                (*mStdOut).flush();
-                QCoreApplication::exit();
+                strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+                strError+=QObject::tr("\nError making tuplekey path:\n%1").arg(tuplekeyPath);
+                return(false);
             }
         }
         QString outputTuplekeyFileName=tuplekeyPath+"/"+fileInfo.baseName()+"."+fileInfo.suffix();
@@ -925,11 +1158,9 @@ void SceneLandsat8::onReprojectionProcessFinished()
         {
             if(!QFile::remove(outputTuplekeyFileName))
             {
-                QString msg=QObject::tr("SceneLandsat8::onReprojectionProcessFinished");
-                msg+=QObject::tr("\nError removing tuplekey output file:\n%1").arg(outputTuplekeyFileName);
-                (*mStdOut)<<msg<<"\n";
-                (*mStdOut).flush();
-                QCoreApplication::exit();
+                strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+                strError+=QObject::tr("\nError removing tuplekey output file:\n%1").arg(outputTuplekeyFileName);
+                return(false);
             }
         }
 //        if(quadkey.compare("0313333323")==0)
@@ -938,6 +1169,12 @@ void SceneLandsat8::onReprojectionProcessFinished()
 //            yo++;
 //        }
         mTuplekeysOutputFileNames.push_back(outputTuplekeyFileName);
+        if(mReprojectInProcess)
+        {
+            tilesOutputFileNames.push_back(outputTuplekeyFileName);
+            tilesBoundingBoxes.push_back(boundingBoxes.at(nTile));
+            continue;
+        }
         {
             QString command=LIBIGDAL_GDALTRANSLATE_COMMAND;
             QStringList arguments;
@@ -1021,5 +1258,62 @@ void SceneLandsat8::onReprojectionProcessFinished()
             mPtrMultiProcess->appendProcess(ptrProcess);
         }
     }
+    if(tilesOutputFileNames.size()>0)
+    {
+        // Una sola lectura del fichero reproyectado para todos los tuplekeys
+        QStringList creationOptions;
+        if(createTiledRaster)
+        {
+            creationOptions<<"TILED=YES";
+        }
+        creationOptions<<strCompressionArgument;
+        QVector<int> overviewFactors;
+        QVector<bool> emptyTiles;
+        int overview=1;
+        for(int lod=lodStorage+1;lod<=lodSpatialResolution;lod++)
+        {
+            overview*=2;
+            overviewFactors.push_back(overview);
+        }
+        if(!tileRasterFile(outputFileName,
+                           tilesOutputFileNames,
+                           tilesBoundingBoxes,
+                           basePixelSize,
+                           resamplingMethod,
+                           REMOTESENSING_LANDSAT8_NULL_VALUE,
+                           creationOptions,
+                           overviewFactors,
+                           emptyTiles,
+                           strAuxError))
+        {
+            strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+            strError+=QObject::tr("\nError tiling reprojected raster file:\n%1\nError:\n%2")
+                    .arg(outputFileName).arg(strAuxError);
+            return(false);
+        }
+        // Los tuplekeys sin pixeles validos no llegan a crearse: no hay que abrirlos ni borrarlos
+        for(int nt=0;nt<tilesOutputFileNames.size();nt++)
+        {
+            if(emptyTiles[nt])
+            {
+                QFileInfo tileFileInfo(tilesOutputFileNames[nt]);
+                mPtrNestedGridProject->addPathToRemoveIfEmpty(tileFileInfo.absolutePath());
+                emptyTilesOutputFileNames.push_back(tilesOutputFileNames[nt]);
+            }
+            else if(!insertTuplekeyFile(tilesOutputFileNames[nt],strAuxError))
+            {
+                strError=QObject::tr("SceneLandsat8::processReprojectionOutput");
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
+            mTuplekeysOutputFileNames.remove(0);
+        }
+    }
+    if(mReprojectInProcess)
+    {
+        mExpectedTuplekeysFileNamesByBand[bandId]=tilesOutputFileNames;
+        mEmptyTuplekeysFileNamesByBand[bandId]=emptyTilesOutputFileNames;
+    }
     mReprojectionProcessesOutputFileNames.remove(0);
+    return(true);
 }
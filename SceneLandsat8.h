@@ -5,6 +5,7 @@
 #include "Scene.h"
 
 #include <QDateTime>
+#include <QMap>
 #include <QTextStream>
 
 class OGRGeometry;
@@ -14,6 +15,44 @@ namespace ProcessTools{
 }
 
 namespace RemoteSensing{
+// Metadatos MTL de USGS leidos una sola vez. Los coeficientes se indexan por numero de banda
+struct LIBREMOTESENSINGSHARED_EXPORT Landsat8Metadata
+{
+    Landsat8Metadata();
+    bool getValue(QString tag,
+                  double& value,
+                  QString& strError);
+    bool getValuePointers(QString tag,
+                          double*& ptrValue,
+                          bool*& ptrHasValue,
+                          QString& strError);
+    bool setValue(QString tag,
+                  QString value,
+                  QString& strError);
+    QString fileName;
+    qint64 fileSize;
+    QDateTime fileLastModified;
+    QString fileContent;
+    QMap<QString,QMap<QString,QString> > valuesByTagByGroup;
+    int path;
+    int row;
+    QDateTime dateTime;
+    double sunAzimuth;
+    double sunElevation;
+    double earthSunDistance;
+    bool hasSunAzimuth;
+    bool hasSunElevation;
+    bool hasEarthSunDistance;
+    double reflectanceMult[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    double reflectanceAdd[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    double radianceMult[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    double radianceAdd[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    bool hasReflectanceMult[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    bool hasReflectanceAdd[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    bool hasRadianceMult[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+    bool hasRadianceAdd[REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE+1];
+};
+
 class LIBREMOTESENSINGSHARED_EXPORT SceneLandsat8 : public Scene
 {
     Q_OBJECT
@@ -35,6 +74,10 @@ public:
     static bool getBandIdFromFileName(QString fileName,
                                       QString& bandId,
                                       QString& strError);
+    static bool getMetadata(QString metadataFileName,
+                            Landsat8Metadata& metadata,
+                            QString& strError);
+    const Landsat8Metadata& getMetadata(){return(mMetadata);}
     static bool getMetadataValues(QString metadataFileName,
                                   QVector<QString> metadataTags,
                                   QVector<QString>& metadataValues,
@@ -54,17 +97,19 @@ public slots:
     void manageProccesStdOutput(QString data);
     void manageProccesErrorOutput(QString data);
 private:
+    bool insertTuplekeyFile(QString fileName,
+                            QString& strError);
+    bool processReprojectionOutput(QString& strError);
     QTextStream* mStdOut;
     QString mMetadataUsgsFormatFileName;
     QMap<QString,QString> mBandsUsgsFormatFileName;
-    QMap<QString,QMap<QString,QString> > mUsgsMetadata;
+    Landsat8Metadata mMetadata;
     QMap<QString,QString> mBandCodeByBandUsgsFormatFileCompleteBaseName;
     int mPath;
     int mRow;
     QDateTime mDateTime;
     QVector<QString> mReprojectionProcessesOutputFileNames;
     QVector<QString> mTuplekeysOutputFileNames;
-    QString mMetadataFileContent;
     QVector<QString> mLandsat8BandsCode;
     QString mStrBandsCodeValidDomain;
     QMap<QString,QVector<QString> > mLandsat8BandsCodeAliasByCode;
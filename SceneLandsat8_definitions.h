@@ -3,6 +3,7 @@
 
 #define REMOTESENSING_LANDSAT8_NULL_VALUE                                                   0
 #define REMOTESENSING_LANDSAT8_FOOTPRINT_EPSG_CODE                                          4326
+#define REMOTESENSING_LANDSAT8_FOOTPRINT_BUFFER                                             0.1 // grados, la escena real se desplaza respecto a WRS-2
 #define REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MINVALUE                                      1
 #define REMOTESENSING_LANDSAT8_NUMBER_OF_BAND_MAXVALUE                                      12
 #define REMOTESENSING_LANDSAT8_USGS_FORMAT_METADATA_FILE_SUFFIX                             "_MTL"
@@ -106,6 +107,11 @@
 #define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_RADIANCE_ADD_BAND_10                       "RADIANCE_ADD_BAND_10"
 #define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_RADIANCE_ADD_BAND_11                       "RADIANCE_ADD_BAND_11"
 
+#define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_REFLECTANCE_MULT_BAND_PREFIX               "REFLECTANCE_MULT_BAND_"
+#define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_REFLECTANCE_ADD_BAND_PREFIX                "REFLECTANCE_ADD_BAND_"
+#define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_RADIANCE_MULT_BAND_PREFIX                  "RADIANCE_MULT_BAND_"
+#define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_RADIANCE_ADD_BAND_PREFIX                   "RADIANCE_ADD_BAND_"
+
 #define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_SUN_AZIMUTH                                "SUN_AZIMUTH"
 #define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_SUN_ELEVATION                              "SUN_ELEVATION"
 #define REMOTESENSING_LANDSAT8_USGS_METADATA_TAG_EARTH_SUN_DISTANCE                         "EARTH_SUN_DISTANCE"
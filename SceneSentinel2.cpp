@@ -6,6 +6,9 @@
 #include <QDateTime>
 #include <QtCore>
 
+#include <cpl_vsi.h>
+#include <cpl_string.h>
+
 //#include "../../libs/libPW/libPW.h"
 #include "../../libs/libProcessTools/Process.h"
 #include "../../libs/libProcessTools/ExternalProcess.h"
@@ -75,6 +78,8 @@ bool SceneSentinel2::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGr
     NestedGrid::NestedGridTools* ptrNestedGridTools=mPtrNestedGridProject->getNestedGridTools();
     IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor=ptrNestedGridTools->getIGDALProcessMonitor();
     QString resamplingMethod=ptrNestedGridProject->getResamplingMethod();
+    QVector<QString> reprojectionInputFileNames;
+    QVector<QString> reprojectionOutputFileNames;
     for(int i=0;i<sentinel2BandsToUse.size();i++)
     {
 //        QString bandId=QString::number(landsat8BandsToUse.at(i));
@@ -120,7 +125,7 @@ bool SceneSentinel2::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGr
                     outputFileExtension=NESTED_GRID_RASTER_FORMAT_GTIFF_FILE_EXTENSION;
                 }
 //                outputFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()+"_rpy."+fileInfo.suffix();
-                outputFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()+"_rpy."+outputFileExtension;
+                outputFileName=getReprojectedFileName(fileName,outputFileExtension);
                 if(QFile::exists(outputFileName))
                 {
                     QFlags<QFile::Permission> permissionsImage=QFile::permissions(outputFileName);
@@ -140,6 +145,12 @@ bool SceneSentinel2::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGr
                         return(false);
                     }
                 }
+                if(mReprojectInProcess)
+                {
+                    reprojectionInputFileNames.push_back(fileName);
+                    reprojectionOutputFileNames.push_back(outputFileName);
+                    continue;
+                }
                 bool forceReprojection=true;
                 if(!ptrLibIGDALProcessMonitor->rasterReprojectionGetProcessDefinition(fileName,
                                                                                       inputProj4Crs,
@@ -182,6 +193,31 @@ bool SceneSentinel2::createNestedGrid(NestedGrid::NestedGridProject *ptrNestedGr
 //            onReprojectionProcessFinished();
 //        }
     }
+    if(reprojectionInputFileNames.size()>0)
+    {
+        if(!reprojectRasterFiles(reprojectionInputFileNames,
+                                 reprojectionOutputFileNames,
+                                 mCrsDescription,
+                                 ptrNestedGridTools->getCrsDescription(),
+                                 resamplingMethod,
+                                 REMOTESENSING_SENTINEL2_NULL_VALUE,
+                                 strAuxError))
+        {
+            strError=QObject::tr("SceneSentinel2::createNestedGrid");
+            strError+=QObject::tr("\nError reprojecting bands:\nError: %1").arg(strAuxError);
+            return(false);
+        }
+        // Igual que al terminar cada proceso gdalwarp, pero un fallo se devuelve como error
+        for(int nf=0;nf<reprojectionInputFileNames.size();nf++)
+        {
+            if(!processReprojectionOutput(strAuxError))
+            {
+                strError=QObject::tr("SceneSentinel2::createNestedGrid");
+                strError+=QObject::tr("\nError tiling bands:\nError: %1").arg(strAuxError);
+                return(false);
+            }
+        }
+    }
     return(true);
 }
 
@@ -275,6 +311,23 @@ bool SceneSentinel2::setFromEsaZipFormat(QString &scenePath,
         return(false);
     }
     mMetadataEsaZipFormatFileName=sceneMetadataFile;
+    // Bandas leidas sin extraer desde el zip de ESA. Los ficheros reproyectados van junto al zip
+    bool bandsInZip=false;
+    QFileInfo scenePathFileInfo(scenePath);
+    if(scenePathFileInfo.isFile()
+            &&scenePathFileInfo.suffix().compare(REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_FILE_EXTENSION,Qt::CaseInsensitive)==0)
+    {
+        bandsInZip=true;
+        if(!getZipBandsIndex(scenePathFileInfo.absoluteFilePath(),
+                             strAuxError))
+        {
+            strError=QObject::tr("SceneSentinel2::setFromEsaZipFormat");
+            strError+=QObject::tr("\nFor scene: %1").arg(mId);
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        mReprojectionPath=scenePathFileInfo.absolutePath();
+    }
     QString sceneCrsDescription;
     for(int nb=0;nb<mSentinel2BandsCode.size();nb++)
     {
@@ -283,7 +336,18 @@ bool SceneSentinel2::setFromEsaZipFormat(QString &scenePath,
 //        bandFileName+=QString::number(nb);
         bandFileName+=bandCode;
         bandFileName+=REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_BAND_FILE_EXTENSION;
-        if(!QFile::exists(bandFileName))
+        if(bandsInZip)
+        {
+            if(!mZipBandFileNameByBandCode.contains(bandCode))
+            {
+                strError=QObject::tr("SceneSentinel2::setFromEsaZipFormat");
+                strError+=QObject::tr("\nFor scene: %1").arg(mId);
+                strError+=QObject::tr("\nnot exists band: %1 in file:\n%2").arg(bandCode).arg(scenePath);
+                return(false);
+            }
+            bandFileName=mZipBandFileNameByBandCode[bandCode];
+        }
+        else if(!QFile::exists(bandFileName))
         {
             strError=QObject::tr("SceneSentinel2::setFromEsaZipFormat");
             strError+=QObject::tr("\nFor scene: %1").arg(mId);
@@ -354,6 +418,74 @@ bool SceneSentinel2::setFromEsaZipFormat(QString &scenePath,
     return(true);
 }
 
+bool SceneSentinel2::getZipBandsIndex(QString zipFileName,
+                                      QString &strError)
+{
+    mZipBandFileNameByBandCode.clear();
+    // Un solo recorrido del directorio del zip por escena
+    QString vsiZipFileName=REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_VSIZIP_PREFIX+zipFileName;
+    char** ptrEntries=VSIReadDirRecursive(vsiZipFileName.toStdString().c_str());
+    if(ptrEntries==NULL)
+    {
+        strError=QObject::tr("SceneSentinel2::getZipBandsIndex");
+        strError+=QObject::tr("\nError reading contents of file:\n%1").arg(zipFileName);
+        return(false);
+    }
+    for(int ne=0;ptrEntries[ne]!=NULL;ne++)
+    {
+        QString entry=QString::fromUtf8(ptrEntries[ne]);
+        if(!entry.contains(REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_BANDS_FOLDER))
+        {
+            continue;
+        }
+        for(int nb=0;nb<mSentinel2BandsCode.size();nb++)
+        {
+            QString bandCode=mSentinel2BandsCode[nb];
+            QString bandFileEnd=REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_BAND_FILE_SUFFIX;
+            bandFileEnd+=bandCode;
+            bandFileEnd+=REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_BAND_FILE_EXTENSION;
+            if(entry.endsWith(bandFileEnd,Qt::CaseInsensitive))
+            {
+                mZipBandFileNameByBandCode[bandCode]=vsiZipFileName+"/"+entry;
+                break;
+            }
+        }
+    }
+    CSLDestroy(ptrEntries);
+    return(true);
+}
+
+bool SceneSentinel2::insertTuplekeyFile(QString fileName,
+                                        QString &strError)
+{
+    QFileInfo fileInfo(fileName);
+    QString completeBaseName=fileInfo.completeBaseName();
+    if(!mBandCodeByBandEsaZipFormatFileCompleteBaseName.contains(completeBaseName))
+    {
+        strError=QObject::tr("SceneSentinel2::insertTuplekeyFile");
+        strError+=QObject::tr("\nNot exists band for tuplekey file:\n%1").arg(fileName);
+        return(false);
+    }
+//        int numberOfBand=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
+    QString bandId=mBandCodeByBandEsaZipFormatFileCompleteBaseName[completeBaseName];
+    QDir fileDir=fileInfo.dir();
+    QString quadkey=fileDir.dirName();
+    if(!mTuplekeysByBand.contains(bandId))
+    {
+        QVector<QString> quadkeys;
+        mTuplekeysByBand[bandId]=quadkeys;
+    }
+//        if(!mQuadkeysByBand.contains(numberOfBand))
+//        {
+//            QVector<QString> quadkeys;
+//            mQuadkeysByBand[numberOfBand]=quadkeys;
+//        }
+//        mQuadkeysByBand[numberOfBand].push_back(quadkey);
+    mTuplekeysByBand[bandId].push_back(quadkey);
+    mTuplekeysFileNamesByBand[bandId].push_back(fileName);
+    return(true);
+}
+
 void SceneSentinel2::onTuplekeyFirstProcessFinished()
 {
     QString fileName=mTuplekeysOutputFileNames[0];
@@ -432,64 +564,59 @@ void SceneSentinel2::onTuplekeySecondProcessFinished()
         QFileInfo fileInfo(fileName);
         mPtrNestedGridProject->addPathToRemoveIfEmpty(fileInfo.absolutePath());
     }
-    else
+    else if(!insertTuplekeyFile(fileName,strError))
     {
-        QFileInfo fileInfo(fileName);
-        QString completeBaseName=fileInfo.completeBaseName();
-//        int numberOfBand=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
-        QString bandId=mBandCodeByBandEsaZipFormatFileCompleteBaseName[completeBaseName];
-        QDir fileDir=fileInfo.dir();
-        QString quadkey=fileDir.dirName();
-        if(!mTuplekeysByBand.contains(bandId))
-        {
-            QVector<QString> quadkeys;
-            mTuplekeysByBand[bandId]=quadkeys;
-        }
-//        if(!mQuadkeysByBand.contains(numberOfBand))
-//        {
-//            QVector<QString> quadkeys;
-//            mQuadkeysByBand[numberOfBand]=quadkeys;
-//        }
-//        mQuadkeysByBand[numberOfBand].push_back(quadkey);
-        mTuplekeysByBand[bandId].push_back(quadkey);
+        (*mStdOut)<<strError<<"\n";
+        (*mStdOut).flush();
+        QCoreApplication::exit();
     }
     ptrRaster->closeDataset();
     mTuplekeysOutputFileNames.remove(0);
 }
 
 void SceneSentinel2::onReprojectionProcessFinished()
+{
+    QString strError;
+    if(!processReprojectionOutput(strError))
+    {
+        (*mStdOut)<<strError<<"\n";
+        (*mStdOut).flush();
+        QCoreApplication::exit();
+    }
+}
+
+bool SceneSentinel2::processReprojectionOutput(QString &strError)
 {
     QString fileName=mReprojectionProcessesOutputFileNames[0];
     QFileInfo fileInfo(fileName);
     QString completeBaseName=fileInfo.completeBaseName();
     QString bandId=mBandCodeByBandEsaZipFormatFileCompleteBaseName[completeBaseName];
+    mExpectedTuplekeysFileNamesByBand.remove(bandId);
+    mEmptyTuplekeysFileNamesByBand.remove(bandId);
 //    int numberOfBand=mBandCodeByBandUsgsFormatFileCompleteBaseName[completeBaseName];
     QString outputFileName;
     QString outputFileExtension=mPtrNestedGridProject->getRasterFormat();
     if(outputFileExtension.compare(NESTED_GRID_RASTER_FORMAT_GTIFF,Qt::CaseInsensitive)!=0)
     {
-        QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished");
-        msg+=QObject::tr("\For scene: %1\nnot valid output format:%2")
+        strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+        strError+=QObject::tr("\nFor scene: %1\nnot valid output format:%2")
                 .arg(mId).arg(outputFileExtension);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        return(false);
     }
     else
     {
         outputFileExtension=NESTED_GRID_RASTER_FORMAT_GTIFF_FILE_EXTENSION;
     }
 //    outputFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()+"_rpy."+fileInfo.suffix();
-    outputFileName=fileInfo.absolutePath()+"/"+fileInfo.completeBaseName()+"_rpy."+outputFileExtension;
+    outputFileName=getReprojectedFileName(fileName,outputFileExtension);
     if(!QFile::exists(outputFileName))
     {
-        QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished\nOutput file not exists:\n%1")
+        strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+        strError+=QObject::tr("\nOutput file not exists:\n%1")
                 .arg(outputFileName);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        return(false);
     }
-    QDir tmpDir(fileInfo.absolutePath());
+    QDir tmpDir(QFileInfo(outputFileName).absolutePath());
     QStringList filters;
     QString filter=fileInfo.completeBaseName()+"_rpy.*";
     filters << filter;
@@ -499,17 +626,16 @@ void SceneSentinel2::onReprojectionProcessFinished()
         QString fileName=fileInfoList[i].absoluteFilePath();
         mPtrNestedGridProject->addFileToRemove(fileName);
     }
-    QString strError;
+    QString strAuxError;
     IGDAL::Raster* ptrReprojectedRasterBand=new IGDAL::Raster(mPtrCrsTools);
     if(!ptrReprojectedRasterBand->setFromFile(outputFileName,
-                                              strError))
+                                              strAuxError))
     {
-        QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished");
-        msg+=QObject::tr("\nError openning reprojected raster file:\n%1\nError:\n%2")
-                .arg(outputFileName).arg(strError);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+        strError+=QObject::tr("\nError openning reprojected raster file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        delete(ptrReprojectedRasterBand);
+        return(false);
     }
     NestedGrid::NestedGridTools* ptrNestedGridTools=mPtrNestedGridProject->getNestedGridTools();
     QString reprojectedProj4Crs=ptrNestedGridTools->getCrsDescription();
@@ -518,16 +644,16 @@ void SceneSentinel2::onReprojectionProcessFinished()
                                                  nwSc,
                                                  seFc,
                                                  seSc,
-                                                 strError))
+                                                 strAuxError))
     {
-        QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished");
-        msg+=QObject::tr("\nError recovering bounding box from reprojected raster file:\n%1\nError:\n%2")
-                .arg(outputFileName).arg(strError);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+        strError+=QObject::tr("\nError recovering bounding box from reprojected raster file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        delete(ptrReprojectedRasterBand);
+        return(false);
     }
     ptrReprojectedRasterBand->closeDataset();
+    delete(ptrReprojectedRasterBand);
     int lodStorage=mPtrNestedGridProject->getSentinel2LODStorage(bandId);
     int lodSpatialResolution=mPtrNestedGridProject->getSentinel2LODSpatialResolution(bandId);
 //    int lodStorage=mPtrNestedGridProject->getLandsatLODStorage(numberOfBand);
@@ -545,14 +671,12 @@ void SceneSentinel2::onReprojectionProcessFinished()
     QVector<QVector<double> > boundingBoxes;
     if(!ptrNestedGridTools->getTiles(lodStorage,reprojectedProj4Crs,nwFc,nwSc,seFc,seSc,
                                      tuplekeys,tilesX,tilesY,boundingBoxes,
-                                     strError))
+                                     strAuxError))
     {
-        QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished");
-        msg+=QObject::tr("\nError recovering tiles for reprojected raster file:\n%1\nError:\n%2")
-                .arg(outputFileName).arg(strError);
-        (*mStdOut)<<msg<<"\n";
-        (*mStdOut).flush();
-        QCoreApplication::exit();
+        strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+        strError+=QObject::tr("\nError recovering tiles for reprojected raster file:\n%1\nError:\n%2")
+                .arg(outputFileName).arg(strAuxError);
+        return(false);
     }
     QDir auxDir=QDir::currentPath();
 //    IGDAL::libIGDALProcessMonitor* ptrLibIGDALProcessMonitor=ptrNestedGridTools->getIGDALProcessMonitor();
@@ -564,6 +688,9 @@ void SceneSentinel2::onReprojectionProcessFinished()
     }
     QString strCompressionArgument="COMPRESS="+compressionMethod;
     bool createTiledRaster=mPtrNestedGridProject->getCreateTiledRaster();
+    QVector<QString> tilesOutputFileNames;
+    QVector<QString> emptyTilesOutputFileNames;
+    QVector<QVector<double> > tilesBoundingBoxes;
     for(int nTile=0;nTile<tuplekeys.size();nTile++)
     {
         QString tuplekey=tuplekeys.at(nTile);
@@ -578,11 +705,9 @@ void SceneSentinel2::onReprojectionProcessFinished()
         {
             if(!auxDir.mkpath(tuplekeyPath))
             {
-                QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished");
-                msg+=QObject::tr("\nError making tuplekey path:\n%1").arg(tuplekeyPath);
-                (*mStdOut)<<msg<<"\n";
-                (*mStdOut).flush();
-                QCoreApplication::exit();
+                strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+                strError+=QObject::tr("\nError making tuplekey path:\n%1").arg(tuplekeyPath);
+                return(false);
             }
         }
 //        QString outputQuadkeyFileName=quadKeyPath+"/"+fileInfo.baseName()+"."+fileInfo.suffix();
@@ -591,11 +716,9 @@ void SceneSentinel2::onReprojectionProcessFinished()
         {
             if(!QFile::remove(outputTuplekeyFileName))
             {
-                QString msg=QObject::tr("SceneSentinel2::onReprojectionProcessFinished");
-                msg+=QObject::tr("\nError removing tuplekey output file:\n%1").arg(outputTuplekeyFileName);
-                (*mStdOut)<<msg<<"\n";
-                (*mStdOut).flush();
-                QCoreApplication::exit();
+                strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+                strError+=QObject::tr("\nError removing tuplekey output file:\n%1").arg(outputTuplekeyFileName);
+                return(false);
             }
         }
 //        if(quadkey.compare("0313333323")==0)
@@ -604,6 +727,12 @@ void SceneSentinel2::onReprojectionProcessFinished()
 //            yo++;
 //        }
         mTuplekeysOutputFileNames.push_back(outputTuplekeyFileName);
+        if(mReprojectInProcess)
+        {
+            tilesOutputFileNames.push_back(outputTuplekeyFileName);
+            tilesBoundingBoxes.push_back(boundingBoxes.at(nTile));
+            continue;
+        }
         {
             QString command=LIBIGDAL_GDALTRANSLATE_COMMAND;
             QStringList arguments;
@@ -687,5 +816,62 @@ void SceneSentinel2::onReprojectionProcessFinished()
             mPtrMultiProcess->appendProcess(ptrProcess);
         }
     }
+    if(tilesOutputFileNames.size()>0)
+    {
+        // Una sola lectura del fichero reproyectado para todos los tuplekeys
+        QStringList creationOptions;
+        if(createTiledRaster)
+        {
+            creationOptions<<"TILED=YES";
+        }
+        creationOptions<<strCompressionArgument;
+        QVector<int> overviewFactors;
+        QVector<bool> emptyTiles;
+        int overview=1;
+        for(int lod=lodStorage+1;lod<=lodSpatialResolution;lod++)
+        {
+            overview*=2;
+            overviewFactors.push_back(overview);
+        }
+        if(!tileRasterFile(outputFileName,
+                           tilesOutputFileNames,
+                           tilesBoundingBoxes,
+                           basePixelSize,
+                           resamplingMethod,
+                           REMOTESENSING_SENTINEL2_NULL_VALUE,
+                           creationOptions,
+                           overviewFactors,
+                           emptyTiles,
+                           strAuxError))
+        {
+            strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+            strError+=QObject::tr("\nError tiling reprojected raster file:\n%1\nError:\n%2")
+                    .arg(outputFileName).arg(strAuxError);
+            return(false);
+        }
+        // Los tuplekeys sin pixeles validos no llegan a crearse: no hay que abrirlos ni borrarlos
+        for(int nt=0;nt<tilesOutputFileNames.size();nt++)
+        {
+            if(emptyTiles[nt])
+            {
+                QFileInfo tileFileInfo(tilesOutputFileNames[nt]);
+                mPtrNestedGridProject->addPathToRemoveIfEmpty(tileFileInfo.absolutePath());
+                emptyTilesOutputFileNames.push_back(tilesOutputFileNames[nt]);
+            }
+            else if(!insertTuplekeyFile(tilesOutputFileNames[nt],strAuxError))
+            {
+                strError=QObject::tr("SceneSentinel2::processReprojectionOutput");
+                strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+                return(false);
+            }
+            mTuplekeysOutputFileNames.remove(0);
+        }
+    }
+    if(mReprojectInProcess)
+    {
+        mExpectedTuplekeysFileNamesByBand[bandId]=tilesOutputFileNames;
+        mEmptyTuplekeysFileNamesByBand[bandId]=emptyTilesOutputFileNames;
+    }
     mReprojectionProcessesOutputFileNames.remove(0);
+    return(true);
 }
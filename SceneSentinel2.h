@@ -47,11 +47,17 @@ public slots:
     void manageProccesStdOutput(QString data);
     void manageProccesErrorOutput(QString data);
 private:
+    bool getZipBandsIndex(QString zipFileName,
+                          QString& strError);
+    bool insertTuplekeyFile(QString fileName,
+                            QString& strError);
+    bool processReprojectionOutput(QString& strError);
     QTextStream* mStdOut;
     QString mMetadataEsaZipFormatFileName;
     QMap<QString,QString> mBandsEsaZipFormatFileName;
 //    QMap<QString,QMap<QString,QString> > mUsgsMetadata;
     QMap<QString,QString> mBandCodeByBandEsaZipFormatFileCompleteBaseName;
+    QMap<QString,QString> mZipBandFileNameByBandCode; // rutas /vsizip/ de las bandas dentro del zip
 //    int mPath;
 //    int mRow;
 //    QDateTime mDateTime;
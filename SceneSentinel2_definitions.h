@@ -8,6 +8,9 @@
 #define REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_BAND_FILE_EXTENSION                              ".jp2"
 #define REMOTESENSING_SENTINEL2_COMPRESSION_METHOD_JPEG_ALTERNATIVE                             "LZW"
 #define REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_TEMPLATE_JP2_EXTRACTION                          "*_B??.jp2"
+#define REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_FILE_EXTENSION                                   "zip"
+#define REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_VSIZIP_PREFIX                                    "/vsizip/"
+#define REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_BANDS_FOLDER                                     "IMG_DATA"
 
 #define REMOTESENSING_SENTINEL2_ESA_ZIP_FORMAT_METADATA_COMPRESSED_FILE_EXTENSION               ".zip"
 
@@ -1,16 +1,83 @@
 #include <ogr_geos.h>
 #include <ogr_geometry.h>
 
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
 #include "ScenesManager.h"
 #include "SceneLandsat8.h"
 #include "SceneSentinel2.h"
 #include "CRSTools.h"
+#include "PersistenceManager.h"
+#include "remotesensing_definitions.h"
 
 using namespace RemoteSensing;
 
+namespace{
+// Teselado de una escena en la ingestion por lotes. El mutex protege el estado compartido
+// (NestedGridProject, CRSTools) y la escena lo libera mientras reproyecta y recorta. La base de
+// datos solo se usa desde el hilo que lanza la ingestion, antes y despues de las tareas
+class SceneNestedGridTask: public QRunnable
+{
+public:
+    SceneNestedGridTask(ScenesManager* ptrScenesManager,
+                        QString sceneId,
+                        NestedGrid::NestedGridProject* ptrNestedGridProject,
+                        const QVector<QString>& bandsToIngest,
+                        bool reproject,
+                        QMutex* ptrSharedStateMutex):
+        mPtrScenesManager(ptrScenesManager),
+        mSceneId(sceneId),
+        mPtrNestedGridProject(ptrNestedGridProject),
+        mBandsToIngest(bandsToIngest),
+        mReproject(reproject),
+        mPtrSharedStateMutex(ptrSharedStateMutex),
+        mSuccess(false)
+    {
+        setAutoDelete(false);
+    }
+    void run()
+    {
+        QMutexLocker locker(mPtrSharedStateMutex);
+        mSuccess=mPtrScenesManager->tileNestedGrid(mSceneId,
+                                                   mPtrNestedGridProject,
+                                                   NULL,
+                                                   mBandsToIngest,
+                                                   mReproject,
+                                                   mStrError);
+    }
+    bool getSuccess(){return(mSuccess);}
+    QString getError(){return(mStrError);}
+private:
+    ScenesManager* mPtrScenesManager;
+    QString mSceneId;
+    NestedGrid::NestedGridProject* mPtrNestedGridProject;
+    QVector<QString> mBandsToIngest;
+    bool mReproject;
+    QMutex* mPtrSharedStateMutex;
+    bool mSuccess;
+    QString mStrError;
+};
+}
+
 ScenesManager::ScenesManager(libCRS::CRSTools *ptrCrsTools)
 {
     mPtrCrsTools=ptrCrsTools;
+    mReprojectInProcess=REMOTESENSING_REPROJECTION_IN_PROCESS;
+    mReprojectToWarpedVrt=REMOTESENSING_REPROJECTION_WARPED_VRT;
+    mReprojectionNumberOfThreads=REMOTESENSING_REPROJECTION_NUMBER_OF_THREADS;
+    mReprojectionWarpMemoryLimitMb=REMOTESENSING_REPROJECTION_WARP_MEMORY_LIMIT_MB;
+    mIngestionNumberOfScenesTasks=REMOTESENSING_INGESTION_NUMBER_OF_SCENES_TASKS;
+    mIngestionNumberOfCpuTasks=REMOTESENSING_INGESTION_NUMBER_OF_CPU_TASKS;
+    mIngestionNumberOfIoTasks=REMOTESENSING_INGESTION_NUMBER_OF_IO_TASKS;
+    mPtrPersistenceManager=NULL;
+    mOutputProfile=REMOTESENSING_OUTPUT_PROFILE_DEFAULT;
 }
 
 ScenesManager::~ScenesManager()
@@ -94,12 +161,6 @@ bool ScenesManager::createNestedGrid(QString &sceneId,
                                      bool reproject,
                                      QString &strError)
 {
-    if(!mPtrScenes.contains(sceneId))
-    {
-        strError=QObject::tr("ScenesManager::reprojectionToNestedGrid");
-        strError+=QObject::tr("\nNot exists scene id: %1").arg(sceneId);
-        return(false);
-    }
     //    CameraModel* imageCameraModel=imageCamera->getCameraModel();
     //    PW::FraserModel *imageDistortionModel = dynamic_cast<PW::FraserModel*>(((PW::PhotogrammetricModel*)imageCameraModel)->getDistortionModel());
     //    if(!imageDistortionModel->isBasic())
@@ -107,47 +168,209 @@ bool ScenesManager::createNestedGrid(QString &sceneId,
     //        strError=QObject::tr("OrientationProcessMonitor::writeSourceOrientation, orientation input is not Fraser basic:\n%1").arg(mSourceCalibration);
     //        return(false);
     //    }
-    Scene* ptrScene=mPtrScenes[sceneId];
-//    if( SceneLandsat8* ptrSceneLandsat8 = dynamic_cast< SceneLandsat8* >((Scene*)ptrScene) )
-//    {
-    QString auxStrError;
-    if(ptrScene->isLandsat8())
+    QVector<QString> bandsToIngest;
+    QMap<QString,QString> fingerprintByBand;
+    if(!prepareNestedGrid(sceneId,
+                          ptrNestedGridProject,
+                          bandsToIngest,
+                          fingerprintByBand,
+                          strError))
     {
-        if(!((SceneLandsat8*)ptrScene)->createNestedGrid(ptrNestedGridProject,
-                                                         ptrMultiProcess,
-                                                         mLandSat8PathRowCrsEpsgCode,
-                                                         mLandsat8PathRowGeometries,
-                                                         mLandsat8BandsToUse,
-                                                         reproject,
-                                                         auxStrError))
+        return(false);
+    }
+    if(!tileNestedGrid(sceneId,
+                       ptrNestedGridProject,
+                       ptrMultiProcess,
+                       bandsToIngest,
+                       reproject,
+                       strError))
+    {
+        return(false);
+    }
+    return(insertIngestionFingerprints(sceneId,
+                                       bandsToIngest,
+                                       fingerprintByBand,
+                                       strError));
+}
+
+bool ScenesManager::createNestedGrids(QVector<QString> &scenesIds,
+                                      NestedGrid::NestedGridProject *ptrNestedGridProject,
+                                      bool reproject,
+                                      QString &strError)
+{
+    if(!mReprojectInProcess)
+    {
+        strError=QObject::tr("ScenesManager::createNestedGrids");
+        strError+=QObject::tr("\nIngestion of several scenes requires in process reprojection");
+        return(false);
+    }
+    for(int ns=0;ns<scenesIds.size();ns++)
+    {
+        if(!mPtrScenes.contains(scenesIds[ns]))
         {
-            strError=QObject::tr("ScenesManager::reprojectionToNestedGrid");
-            strError+=QObject::tr("\nError reproyecting to Nested Grid scene id: %1").arg(sceneId);
-            strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
+            strError=QObject::tr("ScenesManager::createNestedGrids");
+            strError+=QObject::tr("\nNot exists scene id: %1").arg(scenesIds[ns]);
             return(false);
         }
     }
-    else if(ptrScene->isSentinel2())
+    if(scenesIds.size()==0)
     {
-        if(!((SceneSentinel2*)ptrScene)->createNestedGrid(ptrNestedGridProject,
-                                                          ptrMultiProcess,
-                                                          mSentinel2BandsToUse,
-                                                          reproject,
-                                                          auxStrError))
+        return(true);
+    }
+    // Consultas a la base de datos en este hilo, antes de lanzar las tareas
+    QString strAuxError;
+    QVector<QVector<QString> > bandsToIngestByScene;
+    QVector<QMap<QString,QString> > fingerprintByBandByScene;
+    for(int ns=0;ns<scenesIds.size();ns++)
+    {
+        QVector<QString> bandsToIngest;
+        QMap<QString,QString> fingerprintByBand;
+        if(!prepareNestedGrid(scenesIds[ns],
+                              ptrNestedGridProject,
+                              bandsToIngest,
+                              fingerprintByBand,
+                              strAuxError))
         {
-            strError=QObject::tr("ScenesManager::reprojectionToNestedGrid");
-            strError+=QObject::tr("\nError reproyecting to Nested Grid scene id: %1").arg(sceneId);
-            strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
+            strError=QObject::tr("ScenesManager::createNestedGrids");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
             return(false);
         }
+        bandsToIngestByScene.push_back(bandsToIngest);
+        fingerprintByBandByScene.push_back(fingerprintByBand);
     }
-    else
+    int numberOfScenesTasks=mIngestionNumberOfScenesTasks;
+    if(numberOfScenesTasks<=0)
     {
-        strError=QObject::tr("ScenesManager::createNestedGrid");
-        strError+=QObject::tr("\nInvalid scene type id: %1").arg(sceneId);
+        numberOfScenesTasks=qMax(1,QThread::idealThreadCount());
+    }
+    numberOfScenesTasks=qMin(numberOfScenesTasks,scenesIds.size());
+    int numberOfCpuTasks=mIngestionNumberOfCpuTasks;
+    if(numberOfCpuTasks<=0)
+    {
+        numberOfCpuTasks=qMax(1,QThread::idealThreadCount());
+    }
+    int numberOfIoTasks=qMax(1,mIngestionNumberOfIoTasks);
+    // Los semaforos limitan el calculo y el disco de todas las escenas a la vez
+    QSemaphore cpuSemaphore(numberOfCpuTasks);
+    QSemaphore ioSemaphore(numberOfIoTasks);
+    QMutex sharedStateMutex;
+    for(int ns=0;ns<scenesIds.size();ns++)
+    {
+        mPtrScenes[scenesIds[ns]]->setConcurrencyLimits(&cpuSemaphore,
+                                                        &ioSemaphore,
+                                                        &sharedStateMutex);
+    }
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(numberOfScenesTasks);
+    QVector<SceneNestedGridTask*> ptrTasks;
+    for(int ns=0;ns<scenesIds.size();ns++)
+    {
+        SceneNestedGridTask* ptrTask=new SceneNestedGridTask(this,
+                                                             scenesIds[ns],
+                                                             ptrNestedGridProject,
+                                                             bandsToIngestByScene[ns],
+                                                             reproject,
+                                                             &sharedStateMutex);
+        ptrTasks.push_back(ptrTask);
+        threadPool.start(ptrTask);
+    }
+    while(!threadPool.waitForDone(100))
+    {
+        QCoreApplication::processEvents();
+    }
+    // Huellas de las escenas teseladas sin error, de nuevo en este hilo
+    QString strTasksError;
+    for(int nt=0;nt<ptrTasks.size();nt++)
+    {
+        mPtrScenes[scenesIds[nt]]->setConcurrencyLimits(NULL,NULL,NULL);
+        if(!ptrTasks[nt]->getSuccess())
+        {
+            strTasksError+=(ptrTasks[nt]->getError()+"\n");
+        }
+        else if(!insertIngestionFingerprints(scenesIds[nt],
+                                             bandsToIngestByScene[nt],
+                                             fingerprintByBandByScene[nt],
+                                             strAuxError))
+        {
+            strTasksError+=(strAuxError+"\n");
+        }
+        delete(ptrTasks[nt]);
+    }
+    if(!strTasksError.isEmpty())
+    {
+        strError=QObject::tr("ScenesManager::createNestedGrids");
+        strError+=QObject::tr("\nError:\n%1").arg(strTasksError);
         return(false);
     }
+    return(true);
+}
 
+bool ScenesManager::getBandsToIngest(QString sceneId,
+                                     NestedGrid::NestedGridProject *ptrNestedGridProject,
+                                     QVector<QString> &bandsToUse,
+                                     QVector<QString> &bandsToIngest,
+                                     QMap<QString, QString> &fingerprintByBand,
+                                     QString &strError)
+{
+    bandsToIngest.clear();
+    fingerprintByBand.clear();
+    if(mPtrPersistenceManager==NULL
+            ||!mReprojectInProcess)
+    {
+        bandsToIngest=bandsToUse;
+        return(true);
+    }
+    Scene* ptrScene=mPtrScenes[sceneId];
+    // Se omiten las bandas con la misma huella cuyos tuplekeys siguen existiendo
+    QString strAuxError;
+    for(int nb=0;nb<bandsToUse.size();nb++)
+    {
+        QString bandId=bandsToUse[nb];
+        QString fingerprint;
+        if(!ptrScene->getBandFingerprint(bandId,ptrNestedGridProject,fingerprint,strAuxError))
+        {
+            strError=QObject::tr("ScenesManager::getBandsToIngest");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        fingerprintByBand[bandId]=fingerprint;
+        QString previousFingerprint;
+        QVector<QString> tuplekeysFileNames;
+        QVector<QString> emptyTuplekeysFileNames;
+        if(!mPtrPersistenceManager->getIngestionFingerprint(sceneId,
+                                                            bandId,
+                                                            previousFingerprint,
+                                                            tuplekeysFileNames,
+                                                            emptyTuplekeysFileNames,
+                                                            strAuxError))
+        {
+            strError=QObject::tr("ScenesManager::getBandsToIngest");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        bool mustIngest=(previousFingerprint.compare(fingerprint)!=0);
+        QVector<QString> existingTuplekeysFileNames;
+        for(int nf=0;nf<tuplekeysFileNames.size()&&!mustIngest;nf++)
+        {
+            if(emptyTuplekeysFileNames.contains(tuplekeysFileNames[nf]))
+            {
+                continue;
+            }
+            if(!QFile::exists(tuplekeysFileNames[nf]))
+            {
+                mustIngest=true;
+            }
+            existingTuplekeysFileNames.push_back(tuplekeysFileNames[nf]);
+        }
+        if(mustIngest)
+        {
+            bandsToIngest.push_back(bandId);
+        }
+        else
+        {
+            ptrScene->setTuplekeysFileNames(bandId,existingTuplekeysFileNames);
+        }
+    }
     return(true);
 }
 
@@ -210,6 +433,111 @@ bool ScenesManager::getScenesPersistenceData(QMap<QString, QMap<QString, QString
     return(true);
 }
 
+bool ScenesManager::insertIngestionFingerprints(QString sceneId,
+                                                QVector<QString> &bandsToIngest,
+                                                QMap<QString, QString> &fingerprintByBand,
+                                                QString &strError)
+{
+    // Con procesos externos los tuplekeys no estan terminados al salir, no se guarda la huella.
+    // Solo se guarda para bandas teseladas sin error y con todos los tuplekeys no vacios escritos
+    if(mPtrPersistenceManager==NULL
+            ||!mReprojectInProcess)
+    {
+        return(true);
+    }
+    Scene* ptrScene=mPtrScenes[sceneId];
+    QString auxStrError;
+    for(int nb=0;nb<bandsToIngest.size();nb++)
+    {
+        QString bandId=bandsToIngest[nb];
+        QVector<QString> tuplekeysFileNames;
+        QVector<QString> emptyTuplekeysFileNames;
+        if(!ptrScene->getIngestedTuplekeysFileNames(bandId,
+                                                    tuplekeysFileNames,
+                                                    emptyTuplekeysFileNames))
+        {
+            strError=QObject::tr("ScenesManager::insertIngestionFingerprints");
+            strError+=QObject::tr("\nNot completed ingestion for scene id: %1 and band id: %2")
+                    .arg(sceneId).arg(bandId);
+            return(false);
+        }
+        for(int nf=0;nf<tuplekeysFileNames.size();nf++)
+        {
+            if(emptyTuplekeysFileNames.contains(tuplekeysFileNames[nf]))
+            {
+                continue;
+            }
+            if(!QFile::exists(tuplekeysFileNames[nf]))
+            {
+                strError=QObject::tr("ScenesManager::insertIngestionFingerprints");
+                strError+=QObject::tr("\nNot exists tuplekey file:\n%1\nfor scene id: %2 and band id: %3")
+                        .arg(tuplekeysFileNames[nf]).arg(sceneId).arg(bandId);
+                return(false);
+            }
+        }
+        if(!mPtrPersistenceManager->insertIngestionFingerprint(sceneId,
+                                                               bandId,
+                                                               fingerprintByBand[bandId],
+                                                               tuplekeysFileNames,
+                                                               emptyTuplekeysFileNames,
+                                                               auxStrError))
+        {
+            strError=QObject::tr("ScenesManager::insertIngestionFingerprints");
+            strError+=QObject::tr("\nError storing fingerprint for scene id: %1 and band id: %2")
+                    .arg(sceneId).arg(bandId);
+            strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
+            return(false);
+        }
+    }
+    return(true);
+}
+
+bool ScenesManager::prepareNestedGrid(QString sceneId,
+                                      NestedGrid::NestedGridProject *ptrNestedGridProject,
+                                      QVector<QString> &bandsToIngest,
+                                      QMap<QString, QString> &fingerprintByBand,
+                                      QString &strError)
+{
+    bandsToIngest.clear();
+    fingerprintByBand.clear();
+    if(!mPtrScenes.contains(sceneId))
+    {
+        strError=QObject::tr("ScenesManager::prepareNestedGrid");
+        strError+=QObject::tr("\nNot exists scene id: %1").arg(sceneId);
+        return(false);
+    }
+    Scene* ptrScene=mPtrScenes[sceneId];
+    ptrScene->setReprojectionParameters(mReprojectInProcess,
+                                        mReprojectToWarpedVrt,
+                                        mReprojectionNumberOfThreads,
+                                        mReprojectionWarpMemoryLimitMb);
+    ptrScene->setOutputProfile(mOutputProfile);
+    QString auxStrError;
+    QVector<QString> bandsToUse;
+    if(ptrScene->isLandsat8())
+    {
+        bandsToUse=mLandsat8BandsToUse;
+    }
+    else if(ptrScene->isSentinel2())
+    {
+        bandsToUse=mSentinel2BandsToUse;
+    }
+    else
+    {
+        strError=QObject::tr("ScenesManager::prepareNestedGrid");
+        strError+=QObject::tr("\nInvalid scene type id: %1").arg(sceneId);
+        return(false);
+    }
+    if(!getBandsToIngest(sceneId,ptrNestedGridProject,bandsToUse,
+                         bandsToIngest,fingerprintByBand,auxStrError))
+    {
+        strError=QObject::tr("ScenesManager::prepareNestedGrid");
+        strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
+        return(false);
+    }
+    return(true);
+}
+
 bool ScenesManager::setLandsat8Parameters(QString &landSat8PathRowShpFileName,
                                           QString &landSat8PathRowShpPathField,
                                           QString &landSat8PathRowShpRowField,
@@ -227,9 +555,75 @@ bool ScenesManager::setLandsat8Parameters(QString &landSat8PathRowShpFileName,
     return(true);
 }
 
+void ScenesManager::setReprojectionParameters(bool inProcess,
+                                              bool warpedVrt,
+                                              int numberOfThreads,
+                                              double warpMemoryLimitMb)
+{
+    mReprojectInProcess=inProcess;
+    mReprojectToWarpedVrt=warpedVrt;
+    mReprojectionNumberOfThreads=numberOfThreads;
+    mReprojectionWarpMemoryLimitMb=warpMemoryLimitMb;
+}
+
+void ScenesManager::setIngestionParameters(int numberOfScenesTasks,
+                                           int numberOfCpuTasks,
+                                           int numberOfIoTasks)
+{
+    mIngestionNumberOfScenesTasks=numberOfScenesTasks;
+    mIngestionNumberOfCpuTasks=numberOfCpuTasks;
+    mIngestionNumberOfIoTasks=numberOfIoTasks;
+}
+
 bool ScenesManager::setSentinel2Parameters(QVector<QString> &sentinel2BandsToUse,
                                            QString &strError)
 {
     mSentinel2BandsToUse=sentinel2BandsToUse;
     return(true);
 }
+
+bool ScenesManager::tileNestedGrid(QString sceneId,
+                                   NestedGrid::NestedGridProject *ptrNestedGridProject,
+                                   ProcessTools::MultiProcess *ptrMultiProcess,
+                                   QVector<QString> &bandsToIngest,
+                                   bool reproject,
+                                   QString &strError)
+{
+    if(bandsToIngest.size()==0)
+    {
+        return(true);
+    }
+    Scene* ptrScene=mPtrScenes[sceneId];
+    QString auxStrError;
+    if(ptrScene->isLandsat8())
+    {
+        if(!((SceneLandsat8*)ptrScene)->createNestedGrid(ptrNestedGridProject,
+                                                         ptrMultiProcess,
+                                                         mLandSat8PathRowCrsEpsgCode,
+                                                         mLandsat8PathRowGeometries,
+                                                         bandsToIngest,
+                                                         reproject,
+                                                         auxStrError))
+        {
+            strError=QObject::tr("ScenesManager::reprojectionToNestedGrid");
+            strError+=QObject::tr("\nError reproyecting to Nested Grid scene id: %1").arg(sceneId);
+            strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
+            return(false);
+        }
+    }
+    else if(ptrScene->isSentinel2())
+    {
+        if(!((SceneSentinel2*)ptrScene)->createNestedGrid(ptrNestedGridProject,
+                                                          ptrMultiProcess,
+                                                          bandsToIngest,
+                                                          reproject,
+                                                          auxStrError))
+        {
+            strError=QObject::tr("ScenesManager::reprojectionToNestedGrid");
+            strError+=QObject::tr("\nError reproyecting to Nested Grid scene id: %1").arg(sceneId);
+            strError+=QObject::tr("\nError:\n%1").arg(auxStrError);
+            return(false);
+        }
+    }
+    return(true);
+}
@@ -23,6 +23,7 @@ namespace NestedGrid{
 }
 
 namespace RemoteSensing{
+class PersistenceManager;
 class Scene;
 class LIBREMOTESENSINGSHARED_EXPORT ScenesManager
 {
@@ -35,6 +36,10 @@ public:
                           ProcessTools::MultiProcess* ptrMultiProcess,
                           bool reproject,
                           QString& strError);
+    bool createNestedGrids(QVector<QString>& scenesIds,
+                           NestedGrid::NestedGridProject* ptrNestedGridProject,
+                           bool reproject,
+                           QString& strError);
     bool getTupleKeyBySceneId(QString sceneId,
                              QMap<QString,QVector<QString> >& quadkeysByBand,
                              QString& strError);
@@ -58,9 +63,40 @@ public:
                                QMap<int,QMap<int,OGRGeometry*> >& landsat8PathRowGeometries,
                                QVector<QString>& landsat8BandsToUse,
                                QString& strError);
+    void setReprojectionParameters(bool inProcess,
+                                   bool warpedVrt,
+                                   int numberOfThreads,
+                                   double warpMemoryLimitMb);
+    void setIngestionParameters(int numberOfScenesTasks,
+                                int numberOfCpuTasks,
+                                int numberOfIoTasks);
+    void setOutputProfile(QString outputProfile){mOutputProfile=outputProfile;}
+    void setPersistenceManager(PersistenceManager* ptrPersistenceManager){mPtrPersistenceManager=ptrPersistenceManager;}
     bool setSentinel2Parameters(QVector<QString>& landsat8BandsToUse,
                                 QString& strError);
+    // Reproyeccion y teselado de las bandas de una escena, sin usar la base de datos
+    bool tileNestedGrid(QString sceneId,
+                        NestedGrid::NestedGridProject* ptrNestedGridProject,
+                        ProcessTools::MultiProcess* ptrMultiProcess,
+                        QVector<QString>& bandsToIngest,
+                        bool reproject,
+                        QString& strError);
 private:
+    bool getBandsToIngest(QString sceneId,
+                          NestedGrid::NestedGridProject* ptrNestedGridProject,
+                          QVector<QString>& bandsToUse,
+                          QVector<QString>& bandsToIngest,
+                          QMap<QString,QString>& fingerprintByBand,
+                          QString& strError);
+    bool insertIngestionFingerprints(QString sceneId,
+                                     QVector<QString>& bandsToIngest,
+                                     QMap<QString,QString>& fingerprintByBand,
+                                     QString& strError);
+    bool prepareNestedGrid(QString sceneId,
+                           NestedGrid::NestedGridProject* ptrNestedGridProject,
+                           QVector<QString>& bandsToIngest,
+                           QMap<QString,QString>& fingerprintByBand,
+                           QString& strError);
     friend class Scene; // puede acceder a privados y protegidos
     QMap<QString,Scene*> mPtrScenes;
     libCRS::CRSTools* mPtrCrsTools;
@@ -71,6 +107,15 @@ private:
     QMap<int,QMap<int,OGRGeometry*> > mLandsat8PathRowGeometries;
     QVector<QString> mLandsat8BandsToUse;
     QVector<QString> mSentinel2BandsToUse;
+    bool mReprojectInProcess;
+    bool mReprojectToWarpedVrt;
+    int mReprojectionNumberOfThreads;
+    double mReprojectionWarpMemoryLimitMb;
+    int mIngestionNumberOfScenesTasks;
+    int mIngestionNumberOfCpuTasks;
+    int mIngestionNumberOfIoTasks;
+    PersistenceManager* mPtrPersistenceManager; // NULL: sin huellas de ingestion
+    QString mOutputProfile;
 };
 }
 #endif // SCENESMANAGER_H
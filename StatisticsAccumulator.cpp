@@ -0,0 +1,170 @@
+#include <QObject>
+
+#include <math.h>
+
+#include "StatisticsAccumulator.h"
+
+using namespace RemoteSensing;
+
+StatisticsAccumulator::StatisticsAccumulator()
+{
+    mHistogramMinimumValue=0;
+    mHistogramMaximumValue=0;
+    clear();
+}
+
+void StatisticsAccumulator::clear()
+{
+    mCount=0;
+    mSum=0;
+    mSumOfSquares=0;
+    mMinimum=0;
+    mMaximum=0;
+    mHistogram.fill(0);
+}
+
+double StatisticsAccumulator::getMean() const
+{
+    if(mCount==0)
+    {
+        return(0.0);
+    }
+    return(((double)mSum)/mCount);
+}
+
+bool StatisticsAccumulator::getPercentile(double percentile,
+                                          double &value,
+                                          QString &strError) const
+{
+    if(mHistogram.isEmpty())
+    {
+        strError=QObject::tr("StatisticsAccumulator::getPercentile");
+        strError+=QObject::tr("\nHistogram is not enabled");
+        return(false);
+    }
+    if(percentile<0.0||percentile>100.0)
+    {
+        strError=QObject::tr("StatisticsAccumulator::getPercentile");
+        strError+=QObject::tr("\nInvalid percentile: %1").arg(QString::number(percentile));
+        return(false);
+    }
+    if(mCount==0)
+    {
+        strError=QObject::tr("StatisticsAccumulator::getPercentile");
+        strError+=QObject::tr("\nThere are no values");
+        return(false);
+    }
+    // Interpolacion lineal dentro del intervalo, acotada por los extremos observados
+    double binWidth=((double)(mHistogramMaximumValue-mHistogramMinimumValue+1))/mHistogram.size();
+    double target=percentile/100.0*mCount;
+    qint64 accumulatedCount=0;
+    int bin=0;
+    for(bin=0;bin<mHistogram.size()-1;bin++)
+    {
+        if(accumulatedCount+mHistogram[bin]>=target)
+        {
+            break;
+        }
+        accumulatedCount+=mHistogram[bin];
+    }
+    double fraction=0.5;
+    if(mHistogram[bin]>0)
+    {
+        fraction=(target-accumulatedCount)/mHistogram[bin];
+    }
+    value=mHistogramMinimumValue+(bin+fraction)*binWidth;
+    value=qMin((double)mMaximum,qMax((double)mMinimum,value));
+    return(true);
+}
+
+double StatisticsAccumulator::getStd() const
+{
+    if(mCount<2)
+    {
+        return(0.0);
+    }
+    double variance=(((double)mSumOfSquares)-((double)mSum)*((double)mSum)/mCount)/(mCount-1);
+    if(variance<0.0) // redondeo
+    {
+        variance=0.0;
+    }
+    return(sqrt(variance));
+}
+
+bool StatisticsAccumulator::merge(const StatisticsAccumulator &accumulator,
+                                  QString &strError)
+{
+    if(accumulator.mCount==0)
+    {
+        return(true);
+    }
+    if(!mHistogram.isEmpty()||!accumulator.mHistogram.isEmpty())
+    {
+        if(mHistogram.size()!=accumulator.mHistogram.size()
+                ||mHistogramMinimumValue!=accumulator.mHistogramMinimumValue
+                ||mHistogramMaximumValue!=accumulator.mHistogramMaximumValue)
+        {
+            strError=QObject::tr("StatisticsAccumulator::merge");
+            strError+=QObject::tr("\nHistograms are not compatible");
+            return(false);
+        }
+        for(int nb=0;nb<mHistogram.size();nb++)
+        {
+            mHistogram[nb]+=accumulator.mHistogram[nb];
+        }
+    }
+    if(mCount==0)
+    {
+        mMinimum=accumulator.mMinimum;
+        mMaximum=accumulator.mMaximum;
+    }
+    else
+    {
+        mMinimum=qMin(mMinimum,accumulator.mMinimum);
+        mMaximum=qMax(mMaximum,accumulator.mMaximum);
+    }
+    mCount+=accumulator.mCount;
+    mSum+=accumulator.mSum;
+    mSumOfSquares+=accumulator.mSumOfSquares;
+    return(true);
+}
+
+bool StatisticsAccumulator::setHistogram(int minimumValue,
+                                         int maximumValue,
+                                         int numberOfBins,
+                                         QString &strError)
+{
+    if(mCount>0)
+    {
+        strError=QObject::tr("StatisticsAccumulator::setHistogram");
+        strError+=QObject::tr("\nHistogram must be set before adding values");
+        return(false);
+    }
+    if(maximumValue<minimumValue||numberOfBins<1)
+    {
+        strError=QObject::tr("StatisticsAccumulator::setHistogram");
+        strError+=QObject::tr("\nInvalid histogram: [%1,%2] with %3 bins")
+                .arg(QString::number(minimumValue)).arg(QString::number(maximumValue))
+                .arg(QString::number(numberOfBins));
+        return(false);
+    }
+    mHistogramMinimumValue=minimumValue;
+    mHistogramMaximumValue=maximumValue;
+    mHistogram.fill(0,numberOfBins);
+    return(true);
+}
+
+void StatisticsAccumulator::addValueToHistogram(int value)
+{
+    int bin=0;
+    if(value>=mHistogramMaximumValue)
+    {
+        bin=mHistogram.size()-1;
+    }
+    else if(value>mHistogramMinimumValue)
+    {
+        bin=(int)(((qint64)(value-mHistogramMinimumValue))*mHistogram.size()
+                  /(mHistogramMaximumValue-mHistogramMinimumValue+1));
+    }
+    mHistogram[bin]++;
+}
@@ -0,0 +1,54 @@
+#ifndef STATISTICSACCUMULATOR_H
+#define STATISTICSACCUMULATOR_H
+
+#include <QString>
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+namespace RemoteSensing{
+// Estadisticos de valores enteros acumulados sin guardar los valores: numero, suma y suma
+// de cuadrados exactas en enteros de 64 bits, extremos e histograma opcional de intervalos
+// fijos para medianas y percentiles. Dos acumuladores se pueden fusionar (hilos, tuplekeys).
+class LIBREMOTESENSINGSHARED_EXPORT StatisticsAccumulator
+{
+public:
+    StatisticsAccumulator();
+    void addValue(int value)
+    {
+        mCount++;
+        mSum+=value;
+        mSumOfSquares+=(qint64)value*value;
+        if(mCount==1||value<mMinimum) mMinimum=value;
+        if(mCount==1||value>mMaximum) mMaximum=value;
+        if(!mHistogram.isEmpty()) addValueToHistogram(value);
+    }
+    void clear();
+    qint64 getCount() const {return(mCount);}
+    int getMaximum() const {return(mMaximum);}
+    double getMean() const;
+    int getMinimum() const {return(mMinimum);}
+    bool getPercentile(double percentile,
+                       double& value,
+                       QString& strError) const;
+    double getStd() const; // muestral, 0 con menos de dos valores
+    qint64 getSum() const {return(mSum);}
+    bool merge(const StatisticsAccumulator& accumulator,
+               QString& strError);
+    bool setHistogram(int minimumValue,
+                      int maximumValue,
+                      int numberOfBins,
+                      QString& strError);
+private:
+    void addValueToHistogram(int value);
+    qint64 mCount;
+    qint64 mSum;
+    qint64 mSumOfSquares;
+    int mMinimum;
+    int mMaximum;
+    int mHistogramMinimumValue;
+    int mHistogramMaximumValue;
+    QVector<qint64> mHistogram; // vacio si no se usa, los valores fuera de rango van a los extremos
+};
+}
+#endif // STATISTICSACCUMULATOR_H
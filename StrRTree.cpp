@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include <math.h>
+
+#include "StrRTree.h"
+
+using namespace RemoteSensing;
+
+namespace{
+template<typename T>
+bool lessCenterX(const T& first,
+                 const T& second)
+{
+    return(first.minX+first.maxX<second.minX+second.maxX);
+}
+
+template<typename T>
+bool lessCenterY(const T& first,
+                 const T& second)
+{
+    return(first.minY+first.maxY<second.minY+second.maxY);
+}
+}
+
+StrRTree::StrRTree(int nodeCapacity)
+{
+    mNodeCapacity=qMax(2,nodeCapacity);
+    mIsBuilt=false;
+}
+
+void StrRTree::build()
+{
+    mLevels.clear();
+    mIsBuilt=true;
+    if(mItems.isEmpty())
+    {
+        return;
+    }
+    QVector<Box> nodes;
+    pack(mItems,nodes);
+    mLevels.push_back(nodes);
+    while(mLevels.last().size()>1)
+    {
+        QVector<Box> parentNodes;
+        pack(mLevels.last(),parentNodes);
+        mLevels.push_back(parentNodes);
+    }
+}
+
+void StrRTree::clear()
+{
+    mItems.clear();
+    mLevels.clear();
+    mIsBuilt=false;
+}
+
+void StrRTree::insert(int id,
+                      double minX,
+                      double minY,
+                      double maxX,
+                      double maxY)
+{
+    Box item;
+    item.minX=minX;
+    item.minY=minY;
+    item.maxX=maxX;
+    item.maxY=maxY;
+    item.id=id;
+    item.numberOfChildren=0;
+    mItems.push_back(item);
+    mIsBuilt=false;
+}
+
+void StrRTree::pack(QVector<Box> &boxes,
+                    QVector<Box> &nodes)
+{
+    // Se ordena por x, se corta en columnas de sqrt(numero de nodos) nodos, y cada columna se ordena por y
+    nodes.clear();
+    int numberOfBoxes=boxes.size();
+    int numberOfNodes=(numberOfBoxes+mNodeCapacity-1)/mNodeCapacity;
+    int numberOfSlices=(int)ceil(sqrt((double)numberOfNodes));
+    int sliceSize=numberOfSlices*mNodeCapacity;
+    std::sort(boxes.begin(),boxes.end(),lessCenterX<Box>);
+    for(int sliceStart=0;sliceStart<numberOfBoxes;sliceStart+=sliceSize)
+    {
+        int sliceEnd=qMin(numberOfBoxes,sliceStart+sliceSize);
+        std::sort(boxes.begin()+sliceStart,boxes.begin()+sliceEnd,lessCenterY<Box>);
+        for(int nodeStart=sliceStart;nodeStart<sliceEnd;nodeStart+=mNodeCapacity)
+        {
+            int nodeEnd=qMin(sliceEnd,nodeStart+mNodeCapacity);
+            Box node=boxes[nodeStart];
+            for(int nb=nodeStart+1;nb<nodeEnd;nb++)
+            {
+                node.minX=qMin(node.minX,boxes[nb].minX);
+                node.minY=qMin(node.minY,boxes[nb].minY);
+                node.maxX=qMax(node.maxX,boxes[nb].maxX);
+                node.maxY=qMax(node.maxY,boxes[nb].maxY);
+            }
+            node.id=nodeStart;
+            node.numberOfChildren=nodeEnd-nodeStart;
+            nodes.push_back(node);
+        }
+    }
+}
+
+void StrRTree::query(double minX,
+                     double minY,
+                     double maxX,
+                     double maxY,
+                     QVector<int> &ids)
+{
+    ids.clear();
+    if(!mIsBuilt)
+    {
+        build();
+    }
+    if(mLevels.isEmpty())
+    {
+        return;
+    }
+    // Pila de (nivel, nodo); los hijos de los nodos del nivel 0 son los elementos
+    QVector<int> levelsStack;
+    QVector<int> nodesStack;
+    levelsStack.push_back(mLevels.size()-1);
+    nodesStack.push_back(0);
+    while(!nodesStack.isEmpty())
+    {
+        int level=levelsStack.last();
+        int position=nodesStack.last();
+        levelsStack.pop_back();
+        nodesStack.pop_back();
+        const Box& node=mLevels[level][position];
+        if(node.maxX<minX||node.minX>maxX||node.maxY<minY||node.minY>maxY)
+        {
+            continue;
+        }
+        for(int nc=node.id;nc<node.id+node.numberOfChildren;nc++)
+        {
+            if(level==0)
+            {
+                const Box& item=mItems[nc];
+                if(item.maxX<minX||item.minX>maxX||item.maxY<minY||item.minY>maxY)
+                {
+                    continue;
+                }
+                ids.push_back(item.id);
+            }
+            else
+            {
+                levelsStack.push_back(level-1);
+                nodesStack.push_back(nc);
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef STRRTREE_H
+#define STRRTREE_H
+
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+#define STRRTREE_NODE_CAPACITY                      16
+
+namespace RemoteSensing{
+// R-tree estatico empaquetado con Sort-Tile-Recursive: se insertan todos los rectangulos,
+// se construye una vez y despues solo se consulta
+class LIBREMOTESENSINGSHARED_EXPORT StrRTree
+{
+public:
+    StrRTree(int nodeCapacity=STRRTREE_NODE_CAPACITY);
+    void build();
+    void clear();
+    void insert(int id,
+                double minX,
+                double minY,
+                double maxX,
+                double maxY);
+    bool isEmpty(){return(mItems.isEmpty());}
+    void query(double minX,
+               double minY,
+               double maxX,
+               double maxY,
+               QVector<int>& ids);
+private:
+    struct Box
+    {
+        double minX;
+        double minY;
+        double maxX;
+        double maxY;
+        int id; // en los nodos: primer hijo
+        int numberOfChildren;
+    };
+    void pack(QVector<Box>& boxes,
+              QVector<Box>& nodes);
+    int mNodeCapacity;
+    QVector<Box> mItems;
+    QVector<QVector<Box> > mLevels; // mLevels[0] agrupa elementos, el ultimo nivel es la raiz
+    bool mIsBuilt;
+};
+}
+#endif // STRRTREE_H
@@ -1,9 +1,15 @@
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QProgressDialog>
 #include <QWidget>
 #include <QFile>
 #include <QDate>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 #include "../../libs/libCRS/CRSTools.h"
 #include "../../libs/libNestedGrid/NestedGridTools.h"
@@ -14,10 +20,338 @@
 #include "../../libs/libProcessTools/MultiProcess.h"
 #include "../../libs/libProcessTools/ExternalProcess.h"
 
+#include "PixelStateRaster.h"
+#include "RasterBlockCache.h"
+#include "RoiGeometryCache.h"
 #include "TONIpbpProject.h"
+#include "ZonalStatisticsEngine.h"
 
 using namespace RemoteSensing;
 
+namespace{
+// Transpiracion acumulada de un pixel: kcb=ndvi*m+n por ETH0 en cada fecha de la serie con
+// NDVI valido, interpolando kcb linealmente en los dias intermedios, que se suman en forma
+// cerrada con las sumas acumuladas de ETH0. La serie termina en la primera fecha con NDVI
+// no valido despues de alguna valida, incluidas las fechas sin valor (nodata)
+class AccumulatedPerspirationReducer : public ZonalStatisticsReducer
+{
+public:
+    AccumulatedPerspirationReducer(const DailyValueSeries& eth0Series,
+                                   double initialNdvi,
+                                   double finalNdvi,
+                                   double kcbM,
+                                   double kcbN):
+        mETH0Series(eth0Series),
+        mInitialNdvi(initialNdvi),
+        mFinalNdvi(finalNdvi),
+        mKcbM(kcbM),
+        mKcbN(kcbN)
+    {
+        clear();
+    }
+    bool addValue(const ZonalStatisticsRasterFile& rasterFile,
+                  double value,
+                  bool isValid,
+                  bool& finished,
+                  QString& strError)
+    {
+        finished=mFinished;
+        int jd=rasterFile.jd;
+        // Fechas ya acumuladas en una ejecucion anterior o serie terminada
+        if(mFinished||jd<=mProcessedJd)
+        {
+            return(true);
+        }
+        mProcessedJd=jd;
+        double ndvi=(value+rasterFile.offset)*rasterFile.gain;
+        if(isValid&&ndvi>=mInitialNdvi&&ndvi<=mFinalNdvi)
+        {
+            double kcb=ndvi*mKcbM+mKcbN;
+            if(!mETH0Series.contains(jd))
+            {
+                strError=QObject::tr("Error no ETH0 for date %1")
+                        .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1));
+                return(false);
+            }
+            mAccumulatedValue+=(kcb*mETH0Series.getValue(jd));
+            if(mPreviousJd>0)
+            {
+                if(!mETH0Series.containsAll(mPreviousJd+1,jd-1))
+                {
+                    strError=QObject::tr("Error no ETH0 for some date between %1 and %2")
+                            .arg(QDate::fromJulianDay(mPreviousJd).toString(TONIPBPPROJECT_DATE_FORMAT_1))
+                            .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1));
+                    return(false);
+                }
+                mAccumulatedValue+=mETH0Series.getLinearWeightedSum(mPreviousJd+1,
+                                                                    jd-1,
+                                                                    mPreviousKcb,
+                                                                    (kcb-mPreviousKcb)/(jd-mPreviousJd),
+                                                                    mPreviousJd);
+            }
+            mPreviousJd=jd;
+            mPreviousKcb=kcb;
+            mFindInitialNdvi=true;
+        }
+        else if(mFindInitialNdvi)
+        {
+            mFinished=true;
+            finished=true;
+        }
+        return(true);
+    }
+    void clear()
+    {
+        mFindInitialNdvi=false;
+        mFinished=false;
+        mPreviousJd=0;
+        mPreviousKcb=0.0;
+        mAccumulatedValue=0.0;
+        mProcessedJd=0;
+    }
+    void getState(PixelStateWindow& stateWindow,
+                  int column,
+                  int row) const
+    {
+        int status=TONIPBPPROJECT_STATE_STATUS_WITHOUT_NDVI;
+        if(mFinished)
+        {
+            status=TONIPBPPROJECT_STATE_STATUS_FINISHED;
+        }
+        else if(mFindInitialNdvi)
+        {
+            status=TONIPBPPROJECT_STATE_STATUS_ACCUMULATING;
+        }
+        stateWindow.setValue(TONIPBPPROJECT_STATE_BAND_ACCUMULATED_VALUE,column,row,mAccumulatedValue);
+        stateWindow.setValue(TONIPBPPROJECT_STATE_BAND_PREVIOUS_JD,column,row,mPreviousJd);
+        stateWindow.setValue(TONIPBPPROJECT_STATE_BAND_PREVIOUS_KCB,column,row,mPreviousKcb);
+        stateWindow.setValue(TONIPBPPROJECT_STATE_BAND_STATUS,column,row,status);
+        stateWindow.setValue(TONIPBPPROJECT_STATE_BAND_PROCESSED_JD,column,row,mProcessedJd);
+    }
+    void setState(const PixelStateWindow& stateWindow,
+                  int column,
+                  int row)
+    {
+        int status=qRound(stateWindow.getValue(TONIPBPPROJECT_STATE_BAND_STATUS,column,row));
+        mFindInitialNdvi=(status!=TONIPBPPROJECT_STATE_STATUS_WITHOUT_NDVI);
+        mFinished=(status==TONIPBPPROJECT_STATE_STATUS_FINISHED);
+        mAccumulatedValue=stateWindow.getValue(TONIPBPPROJECT_STATE_BAND_ACCUMULATED_VALUE,column,row);
+        mPreviousJd=qRound(stateWindow.getValue(TONIPBPPROJECT_STATE_BAND_PREVIOUS_JD,column,row));
+        mPreviousKcb=stateWindow.getValue(TONIPBPPROJECT_STATE_BAND_PREVIOUS_KCB,column,row);
+        mProcessedJd=qRound(stateWindow.getValue(TONIPBPPROJECT_STATE_BAND_PROCESSED_JD,column,row));
+    }
+    double getValue(double noDataValue) const
+    {
+        if(!mFindInitialNdvi)
+        {
+            return(noDataValue);
+        }
+        return(mAccumulatedValue);
+    }
+private:
+    const DailyValueSeries& mETH0Series;
+    double mInitialNdvi;
+    double mFinalNdvi;
+    double mKcbM;
+    double mKcbN;
+    bool mFindInitialNdvi;
+    bool mFinished;
+    int mPreviousJd;
+    double mPreviousKcb;
+    double mAccumulatedValue;
+    int mProcessedJd; // ultima fecha de la serie leida
+};
+
+// Calcula una tesela de la malla de la zona: valor, estado y tuplekey de cada pixel. Solo se
+// leen, a traves del motor compartido, las ventanas NDVI que solapan con la tesela, remuestreadas
+// a la malla de la zona con TONIPBPPROJECT_RESAMPLING_METHOD
+class AccumulatedPerspirationTileTask : public QRunnable
+{
+public:
+    AccumulatedPerspirationTileTask(const AccumulatedPerspirationReducer& perspirationReducer,
+                                    const QMap<QString,QMap<int,QVector<int> > >& roiColumnsByRowByTuplekey,
+                                    const QMap<QString,QVector<ZonalStatisticsRasterFile> >& seriesByTuplekey,
+                                    int firstColumn,
+                                    int firstRow,
+                                    int columns,
+                                    int rows,
+                                    double roiNwFc,
+                                    double roiNwSc,
+                                    double gsd,
+                                    double noDataValue,
+                                    bool existsPreviousState,
+                                    const PixelStateWindow& previousState,
+                                    bool storeState,
+                                    ZonalStatisticsEngine* ptrZonalStatisticsEngine):
+        mPerspirationReducer(perspirationReducer),
+        mRoiColumnsByRowByTuplekey(roiColumnsByRowByTuplekey),
+        mSeriesByTuplekey(seriesByTuplekey),
+        mFirstColumn(firstColumn),
+        mFirstRow(firstRow),
+        mColumns(columns),
+        mRows(rows),
+        mRoiNwFc(roiNwFc),
+        mRoiNwSc(roiNwSc),
+        mGsd(gsd),
+        mNoDataValue(noDataValue),
+        mExistsPreviousState(existsPreviousState),
+        mPreviousState(previousState),
+        mStoreState(storeState),
+        mPtrZonalStatisticsEngine(ptrZonalStatisticsEngine),
+        mSuccess(false)
+    {
+        setAutoDelete(false);
+    }
+    void run()
+    {
+        mSuccess=process(mStrError);
+    }
+    int getColumns(){return(mColumns);}
+    QString getError(){return(mStrError);}
+    int getFirstColumn(){return(mFirstColumn);}
+    int getFirstRow(){return(mFirstRow);}
+    int getRows(){return(mRows);}
+    const PixelStateWindow& getState(){return(mState);}
+    bool getSuccess(){return(mSuccess);}
+    const QVector<int>& getTuplekeyPositions(){return(mTuplekeyPositions);}
+    QVector<float>& getValues(){return(mValues);}
+private:
+    bool process(QString& strError);
+    AccumulatedPerspirationReducer mPerspirationReducer;
+    const QMap<QString,QMap<int,QVector<int> > >& mRoiColumnsByRowByTuplekey;
+    const QMap<QString,QVector<ZonalStatisticsRasterFile> >& mSeriesByTuplekey;
+    int mFirstColumn;
+    int mFirstRow;
+    int mColumns;
+    int mRows;
+    double mRoiNwFc;
+    double mRoiNwSc;
+    double mGsd;
+    double mNoDataValue;
+    bool mExistsPreviousState;
+    PixelStateWindow mPreviousState;
+    bool mStoreState; // false: mState queda vacio
+    ZonalStatisticsEngine* mPtrZonalStatisticsEngine;
+    QVector<float> mValues; // values[row*columns+column], relativo a la tesela
+    QVector<int> mTuplekeyPositions; // posicion del tuplekey en mRoiColumnsByRowByTuplekey, -1 si no hay
+    PixelStateWindow mState;
+    bool mSuccess;
+    QString mStrError;
+};
+
+bool AccumulatedPerspirationTileTask::process(QString &strError)
+{
+    QString strAuxError;
+    mValues.fill(mNoDataValue,mColumns*mRows);
+    mTuplekeyPositions.fill(-1,mColumns*mRows);
+    if(mStoreState)
+    {
+        mState.setWindow(TONIPBPPROJECT_STATE_NUMBER_OF_BANDS,mFirstColumn,mFirstRow,mColumns,mRows,0.0);
+    }
+    int tuplekeyPosition=-1;
+    QMap<QString,QMap<int,QVector<int> > >::const_iterator iterTuplekey=mRoiColumnsByRowByTuplekey.begin();
+    while(iterTuplekey!=mRoiColumnsByRowByTuplekey.end())
+    {
+        tuplekeyPosition++;
+        QString tuplekey=iterTuplekey.key();
+        const QMap<int,QVector<int> >& roiColumnsByRow=iterTuplekey.value();
+        iterTuplekey++;
+        QMap<QString,QVector<ZonalStatisticsRasterFile> >::const_iterator iterSeries=mSeriesByTuplekey.find(tuplekey);
+        if(iterSeries==mSeriesByTuplekey.end())
+        {
+            continue;
+        }
+        // Pixeles del tuplekey en la tesela
+        QVector<int> pixelColumns;
+        QVector<int> pixelRows;
+        QMap<int,QVector<int> >::const_iterator iterRow=roiColumnsByRow.lowerBound(mFirstRow);
+        while(iterRow!=roiColumnsByRow.end()
+              &&iterRow.key()<mFirstRow+mRows)
+        {
+            for(int nc=0;nc<iterRow.value().size();nc++)
+            {
+                int column=iterRow.value()[nc];
+                if(column>=mFirstColumn&&column<mFirstColumn+mColumns)
+                {
+                    pixelColumns.push_back(column);
+                    pixelRows.push_back(iterRow.key());
+                }
+            }
+            iterRow++;
+        }
+        if(pixelColumns.isEmpty())
+        {
+            continue;
+        }
+        // Solo se leen las fechas posteriores a la ultima procesada en todos los pixeles
+        int minimumProcessedJd=0;
+        for(int np=0;np<pixelColumns.size()&&mExistsPreviousState;np++)
+        {
+            int processedJd=qRound(mPreviousState.getValue(TONIPBPPROJECT_STATE_BAND_PROCESSED_JD,
+                                                           pixelColumns[np],pixelRows[np]));
+            if(np==0||processedJd<minimumProcessedJd)
+            {
+                minimumProcessedJd=processedJd;
+            }
+        }
+        QVector<ZonalStatisticsRasterFile> series;
+        for(int ns=0;ns<iterSeries.value().size();ns++)
+        {
+            if(iterSeries.value()[ns].jd>minimumProcessedJd)
+            {
+                series.push_back(iterSeries.value()[ns]);
+            }
+        }
+        // Un reductor por pixel: cada fecha se lee una vez para todos los pixeles del tuplekey
+        QVector<ZonalStatisticsReducer*> ptrReducers;
+        for(int np=0;np<pixelColumns.size();np++)
+        {
+            AccumulatedPerspirationReducer* ptrReducer=new AccumulatedPerspirationReducer(mPerspirationReducer);
+            ptrReducer->clear();
+            if(mExistsPreviousState)
+            {
+                ptrReducer->setState(mPreviousState,pixelColumns[np],pixelRows[np]);
+            }
+            ptrReducers.push_back(ptrReducer);
+        }
+        bool success=mPtrZonalStatisticsEngine->reduceResampledSeries(series,
+                                                                      mRoiNwFc,
+                                                                      mRoiNwSc,
+                                                                      mGsd,
+                                                                      pixelColumns,
+                                                                      pixelRows,
+                                                                      TONIPBPPROJECT_RESAMPLING_METHOD,
+                                                                      ptrReducers,
+                                                                      strAuxError);
+        for(int np=0;np<pixelColumns.size();np++)
+        {
+            AccumulatedPerspirationReducer* ptrReducer=static_cast<AccumulatedPerspirationReducer*>(ptrReducers[np]);
+            if(success)
+            {
+                int column=pixelColumns[np];
+                int row=pixelRows[np];
+                if(mStoreState)
+                {
+                    ptrReducer->getState(mState,column,row);
+                }
+                int position=(row-mFirstRow)*mColumns+column-mFirstColumn;
+                mValues[position]=ptrReducer->getValue(mNoDataValue);
+                mTuplekeyPositions[position]=tuplekeyPosition;
+            }
+            delete(ptrReducer);
+        }
+        if(!success)
+        {
+            strError=QObject::tr("AccumulatedPerspirationTileTask::process");
+            strError+=QObject::tr("\nError processing tuplekey: %1\nError:\n%2")
+                    .arg(tuplekey).arg(strAuxError);
+            return(false);
+        }
+    }
+    return(true);
+}
+}
+
 TONIpbpProject::TONIpbpProject(libCRS::CRSTools* ptrCrsTools,
                                NestedGrid::NestedGridTools* ptrNestedGridTools,
                                IGDAL::libIGDALProcessMonitor *ptrLibIGDALProcessMonitor,
@@ -38,6 +372,9 @@ TONIpbpProject::TONIpbpProject(libCRS::CRSTools* ptrCrsTools,
     }
     mPtrROIsShapefile=NULL;
     mPtrPersistenceManager=NULL;
+    mPtrRoiGeometryCache=NULL;
+    mPtrRasterBlockCache=NULL;
+    mPtrZonalStatisticsEngine=NULL;
     mValidFormatsForDate.append(TONIPBPPROJECT_DATE_FORMAT_1);
     mValidFormatsForDate.append(TONIPBPPROJECT_DATE_FORMAT_2);
     mValidFormatsForDate.append(TONIPBPPROJECT_DATE_FORMAT_3);
@@ -46,6 +383,7 @@ TONIpbpProject::TONIpbpProject(libCRS::CRSTools* ptrCrsTools,
     mFinalNdvi=TONIPBPPROJECT_NODOUBLE;
     mKcbM=TONIPBPPROJECT_NODOUBLE;
     mKcbN=TONIPBPPROJECT_NODOUBLE;
+    mIncrementalUpdate=false;
     mIsInitialized=false;
 }
 
@@ -162,1030 +500,279 @@ bool TONIpbpProject::loadETH0DataFromFile(QString fileName,
         previousJd=jd;
         ethOValues[jd]=eth0Value;
     }while (!strLine.isNull());    // Se ignora la cabecera, integrada por dos lineas
-    mETHOValues=ethOValues;
+    mETH0Series.setValues(ethOValues);
     return(true);
 }
 
 bool TONIpbpProject::processAccumulatedPerspirationByRoi(QString &strError)
+{
+    // El raster de cada zona se calcula y escribe por teselas
+    bool writeRoiRasters=true;
+    bool writeTuplekeyRoiRasters=false;
+    return(processAccumulatedPerspirationAllOutputs(strError,
+                                                    writeRoiRasters,
+                                                    writeTuplekeyRoiRasters,
+                                                    mIncrementalUpdate));
+}
+
+bool TONIpbpProject::processAccumulatedPerspirationByTuplekeyByRoi(QString &strError)
+{
+    // Genera el mismo raster de cada zona que processAccumulatedPerspirationByRoi
+    bool writeRoiRasters=true;
+    bool writeTuplekeyRoiRasters=false;
+    return(processAccumulatedPerspirationAllOutputs(strError,
+                                                    writeRoiRasters,
+                                                    writeTuplekeyRoiRasters,
+                                                    mIncrementalUpdate));
+}
+
+bool TONIpbpProject::processAccumulatedPerspirationByTuplekey(QString &strError)
 {
     if(!mIsInitialized)
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
         strError+=QObject::tr("\nProject is not initialized");
         return(false);
     }
-    QMap<QString,QMap<QString,QMap<int,QString> > > tuplekeyFileNameByProjectCodeByTuplekeyByJd;
-    QMap<QString,QMap<QString,QMap<int,double> > > gainByProjectCodeByTuplekeyByJd;
-    QMap<QString,QMap<QString,QMap<int,double> > > offsetByProjectCodeByTuplekeyByJd;
-    QMap<QString,int> lodByTuplekey;
-    int globalMaximumLod;
+    setRasterBlockCache();
+    QString crsDescription=mPtrNestedGridTools->getCrsDescription();
+    int numberOfPixels=mPtrNestedGridTools->getBaseWorldWidthAndHeightInPixels();
+    QMap<QString,QMap<QString,QMap<int,QString> > > tuplekeyFileNameByTuplekeyByRoiCodeByJd;
+    QMap<QString, int> roiIdByRoiCode;
+    QMap<QString,int> tuplekeyIdByTuplekeyCode;
+    QMap<QString,double> gainByTuplekeyFileName;
+    QMap<QString,double> offsetByTuplekeyFileName;
+    QMap<QString,int> lodTilesByTuplekeyFileName;
+    QMap<QString,int> lodGsdByTuplekeyFileName;
+    int maximumLod;
     QString strAuxError;
-    if(!mPtrPersistenceManager->getNdviDataByProject(tuplekeyFileNameByProjectCodeByTuplekeyByJd,
-                                                     gainByProjectCodeByTuplekeyByJd,
-                                                     offsetByProjectCodeByTuplekeyByJd,
-                                                     lodByTuplekey,
-                                                     globalMaximumLod,
-                                                     strAuxError))
+    if(mFromConsole)
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-        strError+=QObject::tr("\nError recovering ndvi data from database:\n%1").arg(strAuxError);
-        return(false);
+        QString msg=QObject::tr("    ... Recovering data from database");
+        (*mStdOut) <<msg<< endl;
     }
-//    QMap<QString, double> minFirstCoordinateByProjectCode;
-//    QMap<QString, double> maxSecondCoordinateByProjectCode;
-//    QMap<QString, double> maxFirstCoordinateByProjectCode;
-//    QMap<QString, double> minSecondCoordinateByProjectCode;
-//    if(!mPtrPersistenceManager->getProjectEnvelopes(minFirstCoordinateByProjectCode,
-//                                                    maxSecondCoordinateByProjectCode,
-//                                                    maxFirstCoordinateByProjectCode,
-//                                                    minSecondCoordinateByProjectCode,
-//                                                    strAuxError))
-//    {
-//        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-//        strError+=QObject::tr("\nError recovering envelopes of projects from database:\n%1").arg(strAuxError);
-//        return(false);
-//    }
-    QMap<QString, OGRGeometry *> geometryByProjectCode;
-    if(!mPtrPersistenceManager->getProjectGeometries(geometryByProjectCode,
-                                                     strAuxError))
+    if(!mPtrPersistenceManager->getNdviDataByTuplekeyByRoiCode(tuplekeyFileNameByTuplekeyByRoiCodeByJd,
+                                                               roiIdByRoiCode,
+                                                               tuplekeyIdByTuplekeyCode,
+                                                               gainByTuplekeyFileName,
+                                                               offsetByTuplekeyFileName,
+                                                               lodTilesByTuplekeyFileName,
+                                                               lodGsdByTuplekeyFileName,
+                                                               maximumLod,
+                                                               strAuxError))
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-        strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+        strError+=QObject::tr("\nError recovering ndvi data from database:\n%1").arg(strAuxError);
         return(false);
     }
-    QFile reportFile(mReportFileName);
-    if (!reportFile.open(QFile::WriteOnly |QFile::Text))
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-        strError+=QObject::tr("\nError opening results file: \n %1").arg(mReportFileName);
-        return(false);
-    }
-    QTextStream out(&reportFile);
-    out<<"RESULTADOS DE PROCESAMIENTO\n";
-    out<<"---------------------------\n";
-    QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iter1=tuplekeyFileNameByProjectCodeByTuplekeyByJd.begin();
-    QString crsDescription=mPtrNestedGridTools->getCrsDescription();
-    int numberOfPixels=mPtrNestedGridTools->getBaseWorldWidthAndHeightInPixels();
-    int rasterBand=0;
-    while(iter1!=tuplekeyFileNameByProjectCodeByTuplekeyByJd.end())
-    {
-        QString projectCode=iter1.key();
-        OGRGeometry* ptrROIGeometry=geometryByProjectCode[projectCode];
-        QMap<QString,QMap<int,QString> > tuplekeyFileNameByTuplekeyByJd=iter1.value();
-        QMap<QString,QMap<int,QString> >::const_iterator iter2=tuplekeyFileNameByTuplekeyByJd.begin();
-        // Obtener el gsd de cada fichero que intersecte
-        double minGsd=1000000.0;
-        int maximumLod=0;
-        QMap<QString,IGDAL::Raster*> ptrRasterFileByFileName; // si no se inserta es porque no intersecta con la geometria de la ROI
-        QMap<QString,QVector<double> > georefRasterFileByFileName;
-        while(iter2!=tuplekeyFileNameByTuplekeyByJd.end())
-        {
-            QString tuplekey=iter2.key();
-            int lod=lodByTuplekey[tuplekey];
-            QMap<int,QString> tuplekeyFileNameByJd=iter2.value();
-            QMap<int,QString>::const_iterator iter3=tuplekeyFileNameByJd.begin();
-            bool existSomeRasterFile=false;
-            while(iter3!=tuplekeyFileNameByJd.end())
-            {
-                QString rasterFileName=iter3.value();
-                IGDAL::Raster* ptrRasterFile=NULL;
-                ptrRasterFile=new IGDAL::Raster(mPtrCrsTools);
-                if(!ptrRasterFile->setFromFile(rasterFileName,strAuxError))
-                {
-                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                    strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
-                            .arg(rasterFileName).arg(strAuxError);
-                    QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                    while(iter!=geometryByProjectCode.end())
-                    {
-                        OGRGeometryFactory::destroyGeometry(iter.value());
-                        iter.value()=NULL;
-                        iter++;
-                    }
-                    return(false);
-                }
-                OGRGeometry *ptrRasterEnvelopeGeometry=ptrRasterFile->getEnvelopeGeometry();
-                if(!ptrROIGeometry->Intersects(ptrRasterEnvelopeGeometry))
-                {
-                    iter3++;
-                    continue;
-                }
-                existSomeRasterFile=true;
-                QVector<double> georef;
-                if(!ptrRasterFile->getGeoRef(georef,
-                                             strAuxError))
-                {
-                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                    strError+=QObject::tr("\nError getting georef from raster file:\n%1\nError:\n%2")
-                            .arg(rasterFileName).arg(strAuxError);
-                    QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                    while(iter!=geometryByProjectCode.end())
-                    {
-                        OGRGeometryFactory::destroyGeometry(iter.value());
-                        iter.value()=NULL;
-                        iter++;
-                    }
-                    QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                    while(iterRf!=ptrRasterFileByFileName.end())
-                    {
-                        if(iterRf.value()!=NULL)
-                        {
-                            delete(iterRf.value());
-                            iterRf.value()=NULL;
-                        }
-                        iterRf++;
-                    }
-                    return(false);
-                }
-                ptrRasterFileByFileName[rasterFileName]=ptrRasterFile;
-                georefRasterFileByFileName[rasterFileName]=georef;
-                double rasterGsd=georef[1];
-                if(rasterGsd<minGsd)
-                {
-                    minGsd=rasterGsd;
-                }
-
-                iter3++;
-            }
-            if(existSomeRasterFile)
-            {
-                if(lod>maximumLod)
-                {
-                    maximumLod=lod;
-                }
-            }
-            iter2++;
-        }
-        double roiNwFc,roiNwSc;
-        QMap<QString, QMap<int, QVector<int> > > roiColumnsByRowByTuplekey;
-        int roiColumns,roiRows;
-        if(!mPtrNestedGridTools->getRoiPixelsFromPolygon(ptrROIGeometry,
-                                                         crsDescription,
-                                                         maximumLod,
-                                                         minGsd,
-                                                         roiNwFc,
-                                                         roiNwSc,
-                                                         roiColumnsByRowByTuplekey,
-                                                         roiColumns,
-                                                         roiRows,
+        QMap<QString, OGRGeometry *> geometryByRoiCode;
+        if(!mPtrPersistenceManager->getProjectGeometries(geometryByRoiCode,
                                                          strAuxError))
         {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-            strError+=QObject::tr("\nError getting pixels for project: %1\nError:\n%2")
-                    .arg(projectCode).arg(strAuxError);
-            QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-            while(iter!=geometryByProjectCode.end())
-            {
-                OGRGeometryFactory::destroyGeometry(iter.value());
-                iter.value()=NULL;
-                iter++;
-            }
-            QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-            while(iterRf!=ptrRasterFileByFileName.end())
-            {
-                if(iterRf.value()!=NULL)
-                {
-                    delete(iterRf.value());
-                    iterRf.value()=NULL;
-                }
-                iterRf++;
-            }
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+            strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
             return(false);
         }
-        out<<"- Procesamiento de la zona .........................: "<<projectCode<<"\n";
-        out<<"  - LOD maximo .....................................: "<<QString::number(maximumLod)<<"\n";
-        out<<"  - GSD minimo .....................................: "<<QString::number(minGsd,'f',2)<<"\n";
-//        out<<"  - Dimensiones del raster (columnas,filas) ........: ("<<QString::number(roiColumns)<<","<<QString::number(roiRows)<<")\n";
-        // Se crea el raster
-        int roiNumberOfPixels=roiRows*roiColumns;
-        float* pData=(float*)malloc(roiNumberOfPixels*sizeof(GDT_Float32));
-        QVector<double> roiGeoref;
-        double roiSeFc=roiNwFc+minGsd*roiColumns;
-        double roiSeSc=roiNwSc-minGsd*roiRows;
-        bool closeAfterCreate=false;
-        IGDAL::ImageTypes roiImageType=IGDAL::TIFF;
-        GDALDataType roiGdalDataType=GDT_Float32;
-        QString rasterOutputFileName=mResultsPath+"/"+projectCode+"."+RASTER_TIFF_FILE_EXTENSION;
-        int numberOfBands=1;
-        bool internalGeoRef=true;
-        bool externalGeoRef=false;
-        double noDataValue=TONIPBPPROJECT_RASTER_NODATAVALUE;
-        IGDAL::Raster* ptrOutputRasterFile=new IGDAL::Raster(mPtrCrsTools);
-        QMap<QString, QString> refImageOptions; // por implementar
-        if(!ptrOutputRasterFile->createRaster(rasterOutputFileName, // Se le añade la extension
-                                              roiImageType,roiGdalDataType,
-                                              numberOfBands,
-                                              roiColumns,roiRows,
-                                              internalGeoRef,externalGeoRef,crsDescription,
-                                              roiNwFc,roiNwSc,roiSeFc,roiSeSc,
-                                              roiGeoref, // vacío si se georeferencia con las esquinas
-                                              noDataValue,
-                                              closeAfterCreate,
-                                              refImageOptions,
-                                              //                                               buildOverviews,
-                                              strAuxError))
-        {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-            strError+=QObject::tr("\nError creating raster file:\n%1\nfor project: %2\nError:\n%2")
-                    .arg(rasterOutputFileName).arg(projectCode).arg(strAuxError);
-            QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-            while(iter!=geometryByProjectCode.end())
-            {
-                OGRGeometryFactory::destroyGeometry(iter.value());
-                iter.value()=NULL;
-                iter++;
-            }
-            QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-            while(iterRf!=ptrRasterFileByFileName.end())
-            {
-                if(iterRf.value()!=NULL)
-                {
-                    delete(iterRf.value());
-                    iterRf.value()=NULL;
-                }
-                iterRf++;
-            }
-            free(pData);
+        bool success=setRoiGeometryCache(geometryByRoiCode,
+                                         strAuxError);
+        QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
+        while(iterGeometryByRoiCode!=geometryByRoiCode.end())
+        {
+            OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
+            iterGeometryByRoiCode.value()=NULL;
+            iterGeometryByRoiCode++;
+        }
+        if(!success)
+        {
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+            strError+=QObject::tr("\nError caching geometries of projects:\n%1").arg(strAuxError);
             return(false);
         }
-        for(int row=0;row<roiRows;row++)
+    }
+    QVector<QString> tuplekeys;
+    QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iterTuplekeys=tuplekeyFileNameByTuplekeyByRoiCodeByJd.begin();
+    while(iterTuplekeys!=tuplekeyFileNameByTuplekeyByRoiCodeByJd.end())
+    {
+        tuplekeys.push_back(iterTuplekeys.key());
+        iterTuplekeys++;
+    }
+    QMap<QString,double> minimunGsdByRoiCode;
+    QMap<QString,QVector<double> > rasterBoundingBoxByFileName; // nwFc,nwSc,seFc,seSc -> puede no coincidir con georef porque en algunos casos georef va al centro del pixel
+    QMap<QString,double> rasterGsdByFileName;
+    QMap<QString,int> rasterRowsByFileName;
+    QMap<QString,int> rasterColumnsByFileName;
+    QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iterTuplekeyFileNameByTuplekeyByRoiCodeByJd=tuplekeyFileNameByTuplekeyByRoiCodeByJd.begin();
+    if(mFromConsole)
+    {
+        QString msg=QObject::tr("    ... Computing tuplekeys previous data");
+        (*mStdOut) <<msg<< endl;
+    }
+    while(iterTuplekeyFileNameByTuplekeyByRoiCodeByJd!=tuplekeyFileNameByTuplekeyByRoiCodeByJd.end())
+    {
+        QString tuplekey=iterTuplekeyFileNameByTuplekeyByRoiCodeByJd.key();
+        if(mFromConsole)
         {
-            for(int column=0;column<roiColumns;column++)
-            {
-                pData[row*roiColumns+column]=noDataValue;
-            }
+            QString msg=QObject::tr("        ... Processing tuplekey: %1").arg(tuplekey);
+            (*mStdOut) <<msg<< endl;
         }
-
-        QMap<QString, QMap<int, QVector<int> > >::const_iterator iterRoiColumnsByRowByTuplekey=roiColumnsByRowByTuplekey.begin();
-        while(iterRoiColumnsByRowByTuplekey!=roiColumnsByRowByTuplekey.end())
+        QMap<QString,QMap<int,QString> > tuplekeyFileNameByRoiCodeByJd=iterTuplekeyFileNameByTuplekeyByRoiCodeByJd.value();
+        QMap<QString,QMap<int,QString> >::const_iterator iterTuplekeyFileNameByRoiCodeByJd=tuplekeyFileNameByRoiCodeByJd.begin();
+        while(iterTuplekeyFileNameByRoiCodeByJd!=tuplekeyFileNameByRoiCodeByJd.end())
         {
-            QString tuplekey=iterRoiColumnsByRowByTuplekey.key();
-            out<<"  - Procesamiento del tuplekey .....................: "<<tuplekey<<"\n";
-            if(!tuplekeyFileNameByTuplekeyByJd.contains(tuplekey))
-            {
-                out<<"    No hay informacion para este tuplekey"<<"\n";
-                iterRoiColumnsByRowByTuplekey++;
-            }
-            QVector<int> jds;
-            QVector<QString> fileNames;
-            QVector<double> gains;
-            QVector<double> offsets;
-            QMap<int,QString> tuplekeyFileNameByJd=tuplekeyFileNameByTuplekeyByJd[tuplekey];
-            QMap<int,QString>::const_iterator iter3=tuplekeyFileNameByJd.begin();
-            while(iter3!=tuplekeyFileNameByJd.end())
-            {
-                int jd=iter3.key();
-                QString fileName=iter3.value();
-                if(ptrRasterFileByFileName.contains(fileName)) // siempre se tiene que cumplir
-                {
-                    jds.push_back(jd);
-                    fileNames.push_back(fileName);
-                    double gain=gainByProjectCodeByTuplekeyByJd[projectCode][tuplekey][jd];
-                    double offset=offsetByProjectCodeByTuplekeyByJd[projectCode][tuplekey][jd];
-                    gains.push_back(gain);
-                    offsets.push_back(offset);
-                }
-                iter3++;
-            }
-            out<<"  - Procesamiento del tuplekey .....................: "<<tuplekey<<"\n";
-            out<<"    - Escenas NDVI que intervienenr: "<<QString::number(jds.size())<<"\n";
-            for(int njd=0;njd<jds.size();njd++)
+            QString roiCode=iterTuplekeyFileNameByRoiCodeByJd.key();
+            if(mFromConsole)
             {
-                out<<"    - Fichero ......................................: "<<fileNames[njd]<<"\n";
-                out<<"      - Fecha ......................................: "<<QDate::fromJulianDay(jds[njd]).toString(TONIPBPPROJECT_DATE_FORMAT_1)<<"\n";
-                out<<"      - Gain y Offset ..............................: ";
-                out<<QString::number(gains[njd],'f',3).rightJustified(10);
-                out<<" y ";
-                out<<QString::number(offsets[njd],'f',3).rightJustified(10);
-                out<<"\n";
+                QString msg=QObject::tr("            ... Processing ROI: %1").arg(roiCode);
+                (*mStdOut) <<msg<< endl;
             }
-            QMap<int, QVector<int> > roiColumnsByRow=roiColumnsByRowByTuplekey[tuplekey];
-            QMap<int, QVector<int> >::const_iterator iterRow=roiColumnsByRow.begin();
-            QVector<IGDAL::Raster*> rastersToClose;
-            QMap<QString,QVector<QVector<double> > > rasterValuesByFileName;
-            QMap<QString,QVector<double> > rasterBoundingBoxByFileName; // nwFc,nwSc,seFc,seSc -> puede no coincidir con georef porque en algunos casos georef va al centro del pixel
-            while(iterRow!=roiColumnsByRow.end())
+            QMap<int,QString> tuplekeyFileNameByJd=iterTuplekeyFileNameByRoiCodeByJd.value();
+            QMap<int,QString>::const_iterator iterTuplekeyFileNameByJd=tuplekeyFileNameByJd.begin();
+            while(iterTuplekeyFileNameByJd!=tuplekeyFileNameByJd.end())
             {
-                int row=iterRow.key();
-                for(int nc=0;nc<iterRow.value().size();nc++)
+                QString rasterFileName=iterTuplekeyFileNameByJd.value();
+                int lodTiles=lodTilesByTuplekeyFileName[rasterFileName];
+                int lodGsd=lodGsdByTuplekeyFileName[rasterFileName];
+                if(!rasterGsdByFileName.contains(rasterFileName))
                 {
-                    int column=iterRow.value()[nc];
-                    double centerPixelFc=roiNwFc+column*minGsd+0.5*minGsd;
-                    double centerPixelSc=roiNwSc-row*minGsd-0.5*minGsd;
-                    double nwPixelFc=roiNwFc+column*minGsd;
-                    double nwPixelSc=roiNwSc-row*minGsd;
-                    double nePixelFc=nwPixelFc+minGsd;
-                    double nePixelSc=nwPixelSc;
-                    double sePixelFc=nwPixelFc+minGsd;
-                    double sePixelSc=nwPixelSc-minGsd;
-                    double swPixelFc=nwPixelFc;
-                    double swPixelSc=nwPixelSc-minGsd;
-                    bool findInitialNdvi=false;
-                    bool findFinalNdvid=false;
-                    int previousJd=0;
-                    double previousKcb=0.0;
-                    double accumulatedValue=0.0;
-                    for(int njd=0;njd<jds.size();njd++)
+                    double rasterGsd;
+                    if(!mPtrNestedGridTools->getLodGsd(lodGsd,rasterGsd,strAuxError))
                     {
-                        int jd=jds[njd];
-                        if(jd<mInitialJd||jd>mFinalJd)
-                        {
-                            continue;
-                        }
-                        QString rasterFileName=fileNames[njd];
-                        QVector<double> rasterGeoref=georefRasterFileByFileName[rasterFileName];
-                        QVector<QVector<double> > rasterValues;
-                        QVector<double> rasterBoundingBox;
-                        int rasterColumns,rasterRows;
-                        if(!rasterValuesByFileName.contains(rasterFileName))
+                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                        strError+=QObject::tr("\nError getting lod gds for raster file:\n%1\nError:\n%2")
+                                .arg(rasterFileName).arg(strAuxError);
+                        return(false);
+                    }
+                    rasterGsdByFileName[rasterFileName]=rasterGsd;
+                    if(!minimunGsdByRoiCode.contains(roiCode))
+                    {
+                        minimunGsdByRoiCode[roiCode]=rasterGsd;
+                    }
+                    else
+                    {
+                        if(rasterGsd<minimunGsdByRoiCode[roiCode])
                         {
-                            IGDAL::Raster* ptrRaster=ptrRasterFileByFileName[rasterFileName];
-                            if(!ptrRaster->getSize(rasterColumns,rasterRows,strAuxError))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                                strError+=QObject::tr("\nError getting dimensions from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                                while(iter!=geometryByProjectCode.end())
-                                {
-                                    OGRGeometryFactory::destroyGeometry(iter.value());
-                                    iter.value()=NULL;
-                                    iter++;
-                                }
-                                QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                                while(iterRf!=ptrRasterFileByFileName.end())
-                                {
-                                    if(iterRf.value()!=NULL)
-                                    {
-                                        delete(iterRf.value());
-                                        iterRf.value()=NULL;
-                                    }
-                                    iterRf++;
-                                }
-                                free(pData);
-                                delete(ptrOutputRasterFile);
-                                return(false);
-                            }
-                            double rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc;
-                            if(!ptrRaster->getBoundingBox(rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc,strAuxError))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                                strError+=QObject::tr("\nError getting bounding box from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                                while(iter!=geometryByProjectCode.end())
-                                {
-                                    OGRGeometryFactory::destroyGeometry(iter.value());
-                                    iter.value()=NULL;
-                                    iter++;
-                                }
-                                QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                                while(iterRf!=ptrRasterFileByFileName.end())
-                                {
-                                    if(iterRf.value()!=NULL)
-                                    {
-                                        delete(iterRf.value());
-                                        iterRf.value()=NULL;
-                                    }
-                                    iterRf++;
-                                }
-                                free(pData);
-                                delete(ptrOutputRasterFile);
-                                return(false);
-                            }
-                            rasterBoundingBox.push_back(rasterNwFc);
-                            rasterBoundingBox.push_back(rasterNwSc);
-                            rasterBoundingBox.push_back(rasterSeFc);
-                            rasterBoundingBox.push_back(rasterSeSc);
-                            rasterBoundingBoxByFileName[rasterFileName]=rasterBoundingBox;
-                            if(!ptrRaster->readValues(rasterBand,
-                                                      0,0,
-                                                      rasterColumns,rasterRows,
-                                                      rasterValues,
-                                                      strAuxError)) // values[row][column]
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                                strError+=QObject::tr("\nError getting dimensions from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                                while(iter!=geometryByProjectCode.end())
-                                {
-                                    OGRGeometryFactory::destroyGeometry(iter.value());
-                                    iter.value()=NULL;
-                                    iter++;
-                                }
-                                QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                                while(iterRf!=ptrRasterFileByFileName.end())
-                                {
-                                    if(iterRf.value()!=NULL)
-                                    {
-                                        delete(iterRf.value());
-                                        iterRf.value()=NULL;
-                                    }
-                                    iterRf++;
-                                }
-                                free(pData);
-                                delete(ptrOutputRasterFile);
-                                return(false);
-                            }
-                            rasterValuesByFileName[rasterFileName]=rasterValues;
-                        }
-                        else
-                        {
-                            rasterValues=rasterValuesByFileName[rasterFileName];
-                            rasterBoundingBox=rasterBoundingBoxByFileName[rasterFileName];
-                            rasterRows=rasterValues.size();
-                            rasterColumns=rasterValues[0].size();
-                        }
-                        double rasterGsd=rasterGeoref[1];
-                        double rasterValue=0.0;
-                        if(fabs(rasterGsd-minGsd)<0.001)
-                        {
-                            int rasterColumn=floor((centerPixelFc-rasterBoundingBox[0])/rasterGsd);
-                            int rasterRow=floor((rasterBoundingBox[1]-centerPixelSc)/rasterGsd);
-                            rasterValue=rasterValues[rasterRow][rasterColumn];
-//                            rasterValue=rasterValues[row][column];
-                        }
-                        else
-                        {
-                            if(minGsd<=rasterGsd) // en este caso siempre se cumple
-                            {
-                                int rasterColumn=floor((centerPixelFc-rasterBoundingBox[0])/rasterGsd);
-                                int rasterRow=floor((rasterBoundingBox[1]-centerPixelSc)/rasterGsd);
-                                rasterValue=rasterValues[rasterRow][rasterColumn];
-                            }
-                            else
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                                strError+=QObject::tr("\nError invalid GSD in [%1,%2] for raster file:\n%3")
-                                        .arg(QString::number(column)).arg(QString::number(row)).arg(rasterFileName);
-                                QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                                while(iter!=geometryByProjectCode.end())
-                                {
-                                    OGRGeometryFactory::destroyGeometry(iter.value());
-                                    iter.value()=NULL;
-                                    iter++;
-                                }
-                                QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                                while(iterRf!=ptrRasterFileByFileName.end())
-                                {
-                                    if(iterRf.value()!=NULL)
-                                    {
-                                        delete(iterRf.value());
-                                        iterRf.value()=NULL;
-                                    }
-                                    iterRf++;
-                                }
-                                free(pData);
-                                delete(ptrOutputRasterFile);
-                                return(false);
-                                /*
-                                int rasterNwColumn=floor((nwPixelFc-rasterBoundingBox[0])/rasterGsd);
-                                int rasterNwRow=floor((rasterBoundingBox[1]-nwPixelSc)/rasterGsd);
-                                double rasterNwValue=0.0;
-                                if(rasterNwColumn>0&&rasterNwColumn<rasterColumns
-                                        &&rasterNwRow>0&&rasterNwRow<rasterRows)
-                                {
-                                    rasterNwValue=rasterValues[rasterNwRow][rasterNwColumn];
-                                }
-                                int rasterNeColumn=floor((nePixelFc-rasterBoundingBox[0])/rasterGsd);
-                                int rasterNeRow=floor((rasterBoundingBox[1]-nePixelSc)/rasterGsd);
-                                double rasterNeValue=0.0;
-                                if(rasterNeColumn>0&&rasterNeColumn<rasterColumns
-                                        &&rasterNeRow>0&&rasterNeRow<rasterRows)
-                                {
-                                    rasterNeValue=rasterValues[rasterNeRow][rasterNeColumn];
-                                }
-                                int rasterSeColumn=floor((sePixelFc-rasterBoundingBox[0])/rasterGsd);
-                                int rasterSeRow=floor((rasterBoundingBox[1]-sePixelSc)/rasterGsd);
-                                double rasterSeValue=0.0;
-                                if(rasterSeColumn>0&&rasterSeColumn<rasterColumns
-                                        &&rasterSeRow>0&&rasterSeRow<rasterRows)
-                                {
-                                    rasterSeValue=rasterValues[rasterSeRow][rasterSeColumn];
-                                }
-                                int rasterSwColumn=floor((swPixelFc-rasterBoundingBox[0])/rasterGsd);
-                                int rasterSwRow=floor((rasterBoundingBox[1]-swPixelSc)/rasterGsd);
-                                double rasterSwValue=0.0;
-                                if(rasterSwColumn>0&&rasterSwColumn<rasterColumns
-                                        &&rasterSwRow>0&&rasterSwRow<rasterRows)
-                                {
-                                    rasterSwValue=rasterValues[rasterSwRow][rasterSwColumn];
-                                }
-                                // Interpolacion bilineal
-                                */
-                            }
-                        }
-                        double offset=offsets[njd];
-                        double gain=gains[njd];
-                        double ndvi=(rasterValue+offsets[njd])*gains[njd];
-                        if(ndvi>=mInitialNdvi&&ndvi<=mFinalNdvi)
-                        {
-                            double kcb=ndvi*mKcbM+mKcbN;
-                            if(!mETHOValues.contains(jd))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                                strError+=QObject::tr("\nError no ETH0 for date %1 for raster file:\n%2")
-                                        .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1)).arg(rasterFileName);
-                                QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                                while(iter!=geometryByProjectCode.end())
-                                {
-                                    OGRGeometryFactory::destroyGeometry(iter.value());
-                                    iter.value()=NULL;
-                                    iter++;
-                                }
-                                QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                                while(iterRf!=ptrRasterFileByFileName.end())
-                                {
-                                    if(iterRf.value()!=NULL)
-                                    {
-                                        delete(iterRf.value());
-                                        iterRf.value()=NULL;
-                                    }
-                                    iterRf++;
-                                }
-                                free(pData);
-                                delete(ptrOutputRasterFile);
-                                return(false);
-                            }
-                            double eth0=mETHOValues[jd];
-                            accumulatedValue+=(kcb*eth0);
-                            if(previousJd>0)
-                            {
-                                int interpolatedJd=previousJd+1;
-                                while(interpolatedJd<jd)
-                                {
-                                    if(!mETHOValues.contains(interpolatedJd))
-                                    {
-                                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-                                        strError+=QObject::tr("\nError no ETH0 for date %1 for raster file:\n%2")
-                                                .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1)).arg(rasterFileName);
-                                        QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-                                        while(iter!=geometryByProjectCode.end())
-                                        {
-                                            OGRGeometryFactory::destroyGeometry(iter.value());
-                                            iter.value()=NULL;
-                                            iter++;
-                                        }
-                                        QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                                        while(iterRf!=ptrRasterFileByFileName.end())
-                                        {
-                                            if(iterRf.value()!=NULL)
-                                            {
-                                                delete(iterRf.value());
-                                                iterRf.value()=NULL;
-                                            }
-                                            iterRf++;
-                                        }
-                                        free(pData);
-                                        delete(ptrOutputRasterFile);
-                                        return(false);
-                                    }
-                                    double interpolatedKcb=previousKcb+(kcb-previousKcb)/(jd-previousJd)*(interpolatedJd-previousJd);
-                                    double interpolatedEth0=mETHOValues[interpolatedJd];
-                                    accumulatedValue+=(interpolatedKcb*interpolatedEth0);
-                                    interpolatedJd++;
-                                }
-                            }
-                            previousJd=jd;
-                            previousKcb=kcb;
-                            if(!findInitialNdvi)
-                            {
-                                findInitialNdvi=true;
-                            }
-                        }
-                        else
-                        {
-                            if(findInitialNdvi) // se supone que
-                            {
-                                findFinalNdvid=true;
-                                break;
-                            }
+                            minimunGsdByRoiCode[roiCode]=rasterGsd;
                         }
                     }
-                    double finalRasterValue=noDataValue;
-                    if(findInitialNdvi&&findFinalNdvid) // caso normal
+                    int tileX,tileY,lodAux;
+                    if(!mPtrNestedGridTools->conversionTuplekeyToTileCoordinates(tuplekey,lodAux,tileX,tileY,strAuxError))
                     {
-                        finalRasterValue=accumulatedValue;
+                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                        strError+=QObject::tr("\nError getting tileX and tileY from tuplekey for raster file:\n%1\nError:\n%2")
+                                .arg(rasterFileName).arg(strAuxError);
+                        return(false);
                     }
-                    if(findInitialNdvi&&!findFinalNdvid)
+                    double rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc;
+                    if(!mPtrNestedGridTools->getBoundingBoxFromTile(lodTiles,tileX,tileY,crsDescription,
+                                                                    rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc,
+                                                                    strAuxError))
                     {
-                        finalRasterValue=accumulatedValue;//??
+                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                        strError+=QObject::tr("\nError getting bounding box from tuplekey for raster file:\n%1\nError:\n%2")
+                                .arg(rasterFileName).arg(strAuxError);
+                        return(false);
                     }
-                    int posInPData=(row)*roiColumns+column;
-                    pData[posInPData]=finalRasterValue;
-                }
-                iterRow++;
-            }
-            iterRoiColumnsByRowByTuplekey++;
-        }
-        int initialColumn=0;
-        int initialRow=0;
-        int numberOfBand=0;
-        if(!ptrOutputRasterFile->writeValues(numberOfBand, // desde 0
-                                             initialColumn,
-                                             initialRow,
-                                             roiColumns,
-                                             roiRows,
-                                             pData,
-                                             strError))
-        {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByProject");
-            strError+=QObject::tr("\nError writting raster file:\n%1\nfor project: %2\nError:\n%2")
-                    .arg(rasterOutputFileName).arg(projectCode).arg(strAuxError);
-            QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-            while(iter!=geometryByProjectCode.end())
-            {
-                OGRGeometryFactory::destroyGeometry(iter.value());
-                iter.value()=NULL;
-                iter++;
-            }
-            QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-            while(iterRf!=ptrRasterFileByFileName.end())
-            {
-                if(iterRf.value()!=NULL)
-                {
-                    delete(iterRf.value());
-                    iterRf.value()=NULL;
+                    QVector<double> rasterBoundingBox;
+                    rasterBoundingBox.push_back(rasterNwFc);
+                    rasterBoundingBox.push_back(rasterNwSc);
+                    rasterBoundingBox.push_back(rasterSeFc);
+                    rasterBoundingBox.push_back(rasterSeSc);
+                    rasterBoundingBoxByFileName[rasterFileName]=rasterBoundingBox;
+                    int rasterColumns,rasterRows;
+                    rasterColumns=qRound((rasterSeFc-rasterNwFc)/rasterGsdByFileName[rasterFileName]);
+                    rasterRows=qRound((rasterNwSc-rasterSeSc)/rasterGsdByFileName[rasterFileName]);
+                    rasterRowsByFileName[rasterFileName]=rasterRows;
+                    rasterColumnsByFileName[rasterFileName]=rasterColumns;
                 }
-                iterRf++;
-            }
-            free(pData);
-            delete(ptrOutputRasterFile);
-            return(false);
-        }
-        free(pData);
-        delete(ptrOutputRasterFile);
-        QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-        while(iterRf!=ptrRasterFileByFileName.end())
-        {
-            if(iterRf.value()!=NULL)
-            {
-                delete(iterRf.value());
-                iterRf.value()=NULL;
+                iterTuplekeyFileNameByJd++;
             }
-            iterRf++;
+            iterTuplekeyFileNameByRoiCodeByJd++;
         }
-        iter1++;
-    }
-
-    reportFile.close();
-    QMap<QString, OGRGeometry *>::iterator iter=geometryByProjectCode.begin();
-    while(iter!=geometryByProjectCode.end())
-    {
-        OGRGeometryFactory::destroyGeometry(iter.value());
-        iter.value()=NULL;
-        iter++;
+        iterTuplekeyFileNameByTuplekeyByRoiCodeByJd++;
     }
-    return(true);
-}
 
-bool TONIpbpProject::processAccumulatedPerspirationByTuplekeyByRoi(QString &strError)
-{
-    if(!mIsInitialized)
+    int rasterBand=0;
+    double noDataValue=TONIPBPPROJECT_RASTER_NODATAVALUE;
+    QFile reportFile(mReportFileName);
+    if (!reportFile.open(QFile::WriteOnly |QFile::Text))
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-        strError+=QObject::tr("\nProject is not initialized");
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+        strError+=QObject::tr("\nError opening results file: \n %1").arg(mReportFileName);
         return(false);
     }
-    QMap<QString,QMap<QString,QMap<int,QString> > > tuplekeyFileNameByRoiCodeByTuplekeyByJd;
-    QMap<QString,QMap<QString,QMap<int,double> > > gainByRoiCodeByTuplekeyByJd;
-    QMap<QString,QMap<QString,QMap<int,double> > > offsetByRoiCodeByTuplekeyByJd;
-    QMap<QString,int> lodByTuplekey;
-    int globalMaximumLod;
-    QString strAuxError;
-    if(!mPtrPersistenceManager->getNdviDataByProject(tuplekeyFileNameByRoiCodeByTuplekeyByJd,
-                                                     gainByRoiCodeByTuplekeyByJd,
-                                                     offsetByRoiCodeByTuplekeyByJd,
-                                                     lodByTuplekey,
-                                                     globalMaximumLod,
-                                                     strAuxError))
+    QTextStream out(&reportFile);
+    out<<"RESULTADOS DE PROCESAMIENTO\n";
+    out<<"---------------------------\n";
+    if(mFromConsole)
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-        strError+=QObject::tr("\nError recovering ndvi data from database:\n%1").arg(strAuxError);
-        return(false);
+        QString msg=QObject::tr("    ... Processing tuplekeys");
+        (*mStdOut) <<msg<< endl;
     }
-//    QMap<QString, double> minFirstCoordinateByProjectCode;
-//    QMap<QString, double> maxSecondCoordinateByProjectCode;
-//    QMap<QString, double> maxFirstCoordinateByProjectCode;
-//    QMap<QString, double> minSecondCoordinateByProjectCode;
-//    if(!mPtrPersistenceManager->getProjectEnvelopes(minFirstCoordinateByProjectCode,
-//                                                    maxSecondCoordinateByProjectCode,
-//                                                    maxFirstCoordinateByProjectCode,
-//                                                    minSecondCoordinateByProjectCode,
-//                                                    strAuxError))
-//    {
-//        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-//        strError+=QObject::tr("\nError recovering envelopes of projects from database:\n%1").arg(strAuxError);
-//        return(false);
-//    }
-    QMap<QString, OGRGeometry *> geometryByRoiCode;
-    if(!mPtrPersistenceManager->getProjectGeometries(geometryByRoiCode,
-                                                     strAuxError))
+    for(int nt=0;nt<tuplekeys.size();nt++)
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-        strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
-        return(false);
-    }
-    QString crsDescription=mPtrNestedGridTools->getCrsDescription();
-    int numberOfPixels=mPtrNestedGridTools->getBaseWorldWidthAndHeightInPixels();
-    int rasterBand=0;
-    double noDataValue=TONIPBPPROJECT_RASTER_NODATAVALUE;
-    QMap<QString,QMap<QString, QMap<int, QVector<int> > > > roiColumnsByRowByTuplekeyByRoiCode;
-    QMap<QString, double> roiNwFcByRoiCode;
-    QMap<QString, double> roiNwScByRoiCode;
-    QMap<QString, int> roiColumnsByRoiCode;
-    QMap<QString, int> roiRowsByRoiCode;
-    QMap<QString,double> minimunGsdByRoiCode;
-    QMap<QString,int> maximunLodByRoiCode;
-    QMap<QString,QString> outputRasterFileNameByRoiCode; // si no se inserta es porque no intersecta con la geometria de la ROI
-    QMap<QString,IGDAL::Raster*> ptrRasterFileByFileName; // si no se inserta es porque no intersecta con la geometria de la ROI
-    QMap<QString,QVector<double> > georefRasterFileByFileName;
-    QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iter1=tuplekeyFileNameByRoiCodeByTuplekeyByJd.begin();
-    while(iter1!=tuplekeyFileNameByRoiCodeByTuplekeyByJd.end())
-    {
-        QString roiCode=iter1.key();
-        OGRGeometry* ptrRoiGeometry=geometryByRoiCode[roiCode];
-        QMap<QString,QMap<int,QString> > tuplekeyFileNameByTuplekeyByJd=iter1.value();
-        QMap<QString,QMap<int,QString> >::const_iterator iter2=tuplekeyFileNameByTuplekeyByJd.begin();
-        // Obtener el gsd de cada fichero que intersecte
-        double minGsd=1000000.0;
-        int maximumLod=0;
-        while(iter2!=tuplekeyFileNameByTuplekeyByJd.end())
-        {
-            QString tuplekey=iter2.key();
-            int lod=lodByTuplekey[tuplekey];
-            QMap<int,QString> tuplekeyFileNameByJd=iter2.value();
-            QMap<int,QString>::const_iterator iter3=tuplekeyFileNameByJd.begin();
-            bool existSomeRasterFile=false;
-            while(iter3!=tuplekeyFileNameByJd.end())
-            {
-                QString rasterFileName=iter3.value();
-                IGDAL::Raster* ptrRasterFile=NULL;
-                if(!ptrRasterFileByFileName.contains(rasterFileName))
-                {
-                    ptrRasterFile=new IGDAL::Raster(mPtrCrsTools);
-                    if(!ptrRasterFile->setFromFile(rasterFileName,strAuxError))
-                    {
-                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                        strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
-                                .arg(rasterFileName).arg(strAuxError);
-                        QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
-                        while(iterGeometryByRoiCode!=geometryByRoiCode.end())
-                        {
-                            OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
-                            iterGeometryByRoiCode.value()=NULL;
-                            iterGeometryByRoiCode++;
-                        }
-                        return(false);
-                    }
-                }
-                else
-                {
-                    ptrRasterFile=ptrRasterFileByFileName[rasterFileName];
-                }
-                OGRGeometry *ptrRasterEnvelopeGeometry=ptrRasterFile->getEnvelopeGeometry();
-                if(!ptrRoiGeometry->Intersects(ptrRasterEnvelopeGeometry))
-                {
-                    iter3++;
-                    continue;
-                }
-                existSomeRasterFile=true;
-                if(!ptrRasterFileByFileName.contains(rasterFileName))
-                {
-                    QVector<double> georef;
-                    if(!ptrRasterFile->getGeoRef(georef,
-                                                 strAuxError))
-                    {
-                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                        strError+=QObject::tr("\nError getting georef from raster file:\n%1\nError:\n%2")
-                                .arg(rasterFileName).arg(strAuxError);
-                        QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
-                        while(iterGeometryByRoiCode!=geometryByRoiCode.end())
-                        {
-                            OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
-                            iterGeometryByRoiCode.value()=NULL;
-                            iterGeometryByRoiCode++;
-                        }
-                        QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-                        while(iterRf!=ptrRasterFileByFileName.end())
-                        {
-                            if(iterRf.value()!=NULL)
-                            {
-                                delete(iterRf.value());
-                                iterRf.value()=NULL;
-                            }
-                            iterRf++;
-                        }
-                        return(false);
-                    }
-                    ptrRasterFileByFileName[rasterFileName]=ptrRasterFile;
-                    georefRasterFileByFileName[rasterFileName]=georef;
-                    double rasterGsd=georef[1];
-                    if(rasterGsd<minGsd)
-                    {
-                        minGsd=rasterGsd;
-                    }
-                }
-                iter3++;
-            }
-            if(existSomeRasterFile)
-            {
-                if(lod>maximumLod)
-                {
-                    maximumLod=lod;
-                }
-            }
-            iter2++;
-        }
-        minimunGsdByRoiCode[roiCode]=minGsd;
-        maximunLodByRoiCode[roiCode]=maximumLod;
-        double roiNwFc,roiNwSc;
-        QMap<QString, QMap<int, QVector<int> > > roiColumnsByRowByTuplekey;
-        int roiColumns,roiRows;
-        if(!mPtrNestedGridTools->getRoiPixelsFromPolygon(ptrRoiGeometry,
-                                                         crsDescription,
-                                                         maximumLod,
-                                                         minGsd,
-                                                         roiNwFc,
-                                                         roiNwSc,
-                                                         roiColumnsByRowByTuplekey,
-                                                         roiColumns,
-                                                         roiRows,
-                                                         strAuxError))
+        QString tuplekey=tuplekeys[nt];
+        if(mFromConsole)
         {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-            strError+=QObject::tr("\nError getting pixels for project: %1\nError:\n%2")
-                    .arg(roiCode).arg(strAuxError);
-            QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
-            while(iterGeometryByRoiCode!=geometryByRoiCode.end())
-            {
-                OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
-                iterGeometryByRoiCode.value()=NULL;
-                iterGeometryByRoiCode++;
-            }
-            QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-            while(iterRf!=ptrRasterFileByFileName.end())
-            {
-                if(iterRf.value()!=NULL)
-                {
-                    delete(iterRf.value());
-                    iterRf.value()=NULL;
-                }
-                iterRf++;
-            }
-            return(false);
-        }
-        roiNwFcByRoiCode[roiCode]=roiNwFc;
-        roiNwScByRoiCode[roiCode]=roiNwSc;
-        roiColumnsByRoiCode[roiCode]=roiColumns;
-        roiRowsByRoiCode[roiCode]=roiRows;
-        // Se crea el raster
-        int roiNumberOfPixels=roiRows*roiColumns;
-        float* pData=(float*)malloc(roiNumberOfPixels*sizeof(GDT_Float32));
-        QVector<double> roiGeoref;
-        double roiSeFc=roiNwFc+minGsd*roiColumns;
-        double roiSeSc=roiNwSc-minGsd*roiRows;
-        bool closeAfterCreate=false;
-        IGDAL::ImageTypes roiImageType=IGDAL::TIFF;
-        GDALDataType roiGdalDataType=GDT_Float32;
-        QString rasterOutputFileName=mResultsPath+"/"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
-        int numberOfBands=1;
-        bool internalGeoRef=true;
-        bool externalGeoRef=false;
-        IGDAL::Raster* ptrOutputRasterFile=new IGDAL::Raster(mPtrCrsTools);
-        QMap<QString, QString> refImageOptions; // por implementar
-        if(!ptrOutputRasterFile->createRaster(rasterOutputFileName, // Se le añade la extension
-                                              roiImageType,roiGdalDataType,
-                                              numberOfBands,
-                                              roiColumns,roiRows,
-                                              internalGeoRef,externalGeoRef,crsDescription,
-                                              roiNwFc,roiNwSc,roiSeFc,roiSeSc,
-                                              roiGeoref, // vacío si se georeferencia con las esquinas
-                                              noDataValue,
-                                              closeAfterCreate,
-                                              refImageOptions,
-                                              //                                               buildOverviews,
-                                              strAuxError))
-        {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-            strError+=QObject::tr("\nError creating raster file:\n%1\nfor project: %2\nError:\n%2")
-                    .arg(rasterOutputFileName).arg(roiCode).arg(strAuxError);
-            QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
-            while(iterGeometryByRoiCode!=geometryByRoiCode.end())
-            {
-                OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
-                iterGeometryByRoiCode.value()=NULL;
-                iterGeometryByRoiCode++;
-            }
-            QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-            while(iterRf!=ptrRasterFileByFileName.end())
-            {
-                if(iterRf.value()!=NULL)
-                {
-                    delete(iterRf.value());
-                    iterRf.value()=NULL;
-                }
-                iterRf++;
-            }
-            free(pData);
-            return(false);
+            QString msg=QObject::tr("        ... Processing tuplekey: %1").arg(tuplekey);
+            (*mStdOut) <<msg<< endl;
         }
-        for(int row=0;row<roiRows;row++)
+        int tuplekeyId=tuplekeyIdByTuplekeyCode[tuplekey];
+        out<<"- Tuplekey a procesar ...............: "<<tuplekey<<"\n";
+        QMap<QString,QMap<int,QString> > tuplekeyFileNameByRoiCodeByJd=tuplekeyFileNameByTuplekeyByRoiCodeByJd[tuplekey];
+        QMap<QString,QMap<int,QString> >::const_iterator iterRoi=tuplekeyFileNameByRoiCodeByJd.begin();
+        while(iterRoi!=tuplekeyFileNameByRoiCodeByJd.end())
         {
-            for(int column=0;column<roiColumns;column++)
+            QString roiCode=iterRoi.key();
+            if(mFromConsole)
             {
-                pData[row*roiColumns+column]=noDataValue;
+                QString msg=QObject::tr("            ... Processing ROI: %1").arg(roiCode);
+                (*mStdOut) <<msg<< endl;
             }
-        }
-        int initialColumn=0;
-        int initialRow=0;
-        int numberOfBand=0;
-        if(!ptrOutputRasterFile->writeValues(numberOfBand, // desde 0
-                                             initialColumn,
-                                             initialRow,
-                                             roiColumns,
-                                             roiRows,
-                                             pData,
-                                             strError))
-        {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-            strError+=QObject::tr("\nError writting raster file:\n%1\nfor project: %2\nError:\n%2")
-                    .arg(rasterOutputFileName).arg(roiCode).arg(strAuxError);
-            QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
-            while(iterGeometryByRoiCode!=geometryByRoiCode.end())
+            double minGsd=minimunGsdByRoiCode[roiCode];
+            OGRGeometry *ptrRoiTuplekeyIntersectionGeometry;
+            if(!getRoiTuplekeyIntersectionGeometry(roiCode,
+                                                   tuplekeyId,
+                                                   ptrRoiTuplekeyIntersectionGeometry,
+                                                   strAuxError))
             {
-                OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
-                iterGeometryByRoiCode.value()=NULL;
-                iterGeometryByRoiCode++;
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
+                return(false);
             }
-            QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-            while(iterRf!=ptrRasterFileByFileName.end())
+            double roiNwFc,roiNwSc, roiSeFc,roiSeSc;
+            QMap<int, QVector<int> > roiColumnsByRow;
+            int roiColumns,roiRows;
+            bool existsRoiGeoref=false;
+            if(ptrRoiTuplekeyIntersectionGeometry!=NULL) // si es NULL es porque el ROI contiene al tuplekey
             {
-                if(iterRf.value()!=NULL)
+                if(!mPtrNestedGridTools->getRoiPixelsFromPolygonInTuplekey(ptrRoiTuplekeyIntersectionGeometry,
+                                                                           crsDescription,
+                                                                           tuplekey,
+                                                                           maximumLod,
+                                                                           minGsd,
+                                                                           roiNwFc,
+                                                                           roiNwSc,
+                                                                           roiColumnsByRow,
+                                                                           roiColumns,
+                                                                           roiRows,
+                                                                           strAuxError))
                 {
-                    delete(iterRf.value());
-                    iterRf.value()=NULL;
+                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                    strError+=QObject::tr("\nError recovering roi pixels for project: %1 and tuplekye: %2\nError:\n%3")
+                            .arg(roiCode).arg(tuplekey).arg(strAuxError);
+                    return(false);
                 }
-                iterRf++;
+                roiSeFc=roiNwFc+roiColumns*minGsd;
+                roiSeSc=roiNwSc-roiRows*minGsd;
+                existsRoiGeoref=true;
             }
-            free(pData);
-            delete(ptrOutputRasterFile);
-            return(false);
-        }
-        free(pData);
-        delete(ptrOutputRasterFile);
-        outputRasterFileNameByRoiCode[roiCode]=rasterOutputFileName;
-        QMap<QString, QMap<int, QVector<int> > >::const_iterator iterRoiColumnsByRowByTuplekey=roiColumnsByRowByTuplekey.begin();
-        while(iterRoiColumnsByRowByTuplekey!=roiColumnsByRowByTuplekey.end())
-        {
-            QString tuplekey=iterRoiColumnsByRowByTuplekey.key();
-            QMap<int, QVector<int> > roiColumnsByRow=roiColumnsByRowByTuplekey[tuplekey];
-            roiColumnsByRowByTuplekeyByRoiCode[tuplekey][roiCode]=roiColumnsByRow;
-            iterRoiColumnsByRowByTuplekey++;
-        }
-        iter1++;
-    }
-    QMap<QString,IGDAL::Raster*>::iterator iterRf=ptrRasterFileByFileName.begin();
-    while(iterRf!=ptrRasterFileByFileName.end())
-    {
-        if(iterRf.value()!=NULL)
-        {
-            delete(iterRf.value());
-            iterRf.value()=NULL;
-        }
-        iterRf++;
-    }
-    QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
-    while(iterGeometryByRoiCode!=geometryByRoiCode.end())
-    {
-        OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
-        iterGeometryByRoiCode.value()=NULL;
-        iterGeometryByRoiCode++;
-    }
-    QFile reportFile(mReportFileName);
-    if (!reportFile.open(QFile::WriteOnly |QFile::Text))
-    {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-        strError+=QObject::tr("\nError opening results file: \n %1").arg(mReportFileName);
-        return(false);
-    }
-    QTextStream out(&reportFile);
-    out<<"RESULTADOS DE PROCESAMIENTO\n";
-    out<<"---------------------------\n";
-    QMap<QString,QMap<QString, QMap<int, QVector<int> > > >::const_iterator iterRoiColumnsByRowByTuplekeyByRoiCode=roiColumnsByRowByTuplekeyByRoiCode.begin();
-    while(iterRoiColumnsByRowByTuplekeyByRoiCode!=roiColumnsByRowByTuplekeyByRoiCode.end())
-    {
-        QString tuplekey=iterRoiColumnsByRowByTuplekeyByRoiCode.key();
-        out<<"- Tuplekey a procesar ...............: "<<tuplekey<<"\n";
-//        QMap<QString,IGDAL::Raster*> ptrTuplekeyRasterFileByFileName; // si no se inserta es porque no intersecta con la geometria de la ROI
-        QMap<QString,QVector<QVector<double> > > rasterValuesByFileName;
-        QMap<QString,QVector<double> > rasterBoundingBoxByFileName; // nwFc,nwSc,seFc,seSc -> puede no coincidir con georef porque en algunos casos georef va al centro del pixel
-        QMap<QString, QMap<int, QVector<int> > >::const_iterator iterRoiColumnsByRowByByRoiCode=iterRoiColumnsByRowByTuplekeyByRoiCode.value().begin();
-        while(iterRoiColumnsByRowByByRoiCode!=iterRoiColumnsByRowByTuplekeyByRoiCode.value().end())
-        {
-            QString roiCode=iterRoiColumnsByRowByByRoiCode.key();
-            QMap<int,QString> tuplekeyFileNameByJd=tuplekeyFileNameByRoiCodeByTuplekeyByJd[roiCode][tuplekey];
+            if(ptrRoiTuplekeyIntersectionGeometry!=NULL)
+            {
+                OGRGeometryFactory::destroyGeometry(ptrRoiTuplekeyIntersectionGeometry);
+                ptrRoiTuplekeyIntersectionGeometry=NULL;
+            }
+            QMap<int,QString> tuplekeyFileNameByJd=iterRoi.value();
             QVector<int> jds;
             QVector<QString> fileNames;
             QVector<double> gains;
@@ -1197,54 +784,56 @@ bool TONIpbpProject::processAccumulatedPerspirationByTuplekeyByRoi(QString &strE
                 QString fileName=iterTuplekeyFileNameByJd.value();
                 jds.push_back(jd);
                 fileNames.push_back(fileName);
-                double gain=gainByRoiCodeByTuplekeyByJd[roiCode][tuplekey][jd];
-                double offset=offsetByRoiCodeByTuplekeyByJd[roiCode][tuplekey][jd];
+                double gain=gainByTuplekeyFileName[fileName];
+                double offset=offsetByTuplekeyFileName[fileName];
                 gains.push_back(gain);
                 offsets.push_back(offset);
-                iterTuplekeyFileNameByJd++;
-            }
-            double roiNwFc=roiNwFcByRoiCode[roiCode];
-            double roiNwSc=roiNwScByRoiCode[roiCode];
-            int roiColumns=roiColumnsByRoiCode[roiCode];
-            int roiRows=roiRowsByRoiCode[roiCode];
-            int roiNumberOfPixels=roiRows*roiColumns;
-            QString roiOutputRasterFileName=outputRasterFileNameByRoiCode[roiCode];
-            IGDAL::Raster* ptrRoiRaster=new IGDAL::Raster(mPtrCrsTools);
-            bool updateFile=true;
-            if(!ptrRoiRaster->setFromFile(roiOutputRasterFileName,strAuxError,updateFile))
-            {
-                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
-                        .arg(roiOutputRasterFileName).arg(strAuxError);
-                return(false);
-            }
-            float* pData=(float*)malloc(roiNumberOfPixels*sizeof(GDT_Float32));
-            { // para que se borre roiRasterValues
-                QVector<QVector<double> > roiRasterValues;
-                if(!ptrRoiRaster->readValues(rasterBand,
-                                          0,0,
-                                          roiColumns,roiRows,
-                                          roiRasterValues,
-                                          strAuxError)) // values[row][column]
-                {
-                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                    strError+=QObject::tr("\nError reading values from raster file:\n%1\nError:\n%2")
-                            .arg(roiOutputRasterFileName).arg(strAuxError);
-                    free(pData);
-                    delete(ptrRoiRaster);
-                    return(false);
-                }
-                for(int row=0;row<roiRows;row++)
+                if(!existsRoiGeoref)
                 {
-                    for(int column=0;column<roiColumns;column++)
+                    roiNwFc=rasterBoundingBoxByFileName[fileName][0];
+                    roiNwSc=rasterBoundingBoxByFileName[fileName][1];
+                    roiSeFc=rasterBoundingBoxByFileName[fileName][2];
+                    roiSeSc=rasterBoundingBoxByFileName[fileName][3];
+                    roiColumns=qRound((roiSeFc-roiNwFc)/minGsd);
+                    roiRows=qRound((roiNwSc-roiSeSc)/minGsd);
+                    for(int contRow=0;contRow<roiRows;contRow++)
                     {
-                        pData[row*roiColumns+column]=roiRasterValues[row][column];
+                        QVector<int> auxColumns(roiColumns);
+                        for(int contColumn=0;contColumn<roiColumns;contColumn++)
+                        {
+                            auxColumns[contColumn]=contColumn;
+                        }
+                        roiColumnsByRow[contRow]=auxColumns;
                     }
+                    existsRoiGeoref=true;
                 }
+                iterTuplekeyFileNameByJd++;
             }
-            double minGsd=minimunGsdByRoiCode[roiCode];
-            int maximumLod=maximunLodByRoiCode[roiCode];
-            QMap<int, QVector<int> > roiColumnsByRow=iterRoiColumnsByRowByByRoiCode.value();
+            int roiNumberOfPixels=roiRows*roiColumns;
+            float* pData=(float*)malloc(roiNumberOfPixels*sizeof(GDT_Float32));
+            for(int row=0;row<roiRows;row++)
+            {
+                for(int column=0;column<roiColumns;column++)
+                {
+                    pData[row*roiColumns+column]=noDataValue;
+                }
+            }
+            // Serie temporal del tuplekey en el intervalo de fechas
+            QVector<ZonalStatisticsRasterFile> series;
+            for(int njd=0;njd<jds.size();njd++)
+            {
+                if(jds[njd]<mInitialJd||jds[njd]>mFinalJd)
+                {
+                    continue;
+                }
+                ZonalStatisticsRasterFile rasterFile;
+                rasterFile.fileName=fileNames[njd];
+                rasterFile.jd=jds[njd];
+                rasterFile.gain=gains[njd];
+                rasterFile.offset=offsets[njd];
+                series.push_back(rasterFile);
+            }
+            AccumulatedPerspirationReducer perspirationReducer(mETH0Series,mInitialNdvi,mFinalNdvi,mKcbM,mKcbN);
             QMap<int, QVector<int> >::const_iterator iterRow=roiColumnsByRow.begin();
             while(iterRow!=roiColumnsByRow.end())
             {
@@ -1254,746 +843,823 @@ bool TONIpbpProject::processAccumulatedPerspirationByTuplekeyByRoi(QString &strE
                     int column=iterRow.value()[nc];
                     double centerPixelFc=roiNwFc+column*minGsd+0.5*minGsd;
                     double centerPixelSc=roiNwSc-row*minGsd-0.5*minGsd;
-                    double nwPixelFc=roiNwFc+column*minGsd;
-                    double nwPixelSc=roiNwSc-row*minGsd;
-                    double nePixelFc=nwPixelFc+minGsd;
-                    double nePixelSc=nwPixelSc;
-                    double sePixelFc=nwPixelFc+minGsd;
-                    double sePixelSc=nwPixelSc-minGsd;
-                    double swPixelFc=nwPixelFc;
-                    double swPixelSc=nwPixelSc-minGsd;
-                    bool findInitialNdvi=false;
-                    bool findFinalNdvid=false;
-                    int previousJd=0;
-                    double previousKcb=0.0;
-                    double accumulatedValue=0.0;
-                    for(int njd=0;njd<jds.size();njd++)
-                    {
-                        int jd=jds[njd];
-                        if(jd<mInitialJd||jd>mFinalJd)
-                        {
-                            continue;
-                        }
-                        QString rasterFileName=fileNames[njd];
-                        QVector<double> rasterGeoref=georefRasterFileByFileName[rasterFileName];
-                        QVector<QVector<double> > rasterValues;
-                        QVector<double> rasterBoundingBox;
-                        int rasterColumns,rasterRows;
-                        if(!rasterValuesByFileName.contains(rasterFileName))
-                        {
-                            IGDAL::Raster* ptrRaster=new IGDAL::Raster(mPtrCrsTools);
-                            if(!ptrRaster->setFromFile(rasterFileName,strAuxError))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                delete(ptrRoiRaster);
-                                free(pData);
-                                return(false);
-                            }
-                            if(!ptrRaster->getSize(rasterColumns,rasterRows,strAuxError))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                strError+=QObject::tr("\nError getting dimensions from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                delete(ptrRaster);
-                                delete(ptrRoiRaster);
-                                free(pData);
-                                return(false);
-                            }
-                            double rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc;
-                            if(!ptrRaster->getBoundingBox(rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc,strAuxError))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                strError+=QObject::tr("\nError getting bounding box from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                delete(ptrRaster);
-                                delete(ptrRoiRaster);
-                                free(pData);
-                                return(false);
-                            }
-                            rasterBoundingBox.push_back(rasterNwFc);
-                            rasterBoundingBox.push_back(rasterNwSc);
-                            rasterBoundingBox.push_back(rasterSeFc);
-                            rasterBoundingBox.push_back(rasterSeSc);
-                            rasterBoundingBoxByFileName[rasterFileName]=rasterBoundingBox;
-                            if(!ptrRaster->readValues(rasterBand,
-                                                      0,0,
-                                                      rasterColumns,rasterRows,
-                                                      rasterValues,
-                                                      strAuxError)) // values[row][column]
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                strError+=QObject::tr("\nError getting dimensions from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                delete(ptrRaster);
-                                delete(ptrRoiRaster);
-                                free(pData);
-                                return(false);
-                            }
-                            delete(ptrRaster);
-                            rasterValuesByFileName[rasterFileName]=rasterValues;
-                        }
-                        else
-                        {
-                            rasterValues=rasterValuesByFileName[rasterFileName];
-                            rasterBoundingBox=rasterBoundingBoxByFileName[rasterFileName];
-                            rasterRows=rasterValues.size();
-                            rasterColumns=rasterValues[0].size();
-                        }
-                        double rasterGsd=rasterGeoref[1];
-                        double rasterValue=0.0;
-                        if(fabs(rasterGsd-minGsd)<0.001)
-                        {
-                            int rasterColumn=floor((centerPixelFc-rasterBoundingBox[0])/rasterGsd);
-                            int rasterRow=floor((rasterBoundingBox[1]-centerPixelSc)/rasterGsd);
-                            rasterValue=rasterValues[rasterRow][rasterColumn];
-//                            rasterValue=rasterValues[row][column];
-                        }
-                        else
-                        {
-                            if(minGsd<=rasterGsd) // en este caso siempre se cumple
-                            {
-                                int rasterColumn=floor((centerPixelFc-rasterBoundingBox[0])/rasterGsd);
-                                int rasterRow=floor((rasterBoundingBox[1]-centerPixelSc)/rasterGsd);
-                                rasterValue=rasterValues[rasterRow][rasterColumn];
-                            }
-                            else
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                strError+=QObject::tr("\nError invalid GSD in [%1,%2] for raster file:\n%3")
-                                        .arg(QString::number(column)).arg(QString::number(row)).arg(rasterFileName);
-                                delete(ptrRoiRaster);
-                                free(pData);
-                                return(false);
-                            }
-                        }
-                        double offset=offsets[njd];
-                        double gain=gains[njd];
-                        double ndvi=(rasterValue+offsets[njd])*gains[njd];
-                        if(ndvi>=mInitialNdvi&&ndvi<=mFinalNdvi)
-                        {
-                            double kcb=ndvi*mKcbM+mKcbN;
-                            if(!mETHOValues.contains(jd))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                strError+=QObject::tr("\nError no ETH0 for date %1 for raster file:\n%2")
-                                        .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1)).arg(rasterFileName);
-                                delete(ptrRoiRaster);
-                                free(pData);
-                                return(false);
-                            }
-                            double eth0=mETHOValues[jd];
-                            accumulatedValue+=(kcb*eth0);
-                            if(previousJd>0)
-                            {
-                                int interpolatedJd=previousJd+1;
-                                while(interpolatedJd<jd)
-                                {
-                                    if(!mETHOValues.contains(interpolatedJd))
-                                    {
-                                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                                        strError+=QObject::tr("\nError no ETH0 for date %1 for raster file:\n%2")
-                                                .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1)).arg(rasterFileName);
-                                        delete(ptrRoiRaster);
-                                        free(pData);
-                                        return(false);
-                                    }
-                                    double interpolatedKcb=previousKcb+(kcb-previousKcb)/(jd-previousJd)*(interpolatedJd-previousJd);
-                                    double interpolatedEth0=mETHOValues[interpolatedJd];
-                                    accumulatedValue+=(interpolatedKcb*interpolatedEth0);
-                                    interpolatedJd++;
-                                }
-                            }
-                            previousJd=jd;
-                            previousKcb=kcb;
-                            if(!findInitialNdvi)
-                            {
-                                findInitialNdvi=true;
-                            }
-                        }
-                        else
-                        {
-                            if(findInitialNdvi) // se supone que
-                            {
-                                findFinalNdvid=true;
-                                break;
-                            }
-                        }
-                    }
-                    double finalRasterValue=noDataValue;
-                    if(findInitialNdvi&&findFinalNdvid) // caso normal
-                    {
-                        finalRasterValue=accumulatedValue;
-                    }
-                    if(findInitialNdvi&&!findFinalNdvid)
+                    perspirationReducer.clear();
+                    if(!mPtrZonalStatisticsEngine->reducePixelSeries(series,
+                                                                     centerPixelFc,
+                                                                     centerPixelSc,
+                                                                     minGsd,
+                                                                     perspirationReducer,
+                                                                     strAuxError))
                     {
-                        finalRasterValue=accumulatedValue;//??
+                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                        strError+=QObject::tr("\nError processing pixel [%1,%2] of tuplekey: %3\nError:\n%4")
+                                .arg(QString::number(column)).arg(QString::number(row)).arg(tuplekey).arg(strAuxError);
+                        free(pData);
+                        return(false);
                     }
-                    int posInPData=(row)*roiColumns+column;
-                    pData[posInPData]=finalRasterValue;
+                    pData[row*roiColumns+column]=perspirationReducer.getValue(noDataValue);
                 }
                 iterRow++;
             }
+            bool closeAfterCreate=false;
+            IGDAL::ImageTypes roiImageType=IGDAL::TIFF;
+            GDALDataType roiGdalDataType=GDT_Float32;
+            QString rasterOutputFileName=mResultsPath+"/"+tuplekey+"_"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
+            int numberOfBands=1;
+            bool internalGeoRef=true;
+            bool externalGeoRef=false;
+            QVector<double> roiGeoref;// vacio si se georeferencia con las esquinas
+            IGDAL::Raster* ptrOutputRasterFile=new IGDAL::Raster(mPtrCrsTools);
+            QMap<QString, QString> refImageOptions; // por implementar
+            if(!ptrOutputRasterFile->createRaster(rasterOutputFileName, // Se le añade la extension
+                                                  roiImageType,roiGdalDataType,
+                                                  numberOfBands,
+                                                  roiColumns,roiRows,
+                                                  internalGeoRef,externalGeoRef,crsDescription,
+                                                  roiNwFc,roiNwSc,roiSeFc,roiSeSc,
+                                                  roiGeoref,
+                                                  noDataValue,
+                                                  closeAfterCreate,
+                                                  refImageOptions,
+                                                  //                                               buildOverviews,
+                                                  strAuxError))
+            {
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                strError+=QObject::tr("\nError creating raster file:\n%1\nfor tuplekey: %2 and project: %3\nError:\n%4")
+                        .arg(rasterOutputFileName).arg(tuplekey).arg(roiCode).arg(strAuxError);
+                free(pData);
+                return(false);
+            }
             int initialColumn=0;
             int initialRow=0;
-            if(!ptrRoiRaster->writeValues(rasterBand, // desde 0
-                                          initialColumn,
-                                          initialRow,
-                                          roiColumns,
-                                          roiRows,
-                                          pData,
-                                          strError))
+            int numberOfBand=0;
+            if(!ptrOutputRasterFile->writeValues(numberOfBand, // desde 0
+                                                 initialColumn,
+                                                 initialRow,
+                                                 roiColumns,
+                                                 roiRows,
+                                                 pData,
+                                                 strError))
             {
-                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
-                strError+=QObject::tr("\nError writting values to raster file:\n%1\nError:\n%2")
-                        .arg(roiOutputRasterFileName).arg(strAuxError);
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+                strError+=QObject::tr("\nError writting raster file:\n%1\nfor tuplekey: %2 and project: %3\nError:\n%4")
+                        .arg(rasterOutputFileName).arg(tuplekey).arg(roiCode).arg(strAuxError);
+                return(false);
+                free(pData);
+                delete(ptrOutputRasterFile);
                 return(false);
             }
             free(pData);
-            delete(ptrRoiRaster);
-            out<<"  - ROI a procesar ..................: "<<roiCode<<"\n";
-            iterRoiColumnsByRowByByRoiCode++;
+            delete(ptrOutputRasterFile);
+            iterRoi++;
         }
-        iterRoiColumnsByRowByTuplekeyByRoiCode++;
     }
     reportFile.close();
+    QMap<QString, int>::const_iterator iterRoi=roiIdByRoiCode.begin();
+    ProcessTools::MultiProcess *multiProcess=new ProcessTools::MultiProcess();
+    if(mFromConsole)
+    {
+        QString msg=QObject::tr("    ... Writting merged raster");
+        (*mStdOut) <<msg<< endl;
+    }
+    while(iterRoi!=roiIdByRoiCode.end())
+    {
+        QString roiCode=iterRoi.key();
+//        if(mFromConsole)
+//        {
+//            QString msg=QObject::tr("        ... Processing ROI: %1").arg(roiCode);
+//            (*mStdOut) <<msg<< endl;
+//        }
+        QStringList mergeArguments;
+        QString mergeCommand;
+        QString outputFileName=mResultsPath+"/"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
+        QString inputProj4Crs,outputProj4Crs;
+        QStringList inputFileNames;
+        QString patternFiles="*_"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
+        QString resamplingMethod;
+        if(!mPtrLibIGDALProcessMonitor->rasterMergeProcessDefinition(inputFileNames,
+                                                                     patternFiles,
+                                                                     inputProj4Crs,
+                                                                     outputFileName,
+                                                                     outputProj4Crs,
+                                                                     resamplingMethod,
+                                                                     mergeCommand,
+                                                                     mergeArguments,
+                                                                     strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+            strError+=QObject::tr("\nError getting merge process definition for project: %1\nError:\n%2")
+                    .arg(roiCode).arg(strAuxError);
+            return(false);
+        }
+        ProcessTools::ExternalProcess* ptrMergeRasterProcess=new ProcessTools::ExternalProcess(mergeCommand);
+//        ptrReprojectionRasterProcess->appendEnvironmentValue("PATH",micmacBinaryPath);
+//        ptrReprojectionRasterProcess->appendEnvironmentValue("PATH",micmacBinaryAuxPath);
+        ptrMergeRasterProcess->setWorkingDir(mResultsPath);
+        ptrMergeRasterProcess->addIntputs(mergeArguments);
+        QObject::connect(ptrMergeRasterProcess, SIGNAL(finished()),mPtrLibIGDALProcessMonitor,SLOT(onMergeProcessFinished()));
+        multiProcess->appendProcess(ptrMergeRasterProcess);
+        iterRoi++;
+    }
+    QObject::connect(multiProcess, SIGNAL(newStdData(QString)),mPtrLibIGDALProcessMonitor,SLOT(manageProccesStdOutput(QString)));
+    QObject::connect(multiProcess, SIGNAL(newErrorData(QString)),mPtrLibIGDALProcessMonitor,SLOT(manageProccesErrorOutput(QString)));
+    QObject::connect(multiProcess, SIGNAL(finished()),mPtrLibIGDALProcessMonitor,SLOT(multiProcessFinished()));
+    multiProcess->start();
+
     return(true);
 }
 
-bool TONIpbpProject::processAccumulatedPerspirationByTuplekey(QString &strError)
+bool TONIpbpProject::processAccumulatedPerspirationAllOutputs(QString &strError,
+                                                              bool writeRoiRasters,
+                                                              bool writeTuplekeyRoiRasters,
+                                                              bool incrementalUpdate)
 {
     if(!mIsInitialized)
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspiration");
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
         strError+=QObject::tr("\nProject is not initialized");
         return(false);
     }
-    QString crsDescription=mPtrNestedGridTools->getCrsDescription();
-    int numberOfPixels=mPtrNestedGridTools->getBaseWorldWidthAndHeightInPixels();
-    QMap<QString,QMap<QString,QMap<int,QString> > > tuplekeyFileNameByTuplekeyByRoiCodeByJd;
-    QMap<QString, int> roiIdByRoiCode;
-    QMap<QString,int> tuplekeyIdByTuplekeyCode;
-    QMap<QString,double> gainByTuplekeyFileName;
-    QMap<QString,double> offsetByTuplekeyFileName;
-    QMap<QString,int> lodTilesByTuplekeyFileName;
-    QMap<QString,int> lodGsdByTuplekeyFileName;
-    int maximumLod;
+    if(!writeRoiRasters&&!writeTuplekeyRoiRasters)
+    {
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
+        strError+=QObject::tr("\nThere are no outputs to write");
+        return(false);
+    }
+    setRasterBlockCache();
+    QMap<QString,QMap<QString,QMap<int,QString> > > tuplekeyFileNameByRoiCodeByTuplekeyByJd;
+    QMap<QString,QMap<QString,QMap<int,double> > > gainByRoiCodeByTuplekeyByJd;
+    QMap<QString,QMap<QString,QMap<int,double> > > offsetByRoiCodeByTuplekeyByJd;
+    QMap<QString,int> lodByTuplekey;
+    int globalMaximumLod;
     QString strAuxError;
     if(mFromConsole)
     {
         QString msg=QObject::tr("    ... Recovering data from database");
         (*mStdOut) <<msg<< endl;
     }
-    if(!mPtrPersistenceManager->getNdviDataByTuplekeyByRoiCode(tuplekeyFileNameByTuplekeyByRoiCodeByJd,
-                                                               roiIdByRoiCode,
-                                                               tuplekeyIdByTuplekeyCode,
-                                                               gainByTuplekeyFileName,
-                                                               offsetByTuplekeyFileName,
-                                                               lodTilesByTuplekeyFileName,
-                                                               lodGsdByTuplekeyFileName,
-                                                               maximumLod,
-                                                               strAuxError))
+    if(!mPtrPersistenceManager->getNdviDataByProject(tuplekeyFileNameByRoiCodeByTuplekeyByJd,
+                                                     gainByRoiCodeByTuplekeyByJd,
+                                                     offsetByRoiCodeByTuplekeyByJd,
+                                                     lodByTuplekey,
+                                                     globalMaximumLod,
+                                                     strAuxError))
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
         strError+=QObject::tr("\nError recovering ndvi data from database:\n%1").arg(strAuxError);
         return(false);
     }
-    QVector<QString> tuplekeys;
-    QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iterTuplekeys=tuplekeyFileNameByTuplekeyByRoiCodeByJd.begin();
-    while(iterTuplekeys!=tuplekeyFileNameByTuplekeyByRoiCodeByJd.end())
+    QMap<QString, OGRGeometry *> geometryByRoiCode;
+    if(!mPtrPersistenceManager->getProjectGeometries(geometryByRoiCode,
+                                                     strAuxError))
     {
-        tuplekeys.push_back(iterTuplekeys.key());
-        iterTuplekeys++;
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
+        strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
+        return(false);
     }
-    QMap<QString,double> minimunGsdByRoiCode;
-    QMap<QString,QVector<double> > rasterBoundingBoxByFileName; // nwFc,nwSc,seFc,seSc -> puede no coincidir con georef porque en algunos casos georef va al centro del pixel
-    QMap<QString,double> rasterGsdByFileName;
-    QMap<QString,int> rasterRowsByFileName;
-    QMap<QString,int> rasterColumnsByFileName;
-    QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iterTuplekeyFileNameByTuplekeyByRoiCodeByJd=tuplekeyFileNameByTuplekeyByRoiCodeByJd.begin();
-    if(mFromConsole)
+    bool success=setRoiGeometryCache(geometryByRoiCode,
+                                     strAuxError);
+    if(!success)
     {
-        QString msg=QObject::tr("    ... Computing tuplekeys previous data");
-        (*mStdOut) <<msg<< endl;
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
+        strError+=QObject::tr("\nError caching geometries of projects:\n%1").arg(strAuxError);
     }
-    while(iterTuplekeyFileNameByTuplekeyByRoiCodeByJd!=tuplekeyFileNameByTuplekeyByRoiCodeByJd.end())
+    QFile reportFile(mReportFileName);
+    if(success)
     {
-        QString tuplekey=iterTuplekeyFileNameByTuplekeyByRoiCodeByJd.key();
-        if(mFromConsole)
+        if (!reportFile.open(QFile::WriteOnly |QFile::Text))
         {
-            QString msg=QObject::tr("        ... Processing tuplekey: %1").arg(tuplekey);
-            (*mStdOut) <<msg<< endl;
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
+            strError+=QObject::tr("\nError opening results file: \n %1").arg(mReportFileName);
+            success=false;
         }
-        QMap<QString,QMap<int,QString> > tuplekeyFileNameByRoiCodeByJd=iterTuplekeyFileNameByTuplekeyByRoiCodeByJd.value();
-        QMap<QString,QMap<int,QString> >::const_iterator iterTuplekeyFileNameByRoiCodeByJd=tuplekeyFileNameByRoiCodeByJd.begin();
-        while(iterTuplekeyFileNameByRoiCodeByJd!=tuplekeyFileNameByRoiCodeByJd.end())
+    }
+    // Envolvente y GSD de cada fichero NDVI, que se abre una sola vez para todas las zonas
+    QMap<QString,OGRGeometry*> ptrEnvelopeGeometryByFileName;
+    QMap<QString,double> rasterGsdByFileName;
+    if(success)
+    {
+        QTextStream out(&reportFile);
+        out<<"RESULTADOS DE PROCESAMIENTO\n";
+        out<<"---------------------------\n";
+        QMap<QString,QMap<QString,QMap<int,QString> > >::const_iterator iterRoi=tuplekeyFileNameByRoiCodeByTuplekeyByJd.begin();
+        while(iterRoi!=tuplekeyFileNameByRoiCodeByTuplekeyByJd.end())
         {
-            QString roiCode=iterTuplekeyFileNameByRoiCodeByJd.key();
+            QString roiCode=iterRoi.key();
             if(mFromConsole)
             {
-                QString msg=QObject::tr("            ... Processing ROI: %1").arg(roiCode);
+                QString msg=QObject::tr("        ... Processing ROI: %1").arg(roiCode);
                 (*mStdOut) <<msg<< endl;
             }
-            QMap<int,QString> tuplekeyFileNameByJd=iterTuplekeyFileNameByRoiCodeByJd.value();
-            QMap<int,QString>::const_iterator iterTuplekeyFileNameByJd=tuplekeyFileNameByJd.begin();
-            while(iterTuplekeyFileNameByJd!=tuplekeyFileNameByJd.end())
+            if(!processAccumulatedPerspirationAllOutputsForRoi(roiCode,
+                                                               geometryByRoiCode[roiCode],
+                                                               iterRoi.value(),
+                                                               gainByRoiCodeByTuplekeyByJd[roiCode],
+                                                               offsetByRoiCodeByTuplekeyByJd[roiCode],
+                                                               lodByTuplekey,
+                                                               ptrEnvelopeGeometryByFileName,
+                                                               rasterGsdByFileName,
+                                                               writeRoiRasters,
+                                                               writeTuplekeyRoiRasters,
+                                                               incrementalUpdate,
+                                                               out,
+                                                               strAuxError))
             {
-                QString rasterFileName=iterTuplekeyFileNameByJd.value();
-                int lodTiles=lodTilesByTuplekeyFileName[rasterFileName];
-                int lodGsd=lodGsdByTuplekeyFileName[rasterFileName];
-                if(!rasterGsdByFileName.contains(rasterFileName))
-                {
-                    double rasterGsd;
-                    if(!mPtrNestedGridTools->getLodGsd(lodGsd,rasterGsd,strAuxError))
-                    {
-                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                        strError+=QObject::tr("\nError getting lod gds for raster file:\n%1\nError:\n%2")
-                                .arg(rasterFileName).arg(strAuxError);
-                        return(false);
-                    }
-                    rasterGsdByFileName[rasterFileName]=rasterGsd;
-                    if(!minimunGsdByRoiCode.contains(roiCode))
-                    {
-                        minimunGsdByRoiCode[roiCode]=rasterGsd;
-                    }
-                    else
-                    {
-                        if(rasterGsd<minimunGsdByRoiCode[roiCode])
-                        {
-                            minimunGsdByRoiCode[roiCode]=rasterGsd;
-                        }
-                    }
-                    int tileX,tileY,lodAux;
-                    if(!mPtrNestedGridTools->conversionTuplekeyToTileCoordinates(tuplekey,lodAux,tileX,tileY,strAuxError))
-                    {
-                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                        strError+=QObject::tr("\nError getting tileX and tileY from tuplekey for raster file:\n%1\nError:\n%2")
-                                .arg(rasterFileName).arg(strAuxError);
-                        return(false);
-                    }
-                    double rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc;
-                    if(!mPtrNestedGridTools->getBoundingBoxFromTile(lodTiles,tileX,tileY,crsDescription,
-                                                                    rasterNwFc,rasterNwSc,rasterSeFc,rasterSeSc,
-                                                                    strAuxError))
-                    {
-                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                        strError+=QObject::tr("\nError getting bounding box from tuplekey for raster file:\n%1\nError:\n%2")
-                                .arg(rasterFileName).arg(strAuxError);
-                        return(false);
-                    }
-                    QVector<double> rasterBoundingBox;
-                    rasterBoundingBox.push_back(rasterNwFc);
-                    rasterBoundingBox.push_back(rasterNwSc);
-                    rasterBoundingBox.push_back(rasterSeFc);
-                    rasterBoundingBox.push_back(rasterSeSc);
-                    rasterBoundingBoxByFileName[rasterFileName]=rasterBoundingBox;
-                    int rasterColumns,rasterRows;
-                    rasterColumns=qRound((rasterSeFc-rasterNwFc)/rasterGsdByFileName[rasterFileName]);
-                    rasterRows=qRound((rasterNwSc-rasterSeSc)/rasterGsdByFileName[rasterFileName]);
-                    rasterRowsByFileName[rasterFileName]=rasterRows;
-                    rasterColumnsByFileName[rasterFileName]=rasterColumns;
-                }
-                iterTuplekeyFileNameByJd++;
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputs");
+                strError+=QObject::tr("\nError processing project: %1\nError:\n%2")
+                        .arg(roiCode).arg(strAuxError);
+                success=false;
+                break;
             }
-            iterTuplekeyFileNameByRoiCodeByJd++;
+            iterRoi++;
         }
-        iterTuplekeyFileNameByTuplekeyByRoiCodeByJd++;
+        reportFile.close();
     }
-
-    int rasterBand=0;
-    double noDataValue=TONIPBPPROJECT_RASTER_NODATAVALUE;
-    QFile reportFile(mReportFileName);
-    if (!reportFile.open(QFile::WriteOnly |QFile::Text))
+    QMap<QString,OGRGeometry*>::iterator iterEnvelope=ptrEnvelopeGeometryByFileName.begin();
+    while(iterEnvelope!=ptrEnvelopeGeometryByFileName.end())
     {
-        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-        strError+=QObject::tr("\nError opening results file: \n %1").arg(mReportFileName);
-        return(false);
+        OGRGeometryFactory::destroyGeometry(iterEnvelope.value());
+        iterEnvelope.value()=NULL;
+        iterEnvelope++;
     }
-    QTextStream out(&reportFile);
-    out<<"RESULTADOS DE PROCESAMIENTO\n";
-    out<<"---------------------------\n";
-    if(mFromConsole)
+    QMap<QString, OGRGeometry *>::iterator iterGeometryByRoiCode=geometryByRoiCode.begin();
+    while(iterGeometryByRoiCode!=geometryByRoiCode.end())
     {
-        QString msg=QObject::tr("    ... Processing tuplekeys");
-        (*mStdOut) <<msg<< endl;
+        OGRGeometryFactory::destroyGeometry(iterGeometryByRoiCode.value());
+        iterGeometryByRoiCode.value()=NULL;
+        iterGeometryByRoiCode++;
     }
-    for(int nt=0;nt<tuplekeys.size();nt++)
-    {
-        QString tuplekey=tuplekeys[nt];
-        if(mFromConsole)
-        {
-            QString msg=QObject::tr("        ... Processing tuplekey: %1").arg(tuplekey);
-            (*mStdOut) <<msg<< endl;
-        }
-        int tuplekeyId=tuplekeyIdByTuplekeyCode[tuplekey];
-        out<<"- Tuplekey a procesar ...............: "<<tuplekey<<"\n";
-        QMap<QString,QVector<QVector<double> > > rasterValuesByFileName;
-        QMap<QString,QMap<int,QString> > tuplekeyFileNameByRoiCodeByJd=tuplekeyFileNameByTuplekeyByRoiCodeByJd[tuplekey];
-        QMap<QString,QMap<int,QString> >::const_iterator iterRoi=tuplekeyFileNameByRoiCodeByJd.begin();
-        while(iterRoi!=tuplekeyFileNameByRoiCodeByJd.end())
+    return(success);
+}
+
+bool TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi(QString roiCode,
+                                                                    OGRGeometry *ptrRoiGeometry,
+                                                                    const QMap<QString, QMap<int, QString> > &tuplekeyFileNameByTuplekeyByJd,
+                                                                    const QMap<QString, QMap<int, double> > &gainByTuplekeyByJd,
+                                                                    const QMap<QString, QMap<int, double> > &offsetByTuplekeyByJd,
+                                                                    const QMap<QString, int> &lodByTuplekey,
+                                                                    QMap<QString, OGRGeometry *> &ptrEnvelopeGeometryByFileName,
+                                                                    QMap<QString, double> &rasterGsdByFileName,
+                                                                    bool writeRoiRasters,
+                                                                    bool writeTuplekeyRoiRasters,
+                                                                    bool incrementalUpdate,
+                                                                    QTextStream &out,
+                                                                    QString &strError)
+{
+    QString strAuxError;
+    QString crsDescription=mPtrNestedGridTools->getCrsDescription();
+    double noDataValue=TONIPBPPROJECT_RASTER_NODATAVALUE;
+    // Serie temporal de cada tuplekey que intersecta con la zona, GSD minimo y LOD maximo
+    QMap<QString,QVector<ZonalStatisticsRasterFile> > seriesByTuplekey;
+    double minGsd=1000000.0;
+    int maximumLod=0;
+    QMap<QString,QMap<int,QString> >::const_iterator iterTuplekey=tuplekeyFileNameByTuplekeyByJd.begin();
+    while(iterTuplekey!=tuplekeyFileNameByTuplekeyByJd.end())
+    {
+        QString tuplekey=iterTuplekey.key();
+        bool existSomeRasterFile=false;
+        QVector<ZonalStatisticsRasterFile> series;
+        QMap<int,QString>::const_iterator iterFileName=iterTuplekey.value().begin();
+        while(iterFileName!=iterTuplekey.value().end())
         {
-            QString roiCode=iterRoi.key();
-            if(mFromConsole)
+            int jd=iterFileName.key();
+            QString rasterFileName=iterFileName.value();
+            if(!ptrEnvelopeGeometryByFileName.contains(rasterFileName))
             {
-                QString msg=QObject::tr("            ... Processing ROI: %1").arg(roiCode);
-                (*mStdOut) <<msg<< endl;
+                IGDAL::Raster* ptrRasterFile=new IGDAL::Raster(mPtrCrsTools);
+                QVector<double> georef;
+                if(!ptrRasterFile->setFromFile(rasterFileName,strAuxError)
+                        ||!ptrRasterFile->getGeoRef(georef,strAuxError))
+                {
+                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+                    strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
+                            .arg(rasterFileName).arg(strAuxError);
+                    delete(ptrRasterFile);
+                    return(false);
+                }
+                ptrEnvelopeGeometryByFileName[rasterFileName]=ptrRasterFile->getEnvelopeGeometry()->clone();
+                rasterGsdByFileName[rasterFileName]=georef[1];
+                delete(ptrRasterFile);
             }
-            int roiId=roiIdByRoiCode[roiCode];
-            double minGsd=minimunGsdByRoiCode[roiCode];
-            OGRGeometry *ptrRoiTuplekeyIntersectionGeometry;
-            if(!mPtrPersistenceManager->getProjectTuplekeyIntersectionGeomety(roiId,
-                                                                              tuplekeyId,
-                                                                              ptrRoiTuplekeyIntersectionGeometry,
-                                                                              strAuxError))
+            // Todos los ficheros de un tuplekey comparten envolvente
+            bool intersects=false;
+            if(!mPtrRoiGeometryCache->getIntersects(roiCode,
+                                                    tuplekey,
+                                                    ptrEnvelopeGeometryByFileName[rasterFileName],
+                                                    intersects,
+                                                    strAuxError))
             {
-                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                strError+=QObject::tr("\nError recovering geometries of projects from database:\n%1").arg(strAuxError);
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+                strError+=QObject::tr("\nError intersecting raster file:\n%1\nError:\n%2")
+                        .arg(rasterFileName).arg(strAuxError);
                 return(false);
             }
-            double roiNwFc,roiNwSc, roiSeFc,roiSeSc;
-            QMap<int, QVector<int> > roiColumnsByRow;
-            int roiColumns,roiRows;
-            bool existsRoiGeoref=false;
-            if(ptrRoiTuplekeyIntersectionGeometry!=NULL) // si es NULL es porque el ROI contiene al tuplekey
+            if(!intersects)
             {
-                if(!mPtrNestedGridTools->getRoiPixelsFromPolygonInTuplekey(ptrRoiTuplekeyIntersectionGeometry,
-                                                                           crsDescription,
-                                                                           tuplekey,
-                                                                           maximumLod,
-                                                                           minGsd,
-                                                                           roiNwFc,
-                                                                           roiNwSc,
-                                                                           roiColumnsByRow,
-                                                                           roiColumns,
-                                                                           roiRows,
-                                                                           strAuxError))
-                {
-                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                    strError+=QObject::tr("\nError recovering roi pixels for project: %1 and tuplekye: %2\nError:\n%3")
-                            .arg(roiCode).arg(tuplekey).arg(strAuxError);
-                    return(false);
-                }
-                roiSeFc=roiNwFc+roiColumns*minGsd;
-                roiSeSc=roiNwSc-roiRows*minGsd;
-                existsRoiGeoref=true;
+                iterFileName++;
+                continue;
             }
-            if(ptrRoiTuplekeyIntersectionGeometry!=NULL)
+            existSomeRasterFile=true;
+            minGsd=qMin(minGsd,rasterGsdByFileName[rasterFileName]);
+            if(jd>=mInitialJd&&jd<=mFinalJd)
             {
-                OGRGeometryFactory::destroyGeometry(ptrRoiTuplekeyIntersectionGeometry);
-                ptrRoiTuplekeyIntersectionGeometry=NULL;
+                ZonalStatisticsRasterFile rasterFile;
+                rasterFile.fileName=rasterFileName;
+                rasterFile.jd=jd;
+                rasterFile.gain=gainByTuplekeyByJd[tuplekey][jd];
+                rasterFile.offset=offsetByTuplekeyByJd[tuplekey][jd];
+                series.push_back(rasterFile);
             }
-            QMap<int,QString> tuplekeyFileNameByJd=iterRoi.value();
-            QVector<int> jds;
-            QVector<QString> fileNames;
-            QVector<double> gains;
-            QVector<double> offsets;
-            QMap<int,QString>::const_iterator iterTuplekeyFileNameByJd=tuplekeyFileNameByJd.begin();
-            while(iterTuplekeyFileNameByJd!=tuplekeyFileNameByJd.end())
+            iterFileName++;
+        }
+        if(existSomeRasterFile)
+        {
+            maximumLod=qMax(maximumLod,lodByTuplekey[tuplekey]);
+            seriesByTuplekey[tuplekey]=series;
+        }
+        iterTuplekey++;
+    }
+    double roiNwFc,roiNwSc;
+    QMap<QString, QMap<int, QVector<int> > > roiColumnsByRowByTuplekey;
+    int roiColumns,roiRows;
+    if(!mPtrNestedGridTools->getRoiPixelsFromPolygon(ptrRoiGeometry,
+                                                     crsDescription,
+                                                     maximumLod,
+                                                     minGsd,
+                                                     roiNwFc,
+                                                     roiNwSc,
+                                                     roiColumnsByRowByTuplekey,
+                                                     roiColumns,
+                                                     roiRows,
+                                                     strAuxError))
+    {
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+        strError+=QObject::tr("\nError getting pixels for project: %1\nError:\n%2")
+                .arg(roiCode).arg(strAuxError);
+        return(false);
+    }
+    out<<"- Procesamiento de la zona .........................: "<<roiCode<<"\n";
+    out<<"  - LOD maximo .....................................: "<<QString::number(maximumLod)<<"\n";
+    out<<"  - GSD minimo .....................................: "<<QString::number(minGsd,'f',2)<<"\n";
+    // Estado de la ejecucion anterior: solo se usa si coincide la malla y los parametros
+    QVector<double> roiGeoTransform;
+    roiGeoTransform<<roiNwFc<<minGsd<<0.0<<roiNwSc<<0.0<<-minGsd;
+    QString stateParameters=QString::number(mInitialJd)+";"+QString::number(mInitialNdvi,'g',17)
+            +";"+QString::number(mFinalNdvi,'g',17)+";"+QString::number(mKcbM,'g',17)
+            +";"+QString::number(mKcbN,'g',17);
+    QString stateFileName=mResultsPath+"/"+roiCode+TONIPBPPROJECT_STATE_FILE_SUFFIX+"."+RASTER_TIFF_FILE_EXTENSION;
+    PixelStateRaster previousStateRaster;
+    bool existsPreviousState=false;
+    if(incrementalUpdate&&QFile::exists(stateFileName))
+    {
+        if(!previousStateRaster.open(stateFileName,strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+            strError+=QObject::tr("\nError reading state file for project: %1\nError:\n%2")
+                    .arg(roiCode).arg(strAuxError);
+            return(false);
+        }
+        QString previousStateParameters;
+        existsPreviousState=(previousStateRaster.isCompatible(TONIPBPPROJECT_STATE_NUMBER_OF_BANDS,roiColumns,roiRows,roiGeoTransform)
+                             &&previousStateRaster.getMetadataValue(TONIPBPPROJECT_STATE_METADATA_PARAMETERS,previousStateParameters)
+                             &&previousStateParameters==stateParameters);
+        // El estado no sirve si proceso fechas posteriores a la final actual o si han cambiado
+        // la ETH0 o los NDVI de las fechas que ya acumulo
+        QString strPreviousFinalJd,previousInputsFingerprint;
+        int previousFinalJd=0;
+        bool validPreviousFinalJd=false;
+        if(existsPreviousState
+                &&previousStateRaster.getMetadataValue(TONIPBPPROJECT_STATE_METADATA_FINAL_JD,strPreviousFinalJd))
+        {
+            previousFinalJd=strPreviousFinalJd.toInt(&validPreviousFinalJd);
+        }
+        existsPreviousState=(existsPreviousState
+                             &&validPreviousFinalJd
+                             &&previousFinalJd<=mFinalJd
+                             &&previousStateRaster.getMetadataValue(TONIPBPPROJECT_STATE_METADATA_INPUTS_FINGERPRINT,previousInputsFingerprint));
+        if(existsPreviousState)
+        {
+            QString inputsFingerprint;
+            getStateInputsFingerprint(previousFinalJd,seriesByTuplekey,inputsFingerprint);
+            existsPreviousState=(inputsFingerprint==previousInputsFingerprint);
+        }
+        if(!existsPreviousState)
+        {
+            previousStateRaster.clear();
+            out<<"  - Estado anterior no valido, se recalcula ........: "<<stateFileName<<"\n";
+        }
+    }
+    if(existsPreviousState)
+    {
+        out<<"  - Actualizacion incremental desde el estado ......: "<<stateFileName<<"\n";
+    }
+    // El raster de estado, de 5 bandas Float64, solo se escribe para la actualizacion incremental
+    PixelStateRaster stateRaster;
+    PixelStateRaster* ptrStateRaster=NULL;
+    if(incrementalUpdate)
+    {
+        if(!stateRaster.create(stateFileName,
+                               TONIPBPPROJECT_STATE_NUMBER_OF_BANDS,
+                               roiColumns,
+                               roiRows,
+                               roiGeoTransform,
+                               strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+            strError+=QObject::tr("\nError creating state file for project: %1\nError:\n%2")
+                    .arg(roiCode).arg(strAuxError);
+            return(false);
+        }
+        stateRaster.setMetadataValue(TONIPBPPROJECT_STATE_METADATA_PARAMETERS,stateParameters);
+        QString inputsFingerprint;
+        getStateInputsFingerprint(mFinalJd,seriesByTuplekey,inputsFingerprint);
+        stateRaster.setMetadataValue(TONIPBPPROJECT_STATE_METADATA_FINAL_JD,QString::number(mFinalJd));
+        stateRaster.setMetadataValue(TONIPBPPROJECT_STATE_METADATA_INPUTS_FINGERPRINT,inputsFingerprint);
+        ptrStateRaster=&stateRaster;
+    }
+    // Rasters de salida, que se escriben por teselas segun se calculan
+    bool success=true;
+    QMap<QString,IGDAL::Raster*> ptrOutputRasterByFileName;
+    QVector<IGDAL::Raster*> ptrTuplekeyRasters; // NULL si no se escribe
+    QVector<QVector<int> > tuplekeyWindows; // firstColumn,firstRow,endColumn,endRow en la malla de la zona
+    QMap<QString, QMap<int, QVector<int> > >::const_iterator iterRoiColumnsByRowByTuplekey=roiColumnsByRowByTuplekey.begin();
+    while(iterRoiColumnsByRowByTuplekey!=roiColumnsByRowByTuplekey.end())
+    {
+        QString tuplekey=iterRoiColumnsByRowByTuplekey.key();
+        const QMap<int, QVector<int> >& roiColumnsByRow=iterRoiColumnsByRowByTuplekey.value();
+        iterRoiColumnsByRowByTuplekey++;
+        QVector<int> window(4);
+        window[0]=roiColumns;
+        window[1]=roiRows;
+        window[2]=0;
+        window[3]=0;
+        QMap<int, QVector<int> >::const_iterator iterRow=roiColumnsByRow.begin();
+        while(iterRow!=roiColumnsByRow.end())
+        {
+            for(int nc=0;nc<iterRow.value().size();nc++)
             {
-                int jd=iterTuplekeyFileNameByJd.key();
-                QString fileName=iterTuplekeyFileNameByJd.value();
-                jds.push_back(jd);
-                fileNames.push_back(fileName);
-                double gain=gainByTuplekeyFileName[fileName];
-                double offset=offsetByTuplekeyFileName[fileName];
-                gains.push_back(gain);
-                offsets.push_back(offset);
-                if(!existsRoiGeoref)
-                {
-                    roiNwFc=rasterBoundingBoxByFileName[fileName][0];
-                    roiNwSc=rasterBoundingBoxByFileName[fileName][1];
-                    roiSeFc=rasterBoundingBoxByFileName[fileName][2];
-                    roiSeSc=rasterBoundingBoxByFileName[fileName][3];
-                    roiColumns=qRound((roiSeFc-roiNwFc)/minGsd);
-                    roiRows=qRound((roiNwSc-roiSeSc)/minGsd);
-                    for(int contRow=0;contRow<roiRows;contRow++)
-                    {
-                        QVector<int> auxColumns(roiColumns);
-                        for(int contColumn=0;contColumn<roiColumns;contColumn++)
-                        {
-                            auxColumns[contColumn]=contColumn;
-                        }
-                        roiColumnsByRow[contRow]=auxColumns;
-                    }
-                    existsRoiGeoref=true;
-                }
-                iterTuplekeyFileNameByJd++;
+                window[0]=qMin(window[0],iterRow.value()[nc]);
+                window[1]=qMin(window[1],iterRow.key());
+                window[2]=qMax(window[2],iterRow.value()[nc]+1);
+                window[3]=qMax(window[3],iterRow.key()+1);
             }
-            int roiNumberOfPixels=roiRows*roiColumns;
-            float* pData=(float*)malloc(roiNumberOfPixels*sizeof(GDT_Float32));
-            for(int row=0;row<roiRows;row++)
+            iterRow++;
+        }
+        tuplekeyWindows.push_back(window);
+        ptrTuplekeyRasters.push_back(NULL);
+        out<<"  - Procesamiento del tuplekey .....................: "<<tuplekey<<"\n";
+        if(!seriesByTuplekey.contains(tuplekey)
+                ||window[2]<=window[0])
+        {
+            out<<"    No hay informacion para este tuplekey"<<"\n";
+            continue;
+        }
+        out<<"    - Escenas NDVI que intervienen .................: "<<QString::number(seriesByTuplekey[tuplekey].size())<<"\n";
+        if(!success||!writeTuplekeyRoiRasters)
+        {
+            continue;
+        }
+        QString rasterOutputFileName=mResultsPath+"/"+tuplekey+"_"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
+        IGDAL::Raster* ptrTuplekeyRaster=NULL;
+        if(!createOutputRaster(rasterOutputFileName,
+                               roiNwFc+window[0]*minGsd,
+                               roiNwSc-window[1]*minGsd,
+                               minGsd,
+                               window[2]-window[0],
+                               window[3]-window[1],
+                               ptrTuplekeyRaster,
+                               strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            success=false;
+            continue;
+        }
+        ptrOutputRasterByFileName[rasterOutputFileName]=ptrTuplekeyRaster;
+        ptrTuplekeyRasters[ptrTuplekeyRasters.size()-1]=ptrTuplekeyRaster;
+        out<<"    - Fichero de resultados del tuplekey ...........: "<<rasterOutputFileName<<"\n";
+    }
+    IGDAL::Raster* ptrRoiRaster=NULL;
+    QString roiRasterOutputFileName=mResultsPath+"/"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
+    if(success&&writeRoiRasters)
+    {
+        if(!createOutputRaster(roiRasterOutputFileName,
+                               roiNwFc,
+                               roiNwSc,
+                               minGsd,
+                               roiColumns,
+                               roiRows,
+                               ptrRoiRaster,
+                               strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            success=false;
+        }
+        else
+        {
+            ptrOutputRasterByFileName[roiRasterOutputFileName]=ptrRoiRaster;
+        }
+    }
+    // Teselas de la malla de la zona, calculadas en paralelo por grupos y escritas en orden,
+    // por lo que la memoria depende del tamano de tesela y no del de la zona
+    QVector<QVector<int> > tiles; // firstColumn,firstRow,columns,rows
+    for(int tileRow=0;tileRow<roiRows;tileRow+=TONIPBPPROJECT_OUTPUT_TILE_SIZE)
+    {
+        for(int tileColumn=0;tileColumn<roiColumns;tileColumn+=TONIPBPPROJECT_OUTPUT_TILE_SIZE)
+        {
+            QVector<int> tile(4);
+            tile[0]=tileColumn;
+            tile[1]=tileRow;
+            tile[2]=qMin(TONIPBPPROJECT_OUTPUT_TILE_SIZE,roiColumns-tileColumn);
+            tile[3]=qMin(TONIPBPPROJECT_OUTPUT_TILE_SIZE,roiRows-tileRow);
+            tiles.push_back(tile);
+        }
+    }
+    int numberOfThreads=TONIPBPPROJECT_NUMBER_OF_THREADS;
+    if(numberOfThreads<=0)
+    {
+        numberOfThreads=QThread::idealThreadCount();
+    }
+    numberOfThreads=qMax(1,numberOfThreads);
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(numberOfThreads);
+    AccumulatedPerspirationReducer perspirationReducer(mETH0Series,mInitialNdvi,mFinalNdvi,mKcbM,mKcbN);
+    for(int firstTile=0;success&&firstTile<tiles.size();firstTile+=numberOfThreads)
+    {
+        QVector<AccumulatedPerspirationTileTask*> ptrTasks;
+        for(int nt=firstTile;nt<qMin(tiles.size(),firstTile+numberOfThreads);nt++)
+        {
+            const QVector<int>& tile=tiles[nt];
+            PixelStateWindow previousState;
+            if(existsPreviousState)
+            {
+                previousState.setWindow(TONIPBPPROJECT_STATE_NUMBER_OF_BANDS,tile[0],tile[1],tile[2],tile[3],0.0);
+            }
+            if(existsPreviousState
+                    &&!previousStateRaster.readWindow(previousState,strAuxError))
+            {
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+                strError+=QObject::tr("\nError reading state file for project: %1\nError:\n%2")
+                        .arg(roiCode).arg(strAuxError);
+                success=false;
+                break;
+            }
+            AccumulatedPerspirationTileTask* ptrTask=new AccumulatedPerspirationTileTask(perspirationReducer,
+                                                                                         roiColumnsByRowByTuplekey,
+                                                                                         seriesByTuplekey,
+                                                                                         tile[0],tile[1],tile[2],tile[3],
+                                                                                         roiNwFc,
+                                                                                         roiNwSc,
+                                                                                         minGsd,
+                                                                                         noDataValue,
+                                                                                         existsPreviousState,
+                                                                                         previousState,
+                                                                                         ptrStateRaster!=NULL,
+                                                                                         mPtrZonalStatisticsEngine);
+            ptrTasks.push_back(ptrTask);
+            threadPool.start(ptrTask);
+        }
+        while(!threadPool.waitForDone(100))
+        {
+            QCoreApplication::processEvents();
+        }
+        for(int nt=0;nt<ptrTasks.size();nt++)
+        {
+            AccumulatedPerspirationTileTask* ptrTask=ptrTasks[nt];
+            if(success&&!ptrTask->getSuccess())
             {
-                for(int column=0;column<roiColumns;column++)
-                {
-                    pData[row*roiColumns+column]=noDataValue;
-                }
+                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+                strError+=QObject::tr("\nError:\n%1").arg(ptrTask->getError());
+                success=false;
             }
-            QMap<int, QVector<int> >::const_iterator iterRow=roiColumnsByRow.begin();
-            while(iterRow!=roiColumnsByRow.end())
+            if(success)
             {
-                int row=iterRow.key();
-                for(int nc=0;nc<iterRow.value().size();nc++)
+                success=writeAccumulatedPerspirationTile(ptrTask->getFirstColumn(),
+                                                         ptrTask->getFirstRow(),
+                                                         ptrTask->getColumns(),
+                                                         ptrTask->getRows(),
+                                                         ptrTask->getValues(),
+                                                         ptrTask->getTuplekeyPositions(),
+                                                         ptrTask->getState(),
+                                                         ptrRoiRaster,
+                                                         ptrTuplekeyRasters,
+                                                         tuplekeyWindows,
+                                                         ptrStateRaster,
+                                                         strAuxError);
+                if(!success)
                 {
-                    int column=iterRow.value()[nc];
-                    double centerPixelFc=roiNwFc+column*minGsd+0.5*minGsd;
-                    double centerPixelSc=roiNwSc-row*minGsd-0.5*minGsd;
-                    double nwPixelFc=roiNwFc+column*minGsd;
-                    double nwPixelSc=roiNwSc-row*minGsd;
-                    double nePixelFc=nwPixelFc+minGsd;
-                    double nePixelSc=nwPixelSc;
-                    double sePixelFc=nwPixelFc+minGsd;
-                    double sePixelSc=nwPixelSc-minGsd;
-                    double swPixelFc=nwPixelFc;
-                    double swPixelSc=nwPixelSc-minGsd;
-                    bool findInitialNdvi=false;
-                    bool findFinalNdvid=false;
-                    int previousJd=0;
-                    double previousKcb=0.0;
-                    double accumulatedValue=0.0;
-                    for(int njd=0;njd<jds.size();njd++)
-                    {
-                        int jd=jds[njd];
-                        if(jd<mInitialJd||jd>mFinalJd)
-                        {
-                            continue;
-                        }
-                        QString rasterFileName=fileNames[njd];
-                        QVector<QVector<double> > rasterValues;
-                        double rasterNwFc=rasterBoundingBoxByFileName[rasterFileName][0];
-                        double rasterNwSc=rasterBoundingBoxByFileName[rasterFileName][1];
-                        int rasterColumns=rasterColumnsByFileName[rasterFileName];
-                        int rasterRows=rasterRowsByFileName[rasterFileName];
-                        if(!rasterValuesByFileName.contains(rasterFileName))
-                        {
-                            IGDAL::Raster* ptrRaster=new IGDAL::Raster(mPtrCrsTools);
-                            if(!ptrRaster->setFromFile(rasterFileName,strAuxError))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                                strError+=QObject::tr("\nError opening raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                free(pData);
-                                return(false);
-                            }
-                            if(!ptrRaster->readValues(rasterBand,
-                                                      0,0,
-                                                      rasterColumns,rasterRows,
-                                                      rasterValues,
-                                                      strAuxError)) // values[row][column]
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                                strError+=QObject::tr("\nError getting dimensions from raster file:\n%1\nError:\n%2")
-                                        .arg(rasterFileName).arg(strAuxError);
-                                delete(ptrRaster);
-                                free(pData);
-                                return(false);
-                            }
-                            delete(ptrRaster);
-                            rasterValuesByFileName[rasterFileName]=rasterValues;
-                        }
-                        else
-                        {
-                            rasterValues=rasterValuesByFileName[rasterFileName];
-//                            rasterBoundingBox=rasterBoundingBoxByFileName[rasterFileName];
-//                            rasterRows=rasterValues.size();
-//                            rasterColumns=rasterValues[0].size();
-                        }
-                        double rasterGsd=rasterGsdByFileName[rasterFileName];
-                        double rasterValue=0.0;
-                        if(fabs(rasterGsd-minGsd)<0.001)
-                        {
-                            int rasterColumn=floor((centerPixelFc-rasterNwFc)/rasterGsd);
-                            int rasterRow=floor((rasterNwSc-centerPixelSc)/rasterGsd);
-                            rasterValue=rasterValues[rasterRow][rasterColumn];
-//                            rasterValue=rasterValues[row][column];
-                        }
-                        else
-                        {
-                            if(minGsd<=rasterGsd) // en este caso siempre se cumple
-                            {
-                                int rasterColumn=floor((centerPixelFc-rasterNwFc)/rasterGsd);
-                                int rasterRow=floor((rasterNwSc-centerPixelSc)/rasterGsd);
-                                rasterValue=rasterValues[rasterRow][rasterColumn];
-                            }
-                            else
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                                strError+=QObject::tr("\nError invalid GSD in [%1,%2] for raster file:\n%3")
-                                        .arg(QString::number(column)).arg(QString::number(row)).arg(rasterFileName);
-                                free(pData);
-                                return(false);
-                            }
-                        }
-                        double offset=offsets[njd];
-                        double gain=gains[njd];
-                        double ndvi=(rasterValue+offsets[njd])*gains[njd];
-                        if(ndvi>=mInitialNdvi&&ndvi<=mFinalNdvi)
-                        {
-                            double kcb=ndvi*mKcbM+mKcbN;
-                            if(!mETHOValues.contains(jd))
-                            {
-                                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                                strError+=QObject::tr("\nError no ETH0 for date %1 for raster file:\n%2")
-                                        .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1)).arg(rasterFileName);
-                                free(pData);
-                                return(false);
-                            }
-                            double eth0=mETHOValues[jd];
-                            accumulatedValue+=(kcb*eth0);
-                            if(previousJd>0)
-                            {
-                                int interpolatedJd=previousJd+1;
-                                while(interpolatedJd<jd)
-                                {
-                                    if(!mETHOValues.contains(interpolatedJd))
-                                    {
-                                        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                                        strError+=QObject::tr("\nError no ETH0 for date %1 for raster file:\n%2")
-                                                .arg(QDate::fromJulianDay(jd).toString(TONIPBPPROJECT_DATE_FORMAT_1)).arg(rasterFileName);
-                                        free(pData);
-                                        return(false);
-                                    }
-                                    double interpolatedKcb=previousKcb+(kcb-previousKcb)/(jd-previousJd)*(interpolatedJd-previousJd);
-                                    double interpolatedEth0=mETHOValues[interpolatedJd];
-                                    accumulatedValue+=(interpolatedKcb*interpolatedEth0);
-                                    interpolatedJd++;
-                                }
-                            }
-                            previousJd=jd;
-                            previousKcb=kcb;
-                            if(!findInitialNdvi)
-                            {
-                                findInitialNdvi=true;
-                            }
-                        }
-                        else
-                        {
-                            if(findInitialNdvi) // se supone que
-                            {
-                                findFinalNdvid=true;
-                                break;
-                            }
-                        }
-                    }
-                    double finalRasterValue=noDataValue;
-                    if(findInitialNdvi&&findFinalNdvid) // caso normal
-                    {
-                        finalRasterValue=accumulatedValue;
-                    }
-                    if(findInitialNdvi&&!findFinalNdvid)
-                    {
-                        finalRasterValue=accumulatedValue;//??
-                    }
-                    int posInPData=(row)*roiColumns+column;
-                    pData[posInPData]=finalRasterValue;
+                    strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+                    strError+=QObject::tr("\nError writting tile for project: %1\nError:\n%2")
+                            .arg(roiCode).arg(strAuxError);
                 }
-                iterRow++;
-            }
-            bool closeAfterCreate=false;
-            IGDAL::ImageTypes roiImageType=IGDAL::TIFF;
-            GDALDataType roiGdalDataType=GDT_Float32;
-            QString rasterOutputFileName=mResultsPath+"/"+tuplekey+"_"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
-            int numberOfBands=1;
-            bool internalGeoRef=true;
-            bool externalGeoRef=false;
-            QVector<double> roiGeoref;// vacio si se georeferencia con las esquinas
-            IGDAL::Raster* ptrOutputRasterFile=new IGDAL::Raster(mPtrCrsTools);
-            QMap<QString, QString> refImageOptions; // por implementar
-            if(!ptrOutputRasterFile->createRaster(rasterOutputFileName, // Se le añade la extension
-                                                  roiImageType,roiGdalDataType,
-                                                  numberOfBands,
-                                                  roiColumns,roiRows,
-                                                  internalGeoRef,externalGeoRef,crsDescription,
-                                                  roiNwFc,roiNwSc,roiSeFc,roiSeSc,
-                                                  roiGeoref,
-                                                  noDataValue,
-                                                  closeAfterCreate,
-                                                  refImageOptions,
-                                                  //                                               buildOverviews,
-                                                  strAuxError))
-            {
-                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                strError+=QObject::tr("\nError creating raster file:\n%1\nfor tuplekey: %2 and project: %3\nError:\n%4")
-                        .arg(rasterOutputFileName).arg(tuplekey).arg(roiCode).arg(strAuxError);
-                free(pData);
-                return(false);
             }
-            int initialColumn=0;
-            int initialRow=0;
-            int numberOfBand=0;
-            if(!ptrOutputRasterFile->writeValues(numberOfBand, // desde 0
-                                                 initialColumn,
-                                                 initialRow,
-                                                 roiColumns,
-                                                 roiRows,
-                                                 pData,
-                                                 strError))
+            delete(ptrTask);
+        }
+    }
+    QMap<QString,IGDAL::Raster*>::iterator iterOutputRaster=ptrOutputRasterByFileName.begin();
+    while(iterOutputRaster!=ptrOutputRasterByFileName.end())
+    {
+        delete(iterOutputRaster.value());
+        iterOutputRaster.value()=NULL;
+        iterOutputRaster++;
+    }
+    previousStateRaster.clear();
+    if(!success)
+    {
+        stateRaster.clear();
+        return(false);
+    }
+    if(ptrStateRaster!=NULL
+            &&!stateRaster.close(strAuxError))
+    {
+        strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationAllOutputsForRoi");
+        strError+=QObject::tr("\nError writting state file for project: %1\nError:\n%2")
+                .arg(roiCode).arg(strAuxError);
+        return(false);
+    }
+    if(writeRoiRasters)
+    {
+        out<<"  - Fichero de resultados de la zona ...............: "<<roiRasterOutputFileName<<"\n";
+    }
+    return(true);
+}
+
+bool TONIpbpProject::createOutputRaster(QString fileName,
+                                        double nwFc,
+                                        double nwSc,
+                                        double gsd,
+                                        int columns,
+                                        int rows,
+                                        IGDAL::Raster *&ptrRaster,
+                                        QString &strError)
+{
+    ptrRaster=NULL;
+    QString strAuxError;
+    QString crsDescription=mPtrNestedGridTools->getCrsDescription();
+    double seFc=nwFc+gsd*columns;
+    double seSc=nwSc-gsd*rows;
+    bool closeAfterCreate=false;
+    IGDAL::ImageTypes imageType=IGDAL::TIFF;
+    GDALDataType gdalDataType=GDT_Float32;
+    int numberOfBands=1;
+    bool internalGeoRef=true;
+    bool externalGeoRef=false;
+    double noDataValue=TONIPBPPROJECT_RASTER_NODATAVALUE;
+    QVector<double> georef; // vacio si se georeferencia con las esquinas
+    QMap<QString, QString> refImageOptions; // por implementar
+    IGDAL::Raster* ptrOutputRasterFile=new IGDAL::Raster(mPtrCrsTools);
+    if(!ptrOutputRasterFile->createRaster(fileName,
+                                          imageType,gdalDataType,
+                                          numberOfBands,
+                                          columns,rows,
+                                          internalGeoRef,externalGeoRef,crsDescription,
+                                          nwFc,nwSc,seFc,seSc,
+                                          georef,
+                                          noDataValue,
+                                          closeAfterCreate,
+                                          refImageOptions,
+                                          strAuxError))
+    {
+        strError=QObject::tr("TONIpbpProject::createOutputRaster");
+        strError+=QObject::tr("\nError creating raster file:\n%1\nError:\n%2")
+                .arg(fileName).arg(strAuxError);
+        delete(ptrOutputRasterFile);
+        return(false);
+    }
+    ptrRaster=ptrOutputRasterFile;
+    return(true);
+}
+
+void TONIpbpProject::getStateInputsFingerprint(int finalJd,
+                                               const QMap<QString, QVector<ZonalStatisticsRasterFile> > &seriesByTuplekey,
+                                               QString &fingerprint)
+{
+    // Huella de las entradas del estado hasta finalJd: valores de ETH0 e identidad de los
+    // ficheros NDVI (ruta, tamaño y fecha de modificacion) con sus parametros radiometricos
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for(int jd=mInitialJd;jd<=finalJd;jd++)
+    {
+        if(mETH0Series.contains(jd))
+        {
+            hash.addData(QString(QString::number(jd)+";"
+                                 +QString::number(mETH0Series.getValue(jd),'g',17)+"\n").toUtf8());
+        }
+    }
+    QMap<QString,QVector<ZonalStatisticsRasterFile> >::const_iterator iterSeries=seriesByTuplekey.begin();
+    while(iterSeries!=seriesByTuplekey.end())
+    {
+        for(int ns=0;ns<iterSeries.value().size();ns++)
+        {
+            const ZonalStatisticsRasterFile& rasterFile=iterSeries.value()[ns];
+            if(rasterFile.jd>finalJd)
             {
-                strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-                strError+=QObject::tr("\nError writting raster file:\n%1\nfor tuplekey: %2 and project: %3\nError:\n%4")
-                        .arg(rasterOutputFileName).arg(tuplekey).arg(roiCode).arg(strAuxError);
-                return(false);
-                free(pData);
-                delete(ptrOutputRasterFile);
-                return(false);
+                continue;
             }
-            free(pData);
-            delete(ptrOutputRasterFile);
-            iterRoi++;
+            QFileInfo rasterFileInfo(rasterFile.fileName);
+            QString strRasterFile=iterSeries.key()+";"+QString::number(rasterFile.jd)+";"+rasterFileInfo.absoluteFilePath();
+            strRasterFile+=(";"+QString::number(rasterFileInfo.size()));
+            strRasterFile+=(";"+QString::number(rasterFileInfo.lastModified().toMSecsSinceEpoch()));
+            strRasterFile+=(";"+QString::number(rasterFile.gain,'g',17));
+            strRasterFile+=(";"+QString::number(rasterFile.offset,'g',17));
+            hash.addData(QString(strRasterFile+"\n").toUtf8());
         }
+        iterSeries++;
     }
-    reportFile.close();
-    QMap<QString, int>::const_iterator iterRoi=roiIdByRoiCode.begin();
-    ProcessTools::MultiProcess *multiProcess=new ProcessTools::MultiProcess();
-    if(mFromConsole)
+    fingerprint=QString::fromLatin1(hash.result().toHex());
+}
+
+bool TONIpbpProject::getRoiTuplekeyIntersectionGeometry(QString roiCode,
+                                                        int tuplekeyId,
+                                                        OGRGeometry *&ptrGeometry,
+                                                        QString &strError)
+{
+    ptrGeometry=NULL;
+    QString strAuxError;
+    if(mPtrRoiGeometryCache==NULL)
     {
-        QString msg=QObject::tr("    ... Writting merged raster");
-        (*mStdOut) <<msg<< endl;
+        strError=QObject::tr("TONIpbpProject::getRoiTuplekeyIntersectionGeometry");
+        strError+=QObject::tr("\nGeometries of projects are not loaded");
+        return(false);
     }
-    while(iterRoi!=roiIdByRoiCode.end())
+    if(!mPtrRoiGeometryCache->containsTuplekey(tuplekeyId))
     {
-        QString roiCode=iterRoi.key();
-//        if(mFromConsole)
-//        {
-//            QString msg=QObject::tr("        ... Processing ROI: %1").arg(roiCode);
-//            (*mStdOut) <<msg<< endl;
-//        }
-        QStringList mergeArguments;
-        QString mergeCommand;
-        QString outputFileName=mResultsPath+"/"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
-        QString inputProj4Crs,outputProj4Crs;
-        QStringList inputFileNames;
-        QString patternFiles="*_"+roiCode+"."+RASTER_TIFF_FILE_EXTENSION;
-        QString resamplingMethod;
-        if(!mPtrLibIGDALProcessMonitor->rasterMergeProcessDefinition(inputFileNames,
-                                                                     patternFiles,
-                                                                     inputProj4Crs,
-                                                                     outputFileName,
-                                                                     outputProj4Crs,
-                                                                     resamplingMethod,
-                                                                     mergeCommand,
-                                                                     mergeArguments,
-                                                                     strAuxError))
+        OGRGeometry* ptrTuplekeyGeometry=NULL;
+        if(!mPtrPersistenceManager->getTuplekeyGeometry(tuplekeyId,
+                                                        ptrTuplekeyGeometry,
+                                                        strAuxError))
         {
-            strError=QObject::tr("TONIpbpProject::processAccumulatedPerspirationByTuplekey");
-            strError+=QObject::tr("\nError getting merge process definition for project: %1\nError:\n%2")
-                    .arg(roiCode).arg(strAuxError);
+            strError=QObject::tr("TONIpbpProject::getRoiTuplekeyIntersectionGeometry");
+            strError+=QObject::tr("\nError recovering data for tuplekey id: %1")
+                    .arg(QString::number(tuplekeyId));
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        bool success=mPtrRoiGeometryCache->insertTuplekey(tuplekeyId,ptrTuplekeyGeometry,strAuxError);
+        OGRGeometryFactory::destroyGeometry(ptrTuplekeyGeometry);
+        if(!success)
+        {
+            strError=QObject::tr("TONIpbpProject::getRoiTuplekeyIntersectionGeometry");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
             return(false);
         }
-        ProcessTools::ExternalProcess* ptrMergeRasterProcess=new ProcessTools::ExternalProcess(mergeCommand);
-//        ptrReprojectionRasterProcess->appendEnvironmentValue("PATH",micmacBinaryPath);
-//        ptrReprojectionRasterProcess->appendEnvironmentValue("PATH",micmacBinaryAuxPath);
-        ptrMergeRasterProcess->setWorkingDir(mResultsPath);
-        ptrMergeRasterProcess->addIntputs(mergeArguments);
-        QObject::connect(ptrMergeRasterProcess, SIGNAL(finished()),mPtrLibIGDALProcessMonitor,SLOT(onMergeProcessFinished()));
-        multiProcess->appendProcess(ptrMergeRasterProcess);
-        iterRoi++;
     }
-    QObject::connect(multiProcess, SIGNAL(newStdData(QString)),mPtrLibIGDALProcessMonitor,SLOT(manageProccesStdOutput(QString)));
-    QObject::connect(multiProcess, SIGNAL(newErrorData(QString)),mPtrLibIGDALProcessMonitor,SLOT(manageProccesErrorOutput(QString)));
-    QObject::connect(multiProcess, SIGNAL(finished()),mPtrLibIGDALProcessMonitor,SLOT(multiProcessFinished()));
-    multiProcess->start();
+    bool roiContainsTuplekey=false;
+    if(!mPtrRoiGeometryCache->getRoiTuplekeyIntersectionGeometry(roiCode,
+                                                                 tuplekeyId,
+                                                                 ptrGeometry,
+                                                                 roiContainsTuplekey,
+                                                                 strAuxError))
+    {
+        strError=QObject::tr("TONIpbpProject::getRoiTuplekeyIntersectionGeometry");
+        strError+=QObject::tr("\nError recovering data for project: %1 an tuplekey id: %2")
+                .arg(roiCode).arg(QString::number(tuplekeyId));
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    // Si el ROI contiene al tuplekey se devuelve NULL, como en PersistenceManager
+    if(roiContainsTuplekey)
+    {
+        OGRGeometryFactory::destroyGeometry(ptrGeometry);
+        ptrGeometry=NULL;
+    }
+    return(true);
+}
+
+void TONIpbpProject::setRasterBlockCache()
+{
+    // Los valores de los ficheros NDVI se leen por bloques con memoria acotada
+    if(mPtrRasterBlockCache==NULL)
+    {
+        mPtrRasterBlockCache=new RasterBlockCache(TONIPBPPROJECT_RASTER_BLOCK_CACHE_MAXIMUM_MB);
+    }
+    if(mPtrZonalStatisticsEngine==NULL)
+    {
+        mPtrZonalStatisticsEngine=new ZonalStatisticsEngine(mPtrRasterBlockCache);
+    }
+    mPtrRasterBlockCache->clear();
+}
 
+bool TONIpbpProject::setRoiGeometryCache(QMap<QString, OGRGeometry *> &geometryByRoiCode,
+                                         QString &strError)
+{
+    if(mPtrRoiGeometryCache==NULL)
+    {
+        mPtrRoiGeometryCache=new RoiGeometryCache();
+    }
+    mPtrRoiGeometryCache->clear();
+    QString strAuxError;
+    QMap<QString, OGRGeometry *>::const_iterator iter=geometryByRoiCode.begin();
+    while(iter!=geometryByRoiCode.end())
+    {
+        if(!mPtrRoiGeometryCache->insertRoi(iter.key(),iter.value(),strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::setRoiGeometryCache");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        iter++;
+    }
     return(true);
 }
 
@@ -2595,6 +2261,42 @@ bool TONIpbpProject::setFromFile(QString &inputFileName,
         clear();
         return(false);
     }
+    QString dbFileName=strValue;
+
+    // Lectura opcional de la actualizacion incremental (true/false), false si no existe la linea
+    nline++;
+    strLine=in.readLine();
+    strLine=strLine.trimmed();
+    if(!strLine.isEmpty())
+    {
+        strList=strLine.split(TONIPBPPROJECT_SEPARATOR_CHARACTER);
+        if(strList.size()!=2)
+        {
+            strError=QObject::tr("TONIpbpProject::setFromFile");
+            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+            strError+=QObject::tr("\nThere are not two fields separated by %1").arg(TONIPBPPROJECT_SEPARATOR_CHARACTER);
+            fileInput.close();
+            clear();
+            return(false);
+        }
+        strValue=strList.at(1).trimmed();
+        if(strValue.compare(TONIPBPPROJECT_INCREMENTAL_UPDATE_TRUE,Qt::CaseInsensitive)==0)
+        {
+            mIncrementalUpdate=true;
+        }
+        else if(strValue.compare(TONIPBPPROJECT_INCREMENTAL_UPDATE_FALSE,Qt::CaseInsensitive)!=0)
+        {
+            strError=QObject::tr("TONIpbpProject::setFromFile");
+            strError+=QObject::tr("\nError reading file: %1").arg(inputFileName);
+            strError+=QObject::tr("\nError reading line: %1").arg(QString::number(nline));
+            strError+=QObject::tr("\nIncremental update value is not %1 or %2: %3")
+                    .arg(TONIPBPPROJECT_INCREMENTAL_UPDATE_TRUE).arg(TONIPBPPROJECT_INCREMENTAL_UPDATE_FALSE).arg(strValue);
+            fileInput.close();
+            clear();
+            return(false);
+        }
+    }
     mPtrPersistenceManager = new RemoteSensing::PersistenceManager();
     QDir programDir=qApp->applicationDirPath();
     QString programPath=programDir.absolutePath();
@@ -2605,15 +2307,15 @@ bool TONIpbpProject::setFromFile(QString &inputFileName,
                                                      strAuxError))
     {
         strError=QObject::tr("TONIpbpProject::setFromFile");
-        strError+=QObject::tr("\nError initializing database:\n%1\nError:\n%2").arg(strValue).arg(strAuxError);
+        strError+=QObject::tr("\nError initializing database:\n%1\nError:\n%2").arg(dbFileName).arg(strAuxError);
         fileInput.close();
         clear();
         return(false);
     }
-    if(!mPtrPersistenceManager->openDatabase(strValue,strError))
+    if(!mPtrPersistenceManager->openDatabase(dbFileName,strError))
     {
         strError=QObject::tr("TONIpbpProject::setFromFile");
-        strError+=QObject::tr("\nError setting database:\n%1\nError:\n%2").arg(strValue).arg(strAuxError);
+        strError+=QObject::tr("\nError setting database:\n%1\nError:\n%2").arg(dbFileName).arg(strAuxError);
         fileInput.close();
         clear();
         return(false);
@@ -2734,7 +2436,7 @@ void TONIpbpProject::multiProcessFinished()
 void TONIpbpProject::clear()
 {
     mETH0FileName.clear();
-    mETHOValues.clear();
+    mETH0Series.clear();
     if(mPtrROIsShapefile!=NULL)
     {
         delete(mPtrROIsShapefile);
@@ -2745,6 +2447,21 @@ void TONIpbpProject::clear()
         delete(mPtrPersistenceManager);
         mPtrPersistenceManager=NULL;
     }
+    if(mPtrRoiGeometryCache!=NULL)
+    {
+        delete(mPtrRoiGeometryCache);
+        mPtrRoiGeometryCache=NULL;
+    }
+    if(mPtrZonalStatisticsEngine!=NULL)
+    {
+        delete(mPtrZonalStatisticsEngine);
+        mPtrZonalStatisticsEngine=NULL;
+    }
+    if(mPtrRasterBlockCache!=NULL)
+    {
+        delete(mPtrRasterBlockCache);
+        mPtrRasterBlockCache=NULL;
+    }
     mInitialJd=0;
     mFinalJd=0;
     mInitialNdvi=TONIPBPPROJECT_NODOUBLE;
@@ -2754,6 +2471,7 @@ void TONIpbpProject::clear()
     mReportFileName.clear();
 //    mOutputRasterFileName.clear();
     mResultsPath.clear();
+    mIncrementalUpdate=false;
     mIsInitialized=false;
     mProjectCodes.clear();
 }
@@ -2833,3 +2551,87 @@ bool TONIpbpProject::removeRubbish(QString &strError)
     }
     return(true);
 }
+
+bool TONIpbpProject::writeAccumulatedPerspirationTile(int firstColumn,
+                                                      int firstRow,
+                                                      int columns,
+                                                      int rows,
+                                                      QVector<float> &values,
+                                                      const QVector<int> &tuplekeyPositions,
+                                                      const PixelStateWindow &state,
+                                                      IGDAL::Raster *ptrRoiRaster,
+                                                      const QVector<IGDAL::Raster *> &ptrTuplekeyRasters,
+                                                      const QVector<QVector<int> > &tuplekeyWindows,
+                                                      PixelStateRaster *ptrStateRaster,
+                                                      QString &strError)
+{
+    QString strAuxError;
+    int numberOfBand=0;
+    if(ptrStateRaster!=NULL
+            &&!ptrStateRaster->writeWindow(state,strAuxError))
+    {
+        strError=QObject::tr("TONIpbpProject::writeAccumulatedPerspirationTile");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    if(ptrRoiRaster!=NULL)
+    {
+        if(!ptrRoiRaster->writeValues(numberOfBand, // desde 0
+                                      firstColumn,
+                                      firstRow,
+                                      columns,
+                                      rows,
+                                      values.data(),
+                                      strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::writeAccumulatedPerspirationTile");
+            strError+=QObject::tr("\nError writting zone raster:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    // Interseccion de la tesela con la ventana de cada tuplekey, solo con sus pixeles
+    for(int nt=0;nt<ptrTuplekeyRasters.size();nt++)
+    {
+        if(ptrTuplekeyRasters[nt]==NULL)
+        {
+            continue;
+        }
+        const QVector<int>& window=tuplekeyWindows[nt];
+        int intersectionFirstColumn=qMax(firstColumn,window[0]);
+        int intersectionFirstRow=qMax(firstRow,window[1]);
+        int intersectionEndColumn=qMin(firstColumn+columns,window[2]);
+        int intersectionEndRow=qMin(firstRow+rows,window[3]);
+        if(intersectionEndColumn<=intersectionFirstColumn
+                ||intersectionEndRow<=intersectionFirstRow)
+        {
+            continue;
+        }
+        int intersectionColumns=intersectionEndColumn-intersectionFirstColumn;
+        int intersectionRows=intersectionEndRow-intersectionFirstRow;
+        QVector<float> tuplekeyValues(intersectionColumns*intersectionRows,TONIPBPPROJECT_RASTER_NODATAVALUE);
+        for(int row=intersectionFirstRow;row<intersectionEndRow;row++)
+        {
+            for(int column=intersectionFirstColumn;column<intersectionEndColumn;column++)
+            {
+                int position=(row-firstRow)*columns+column-firstColumn;
+                if(tuplekeyPositions[position]==nt)
+                {
+                    tuplekeyValues[(row-intersectionFirstRow)*intersectionColumns+column-intersectionFirstColumn]=values[position];
+                }
+            }
+        }
+        if(!ptrTuplekeyRasters[nt]->writeValues(numberOfBand, // desde 0
+                                                intersectionFirstColumn-window[0],
+                                                intersectionFirstRow-window[1],
+                                                intersectionColumns,
+                                                intersectionRows,
+                                                tuplekeyValues.data(),
+                                                strAuxError))
+        {
+            strError=QObject::tr("TONIpbpProject::writeAccumulatedPerspirationTile");
+            strError+=QObject::tr("\nError writting tuplekey raster:\n%1").arg(strAuxError);
+            return(false);
+        }
+    }
+    return(true);
+}
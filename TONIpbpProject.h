@@ -9,6 +9,8 @@
 #include <QStringList>
 
 #include "libremotesensing_global.h"
+#include "DailyValueSeries.h"
+#include "ResamplingIndexMap.h"
 
 #define TONIPBPPROJECT_SEPARATOR_CHARACTER                                  "#"
 #define TONIPBPPROJECT_DATES_SEPARATOR_CHARACTER                            "-"
@@ -35,6 +37,30 @@
 
 #define TONIPBPPROJECT_ZONECODE_PREFIX                                      "zone_"
 
+#define TONIPBPPROJECT_RASTER_BLOCK_CACHE_MAXIMUM_MB                        512
+#define TONIPBPPROJECT_OUTPUT_TILE_SIZE                                     512 // pixeles de lado de cada tesela de salida
+#define TONIPBPPROJECT_NUMBER_OF_THREADS                                    0 // 0: QThread::idealThreadCount()
+#define TONIPBPPROJECT_RESAMPLING_METHOD                                    RESAMPLINGINDEXMAP_METHOD_NEAREST
+
+// Estado por pixel para la actualizacion incremental, raster <zona>_state.tif
+#define TONIPBPPROJECT_INCREMENTAL_UPDATE_TRUE                              "true"
+#define TONIPBPPROJECT_INCREMENTAL_UPDATE_FALSE                             "false"
+#define TONIPBPPROJECT_STATE_FILE_SUFFIX                                    "_state"
+#define TONIPBPPROJECT_STATE_NUMBER_OF_BANDS                                5
+#define TONIPBPPROJECT_STATE_BAND_ACCUMULATED_VALUE                         0
+#define TONIPBPPROJECT_STATE_BAND_PREVIOUS_JD                               1 // ultima fecha con NDVI valido
+#define TONIPBPPROJECT_STATE_BAND_PREVIOUS_KCB                              2
+#define TONIPBPPROJECT_STATE_BAND_STATUS                                    3
+#define TONIPBPPROJECT_STATE_BAND_PROCESSED_JD                              4 // ultima fecha NDVI leida
+#define TONIPBPPROJECT_STATE_STATUS_WITHOUT_NDVI                            0
+#define TONIPBPPROJECT_STATE_STATUS_ACCUMULATING                            1
+#define TONIPBPPROJECT_STATE_STATUS_FINISHED                                2
+#define TONIPBPPROJECT_STATE_METADATA_PARAMETERS                            "TONIPBP_PARAMETERS"
+#define TONIPBPPROJECT_STATE_METADATA_FINAL_JD                              "TONIPBP_FINAL_JD" // ninguna fecha procesada es posterior
+#define TONIPBPPROJECT_STATE_METADATA_INPUTS_FINGERPRINT                    "TONIPBP_INPUTS_FINGERPRINT" // ETH0 y NDVI hasta TONIPBP_FINAL_JD
+
+class OGRGeometry;
+
 namespace NestedGrid{
     class NestedGridTools;
     class NestedGridProject;
@@ -46,11 +72,18 @@ class CRSTools;
 
 namespace IGDAL{
     class libIGDALProcessMonitor;
+    class Raster;
     class Shapefile;
 }
 
 namespace RemoteSensing{
 class PersistenceManager;
+class PixelStateRaster;
+struct PixelStateWindow;
+class RasterBlockCache;
+class RoiGeometryCache;
+class ZonalStatisticsEngine;
+struct ZonalStatisticsRasterFile;
 class LIBREMOTESENSINGSHARED_EXPORT TONIpbpProject : public QObject
 {
     Q_OBJECT
@@ -63,6 +96,13 @@ public:
                    QWidget *parent=NULL);
     bool loadETH0DataFromFile(QString fileName,
                               QString& strError);
+    // Un solo recorrido de los ficheros NDVI: cada pixel se calcula una vez y se escribe en el
+    // raster de la zona y en el raster de cada tuplekey de la zona. Con incrementalUpdate se
+    // guarda el estado por pixel de cada zona y solo se acumulan las fechas nuevas
+    bool processAccumulatedPerspirationAllOutputs(QString& strError,
+                                                  bool writeRoiRasters=true,
+                                                  bool writeTuplekeyRoiRasters=true,
+                                                  bool incrementalUpdate=false);
     bool processAccumulatedPerspirationByRoi(QString& strError);
     bool processAccumulatedPerspirationByTuplekeyByRoi(QString& strError);
     bool processAccumulatedPerspirationByTuplekey(QString& strError);
@@ -73,8 +113,51 @@ public slots:
 
 private:
     void clear();
+    bool createOutputRaster(QString fileName,
+                            double nwFc,
+                            double nwSc,
+                            double gsd,
+                            int columns,
+                            int rows,
+                            IGDAL::Raster*& ptrRaster,
+                            QString& strError);
+    void getStateInputsFingerprint(int finalJd,
+                                   const QMap<QString,QVector<ZonalStatisticsRasterFile> >& seriesByTuplekey,
+                                   QString& fingerprint);
+    bool getRoiTuplekeyIntersectionGeometry(QString roiCode,
+                                            int tuplekeyId,
+                                            OGRGeometry*& ptrGeometry,
+                                            QString& strError);
+    bool processAccumulatedPerspirationAllOutputsForRoi(QString roiCode,
+                                                        OGRGeometry* ptrRoiGeometry,
+                                                        const QMap<QString,QMap<int,QString> >& tuplekeyFileNameByTuplekeyByJd,
+                                                        const QMap<QString,QMap<int,double> >& gainByTuplekeyByJd,
+                                                        const QMap<QString,QMap<int,double> >& offsetByTuplekeyByJd,
+                                                        const QMap<QString,int>& lodByTuplekey,
+                                                        QMap<QString,OGRGeometry*>& ptrEnvelopeGeometryByFileName,
+                                                        QMap<QString,double>& rasterGsdByFileName,
+                                                        bool writeRoiRasters,
+                                                        bool writeTuplekeyRoiRasters,
+                                                        bool incrementalUpdate,
+                                                        QTextStream& out,
+                                                        QString& strError);
     bool removeDir(QString dirName);
     bool removeRubbish(QString &strError);
+    void setRasterBlockCache();
+    bool setRoiGeometryCache(QMap<QString, OGRGeometry *>& geometryByRoiCode,
+                             QString& strError);
+    bool writeAccumulatedPerspirationTile(int firstColumn,
+                                          int firstRow,
+                                          int columns,
+                                          int rows,
+                                          QVector<float>& values,
+                                          const QVector<int>& tuplekeyPositions,
+                                          const PixelStateWindow& state,
+                                          IGDAL::Raster* ptrRoiRaster,
+                                          const QVector<IGDAL::Raster*>& ptrTuplekeyRasters,
+                                          const QVector<QVector<int> >& tuplekeyWindows,
+                                          PixelStateRaster* ptrStateRaster, // NULL: sin estado
+                                          QString& strError);
     QTextStream* mStdOut;
     bool mFromConsole;
     bool mRemoveRubbish;
@@ -82,7 +165,7 @@ private:
     QList<QString> mPathsToRemove;
     QList<QString> mFilesToRemove;
     QString mETH0FileName;
-    QMap<int,double> mETHOValues;
+    DailyValueSeries mETH0Series; // ETH0 diaria densa con sumas acumuladas
     QVector<QString> mProjectCodes;
     IGDAL::Shapefile* mPtrROIsShapefile;
     int mInitialJd;
@@ -94,11 +177,15 @@ private:
     QString mReportFileName;
 //    QString mOutputRasterFileName;
     QString mResultsPath;
+    bool mIncrementalUpdate; // linea opcional del fichero de proyecto
     bool mIsInitialized;
     QStringList mValidFormatsForDate;
     QWidget *mPtrParentWidget;
     libCRS::CRSTools* mPtrCrsTools;
     PersistenceManager *mPtrPersistenceManager;
+    RasterBlockCache* mPtrRasterBlockCache;
+    RoiGeometryCache* mPtrRoiGeometryCache; // geometrias preparadas de los ROIs durante cada proceso
+    ZonalStatisticsEngine* mPtrZonalStatisticsEngine; // sobre mPtrRasterBlockCache
     NestedGrid::NestedGridTools* mPtrNestedGridTools;
     NestedGrid::NestedGridProject* mPtrNestedGridProject;
     IGDAL::libIGDALProcessMonitor* mPtrLibIGDALProcessMonitor;
@@ -0,0 +1,365 @@
+#include <QMap>
+#include <QObject>
+#include <QPair>
+
+#include <algorithm>
+#include <math.h>
+
+#include "RasterBlockCache.h"
+#include "ResamplingIndexMap.h"
+#include "RoiCoverageMask.h"
+#include "ZonalStatisticsEngine.h"
+
+using namespace RemoteSensing;
+
+namespace{
+int findWindowGroup(QVector<int>& parents,
+                    int position)
+{
+    while(parents[position]!=position)
+    {
+        parents[position]=parents[parents[position]];
+        position=parents[position];
+    }
+    return(position);
+}
+
+// Agrupa las ventanas (firstColumn,firstRow,endColumn,endRow) que se solapan o estan a menos
+// de gap pixeles, por barrido en filas. Las ventanas vacias no se asignan a ningun grupo
+void coalesceWindows(const QVector<QVector<int> >& windows,
+                     int gap,
+                     QVector<QVector<int> >& groupWindows,
+                     QVector<QVector<int> >& windowPositionsByGroup)
+{
+    groupWindows.clear();
+    windowPositionsByGroup.clear();
+    QVector<QPair<int,int> > firstRowAndPositions;
+    QVector<int> parents(windows.size());
+    for(int nw=0;nw<windows.size();nw++)
+    {
+        parents[nw]=nw;
+        if(windows[nw][2]>windows[nw][0]&&windows[nw][3]>windows[nw][1])
+        {
+            firstRowAndPositions.push_back(qMakePair(windows[nw][1],nw));
+        }
+    }
+    std::sort(firstRowAndPositions.begin(),firstRowAndPositions.end());
+    for(int i=0;i<firstRowAndPositions.size();i++)
+    {
+        const QVector<int>& window=windows[firstRowAndPositions[i].second];
+        for(int j=i+1;j<firstRowAndPositions.size();j++)
+        {
+            const QVector<int>& otherWindow=windows[firstRowAndPositions[j].second];
+            if(otherWindow[1]>window[3]+gap)
+            {
+                break;
+            }
+            if(otherWindow[0]<=window[2]+gap
+                    &&window[0]<=otherWindow[2]+gap)
+            {
+                int group=findWindowGroup(parents,firstRowAndPositions[i].second);
+                int otherGroup=findWindowGroup(parents,firstRowAndPositions[j].second);
+                parents[otherGroup]=group;
+            }
+        }
+    }
+    QMap<int,int> groupByRoot;
+    for(int i=0;i<firstRowAndPositions.size();i++)
+    {
+        int position=firstRowAndPositions[i].second;
+        int root=findWindowGroup(parents,position);
+        const QVector<int>& window=windows[position];
+        if(!groupByRoot.contains(root))
+        {
+            groupByRoot[root]=groupWindows.size();
+            groupWindows.push_back(window);
+            windowPositionsByGroup.push_back(QVector<int>());
+        }
+        int group=groupByRoot[root];
+        QVector<int>& groupWindow=groupWindows[group];
+        groupWindow[0]=qMin(groupWindow[0],window[0]);
+        groupWindow[1]=qMin(groupWindow[1],window[1]);
+        groupWindow[2]=qMax(groupWindow[2],window[2]);
+        groupWindow[3]=qMax(groupWindow[3],window[3]);
+        windowPositionsByGroup[group].push_back(position);
+    }
+}
+}
+
+ZonalStatisticsEngine::ZonalStatisticsEngine(RasterBlockCache *ptrRasterBlockCache,
+                                             int windowCoalescingGap)
+{
+    mPtrRasterBlockCache=ptrRasterBlockCache;
+    mWindowCoalescingGap=qMax(0,windowCoalescingGap);
+}
+
+bool ZonalStatisticsEngine::reducePixelSeries(const QVector<ZonalStatisticsRasterFile> &series,
+                                              double pixelCenterFc,
+                                              double pixelCenterSc,
+                                              double pixelGsd,
+                                              ZonalStatisticsReducer &reducer,
+                                              QString &strError)
+{
+    QString strAuxError;
+    for(int ns=0;ns<series.size();ns++)
+    {
+        const ZonalStatisticsRasterFile& rasterFile=series[ns];
+        QVector<double> geoTransform;
+        if(!mPtrRasterBlockCache->getGeoTransform(rasterFile.fileName,geoTransform,strAuxError))
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reducePixelSeries");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        double rasterGsd=geoTransform[1];
+        // El pixel de la zona no puede ser mayor que el del raster
+        if(pixelGsd-rasterGsd>=ZONALSTATISTICSENGINE_GSD_TOLERANCE)
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reducePixelSeries");
+            strError+=QObject::tr("\nInvalid GSD: %1 greater than GSD: %2 of raster file:\n%3")
+                    .arg(QString::number(pixelGsd)).arg(QString::number(rasterGsd)).arg(rasterFile.fileName);
+            return(false);
+        }
+        int rasterColumn=floor((pixelCenterFc-geoTransform[0])/rasterGsd);
+        int rasterRow=floor((geoTransform[3]-pixelCenterSc)/rasterGsd);
+        double rasterValue=0.0;
+        bool existsNoDataValue=false;
+        double noDataValue=0.0;
+        if(!mPtrRasterBlockCache->getValue(rasterFile.fileName,rasterColumn,rasterRow,rasterValue,strAuxError)
+                ||!mPtrRasterBlockCache->getNoDataValue(rasterFile.fileName,existsNoDataValue,noDataValue,strAuxError))
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reducePixelSeries");
+            strError+=QObject::tr("\nError reading value from raster file:\n%1\nError:\n%2")
+                    .arg(rasterFile.fileName).arg(strAuxError);
+            return(false);
+        }
+        bool isValid=(!existsNoDataValue||rasterValue!=noDataValue);
+        bool finished=false;
+        if(!reducer.addValue(rasterFile,rasterValue,isValid,finished,strAuxError))
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reducePixelSeries");
+            strError+=QObject::tr("\nError reducing value from raster file:\n%1\nError:\n%2")
+                    .arg(rasterFile.fileName).arg(strAuxError);
+            return(false);
+        }
+        if(finished)
+        {
+            break;
+        }
+    }
+    return(true);
+}
+
+bool ZonalStatisticsEngine::reduceResampledSeries(const QVector<ZonalStatisticsRasterFile> &series,
+                                                  double outputNwFc,
+                                                  double outputNwSc,
+                                                  double outputGsd,
+                                                  const QVector<int> &pixelColumns,
+                                                  const QVector<int> &pixelRows,
+                                                  int resamplingMethod,
+                                                  const QVector<ZonalStatisticsReducer *> &ptrReducers,
+                                                  QString &strError)
+{
+    QString strAuxError;
+    int numberOfPixels=pixelColumns.size();
+    if(pixelRows.size()!=numberOfPixels
+            ||ptrReducers.size()!=numberOfPixels)
+    {
+        strError=QObject::tr("ZonalStatisticsEngine::reduceResampledSeries");
+        strError+=QObject::tr("\nThere is not one row and one reducer for each pixel");
+        return(false);
+    }
+    // Las fechas con la misma malla comparten el mapa de indices
+    QMap<QString,ResamplingIndexMap> indexMapByGridKey;
+    QVector<char> finishedPixels(numberOfPixels,0);
+    int numberOfFinishedPixels=0;
+    for(int ns=0;ns<series.size()&&numberOfFinishedPixels<numberOfPixels;ns++)
+    {
+        const ZonalStatisticsRasterFile& rasterFile=series[ns];
+        QVector<double> geoTransform;
+        int rasterColumns,rasterRows;
+        bool existsNoDataValue=false;
+        double noDataValue=0.0;
+        if(!mPtrRasterBlockCache->getGeoTransform(rasterFile.fileName,geoTransform,strAuxError)
+                ||!mPtrRasterBlockCache->getSize(rasterFile.fileName,rasterColumns,rasterRows,strAuxError)
+                ||!mPtrRasterBlockCache->getNoDataValue(rasterFile.fileName,existsNoDataValue,noDataValue,strAuxError))
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reduceResampledSeries");
+            strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+            return(false);
+        }
+        QString gridKey=ResamplingIndexMap::getGridKey(geoTransform,rasterColumns,rasterRows);
+        if(!indexMapByGridKey.contains(gridKey))
+        {
+            if(!indexMapByGridKey[gridKey].build(geoTransform,
+                                                 rasterColumns,
+                                                 rasterRows,
+                                                 outputNwFc,
+                                                 outputNwSc,
+                                                 outputGsd,
+                                                 pixelColumns,
+                                                 pixelRows,
+                                                 resamplingMethod,
+                                                 strAuxError))
+            {
+                strError=QObject::tr("ZonalStatisticsEngine::reduceResampledSeries");
+                strError+=QObject::tr("\nError building index map for raster file:\n%1\nError:\n%2")
+                        .arg(rasterFile.fileName).arg(strAuxError);
+                return(false);
+            }
+        }
+        const ResamplingIndexMap& indexMap=indexMapByGridKey[gridKey];
+        if(indexMap.getColumns()==0||indexMap.getRows()==0)
+        {
+            continue;
+        }
+        const RasterBlock* ptrWindow=NULL;
+        if(!mPtrRasterBlockCache->pinWindow(rasterFile.fileName,
+                                            indexMap.getFirstColumn(),
+                                            indexMap.getFirstRow(),
+                                            indexMap.getColumns(),
+                                            indexMap.getRows(),
+                                            ptrWindow,
+                                            strAuxError))
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reduceResampledSeries");
+            strError+=QObject::tr("\nError reading raster file:\n%1\nError:\n%2").arg(rasterFile.fileName).arg(strAuxError);
+            return(false);
+        }
+        const double* ptrWindowValues=ptrWindow->values.constData();
+        for(int np=0;np<numberOfPixels;np++)
+        {
+            if(finishedPixels[np]!=0)
+            {
+                continue;
+            }
+            bool isValid=false;
+            double rasterValue=indexMap.gather(ptrWindowValues,np,existsNoDataValue,noDataValue,isValid);
+            bool finished=false;
+            if(!ptrReducers[np]->addValue(rasterFile,rasterValue,isValid,finished,strAuxError))
+            {
+                strError=QObject::tr("ZonalStatisticsEngine::reduceResampledSeries");
+                strError+=QObject::tr("\nError reducing value from raster file:\n%1\nError:\n%2")
+                        .arg(rasterFile.fileName).arg(strAuxError);
+                mPtrRasterBlockCache->unpinBlock(ptrWindow);
+                return(false);
+            }
+            if(finished)
+            {
+                finishedPixels[np]=1;
+                numberOfFinishedPixels++;
+            }
+        }
+        mPtrRasterBlockCache->unpinBlock(ptrWindow);
+    }
+    return(true);
+}
+
+bool ZonalStatisticsEngine::reduceZones(const ZonalStatisticsRasterFile &rasterFile,
+                                        int maximumColumns,
+                                        int maximumRows,
+                                        const QVector<const RoiCoverageMask *> &ptrCoverageMasks,
+                                        const QVector<ZonalStatisticsReducer *> &ptrReducers,
+                                        QString &strError)
+{
+    QString strAuxError;
+    if(ptrCoverageMasks.size()!=ptrReducers.size())
+    {
+        strError=QObject::tr("ZonalStatisticsEngine::reduceZones");
+        strError+=QObject::tr("\nThere is not one reducer for each coverage mask");
+        return(false);
+    }
+    int rasterColumns,rasterRows;
+    bool existsNoDataValue=false;
+    double noDataValue=0.0;
+    if(!mPtrRasterBlockCache->getSize(rasterFile.fileName,rasterColumns,rasterRows,strAuxError)
+            ||!mPtrRasterBlockCache->getNoDataValue(rasterFile.fileName,existsNoDataValue,noDataValue,strAuxError))
+    {
+        strError=QObject::tr("ZonalStatisticsEngine::reduceZones");
+        strError+=QObject::tr("\nError:\n%1").arg(strAuxError);
+        return(false);
+    }
+    rasterColumns=qMin(rasterColumns,maximumColumns);
+    rasterRows=qMin(rasterRows,maximumRows);
+    // Ventana de pixeles de cada zona
+    QVector<QVector<int> > windows; // firstColumn,firstRow,endColumn,endRow
+    for(int nz=0;nz<ptrCoverageMasks.size();nz++)
+    {
+        QVector<int> window(4);
+        window[0]=0;
+        window[1]=0;
+        window[2]=rasterColumns;
+        window[3]=rasterRows;
+        const RoiCoverageMask* ptrCoverageMask=ptrCoverageMasks[nz];
+        if(ptrCoverageMask!=NULL)
+        {
+            window[0]=ptrCoverageMask->getFirstColumn();
+            window[1]=ptrCoverageMask->getFirstRow();
+            window[2]=qMin(rasterColumns,window[0]+ptrCoverageMask->getNumberOfColumns());
+            window[3]=qMin(rasterRows,window[1]+ptrCoverageMask->getNumberOfRows());
+        }
+        windows.push_back(window);
+    }
+    // Se lee una vez cada grupo de ventanas proximas, no el fichero completo
+    QVector<QVector<int> > groupWindows;
+    QVector<QVector<int> > windowPositionsByGroup;
+    coalesceWindows(windows,
+                    mWindowCoalescingGap,
+                    groupWindows,
+                    windowPositionsByGroup);
+    for(int ng=0;ng<groupWindows.size();ng++)
+    {
+        const QVector<int>& groupWindow=groupWindows[ng];
+        const RasterBlock* ptrWindow=NULL;
+        if(!mPtrRasterBlockCache->pinWindow(rasterFile.fileName,
+                                            groupWindow[0],
+                                            groupWindow[1],
+                                            groupWindow[2]-groupWindow[0],
+                                            groupWindow[3]-groupWindow[1],
+                                            ptrWindow,
+                                            strAuxError))
+        {
+            strError=QObject::tr("ZonalStatisticsEngine::reduceZones");
+            strError+=QObject::tr("\nError reading raster file:\n%1\nError:\n%2").arg(rasterFile.fileName).arg(strAuxError);
+            return(false);
+        }
+        const QVector<int>& windowPositions=windowPositionsByGroup[ng];
+        for(int nwp=0;nwp<windowPositions.size();nwp++)
+        {
+            int windowPosition=windowPositions[nwp];
+            const RoiCoverageMask* ptrCoverageMask=ptrCoverageMasks[windowPosition];
+            ZonalStatisticsReducer* ptrReducer=ptrReducers[windowPosition];
+            const QVector<int>& window=windows[windowPosition];
+            for(int rasterRow=window[1];rasterRow<window[3];rasterRow++)
+            {
+                const double* ptrRowValues=ptrWindow->values.constData()
+                        +(rasterRow-ptrWindow->firstRow)*ptrWindow->columns;
+                for(int rasterColumn=window[0];rasterColumn<window[2];rasterColumn++)
+                {
+                    // Pixeles total o parcialmente cubiertos por la zona
+                    if(ptrCoverageMask!=NULL
+                            &&!ptrCoverageMask->isCovered(rasterColumn,rasterRow))
+                    {
+                        continue;
+                    }
+                    double rasterValue=ptrRowValues[rasterColumn-ptrWindow->firstColumn];
+                    bool finished=false;
+                    if(!ptrReducer->addValue(rasterFile,
+                                             rasterValue,
+                                             !existsNoDataValue||rasterValue!=noDataValue,
+                                             finished,
+                                             strAuxError))
+                    {
+                        strError=QObject::tr("ZonalStatisticsEngine::reduceZones");
+                        strError+=QObject::tr("\nError reducing value from raster file:\n%1\nError:\n%2")
+                                .arg(rasterFile.fileName).arg(strAuxError);
+                        mPtrRasterBlockCache->unpinBlock(ptrWindow);
+                        return(false);
+                    }
+                }
+            }
+        }
+        mPtrRasterBlockCache->unpinBlock(ptrWindow);
+    }
+    return(true);
+}
@@ -0,0 +1,81 @@
+#ifndef ZONALSTATISTICSENGINE_H
+#define ZONALSTATISTICSENGINE_H
+
+#include <QString>
+#include <QVector>
+
+#include "libremotesensing_global.h"
+
+#define ZONALSTATISTICSENGINE_DEFAULT_WINDOW_COALESCING_GAP     16 // pixeles entre ventanas de zonas que se leen juntas
+#define ZONALSTATISTICSENGINE_GSD_TOLERANCE                     0.001
+
+namespace RemoteSensing{
+class RasterBlockCache;
+class RoiCoverageMask;
+
+// Fichero de una serie temporal con sus parametros radiometricos
+struct ZonalStatisticsRasterFile
+{
+    QString fileName;
+    int jd; // 0 si no se usa
+    double gain;
+    double offset;
+};
+
+// Reductor de los valores leidos: cada cliente aplica su transformacion (ndvi, kcb, ...)
+// y acumula. finished=true detiene la serie de un pixel. isValid=false para nodata o, al
+// remuestrear, sin ninguna toma valida: value no tiene significado y el reductor decide
+// si la fecha se ignora o termina la serie
+class LIBREMOTESENSINGSHARED_EXPORT ZonalStatisticsReducer
+{
+public:
+    virtual ~ZonalStatisticsReducer(){}
+    virtual bool addValue(const ZonalStatisticsRasterFile& rasterFile,
+                          double value,
+                          bool isValid,
+                          bool& finished,
+                          QString& strError)=0;
+};
+
+// Lectura de zonas sobre series de rasters a traves de la cache de bloques compartida:
+//  - reducePixelSeries: serie temporal de un pixel de la malla de la zona, con GSD igual
+//    o menor que el de los rasters
+//  - reduceResampledSeries: series temporales de un conjunto de pixeles de la malla de la zona,
+//    remuestreadas con un mapa de indices calculado una vez por malla de raster, con cualquier
+//    GSD, leyendo de cada fecha una sola ventana
+//  - reduceZones: todas las zonas de un raster, cada una limitada a su mascara de cobertura,
+//    leyendo una vez cada grupo de ventanas proximas
+// No guarda estado de cada proceso, por lo que se puede usar desde varios hilos.
+class LIBREMOTESENSINGSHARED_EXPORT ZonalStatisticsEngine
+{
+public:
+    ZonalStatisticsEngine(RasterBlockCache* ptrRasterBlockCache,
+                          int windowCoalescingGap=ZONALSTATISTICSENGINE_DEFAULT_WINDOW_COALESCING_GAP);
+    RasterBlockCache* getRasterBlockCache(){return(mPtrRasterBlockCache);}
+    bool reducePixelSeries(const QVector<ZonalStatisticsRasterFile>& series,
+                           double pixelCenterFc,
+                           double pixelCenterSc,
+                           double pixelGsd,
+                           ZonalStatisticsReducer& reducer,
+                           QString& strError);
+    bool reduceResampledSeries(const QVector<ZonalStatisticsRasterFile>& series,
+                               double outputNwFc,
+                               double outputNwSc,
+                               double outputGsd,
+                               const QVector<int>& pixelColumns,
+                               const QVector<int>& pixelRows,
+                               int resamplingMethod,
+                               const QVector<ZonalStatisticsReducer*>& ptrReducers, // uno por pixel
+                               QString& strError);
+    bool reduceZones(const ZonalStatisticsRasterFile& rasterFile,
+                     int maximumColumns,
+                     int maximumRows,
+                     const QVector<const RoiCoverageMask*>& ptrCoverageMasks, // NULL: todo el raster
+                     const QVector<ZonalStatisticsReducer*>& ptrReducers,
+                     QString& strError);
+private:
+    RasterBlockCache* mPtrRasterBlockCache;
+    int mWindowCoalescingGap;
+};
+}
+#endif // ZONALSTATISTICSENGINE_H
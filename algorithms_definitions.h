@@ -10,6 +10,9 @@
 #define ALGORITHMS_DATE_STRING_FORMAT                               "yyyy/MM/dd"
 #define ALGORITHMS_DATE_TIME_FILE_NAME_STRING_FORMAT                "yyyyMMdd_hhmmss"
 #define ALGORITHMS_RESULTS_FILE_EXTENSION                           "txt"
+#define ALGORITHMS_PARAMETER_OUTPUT_PROFILE_SUFFIX                  "_OutputProfile" // Default o COG
+#define ALGORITHMS_COG_OVERVIEW_RESAMPLING                          "AVERAGE"
+#define ALGORITHMS_PIAS_COG_OVERVIEW_RESAMPLING                     "NEAREST"
 
 #define ALGORITHMS_NDVI_CODE                                        "NDVI"
 #define ALGORITHMS_NDVI_GUI_TAG                                     "Normalized Difference Vegetation Index Computation"
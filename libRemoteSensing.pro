@@ -39,7 +39,18 @@ SOURCES += \
     ParametersManager.cpp \
     ParametersManagerDialog.cpp \
     TONIpbpProject.cpp \
-    ClassificationProject.cpp
+    ClassificationProject.cpp \
+    StrRTree.cpp \
+    CloudOptimizedGeoTiff.cpp \
+    ColumnarTableWriter.cpp \
+    DailyValueSeries.cpp \
+    PixelStateRaster.cpp \
+    RasterBlockCache.cpp \
+    ResamplingIndexMap.cpp \
+    RoiCoverageMask.cpp \
+    RoiGeometryCache.cpp \
+    StatisticsAccumulator.cpp \
+    ZonalStatisticsEngine.cpp
 
 HEADERS +=\
         libremotesensing_global.h \
@@ -59,7 +70,18 @@ HEADERS +=\
     ParametersManagerDialog.h \
     algorithms_definitions.h \
     TONIpbpProject.h \
-    ClassificationProject.h
+    ClassificationProject.h \
+    StrRTree.h \
+    CloudOptimizedGeoTiff.h \
+    ColumnarTableWriter.h \
+    DailyValueSeries.h \
+    PixelStateRaster.h \
+    RasterBlockCache.h \
+    ResamplingIndexMap.h \
+    RoiCoverageMask.h \
+    RoiGeometryCache.h \
+    StatisticsAccumulator.h \
+    ZonalStatisticsEngine.h
 
 DESTDIR_RELEASE= ./../../../build/release
 DESTDIR_DEBUG= ./../../../build/debug
@@ -438,4 +438,106 @@
 #define PERSISTENCEMANAGER_SPATIALITE_TABLE_SENTINEL2_METADATA_FIELD_METADATA_FILE_FIELD_TYPE           SPATIALITE_FIELD_TYPE_TEXT
 
 
+// TABLE_PRODUCTS_FINGERPRINTS
+// Huella de cada producto (REFL, NDVI, PIAS, INTC): hash de ficheros de entrada, algoritmo y parametros
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_TABLE_NAME                            "products_fingerprints"
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ID                              "id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ID_FIELD_TYPE                   SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME                       "file_name"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FILE_NAME_FIELD_TYPE            SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ALGORITHM_CODE                  "algorithm_code"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_ALGORITHM_CODE_FIELD_TYPE       SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FINGERPRINT                     "fingerprint"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_PRODUCTS_FINGERPRINTS_FIELD_FINGERPRINT_FIELD_TYPE          SPATIALITE_FIELD_TYPE_TEXT
+
+
+// TABLE_INGESTION_FINGERPRINTS
+// Huella de la ingestion completa de cada banda de escena en NestedGrid, ficheros de tuplekeys
+// esperados y, de ellos, los que no se crearon por no tener pixeles validos
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TABLE_NAME                          "ingestion_fingerprints"
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_ID                            "id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_ID_FIELD_TYPE                 SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID                      "scene_id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_SCENE_ID_FIELD_TYPE           SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID                       "band_id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_BAND_ID_FIELD_TYPE            SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_FINGERPRINT                   "fingerprint"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_FINGERPRINT_FIELD_TYPE        SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_TUPLEKEYS_FILES               "tuplekeys_files"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_TUPLEKEYS_FILES_FIELD_TYPE    SPATIALITE_FIELD_TYPE_TEXT
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_EMPTY_TUPLEKEYS_FILES         "empty_tuplekeys_files"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_FIELD_EMPTY_TUPLEKEYS_FILES_FIELD_TYPE SPATIALITE_FIELD_TYPE_TEXT
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_INGESTION_FINGERPRINTS_TUPLEKEYS_FILES_SEPARATOR           ";"
+
+
+// TABLE_ALGORITHM_JOBS
+// Cola de trabajos por (algoritmo, zona, tuplekey, banda) compartida entre procesos
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_TABLE_NAME                                   "algorithm_jobs"
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID                                     "id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ID_FIELD_TYPE                          SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE                         "algorithm_code"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ALGORITHM_CODE_FIELD_TYPE              SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE                              "zone_code"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ZONE_CODE_FIELD_TYPE                   SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY                               "tuplekey"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_TUPLEKEY_FIELD_TYPE                    SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_BAND_ID                                "band_id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_BAND_ID_FIELD_TYPE                     SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS                                 "status"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_STATUS_FIELD_TYPE                      SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_WORKER_ID                              "worker_id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_WORKER_ID_FIELD_TYPE                   SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN                            "lease_token"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_TOKEN_FIELD_TYPE                 SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_EXPIRATION                       "lease_expiration"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_LEASE_EXPIRATION_FIELD_TYPE            SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS                               "attempts"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ATTEMPTS_FIELD_TYPE                    SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MERGE_FILES                            "merge_files"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MERGE_FILES_FIELD_TYPE                 SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROCESS_FILES                        "reprocess_files"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROCESS_FILES_FIELD_TYPE             SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROJECT_FILES                        "reproject_files"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_REPROJECT_FILES_FIELD_TYPE             SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MAIN_SCENE_JD                          "main_scene_jd"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_MAIN_SCENE_JD_FIELD_TYPE               SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_IMAGE_ID                "intc_ref_image_id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_IMAGE_ID_FIELD_TYPE     SPATIALITE_FIELD_TYPE_INTEGER
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_RASTER_ID               "intc_ref_raster_id"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_INTC_REFERENCE_RASTER_ID_FIELD_TYPE    SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ERROR                                  "error"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_FIELD_ERROR_FIELD_TYPE                       SPATIALITE_FIELD_TYPE_TEXT
+
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_PENDING                               "pending"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_RUNNING                               "running"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_DONE                                  "done"
+#define PERSISTENCEMANAGER_SPATIALITE_TABLE_ALGORITHM_JOBS_STATUS_FAILED                                "failed"
+
+
 #endif // PERSISTENCEMANAGER_DEFINITIONS_H
@@ -15,5 +15,26 @@
 #define REMOTESENSING_PRODUCT_DATA_DATE_FORMAT                              "yyyy:MM:dd"
 #define REMOTESENSING_PRODUCT_DATA_DATE_FORMAT_YYYY_DOY                     "yyyydoy"
 
+#define REMOTESENSING_REPROJECTION_IN_PROCESS                               true
+#define REMOTESENSING_REPROJECTION_NUMBER_OF_THREADS                        0 // 0: QThread::idealThreadCount()
+#define REMOTESENSING_REPROJECTION_WARP_MEMORY_LIMIT_MB                     512.0 // compartida por todas las bandas
+#define REMOTESENSING_REPROJECTION_OUTPUT_FORMAT                            "GTiff"
+#define REMOTESENSING_REPROJECTION_WARPED_VRT                               true // reproyeccion bajo demanda, sin _rpy.tif
+#define REMOTESENSING_REPROJECTION_WARPED_VRT_FILE_EXTENSION                "vrt"
+#define REMOTESENSING_TILING_STRIP_NUMBER_OF_ROWS                           512
+#define REMOTESENSING_INGESTION_NUMBER_OF_SCENES_TASKS                      0 // 0: QThread::idealThreadCount()
+#define REMOTESENSING_INGESTION_NUMBER_OF_CPU_TASKS                         0 // 0: QThread::idealThreadCount()
+#define REMOTESENSING_INGESTION_NUMBER_OF_IO_TASKS                          2 // lecturas/escrituras simultaneas a disco
+#define REMOTESENSING_INGESTION_FINGERPRINT_CHUNK_SIZE                      1048576 // bytes leidos al principio y al final de cada banda
+#define REMOTESENSING_VSIZIP_PREFIX                                         "/vsizip/"
+#define REMOTESENSING_OUTPUT_PROFILE_DEFAULT                                "Default" // opciones de imagen de cada algoritmo
+#define REMOTESENSING_OUTPUT_PROFILE_COG                                    "COG"
+#define REMOTESENSING_COG_DRIVER_NAME                                       "COG" // GDAL >= 3.1
+#define REMOTESENSING_COG_BLOCK_SIZE                                        512
+#define REMOTESENSING_COG_TUPLEKEY_BLOCK_SIZE                               256
+#define REMOTESENSING_COG_COMPRESSION_METHOD                                "ZSTD"
+#define REMOTESENSING_COG_COMPRESSION_METHOD_ALTERNATIVE                    "DEFLATE"
+#define REMOTESENSING_COG_TEMPORARY_FILE_SUFFIX                             "_cog"
+
 
 #endif // REMOTESENSING_DEFINITIONS_H